@@ -0,0 +1,138 @@
+/**
+ * Dictionary Benchmark Application
+ * Inserts a synthetic set of RDF IRIs with long shared prefixes into
+ * ArtDictionary, PrescillaDictionary and AvlDictionary, then looks every
+ * value up again (plus the same number of missing values) and erases
+ * half of them. Prints the average time per operation and the number of
+ * errors, i.e. lookups that returned a wrong key or a value differing
+ * from the inserted string.
+ */
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+
+#include "util/allocators/malloc_free_allocator.h"
+typedef MallocFreeAllocator<Os> Allocator;
+Allocator& get_allocator();
+
+#include "util/tuple_store/art_dictionary.h"
+#include "util/tuple_store/prescilla_dictionary.h"
+#include "util/tuple_store/avl_dictionary.h"
+
+#include <ctime>
+
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#define VALUES 20000
+#define STRING_LENGTH 80
+
+typedef ArtDictionary<Os> Art;
+typedef PrescillaDictionary<Os> Prescilla;
+typedef AvlDictionary<Os> Avl;
+
+class DictionaryBenchmark {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &FacetProvider<Os, Os::Debug>::get_facet(value);
+
+			make_values();
+
+			debug_->debug("dictionary_benchmark;dictionary;values;insert_ns;find_ns;miss_ns;erase_ns;errors");
+			run<Art>("art");
+			run<Prescilla>("prescilla");
+			run<Avl>("avl");
+		}
+
+		void make_values() {
+			static const char *properties[] = {
+				"temperature", "humidity", "light", "pressure"
+			};
+
+			for(size_type i = 0; i < VALUES; i++) {
+				snprintf((char*)values_[i], STRING_LENGTH,
+						"http://spitfire-project.eu/sensor/node%d/%s/observation%d",
+						(int)(i / 16), properties[i % 4], (int)(i % 16));
+				snprintf((char*)missing_[i], STRING_LENGTH,
+						"http://spitfire-project.eu/sensor/node%d/%s/observation%d",
+						(int)(i / 16), properties[i % 4], (int)(i % 16 + 16));
+			}
+		}
+
+		template<typename Dictionary>
+		void run(const char *name) {
+			Dictionary *dictionary = new Dictionary();
+			dictionary->init(debug_);
+			size_type errors = 0;
+			double per_value = 1.0e9 / CLOCKS_PER_SEC / VALUES;
+
+			std::clock_t t0 = std::clock();
+			for(size_type i = 0; i < VALUES; i++) {
+				keys_[i] = (unsigned long)dictionary->insert(values_[i]);
+			}
+			std::clock_t insert = std::clock() - t0;
+
+			t0 = std::clock();
+			for(size_type i = 0; i < VALUES; i++) {
+				if((unsigned long)dictionary->find(values_[i]) != keys_[i]) {
+					errors++;
+				}
+			}
+			std::clock_t find = std::clock() - t0;
+
+			t0 = std::clock();
+			for(size_type i = 0; i < VALUES; i++) {
+				if(dictionary->find(missing_[i]) != Dictionary::NULL_KEY) {
+					errors++;
+				}
+			}
+			std::clock_t miss = std::clock() - t0;
+
+			for(size_type i = 0; i < VALUES; i++) {
+				block_data_t *v = dictionary->get_value((typename Dictionary::key_type)keys_[i]);
+				if(strcmp((char*)v, (char*)values_[i]) != 0) {
+					errors++;
+				}
+				dictionary->free_value(v);
+			}
+
+			t0 = std::clock();
+			for(size_type i = 0; i < VALUES; i += 2) {
+				dictionary->erase((typename Dictionary::key_type)keys_[i]);
+			}
+			std::clock_t erase = std::clock() - t0;
+
+			for(size_type i = 0; i < VALUES; i++) {
+				bool found = dictionary->find(values_[i]) != Dictionary::NULL_KEY;
+				if(found != (i % 2 == 1)) {
+					errors++;
+				}
+			}
+
+			debug_->debug("dictionary_benchmark;%s;%d;%d;%d;%d;%d;%d",
+					name, (int)VALUES, (int)(insert * per_value), (int)(find * per_value),
+					(int)(miss * per_value), (int)(erase * per_value * 2), (int)errors);
+			delete dictionary;
+		}
+
+	private:
+		block_data_t values_[VALUES][STRING_LENGTH];
+		block_data_t missing_[VALUES][STRING_LENGTH];
+		unsigned long keys_[VALUES];
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, DictionaryBenchmark> dictionary_benchmark;
+
+Allocator allocator_;
+
+Allocator& get_allocator() { return allocator_; }
+
+void application_main(Os::AppMainParameter& value) {
+	dictionary_benchmark.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
@@ -0,0 +1,187 @@
+/**
+ * Column Tuple Container Test Application
+ * Runs a TupleStore over a ColumnTupleContainer. Inserts TUPLES distinct
+ * tuples and then all of them again, finds each of them, erases every
+ * third one and inserts new tuples into the freed rows. Queries by
+ * predicate and finally erases everything with erase_matching().
+ *
+ * After every step the stored tuples are compared against a brute force
+ * list of what should be there. An end() taken before the inserts and
+ * erases must still compare equal to end() afterwards.
+ *
+ * Prints "column_tuple_container_test;ok" or the steps that failed.
+ */
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#include "util/allocators/malloc_free_allocator.h"
+typedef MallocFreeAllocator<Os> Allocator;
+Allocator& get_allocator();
+
+#include <util/meta.h>
+#include <util/tuple_store/tuplestore.h>
+#include <util/tuple_store/column_tuple_container.h>
+#include <util/tuple_store/prescilla_dictionary.h>
+#include "../inqp_test/tuple.h"
+
+#define TUPLES 40
+#define CAPACITY 64
+#define STRING_LENGTH 8
+
+typedef Tuple<Os> TupleT;
+typedef ColumnTupleContainer<Os, TupleT, CAPACITY> TupleContainer;
+typedef PrescillaDictionary<Os> Dictionary;
+typedef wiselib::TupleStore<Os, TupleContainer, Dictionary, Os::Debug, BIN(111), &TupleT::compare> TS;
+
+class ColumnTupleContainerTest {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet(value);
+			failed_ = 0;
+
+			dictionary_.init(debug_);
+			ts_.init(&dictionary_, &container_, debug_);
+			TupleContainer::iterator end_before = container_.end();
+
+			for(size_type j = 0; j < 2 * TUPLES; j++) {
+				make(j, j < TUPLES);
+			}
+
+			for(size_type j = 0; j < TUPLES; j++) {
+				ts_.insert(tuples_[j]);
+			}
+			check("insert");
+
+			for(size_type j = 0; j < TUPLES; j++) {
+				ts_.insert(tuples_[j]);
+			}
+			check("insert again");
+
+			bool found = true;
+			for(size_type j = 0; j < TUPLES; j++) {
+				TS::iterator it = ts_.find(tuples_[j]);
+				if(it == ts_.end() || !same(*it, tuples_[j])) { found = false; }
+			}
+			if(!found) { fail("find"); }
+
+			for(size_type j = 0; j < TUPLES; j += 3) {
+				TS::iterator it = ts_.find(tuples_[j]);
+				if(it != ts_.end()) { ts_.erase(it); }
+				stored_[j] = false;
+			}
+			check("erase");
+
+			TupleContainer::row_t rows = container_.rows();
+			for(size_type j = TUPLES; j < TUPLES + TUPLES / 3; j++) {
+				ts_.insert(tuples_[j]);
+				stored_[j] = true;
+			}
+			check("reinsert");
+			if(container_.rows() != rows) { fail("rows reused"); }
+			if(end_before != container_.end()) { fail("end stable"); }
+
+			TupleT query;
+			query.set(1, (block_data_t*)"p1");
+			size_type matches = 0;
+			for(TS::iterator it = ts_.begin(&query, BIN(10)); it != ts_.end(); ++it) {
+				if(strcmp((char*)it->get(1), "p1") != 0) { fail("query"); }
+				matches++;
+			}
+			if(matches != count((block_data_t*)"p1")) { fail("query count"); }
+
+			size_type erased = ts_.erase_matching();
+			for(size_type j = 0; j < 2 * TUPLES; j++) { stored_[j] = false; }
+			check("erase all");
+			if(!erased || container_.begin() != end_before ||
+					dictionary_.find((block_data_t*)"p1") != Dictionary::NULL_KEY) {
+				fail("empty");
+			}
+
+			if(!failed_) {
+				debug_->debug("column_tuple_container_test;ok");
+			}
+		}
+
+	private:
+		/**
+		 * Fills tuple j with strings that differ from those of all other
+		 * tuples in at least the object.
+		 */
+		void make(size_type j, bool stored) {
+			snprintf((char*)strings_[j][0], STRING_LENGTH, "s%d", (int)(j % 7));
+			snprintf((char*)strings_[j][1], STRING_LENGTH, "p%d", (int)(j % 3));
+			snprintf((char*)strings_[j][2], STRING_LENGTH, "o%d", (int)j);
+			for(size_type i = 0; i < 3; i++) {
+				tuples_[j].set(i, strings_[j][i]);
+			}
+			stored_[j] = stored;
+		}
+
+		static bool same(TupleT& a, TupleT& b) {
+			for(size_type i = 0; i < 3; i++) {
+				if(strcmp((char*)a.get(i), (char*)b.get(i)) != 0) { return false; }
+			}
+			return true;
+		}
+
+		/**
+		 * Number of stored tuples, only those with predicate p if given.
+		 */
+		size_type count(block_data_t* p) {
+			size_type r = 0;
+			for(size_type j = 0; j < 2 * TUPLES; j++) {
+				if(stored_[j] && (!p || strcmp((char*)strings_[j][1], (char*)p) == 0)) { r++; }
+			}
+			return r;
+		}
+
+		/**
+		 * Fails step unless the store holds exactly the stored tuples,
+		 * each one once.
+		 */
+		void check(const char* step) {
+			bool ok = ts_.size() == count(0);
+			size_type visited = 0;
+			for(TS::iterator it = ts_.begin(); it != ts_.end(); ++it) {
+				size_type j = 0;
+				for( ; j < 2 * TUPLES && !(stored_[j] && same(*it, tuples_[j])); j++) { }
+				if(j == 2 * TUPLES) { ok = false; }
+				visited++;
+			}
+			if(!ok || visited != count(0)) { fail(step); }
+		}
+
+		void fail(const char* step) {
+			debug_->debug("column_tuple_container_test;failed;%s;tuples=%d;rows=%d",
+					step, (int)ts_.size(), (int)container_.rows());
+			failed_++;
+		}
+
+		block_data_t strings_[2 * TUPLES][3][STRING_LENGTH];
+		TupleT tuples_[2 * TUPLES];
+		bool stored_[2 * TUPLES];
+
+		Dictionary dictionary_;
+		TupleContainer container_;
+		TS ts_;
+		size_type failed_;
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, ColumnTupleContainerTest> column_tuple_container_test;
+
+Allocator allocator_;
+
+Allocator& get_allocator() { return allocator_; }
+
+void application_main(Os::AppMainParameter& value) {
+	column_tuple_container_test.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
@@ -0,0 +1,146 @@
+/**
+ * Echo Neighbor Discovery Benchmark Application
+ * Feeds synthetic beacons from a growing number of neighbors into a local
+ * Echo instance and prints the average processing time per received
+ * beacon for each density. Every beacon lists the benchmark node, so the
+ * bidirectional link and piggybacked payload paths are exercised as well.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "algorithms/neighbor_discovery/echo.h"
+#include "util/base_classes/extended_radio_base.h"
+
+#include <ctime>
+
+typedef wiselib::OSMODEL Os;
+
+#define MAX_DENSITY 256
+#define ROUNDS 200
+#define PAYLOAD_ID 6
+
+/**
+ * Radio that never touches the air: sent beacons are counted and dropped,
+ * received beacons are injected by the benchmark.
+ */
+class BeaconInjectionRadio
+   : public wiselib::ExtendedRadioBase<Os, Os::Radio::node_id_t, Os::size_t, Os::block_data_t>
+{
+public:
+   typedef Os::Radio::node_id_t node_id_t;
+   typedef Os::size_t size_t;
+   typedef Os::block_data_t block_data_t;
+   typedef uint8_t message_id_t;
+   typedef BeaconInjectionRadio self_type;
+   typedef self_type* self_pointer_t;
+
+   enum SpecialNodeIds
+   {
+      BROADCAST_ADDRESS = Os::Radio::BROADCAST_ADDRESS,
+      NULL_NODE_ID = Os::Radio::NULL_NODE_ID
+   };
+
+   enum Restrictions
+   {
+      MAX_MESSAGE_LENGTH = Os::Radio::MAX_MESSAGE_LENGTH
+   };
+
+   BeaconInjectionRadio()
+      : id_( 0 ), sent_( 0 )
+   {}
+
+   int enable_radio() { return SUCCESS; }
+   int disable_radio() { return SUCCESS; }
+   node_id_t id() { return id_; }
+   void set_id( node_id_t id ) { id_ = id; }
+
+   int send( node_id_t, size_t, block_data_t* )
+   {
+      sent_++;
+      return SUCCESS;
+   }
+
+   void inject( node_id_t from, size_t len, block_data_t* data )
+   {
+#ifdef SHAWN
+      notify_receivers( from, len, data );
+#else
+      ExtendedData ex;
+      ex.set_link_metric( 100 );
+      notify_receivers( from, len, data, ex );
+#endif
+   }
+
+   uint32_t sent() { return sent_; }
+
+private:
+   node_id_t id_;
+   uint32_t sent_;
+};
+
+typedef wiselib::Echo<Os, BeaconInjectionRadio, Os::Timer, Os::Debug, MAX_DENSITY> nb_t;
+typedef nb_t::EchoMsg_t beacon_t;
+typedef BeaconInjectionRadio::node_id_t node_id_t;
+
+class EchoBenchmark
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      clock_ = &wiselib::FacetProvider<Os, Os::Clock>::get_facet( value );
+
+      radio_.set_id( 0 );
+      neighbor_discovery_.init( radio_, *clock_, *timer_, *debug_, 1000, 9000 );
+      neighbor_discovery_.register_payload_space( PAYLOAD_ID );
+      neighbor_discovery_.reg_event_callback<EchoBenchmark,
+         &EchoBenchmark::callback>( PAYLOAD_ID, nb_t::NEW_PAYLOAD_BIDI, this );
+      neighbor_discovery_.enable();
+
+      debug_->debug( "echo_benchmark;density;beacons;ns_per_beacon;payloads" );
+      for ( int density = 10; density <= MAX_DENSITY; density *= 2 )
+         run( density );
+   }
+   // --------------------------------------------------------------------
+   void run( int density )
+   {
+      neighbor_discovery_.init_echo();
+      payloads_ = 0;
+
+      beacon_t beacon;
+      beacon.add_nb_entry( radio_.id() );
+      uint8_t data[4] = { 1, 2, 3, 4 };
+      uint8_t id = PAYLOAD_ID, len = sizeof(data);
+      beacon.append_payload( id, data, len );
+
+      std::clock_t start = std::clock();
+      for ( int round = 0; round < ROUNDS; ++round )
+         for ( int i = 1; i <= density; ++i )
+            radio_.inject( (node_id_t)i, beacon.buffer_size(), beacon.data() );
+      std::clock_t stop = std::clock();
+
+      uint32_t beacons = (uint32_t)density * ROUNDS;
+      double ns = double( stop - start ) * 1.0e9 / CLOCKS_PER_SEC / beacons;
+      debug_->debug( "echo_benchmark;%d;%d;%d;%d",
+                     density, beacons, (int)ns, payloads_ );
+   }
+   // --------------------------------------------------------------------
+   void callback( uint8_t event, node_id_t from, uint8_t len, uint8_t* data )
+   {
+      payloads_++;
+   }
+
+private:
+   uint32_t payloads_;
+   BeaconInjectionRadio radio_;
+   nb_t neighbor_discovery_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Clock::self_pointer_t clock_;
+};
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, EchoBenchmark> echo_benchmark;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   echo_benchmark.init( value );
+}
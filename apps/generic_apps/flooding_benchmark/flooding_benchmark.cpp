@@ -0,0 +1,138 @@
+/**
+ * Flooding Transmission Benchmark Application
+ * Floods bursts of small events from random nodes of a simulated world
+ * with FloodingAlgorithm and reports how many radio transmissions were
+ * needed per delivered event. Every BURST_PERIOD ms each node starts a
+ * burst of BURST_SIZE events (BURST_GAP ms apart) with probability
+ * 1 / BURST_CHANCE; forwards are coalesced for FLOODING_JITTER ms, 0 sends
+ * every event on its own.
+ *
+ *   make sim ADD_CXXFLAGS=-DFLOODING_JITTER=0
+ *   ./out/sim/flooding_benchmark count=200 width=100 height=100 range=20 \
+ *      jitter=500 time=70
+ *   make sim ADD_CXXFLAGS=-DFLOODING_JITTER=20
+ *   ...
+ */
+#include "external_interface/external_interface_testing.h"
+#include "algorithms/routing/flooding/flooding_algorithm.h"
+#include "internal_interface/routing_table/routing_table_static_array.h"
+
+typedef wiselib::OSMODEL Os;
+
+#ifndef FLOODING_JITTER
+#define FLOODING_JITTER 20
+#endif
+
+#define BURST_PERIOD 1000
+#define BURST_CHANCE 20
+#define BURST_SIZE 4
+#define BURST_GAP 2
+#define REPORT_TIME 60
+
+typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 256, wiselib::SequenceWindow<Os> > SeqMap;
+typedef wiselib::FloodingAlgorithm<Os, SeqMap, Os::Radio, Os::Debug, Os::Timer> flooding_t;
+
+class FloodingBenchmark
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      radio_ = &wiselib::FacetProvider<Os, Os::Radio>::get_facet( value );
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      rand_ = &wiselib::FacetProvider<Os, Os::Rand>::get_facet( value );
+
+      flooding_.init( *radio_, *timer_, *debug_, FLOODING_JITTER );
+      flooding_.init();
+      flooding_.reg_recv_callback<FloodingBenchmark, &FloodingBenchmark::receive>( this );
+      deliveries_ = 0;
+      pending_ = 0;
+      stopped_ = false;
+
+      timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::period>(
+         BURST_PERIOD + (*rand_)( BURST_PERIOD ), this, 0 );
+      // stop generating events some seconds before the report so the last
+      // floods have finished when the counters are read
+      timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::stop>( ( REPORT_TIME - 5 ) * 1000, this, 0 );
+      timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::report>( REPORT_TIME * 1000, this, 0 );
+      if ( radio_->id() == 1 )
+         timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::summary>( REPORT_TIME * 1000 + 500, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void period( void* )
+   {
+      if ( (*rand_)( BURST_CHANCE ) == 0 && pending_ == 0 )
+      {
+         pending_ = BURST_SIZE;
+         event( 0 );
+      }
+      if ( !stopped_ )
+         timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::period>( BURST_PERIOD, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void event( void* )
+   {
+      if ( stopped_ )
+         return;
+
+      uint32_t value = (*rand_)();
+      flooding_.send( Os::Radio::BROADCAST_ADDRESS, sizeof( value ), (Os::Radio::block_data_t*)&value );
+      __sync_fetch_and_add( &events_, 1 );
+
+      if ( --pending_ )
+         timer_->set_timer<FloodingBenchmark, &FloodingBenchmark::event>( BURST_GAP, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void receive( Os::Radio::node_id_t from, Os::Radio::size_t len, Os::Radio::block_data_t *data )
+   {
+      deliveries_++;
+   }
+   // --------------------------------------------------------------------
+   void stop( void* )
+   {
+      stopped_ = true;
+   }
+   // --------------------------------------------------------------------
+   void report( void* )
+   {
+      __sync_fetch_and_add( &nodes_, 1 );
+      __sync_fetch_and_add( &total_deliveries_, deliveries_ );
+      __sync_fetch_and_add( &transmissions_, flooding_.transmissions() );
+   }
+   // --------------------------------------------------------------------
+   void summary( void* )
+   {
+      uint32_t expected = events_ * ( nodes_ - 1 );
+      debug_->debug( "flooding_benchmark;jitter;nodes;events;deliveries;coverage_pct;transmissions;tx_per_delivery_x1000" );
+      debug_->debug( "flooding_benchmark;%d;%d;%d;%d;%d;%d;%d", FLOODING_JITTER,
+         (int)nodes_, (int)events_, (int)total_deliveries_,
+         (int)( expected ? (uint64_t)total_deliveries_ * 100 / expected : 0 ),
+         (int)transmissions_,
+         (int)( total_deliveries_ ? (uint64_t)transmissions_ * 1000 / total_deliveries_ : 0 ) );
+   }
+
+private:
+   static volatile uint32_t nodes_, events_, total_deliveries_, transmissions_;
+
+   flooding_t flooding_;
+   uint32_t deliveries_;
+   uint8_t pending_;
+   bool stopped_;
+
+   Os::Radio::self_pointer_t radio_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Rand::self_pointer_t rand_;
+};
+
+volatile uint32_t FloodingBenchmark::nodes_ = 0;
+volatile uint32_t FloodingBenchmark::events_ = 0;
+volatile uint32_t FloodingBenchmark::total_deliveries_ = 0;
+volatile uint32_t FloodingBenchmark::transmissions_ = 0;
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, FloodingBenchmark> flooding_benchmark;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   flooding_benchmark.init( value );
+}
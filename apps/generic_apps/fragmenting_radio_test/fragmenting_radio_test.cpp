@@ -0,0 +1,200 @@
+/**
+ * Fragmenting Radio Test Application
+ * Node 1 sends messages of several lengths to node 2 through a
+ * FragmentingRadio, alternately with send() and send_in_place(): one that
+ * fits a single frame, one of exactly the radio payload, and messages of
+ * two up to FR_MAX_FRAGMENTS fragments. Node 2 checks every reassembled
+ * message byte by byte.
+ *
+ * The radio below compares the message of the caller against its copy on
+ * every frame it is handed, and node 1 once more after every send, so
+ * any write to the caller's bytes is counted, even one that is undone
+ * before send() returns.
+ *
+ *   make sim
+ *   ./out/sim/fragmenting_radio_test count=2 width=1 height=1 range=10 time=10
+ *
+ * Prints "fragmenting_radio_test;ok" or the counts that differ.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "radio/fragmenting/fragmenting_radio.h"
+
+typedef wiselib::OSMODEL Os;
+
+#define INTERVAL 200
+#define REPORT_TIME 5
+
+/**
+ * Simulated radio with transmission power, which checks that the
+ * message watched by watch() is unchanged whenever it sends a frame.
+ */
+class CheckingRadio : public Os::Radio
+{
+public:
+   class TxPower
+   {
+   public:
+      TxPower() : db_( 0 ) {}
+      int to_dB() { return db_; }
+      void set_dB( int db ) { db_ = db; }
+   private:
+      int db_;
+   };
+
+   CheckingRadio( Os::AppMainParameter& value )
+      : Os::Radio( value ), watched_( 0 ), copy_( 0 ), len_( 0 ), frames_( 0 ), modified_( 0 )
+   {}
+   int set_power( TxPower p ) { power_ = p; return SUCCESS; }
+   TxPower power() { return power_; }
+
+   int send( node_id_t id, size_t len, block_data_t *data )
+   {
+      frames_++;
+      if ( watched_ && memcmp( watched_, copy_, len_ ) != 0 )
+         modified_++;
+      return Os::Radio::send( id, len, data );
+   }
+
+   /** Compares the len bytes at data against copy from now on.
+    */
+   void watch( const block_data_t *data, const block_data_t *copy, size_t len )
+   {
+      watched_ = data;
+      copy_ = copy;
+      len_ = len;
+   }
+
+   uint32_t frames() { return frames_; }
+   uint32_t modified() { return modified_; }
+
+private:
+   TxPower power_;
+   const block_data_t *watched_;
+   const block_data_t *copy_;
+   size_t len_;
+   uint32_t frames_;
+   uint32_t modified_;
+};
+
+typedef wiselib::FragmentingRadio_Type<Os, CheckingRadio, Os::Clock, Os::Timer, Os::Rand, Os::Debug> fragmenting_radio_t;
+typedef fragmenting_radio_t::node_id_t node_id_t;
+typedef fragmenting_radio_t::block_data_t block_data_t;
+typedef fragmenting_radio_t::size_t size_type;
+typedef fragmenting_radio_t::Message Message;
+
+enum { MESSAGE_ID = 42 };
+
+/// payload sizes: one frame, the whole radio payload, 2 fragments, more, the most
+static const size_type lengths[] = {
+   20,
+   CheckingRadio::MAX_MESSAGE_LENGTH - Message::HEADER_SIZE,
+   CheckingRadio::MAX_MESSAGE_LENGTH - Message::HEADER_SIZE + 1,
+   400,
+   fragmenting_radio_t::REASSEMBLY_BUFFER_SIZE - Message::HEADER_SIZE
+};
+#define TOTAL ( sizeof( lengths ) / sizeof( lengths[0] ) )
+
+class FragmentingRadioTest
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      radio_ = new CheckingRadio( value );
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      clock_ = &wiselib::FacetProvider<Os, Os::Clock>::get_facet( value );
+      rand_ = &wiselib::FacetProvider<Os, Os::Rand>::get_facet( value );
+
+      fragmenting_radio_.init( *radio_, *timer_, *debug_, *clock_, *rand_ );
+      fragmenting_radio_.enable_radio();
+      fragmenting_radio_.reg_recv_callback<FragmentingRadioTest, &FragmentingRadioTest::receive>( this );
+      sent_ = 0;
+
+      if ( radio_->id() == 1 )
+      {
+         timer_->set_timer<FragmentingRadioTest, &FragmentingRadioTest::push>( INTERVAL, this, 0 );
+         timer_->set_timer<FragmentingRadioTest, &FragmentingRadioTest::report>( REPORT_TIME * 1000, this, 0 );
+      }
+   }
+   // --------------------------------------------------------------------
+   void push( void* )
+   {
+      block_data_t *data = buffer_ + fragmenting_radio_t::HEADROOM;
+      size_type len = make_message( sent_, data );
+      memcpy( copy_, data, len );
+
+      radio_->watch( data, copy_, len );
+      int result = ( sent_ % 2 ) ?
+         fragmenting_radio_.send_in_place( 2, len, data ) :
+         fragmenting_radio_.send( 2, len, data );
+      radio_->watch( 0, 0, 0 );
+
+      if ( result != Os::SUCCESS )
+         failed_++;
+      if ( memcmp( data, copy_, len ) != 0 )
+         modified_++;
+      if ( ++sent_ < TOTAL )
+         timer_->set_timer<FragmentingRadioTest, &FragmentingRadioTest::push>( INTERVAL, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void receive( node_id_t from, size_type len, block_data_t *data, fragmenting_radio_t::ExData const& )
+   {
+      block_data_t expected[fragmenting_radio_t::MAX_MESSAGE_LENGTH];
+      size_type index = ( (Message*)data )->get_payload()[0];
+      if ( index < TOTAL && len == make_message( index, expected ) && memcmp( data, expected, len ) == 0 )
+         delivered_++;
+      else
+         corrupted_++;
+   }
+   // --------------------------------------------------------------------
+   void report( void* )
+   {
+      if ( sent_ == TOTAL && delivered_ == TOTAL && !corrupted_ && !failed_ && !modified_ && !radio_->modified() )
+         debug_->debug( "fragmenting_radio_test;ok" );
+      else
+         debug_->debug( "fragmenting_radio_test;FAILED;sent %d;delivered %d;corrupted %d;failed %d;modified %d/%d of %d frames",
+            (int)sent_, (int)delivered_, (int)corrupted_, (int)failed_, (int)modified_,
+            (int)radio_->modified(), (int)radio_->frames() );
+   }
+
+private:
+   /** Serialized message number index, returns its length.
+    */
+   static size_type make_message( size_type index, block_data_t *data )
+   {
+      Message m;
+      block_data_t payload[fragmenting_radio_t::MAX_MESSAGE_LENGTH];
+      payload[0] = index;
+      for ( size_type i = 1; i < lengths[index]; i++ )
+         payload[i] = index * 31 + i;
+      m.set_message_id( MESSAGE_ID );
+      m.set_payload( lengths[index], payload );
+      memcpy( data, m.serialize(), m.serial_size() );
+      return m.serial_size();
+   }
+
+   static uint32_t delivered_, corrupted_, failed_, modified_;
+
+   fragmenting_radio_t fragmenting_radio_;
+   block_data_t buffer_[fragmenting_radio_t::HEADROOM + fragmenting_radio_t::MAX_MESSAGE_LENGTH];
+   block_data_t copy_[fragmenting_radio_t::MAX_MESSAGE_LENGTH];
+   uint32_t sent_;
+
+   CheckingRadio* radio_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Clock::self_pointer_t clock_;
+   Os::Rand::self_pointer_t rand_;
+};
+
+uint32_t FragmentingRadioTest::delivered_ = 0;
+uint32_t FragmentingRadioTest::corrupted_ = 0;
+uint32_t FragmentingRadioTest::failed_ = 0;
+uint32_t FragmentingRadioTest::modified_ = 0;
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, FragmentingRadioTest> fragmenting_radio_test;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   fragmenting_radio_test.init( value );
+}
@@ -0,0 +1,268 @@
+/**
+ * INQP Standing Query Benchmark Application
+ * Fills a tuple store with NODES sensors (type, room and value of each),
+ * registers QUERIES standing queries with the INQPQueryProcessor (every
+ * JOIN_EVERY-th one joins the sensors of a type with those of a room,
+ * the others select the sensors of a type or of a room) and executes all
+ * of them ROUNDS times:
+ * 
+ *   sequential  execute() per query, one scan per selection
+ *   shared      execute_all(), one scan feeding all selections per pass
+ *   threads     execute_all() matching on a PCThreadPool
+ * 
+ * Prints the wall clock time per round and the number and a checksum of
+ * the result rows, which have to be the same in every mode.
+ * 
+ *   make
+ *   ./out/pc/inqp_benchmark
+ *   make ADD_CXXFLAGS="-DINQP_SCAN_BLOCK=256 -DPC_THREAD_POOL_THREADS=8"
+ */
+#define WISELIB_LOG_LEVEL 1
+
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#include "util/allocators/malloc_free_allocator.h"
+typedef MallocFreeAllocator<Os> Allocator;
+Allocator& get_allocator();
+
+#include <algorithms/rdf/inqp/query_processor.h>
+#include <external_interface/pc/pc_thread_pool.h>
+#include <util/pstl/list_dynamic.h>
+#include <util/pstl/unique_container.h>
+#include <util/tuple_store/tuplestore.h>
+#include <util/tuple_store/prescilla_dictionary.h>
+#include <util/meta.h>
+#include "tuple.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define NODES 2000
+#define TYPES 16
+#define ROOMS 50
+#define QUERIES 64
+#define JOIN_EVERY 4
+#define ROUNDS 20
+
+typedef Tuple<Os> TupleT;
+typedef list_dynamic<Os, TupleT> TupleList;
+typedef UniqueContainer<TupleList> TupleContainer;
+typedef PrescillaDictionary<Os> Dictionary;
+typedef TupleStore<Os, TupleContainer, Dictionary, Os::Debug, BIN(111), &TupleT::compare> TS;
+typedef Fnv32<Os> Hash;
+
+typedef INQPQueryProcessor<Os, TS, Hash, Dictionary,
+		DictionaryTranslator<Os, Dictionary, Hash, 64>, HashTranslator<Os, Dictionary, Hash, 64>,
+		::uint32_t, QUERIES> SequentialProcessor;
+typedef INQPQueryProcessor<Os, TS, Hash, Dictionary,
+		DictionaryTranslator<Os, Dictionary, Hash, 64>, HashTranslator<Os, Dictionary, Hash, 64>,
+		::uint32_t, QUERIES, Os::Timer, PCThreadPool<Os> > ThreadedProcessor;
+
+template<typename Processor>
+class StandingQueries {
+	public:
+		typedef Processor processor_t;
+		typedef typename Processor::query_id_t query_id_t;
+		typedef typename Processor::operator_id_t operator_id_t;
+		typedef typename Processor::RowT RowT;
+		typedef typename Processor::BOD BOD;
+		typedef typename Processor::CommunicationType CommunicationType;
+		
+		struct OperatorMessage {
+			query_id_t query_id_;
+			block_data_t description_[32];
+			
+			query_id_t query_id() { return query_id_; }
+			BOD* operator_description() { return reinterpret_cast<BOD*>(description_); }
+		};
+		
+		struct QueryInfoMessage {
+			query_id_t query_id_;
+			::uint8_t operators_;
+			
+			query_id_t query_id() { return query_id_; }
+			::uint8_t operators() { return operators_; }
+		};
+		
+		void init(TS& ts, Os::Timer& timer) {
+			processor_.init(&ts, &timer);
+			processor_.template reg_row_callback<StandingQueries, &StandingQueries::on_row>(this);
+			
+			char s[16];
+			for(size_type q = 0; q < QUERIES; q++) {
+				snprintf(s, sizeof(s), "t%d", (int)(q % TYPES));
+				Hash::hash_t type = Hash::hash((block_data_t*)s, strlen(s));
+				snprintf(s, sizeof(s), "r%d", (int)(q % ROOMS));
+				Hash::hash_t room = Hash::hash((block_data_t*)s, strlen(s));
+				
+				if(q % JOIN_EVERY == 0) {
+					add_collect(q, 100);
+					add_join(q, 90, 100);
+					add_selection(q, 70, 90, false, type);
+					add_selection(q, 80, 90 | 0x80, true, room);
+					set_operators(q, 4);
+				}
+				else {
+					add_collect(q, 100);
+					add_selection(q, 80, 100, q % 2, q % 2 ? room : type);
+					set_operators(q, 2);
+				}
+			}
+			reset();
+		}
+		
+		void reset() {
+			rows_ = 0;
+			checksum_ = 0;
+		}
+		
+		void execute_each() {
+			for(size_type q = 0; q < QUERIES; q++) {
+				typename Processor::Query *query = processor_.get_query(q);
+				query->build_tree();
+				processor_.execute(&query, 1);
+			}
+		}
+		
+		void execute_all() { processor_.execute_all(); }
+		
+		void on_row(CommunicationType type, size_type columns, RowT& row, query_id_t qid, operator_id_t oid) {
+			// order independent, the modes deliver the rows of different
+			// queries interleaved differently
+			::uint32_t h = qid;
+			for(size_type i = 0; i < columns; i++) {
+				h = h * 31 + row[i];
+			}
+			rows_++;
+			checksum_ += h * 2654435761u;
+		}
+		
+		::uint32_t rows_;
+		::uint32_t checksum_;
+		
+	private:
+		
+		void add_collect(query_id_t q, operator_id_t id) {
+			block_data_t d[] = { id, BOD::COLLECT, 0, 0, 0, 0, 0 };
+			add(q, d, sizeof(d));
+		}
+		
+		void add_join(query_id_t q, operator_id_t id, operator_id_t parent) {
+			// left subject = right subject, keep the left one
+			block_data_t d[] = { id, BOD::SIMPLE_LOCAL_JOIN, parent, BIN(0011), 0, 0, 0, 0 };
+			add(q, d, sizeof(d));
+		}
+		
+		/**
+		 * Subjects whose "type" (or "room") is the object with hash value.
+		 */
+		void add_selection(query_id_t q, operator_id_t id, ::uint8_t parent, bool by_room, Hash::hash_t value) {
+			const char *p = by_room ? "room" : "type";
+			block_data_t d[] = { id, BOD::GRAPH_PATTERN_SELECTION, parent, BIN(0011), 0, 0, 0,
+				BIN(110), 0, 0, 0, 0, 0, 0, 0, 0 };
+			Hash::hash_t predicate = Hash::hash((block_data_t*)p, strlen(p));
+			write<Os>(d + 8, predicate);
+			write<Os>(d + 12, value);
+			add(q, d, sizeof(d));
+		}
+		
+		void add(query_id_t q, block_data_t *d, size_type len) {
+			OperatorMessage msg;
+			msg.query_id_ = q;
+			memcpy(msg.description_, d, len);
+			processor_.handle_operator(&msg, 0, len);
+		}
+		
+		void set_operators(query_id_t q, ::uint8_t n) {
+			QueryInfoMessage msg;
+			msg.query_id_ = q;
+			msg.operators_ = n;
+			processor_.handle_query_info(&msg, 0, sizeof(msg));
+		}
+		
+		Processor processor_;
+};
+
+class INQPBenchmark {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &FacetProvider<Os, Os::Debug>::get_facet(value);
+			timer_ = &FacetProvider<Os, Os::Timer>::get_facet(value);
+			
+			dictionary_.init(debug_);
+			ts_.init(&dictionary_, &container_, debug_);
+			char s[16], p[16];
+			for(size_type i = 0; i < NODES; i++) {
+				snprintf(s, sizeof(s), "s%d", (int)i);
+				snprintf(p, sizeof(p), "t%d", (int)(i % TYPES));
+				insert(s, "type", p);
+				snprintf(p, sizeof(p), "r%d", (int)(i % ROOMS));
+				insert(s, "room", p);
+				snprintf(p, sizeof(p), "%d", (int)(i * 7 % 1000));
+				insert(s, "value", p);
+			}
+			
+			sequential_.init(ts_, *timer_);
+			threaded_.init(ts_, *timer_);
+			
+			debug_->debug("inqp_benchmark;mode;tuples;queries;scan_block;threads;us_per_round;rows;checksum");
+			run(sequential_, &StandingQueries<SequentialProcessor>::execute_each, "sequential", 1);
+			run(sequential_, &StandingQueries<SequentialProcessor>::execute_all, "shared", 1);
+			run(threaded_, &StandingQueries<ThreadedProcessor>::execute_all, "threads", PC_THREAD_POOL_THREADS);
+		}
+		
+	private:
+		
+		template<typename Q>
+		void run(Q& queries, void (Q::*execute)(), const char *mode, int threads) {
+			(queries.*execute)();
+			queries.reset();
+			double t0 = now_us();
+			for(size_type i = 0; i < ROUNDS; i++) {
+				(queries.*execute)();
+			}
+			double t = (now_us() - t0) / ROUNDS;
+			debug_->debug("inqp_benchmark;%s;%d;%d;%d;%d;%d;%u;%08x", mode, 3 * NODES, QUERIES,
+					(int)Q::processor_t::SCAN_BLOCK, threads, (int)t, queries.rows_ / ROUNDS, queries.checksum_);
+		}
+		
+		void insert(const char *s, const char *p, const char *o) {
+			TupleT t;
+			t.set(0, (block_data_t*)s);
+			t.set(1, (block_data_t*)p);
+			t.set(2, (block_data_t*)o);
+			ts_.insert(t);
+		}
+		
+		double now_us() {
+			timespec ts;
+			clock_gettime(CLOCK_MONOTONIC, &ts);
+			return ts.tv_sec * 1.0e6 + ts.tv_nsec / 1.0e3;
+		}
+		
+		Dictionary dictionary_;
+		TupleContainer container_;
+		TS ts_;
+		StandingQueries<SequentialProcessor> sequential_;
+		StandingQueries<ThreadedProcessor> threaded_;
+		
+		Os::Debug::self_pointer_t debug_;
+		Os::Timer::self_pointer_t timer_;
+};
+
+Allocator allocator_;
+Allocator& get_allocator() { return allocator_; }
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, INQPBenchmark> inqp_benchmark;
+// --------------------------------------------------------------------------
+void application_main(Os::AppMainParameter& value)
+{
+	inqp_benchmark.init(value);
+	exit(0);
+}
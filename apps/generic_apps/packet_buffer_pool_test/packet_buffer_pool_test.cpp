@@ -0,0 +1,157 @@
+/**
+ * Packet Buffer Pool Test Application
+ * Exhausts a PacketBufferPool of BUFFERS buffers and checks that the next
+ * allocation fails and that releasing a handle makes room again. Clones a
+ * shared packet and changes the clone only, moves the window of a packet
+ * to the bounds of its buffer with push(), pull(), put() and trim(), and
+ * copies one handle up to MAX_REFERENCES times, the copies beyond that
+ * being invalid. Every accessor of an invalid handle must answer without
+ * touching a buffer.
+ *
+ *   make pc
+ *
+ * Prints "packet_buffer_pool_test;ok" or the steps that failed.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "util/pstl/packet_buffer_pool.h"
+
+typedef wiselib::OSMODEL Os;
+
+#define BUFFERS 4
+#define BUFFER_SIZE 64
+#define HEADROOM 16
+
+typedef wiselib::PacketBufferPool<Os, BUFFERS, BUFFER_SIZE, HEADROOM> pool_t;
+typedef pool_t::Packet Packet;
+typedef Os::block_data_t block_data_t;
+
+class PacketBufferPoolTest
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      failed_ = 0;
+
+      exhaustion();
+      clone();
+      bounds();
+      references();
+      check( "all returned", pool_.available() == BUFFERS && pool_.stats().in_use == 0 );
+
+      if ( !failed_ )
+         debug_->debug( "packet_buffer_pool_test;ok" );
+   }
+   // --------------------------------------------------------------------
+   void exhaustion()
+   {
+      Packet p[BUFFERS];
+      for ( int i = 0; i < BUFFERS; i++ )
+         p[i] = pool_.allocate();
+      Packet q = pool_.allocate();
+      check( "exhausted", !q.valid() && pool_.available() == 0 && pool_.stats().failures == 1 );
+      check_invalid( "exhausted handle", q );
+      check( "too much headroom", !pool_.allocate( BUFFER_SIZE + 1 ).valid() );
+
+      p[1].release();
+      q = pool_.allocate();
+      check( "after release", q.valid() && !p[1].valid() && pool_.available() == 0 );
+      check( "high water mark", pool_.stats().high_water_mark == BUFFERS );
+   }
+   // --------------------------------------------------------------------
+   void clone()
+   {
+      block_data_t bytes[] = { 1, 2, 3, 4 };
+      Packet p = pool_.allocate( bytes, sizeof( bytes ) );
+      Packet shared = p;
+      check( "shared", p.shared() && shared.references() == 2 && shared.data() == p.data() );
+
+      Packet c = pool_.clone( p );
+      check( "clone", c.valid() && !c.shared() && c.data() != p.data() &&
+         c.length() == p.length() && c.headroom() == p.headroom() &&
+         memcmp( c.data(), bytes, sizeof( bytes ) ) == 0 );
+      c.data()[0] = 9;
+      check( "clone is private", p.data()[0] == 1 );
+
+      shared.release();
+      check( "unshared", !p.shared() && p.references() == 1 );
+      check( "clone of invalid", !pool_.clone( Packet() ).valid() );
+   }
+   // --------------------------------------------------------------------
+   void bounds()
+   {
+      Packet p = pool_.allocate();
+      check( "empty", p.length() == 0 && p.headroom() == HEADROOM &&
+         p.tailroom() == BUFFER_SIZE - HEADROOM );
+
+      block_data_t *tail = p.put( BUFFER_SIZE - HEADROOM );
+      check( "put to the end", tail == p.data() && p.tailroom() == 0 && !p.put( 1 ) );
+
+      block_data_t *front = p.push( HEADROOM );
+      check( "push to the front", front && p.headroom() == 0 && p.length() == BUFFER_SIZE && !p.push( 1 ) );
+
+      check( "pull too much", !p.pull( BUFFER_SIZE + 1 ) && p.length() == BUFFER_SIZE );
+      check( "pull all", p.pull( BUFFER_SIZE ) == front + BUFFER_SIZE && p.length() == 0 &&
+         p.headroom() == BUFFER_SIZE && p.tailroom() == 0 );
+
+      p.push( 8 );
+      p.trim( 3 );
+      check( "trim", p.length() == 3 && p.tailroom() == 5 );
+      p.trim( 10 );
+      check( "trim longer", p.length() == 3 );
+
+      check( "copy too long", !pool_.allocate( front, BUFFER_SIZE - HEADROOM + 1 ).valid() );
+   }
+   // --------------------------------------------------------------------
+   void references()
+   {
+      Packet p = pool_.allocate();
+      Packet *copies = new Packet[pool_t::MAX_REFERENCES];
+      int valid = 0;
+      for ( int i = 0; i < pool_t::MAX_REFERENCES; i++ )
+      {
+         copies[i] = p;
+         if ( copies[i].valid() )
+            valid++;
+      }
+      check( "reference limit", valid == pool_t::MAX_REFERENCES - 1 &&
+         p.references() == pool_t::MAX_REFERENCES );
+
+      Packet beyond( p );
+      check_invalid( "copy beyond the limit", beyond );
+      check( "limit kept", p.references() == pool_t::MAX_REFERENCES );
+
+      delete[] copies;
+      check( "references dropped", p.references() == 1 && pool_.stats().in_use == 1 );
+   }
+
+private:
+   void check_invalid( const char *step, Packet& p )
+   {
+      check( step, !p.valid() && p.data() == 0 && p.length() == 0 && p.headroom() == 0 &&
+         p.tailroom() == 0 && p.references() == 0 && !p.shared() &&
+         !p.push( 1 ) && !p.pull( 0 ) && !p.put( 1 ) );
+      p.trim( 0 );
+      p.release();
+   }
+   // --------------------------------------------------------------------
+   void check( const char *step, bool ok )
+   {
+      if ( !ok )
+      {
+         debug_->debug( "packet_buffer_pool_test;FAILED;%s", step );
+         failed_++;
+      }
+   }
+   // --------------------------------------------------------------------
+   pool_t pool_;
+   int failed_;
+   Os::Debug::self_pointer_t debug_;
+};
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, PacketBufferPoolTest> packet_buffer_pool_test;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   packet_buffer_pool_test.init( value );
+}
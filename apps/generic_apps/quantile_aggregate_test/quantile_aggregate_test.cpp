@@ -0,0 +1,164 @@
+/**
+ * Quantile Aggregate Test Application
+ * Feeds READINGS distinct readings in shuffled order into a
+ * quantile_aggregate of default capacity, so the sketch is at its maximum
+ * fill level with values on many levels. The serialized sketch is written
+ * into an AggregateMsg payload of a 116 byte radio followed by guard
+ * bytes, read back and written again, then two full sketches are
+ * combined. After every step the size must stay within MAX_SIZE and the
+ * payload, the guard bytes must be untouched, the count must be exact
+ * and the median within MAX_RANK_ERROR of the true one.
+ *
+ * The sizes of all sketch aggregates are checked against the payload at
+ * compile time, as Aggregation does for the radio in use.
+ *
+ *   make pc
+ *
+ * Prints "quantile_aggregate_test;ok" or the steps that failed.
+ */
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+typedef Os::block_data_t block_data_t;
+
+#include "util/meta.h"
+#include "util/serialization/serialization.h"
+#include "algorithms/aggregation/aggregationmsg.h"
+#include "algorithms/aggregation/quantile_aggregate.h"
+#include "algorithms/aggregation/hll_aggregate.h"
+#include "algorithms/aggregation/heavy_hitters_aggregate.h"
+#include "algorithms/aggregation/count_min_aggregate.h"
+
+#define READINGS 100000
+#define GUARD 4
+// tolerated rank error of the median in percent, the 24 values of the
+// default sketch are spread over 15 levels here
+#define MAX_RANK_ERROR 30
+
+/**
+ * Only the types AggregateMsg needs, of a radio with the smallest payload
+ * the default sketch sizes are made for (iSense, OSA).
+ */
+struct Radio116 {
+    typedef Os::Radio::node_id_t node_id_t;
+    typedef Os::Radio::size_t size_t;
+    typedef Os::Radio::block_data_t block_data_t;
+    typedef Os::Radio::message_id_t message_id_t;
+
+    enum {
+        MAX_MESSAGE_LENGTH = 116
+    };
+};
+
+typedef AggregateMsg<Os, Radio116> msg_t;
+typedef quantile_aggregate<Os, uint32_t> quantile_t;
+typedef hll_aggregate<Os, uint32_t> hll_t;
+typedef heavy_hitters_aggregate<Os, uint32_t> heavy_hitters_t;
+typedef count_min_aggregate<Os, uint32_t> count_min_t;
+
+static_assert((int)quantile_t::MAX_SIZE <= (int)msg_t::MAX_PAYLOAD_SIZE);
+static_assert((int)hll_t::MAX_SIZE <= (int)msg_t::MAX_PAYLOAD_SIZE);
+static_assert((int)heavy_hitters_t::MAX_SIZE <= (int)msg_t::MAX_PAYLOAD_SIZE);
+static_assert((int)count_min_t::MAX_SIZE <= (int)msg_t::MAX_PAYLOAD_SIZE);
+
+class QuantileAggregateTest {
+public:
+    void init(Os::AppMainParameter& value) {
+        debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet(value);
+        failed_ = 0;
+
+        quantile_t a, b;
+        for (uint32_t i = 0; i < READINGS; i++) {
+            // two permutations of 0 .. READINGS - 1
+            a.put((i * 7919UL) % READINGS);
+            b.put((i * 104729UL + 13) % READINGS);
+            if (a.size() > quantile_t::MAX_SIZE || b.size() > quantile_t::MAX_SIZE) {
+                check("put", false);
+                break;
+            }
+        }
+        check_sketch("fill", a, READINGS, true);
+
+        block_data_t buffer[msg_t::MAX_PAYLOAD_SIZE + GUARD];
+        serialize(a, buffer);
+        quantile_t c(buffer);
+        block_data_t again[msg_t::MAX_PAYLOAD_SIZE + GUARD];
+        serialize(c, again);
+        check("round trip", memcmp(buffer, again, msg_t::MAX_PAYLOAD_SIZE) == 0);
+        check_sketch("read", c, READINGS, true);
+
+        quantile_t d = a.combine(b);
+        check_sketch("combine", d, 2 * READINGS, false);
+        serialize(d, buffer);
+        check_sketch("combined read", quantile_t(buffer), 2 * READINGS, false);
+
+        if (!failed_) {
+            debug_->debug("quantile_aggregate_test;ok");
+        }
+    }
+
+private:
+    /**
+     * Writes q into buffer followed by GUARD guard bytes, checks size()
+     * against the bytes written and that the guard is untouched.
+     */
+    void serialize(quantile_t q, block_data_t *buffer) {
+        memset(buffer, 0xa5, msg_t::MAX_PAYLOAD_SIZE + GUARD);
+        q.writeTo(buffer);
+        bool guard = true;
+        for (int i = 0; i < GUARD; i++) {
+            guard = guard && buffer[msg_t::MAX_PAYLOAD_SIZE + i] == 0xa5;
+        }
+        int items = 0;
+        for (int h = 0; h < buffer[0]; h++) {
+            items += buffer[1 + h];
+        }
+        check("serialize", guard && q.size() == (size_t)(1 + buffer[0] + items * sizeof(uint32_t)));
+    }
+
+    /**
+     * Checks that q stays within MAX_SIZE, holds CAPACITY values if full,
+     * summarizes n readings of 0 .. READINGS - 1 and has about the median
+     * of those.
+     */
+    void check_sketch(const char *step, quantile_t q, uint32_t n, bool full) {
+        size_t size = q.size();
+        int levels = 0, items = 0;
+        block_data_t buffer[msg_t::MAX_PAYLOAD_SIZE + GUARD];
+        q.writeTo(buffer);
+        levels = buffer[0];
+        for (int h = 0; h < levels; h++) {
+            items += buffer[1 + h];
+        }
+
+        uint32_t median = q.get();
+        uint32_t error = median > READINGS / 2 ? median - READINGS / 2 : READINGS / 2 - median;
+        bool ok = size <= quantile_t::MAX_SIZE && size <= msg_t::MAX_PAYLOAD_SIZE &&
+            q.count() == n && (!full || items == quantile_t::CAPACITY) &&
+            error * 100 <= READINGS * MAX_RANK_ERROR;
+        if (!ok) {
+            debug_->debug("quantile_aggregate_test;FAILED;%s;size %d of %d;levels %d;items %d;count %lu;median %lu",
+                step, (int) size, (int) quantile_t::MAX_SIZE, levels, items,
+                (unsigned long) q.count(), (unsigned long) median);
+            failed_++;
+        }
+    }
+
+    void check(const char *step, bool ok) {
+        if (!ok) {
+            debug_->debug("quantile_aggregate_test;FAILED;%s", step);
+            failed_++;
+        }
+    }
+
+    int failed_;
+    Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, QuantileAggregateTest> quantile_aggregate_test;
+
+void application_main(Os::AppMainParameter& value) {
+    quantile_aggregate_test.init(value);
+}
@@ -0,0 +1,175 @@
+/**
+ * Reliable Radio Throughput/Latency Benchmark Application
+ * Node 1 pushes TOTAL messages of PAYLOAD bytes to node 2 through the
+ * ReliableRadio as fast as the send window allows (with BIDIRECTIONAL node
+ * 2 does the same towards node 1, so acks can be piggybacked). At
+ * REPORT_TIME node 2 prints delivered and undelivered messages, the time
+ * until the last delivery, throughput and mean/max latency.
+ *
+ *   make sim
+ *   ./out/sim/reliable_radio_benchmark count=2 width=1 height=1 range=10 \
+ *      loss_model=uniform loss=0.2 time=30
+ *   make sim ADD_CXXFLAGS=-DRR_WINDOW_SIZE=1      (stop and wait)
+ *   make sim ADD_CXXFLAGS="-DRR_ACK_DELAY=0 -DBIDIRECTIONAL"
+ *
+ * The radio transmissions (data and acks) are in the sent column of the
+ * simulator summary line.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "radio/reliable/reliable_radio.h"
+
+typedef wiselib::OSMODEL Os;
+
+#define TOTAL 1000
+#define PAYLOAD 64
+#define MAX_RETRIES 8
+#define SEND_POLL 1
+#define REPORT_TIME 25
+
+/**
+ * The simulated radio has no transmission power, which the ReliableRadio
+ * raises for late retransmissions.
+ */
+class SimTxRadio : public Os::Radio
+{
+public:
+   class TxPower
+   {
+   public:
+      TxPower() : db_( 0 ) {}
+      int to_dB() { return db_; }
+      void set_dB( int db ) { db_ = db; }
+   private:
+      int db_;
+   };
+
+   SimTxRadio( Os::AppMainParameter& value ) : Os::Radio( value ) {}
+   int set_power( TxPower p ) { power_ = p; return SUCCESS; }
+   TxPower power() { return power_; }
+
+private:
+   TxPower power_;
+};
+
+typedef wiselib::ReliableRadio_Type<Os, SimTxRadio, Os::Clock, Os::Timer, Os::Rand, Os::Debug> reliable_radio_t;
+typedef reliable_radio_t::node_id_t node_id_t;
+typedef reliable_radio_t::block_data_t block_data_t;
+typedef reliable_radio_t::size_t size_type;
+
+class ReliableRadioBenchmark
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      radio_ = new SimTxRadio( value );
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      clock_ = &wiselib::FacetProvider<Os, Os::Clock>::get_facet( value );
+      rand_ = &wiselib::FacetProvider<Os, Os::Rand>::get_facet( value );
+
+      reliable_radio_.init( *radio_, *timer_, *debug_, *clock_, *rand_ );
+      reliable_radio_.enable_radio();
+      reliable_radio_.set_max_retries( MAX_RETRIES );
+      reliable_radio_.reg_recv_callback<ReliableRadioBenchmark, &ReliableRadioBenchmark::receive>( this );
+      sent_ = 0;
+
+      if ( radio_->id() > 2 )
+         return;
+      peer_ = 3 - radio_->id();
+#ifndef BIDIRECTIONAL
+      if ( radio_->id() == 1 )
+#endif
+         timer_->set_timer<ReliableRadioBenchmark, &ReliableRadioBenchmark::push>( 100, this, 0 );
+      timer_->set_timer<ReliableRadioBenchmark, &ReliableRadioBenchmark::report>( REPORT_TIME * 1000, this, 0 );
+      if ( radio_->id() == 2 )
+         timer_->set_timer<ReliableRadioBenchmark, &ReliableRadioBenchmark::summary>( REPORT_TIME * 1000 + 500, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void push( void* )
+   {
+      block_data_t buffer[PAYLOAD];
+      memset( buffer, 0, sizeof( buffer ) );
+      while ( sent_ < TOTAL && reliable_radio_.can_send( peer_ ) )
+      {
+         uint64_t t = now_us();
+         memcpy( buffer, &t, sizeof( t ) );
+         if ( reliable_radio_.send( peer_, sizeof( buffer ), buffer ) != Os::SUCCESS )
+            break;
+         sent_++;
+      }
+      if ( sent_ < TOTAL )
+         timer_->set_timer<ReliableRadioBenchmark, &ReliableRadioBenchmark::push>( SEND_POLL, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void receive( node_id_t from, size_type len, block_data_t *data, reliable_radio_t::ExData const& )
+   {
+      if ( len == PAYLOAD )
+      {
+         uint64_t t, sent;
+         t = now_us();
+         memcpy( &sent, data, sizeof( sent ) );
+         if ( delivered_++ == 0 || sent < start_ )
+            start_ = sent;
+         if ( t > last_ )
+            last_ = t;
+         latency_sum_ += t - sent;
+         if ( t - sent > latency_max_ )
+            latency_max_ = t - sent;
+      }
+      else if ( data[0] == reliable_radio_t::RR_UNDELIVERED )
+      {
+         undelivered_++;
+      }
+   }
+   // --------------------------------------------------------------------
+   void report( void* )
+   {
+      retransmissions_ += reliable_radio_.get_retransmissions();
+   }
+   // --------------------------------------------------------------------
+   void summary( void* )
+   {
+      uint64_t duration = last_ > start_ ? last_ - start_ : 1;
+      debug_->debug( "reliable_radio_benchmark;window;ack_delay;delivered;undelivered;duration_ms;msgs_per_s;latency_mean_us;latency_max_us;retransmissions" );
+      debug_->debug( "reliable_radio_benchmark;%d;%d;%d;%d;%d;%d;%d;%d;%d", RR_WINDOW_SIZE, RR_ACK_DELAY,
+         (int)delivered_, (int)undelivered_, (int)( duration / 1000 ),
+         (int)( (uint64_t)delivered_ * 1000000 / duration ),
+         (int)( delivered_ ? latency_sum_ / delivered_ : 0 ), (int)latency_max_,
+         (int)retransmissions_ );
+   }
+
+private:
+   uint64_t now_us()
+   {
+      Os::Clock::time_t t = clock_->time();
+      return (uint64_t)clock_->seconds( t ) * 1000000 + clock_->milliseconds( t ) * 1000 + clock_->microseconds( t );
+   }
+   // --------------------------------------------------------------------
+   static uint32_t delivered_, undelivered_, retransmissions_;
+   static uint64_t start_, last_, latency_sum_, latency_max_;
+
+   reliable_radio_t reliable_radio_;
+   node_id_t peer_;
+   uint32_t sent_;
+
+   SimTxRadio* radio_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Clock::self_pointer_t clock_;
+   Os::Rand::self_pointer_t rand_;
+};
+
+uint32_t ReliableRadioBenchmark::delivered_ = 0;
+uint32_t ReliableRadioBenchmark::undelivered_ = 0;
+uint32_t ReliableRadioBenchmark::retransmissions_ = 0;
+uint64_t ReliableRadioBenchmark::start_ = 0;
+uint64_t ReliableRadioBenchmark::last_ = 0;
+uint64_t ReliableRadioBenchmark::latency_sum_ = 0;
+uint64_t ReliableRadioBenchmark::latency_max_ = 0;
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, ReliableRadioBenchmark> reliable_radio_benchmark;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   reliable_radio_benchmark.init( value );
+}
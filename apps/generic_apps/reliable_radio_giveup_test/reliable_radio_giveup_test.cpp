@@ -0,0 +1,147 @@
+/**
+ * Reliable Radio Give-Up Test Application
+ * Node 1 sends TOTAL numbered messages to node 2, one every INTERVAL ms.
+ * Every transmission of message DROPPED is lost, so the ReliableRadio
+ * gives it up after MAX_RETRIES. Node 2 keeps acking its sequence number
+ * with the later messages in the bitmap; all of them must still be
+ * acknowledged, i.e. node 1 reports exactly one RR_UNDELIVERED.
+ *
+ *   make sim
+ *   ./out/sim/reliable_radio_giveup_test count=2 width=1 height=1 range=10 time=25
+ *
+ * Prints "reliable_radio_giveup_test;ok" or the counts that differ.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "radio/reliable/reliable_radio.h"
+
+typedef wiselib::OSMODEL Os;
+
+#define TOTAL 64
+#define DROPPED 5
+#define MAX_RETRIES 3
+#define INTERVAL 100
+#define REPORT_TIME 20
+
+/**
+ * Simulated radio with transmission power, which loses every frame
+ * carrying the payload of message DROPPED.
+ */
+class DroppingRadio : public Os::Radio
+{
+public:
+   class TxPower
+   {
+   public:
+      TxPower() : db_( 0 ) {}
+      int to_dB() { return db_; }
+      void set_dB( int db ) { db_ = db; }
+   private:
+      int db_;
+   };
+
+   DroppingRadio( Os::AppMainParameter& value ) : Os::Radio( value ), dropped_( 0 ) {}
+   int set_power( TxPower p ) { power_ = p; return SUCCESS; }
+   TxPower power() { return power_; }
+
+   int send( node_id_t id, size_t len, block_data_t *data )
+   {
+      static const block_data_t marker[] = { 'D', 'R', 'O', 'P' };
+      for ( size_t i = 0; i + sizeof( marker ) <= len; i++ )
+      {
+         if ( memcmp( data + i, marker, sizeof( marker ) ) == 0 )
+         {
+            dropped_++;
+            return SUCCESS;
+         }
+      }
+      return Os::Radio::send( id, len, data );
+   }
+
+   uint32_t dropped() { return dropped_; }
+
+private:
+   TxPower power_;
+   uint32_t dropped_;
+};
+
+typedef wiselib::ReliableRadio_Type<Os, DroppingRadio, Os::Clock, Os::Timer, Os::Rand, Os::Debug> reliable_radio_t;
+typedef reliable_radio_t::node_id_t node_id_t;
+typedef reliable_radio_t::block_data_t block_data_t;
+typedef reliable_radio_t::size_t size_type;
+
+class ReliableRadioGiveUpTest
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      radio_ = new DroppingRadio( value );
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      clock_ = &wiselib::FacetProvider<Os, Os::Clock>::get_facet( value );
+      rand_ = &wiselib::FacetProvider<Os, Os::Rand>::get_facet( value );
+
+      reliable_radio_.init( *radio_, *timer_, *debug_, *clock_, *rand_ );
+      reliable_radio_.enable_radio();
+      reliable_radio_.set_max_retries( MAX_RETRIES );
+      reliable_radio_.reg_recv_callback<ReliableRadioGiveUpTest, &ReliableRadioGiveUpTest::receive>( this );
+      sent_ = 0;
+
+      if ( radio_->id() == 1 )
+      {
+         timer_->set_timer<ReliableRadioGiveUpTest, &ReliableRadioGiveUpTest::push>( INTERVAL, this, 0 );
+         timer_->set_timer<ReliableRadioGiveUpTest, &ReliableRadioGiveUpTest::report>( REPORT_TIME * 1000, this, 0 );
+      }
+   }
+   // --------------------------------------------------------------------
+   void push( void* )
+   {
+      block_data_t buffer[8];
+      memset( buffer, 0, sizeof( buffer ) );
+      buffer[0] = sent_;
+      if ( sent_ == DROPPED )
+         memcpy( buffer + 1, "DROP", 4 );
+      if ( reliable_radio_.send( 2, sizeof( buffer ), buffer ) == Os::SUCCESS )
+         sent_++;
+      if ( sent_ < TOTAL )
+         timer_->set_timer<ReliableRadioGiveUpTest, &ReliableRadioGiveUpTest::push>( INTERVAL, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void receive( node_id_t from, size_type len, block_data_t *data, reliable_radio_t::ExData const& )
+   {
+      if ( len == 8 )
+         delivered_++;
+      else if ( data[0] == reliable_radio_t::RR_UNDELIVERED )
+         undelivered_++;
+   }
+   // --------------------------------------------------------------------
+   void report( void* )
+   {
+      if ( sent_ == TOTAL && delivered_ == TOTAL - 1 && undelivered_ == 1 && radio_->dropped() == MAX_RETRIES + 1 )
+         debug_->debug( "reliable_radio_giveup_test;ok" );
+      else
+         debug_->debug( "reliable_radio_giveup_test;FAILED;sent %d;delivered %d;undelivered %d;dropped %d",
+            (int)sent_, (int)delivered_, (int)undelivered_, (int)radio_->dropped() );
+   }
+
+private:
+   static uint32_t delivered_, undelivered_;
+
+   reliable_radio_t reliable_radio_;
+   uint32_t sent_;
+
+   DroppingRadio* radio_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Clock::self_pointer_t clock_;
+   Os::Rand::self_pointer_t rand_;
+};
+
+uint32_t ReliableRadioGiveUpTest::delivered_ = 0;
+uint32_t ReliableRadioGiveUpTest::undelivered_ = 0;
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, ReliableRadioGiveUpTest> reliable_radio_giveup_test;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   reliable_radio_giveup_test.init( value );
+}
@@ -267,7 +267,7 @@ class DsrRoutingApplication
 // --------------------------------------------------------------------------
 // --------------------------------------------------------------------------
 
-typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 64> FloodingStaticMap;
+typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 64, wiselib::SequenceWindow<Os> > FloodingStaticMap;
 typedef wiselib::FloodingAlgorithm<Os, FloodingStaticMap, Os::Radio, Os::Debug> flooding_algorithm_t;
 
 // --------------------------------------------------------------------------
@@ -342,7 +342,7 @@ void application_main( Os::AppMainParameter& value )
 // #include "algorithms/routing/flooding_algorithm.h"
 // 
 // typedef wiselib::OSMODEL Os;
-// typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 8> FloodingStaticMap;
+// typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 8, wiselib::SequenceWindow<Os> > FloodingStaticMap;
 // typedef wiselib::FloodingAlgorithm<Os, FloodingStaticMap, Os::Radio, Os::Debug> flooding_algorithm_t;
 // 
 // flooding_algorithm_t flooding;
@@ -0,0 +1,294 @@
+/**
+ * SHDT Serializer Benchmark Application
+ * Round-trips a synthetic RDF document through ShdtSerializer for several
+ * radio frame sizes, once with the per tuple fill_buffer()/read_buffer()
+ * calls and once with write_frame()/read_frame(), and through the former
+ * serializer (shdt_serializer_baseline.h) for comparison. Prints bytes on
+ * the air and the average encode/decode time per tuple. Every decoded
+ * tuple is compared against the original document.
+ *
+ * Then the frames of the document are decoded once more after
+ * truncating, flipping bytes in or replacing them with random data. The
+ * "corrupt" line counts the frames rejected by read_frame() and, as
+ * errors, decoded tuples holding a null string.
+ */
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+
+#include "util/allocators/malloc_free_allocator.h"
+typedef MallocFreeAllocator<Os> Allocator;
+Allocator& get_allocator();
+
+#include "util/broker/shdt_serializer.h"
+#include "shdt_serializer_baseline.h"
+
+#include <ctime>
+
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#define TUPLES 600
+#define ROUNDS 50
+#define HEADER_SIZE 4
+#define STRING_LENGTH 64
+
+typedef ShdtSerializer<Os, 64> Shdt;
+typedef ShdtSerializerBaseline<Os, 64> Baseline;
+
+/**
+ * Minimal tuple / iterator pair as expected by ShdtSerializer.
+ */
+class BenchmarkTuple {
+	public:
+		BenchmarkTuple() { data_[0] = data_[1] = data_[2] = 0; }
+		block_data_t* get(size_type i) { return data_[i]; }
+		void set(size_type i, block_data_t* data) { data_[i] = data; }
+	private:
+		block_data_t *data_[3];
+};
+
+class BenchmarkIterator {
+	public:
+		typedef BenchmarkTuple Tuple;
+
+		BenchmarkIterator(Tuple* p = 0) : p_(p) { }
+		Tuple& operator*() { return *p_; }
+		BenchmarkIterator& operator++() { ++p_; return *this; }
+		bool operator==(const BenchmarkIterator& other) const { return p_ == other.p_; }
+		bool operator!=(const BenchmarkIterator& other) const { return p_ != other.p_; }
+	private:
+		Tuple *p_;
+};
+
+class ShdtBenchmark {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &FacetProvider<Os, Os::Debug>::get_facet(value);
+
+			make_document();
+
+			debug_->debug("shdt_benchmark;mode;frame_size;frames;bytes;encode_ns;decode_ns;errors");
+			static const size_type frame_sizes[] = { 64, 96, 116 };
+			for(size_type i = 0; i < sizeof(frame_sizes) / sizeof(frame_sizes[0]); i++) {
+				run<Baseline>("baseline", frame_sizes[i], false);
+				run<Shdt>("buffer", frame_sizes[i], false);
+				run<Shdt>("frame", frame_sizes[i], true);
+			}
+			corrupt(116);
+		}
+
+		void make_document() {
+			static const char *predicates[] = {
+				"rdf:type",
+				"ssn:observedProperty",
+				"ssn:hasValue",
+				"ssn:observationResultTime",
+				"rdfs:label"
+			};
+
+			for(size_type i = 0; i < TUPLES; i++) {
+				snprintf((char*)strings_[i][0], STRING_LENGTH, "http://spitfire-project.eu/sensor/%d", (int)(i / 5));
+				snprintf((char*)strings_[i][1], STRING_LENGTH, "%s", predicates[i % 5]);
+				snprintf((char*)strings_[i][2], STRING_LENGTH, "%d", (int)(i * 7 % 101));
+				for(size_type j = 0; j < 3; j++) {
+					document_[i].set(j, strings_[i][j]);
+				}
+			}
+		}
+
+		template<typename Serializer>
+		void run(const char *mode, size_type frame_size, bool frames) {
+			Serializer encoder, decoder;
+			size_type nframes = 0, bytes = 0;
+			errors_ = 0;
+
+			std::clock_t encode = 0, decode = 0;
+			for(size_type round = 0; round < ROUNDS; round++) {
+				encoder.reset();
+				decoder.reset();
+				decoded_ = 0;
+
+				BenchmarkIterator it(document_), end(document_ + TUPLES);
+				bool done = false;
+				while(!done) {
+					size_type len;
+
+					std::clock_t t0 = std::clock();
+					len = encode_frame(encoder, frame_size, frames, it, end);
+					std::clock_t t1 = std::clock();
+					encode += t1 - t0;
+
+					if(!len) {
+						errors_++;
+						break;
+					}
+					if(round == 0) {
+						nframes++;
+						bytes += len;
+					}
+
+					t0 = std::clock();
+					if(frames) {
+						decode_frame(decoder, len, done);
+					}
+					else {
+						block_data_t *buf = frame_;
+						while(len) {
+							BenchmarkTuple t;
+							size_type r = decoder.read_buffer(t, buf, len);
+							if(r == 0 || r == Serializer::npos) {
+								errors_++;
+								break;
+							}
+							buf += r;
+							len -= r;
+							// the baseline can end a buffer with inserts only
+							if(t.get(0)) {
+								on_tuple(t);
+							}
+						}
+						done = (it == end);
+					}
+					decode += std::clock() - t0;
+				}
+				if(decoded_ != TUPLES) {
+					errors_++;
+				}
+			}
+
+			double per_tuple = 1.0e9 / CLOCKS_PER_SEC / ((double)TUPLES * ROUNDS);
+			debug_->debug("shdt_benchmark;%s;%d;%d;%d;%d;%d;%d",
+					mode, (int)frame_size, (int)nframes, (int)bytes,
+					(int)(encode * per_tuple), (int)(decode * per_tuple), (int)errors_);
+		}
+
+		/**
+		 * Encodes the frames of the document, decodes each of them damaged
+		 * by a decoder of its own and intact by one that follows the
+		 * encoder.
+		 */
+		void corrupt(size_type frame_size) {
+			Shdt encoder, decoder, damaged;
+			size_type frames = 0, rejected = 0;
+			::uint32_t seed = 1;
+			errors_ = 0;
+			decoded_ = 0;
+
+			BenchmarkIterator it(document_), end(document_ + TUPLES);
+			for(size_type round = 0; round < ROUNDS; round++) {
+				encoder.reset();
+				decoder.reset();
+				damaged.reset();
+				it = BenchmarkIterator(document_);
+
+				bool done = false;
+				while(!done) {
+					size_type len = encoder.write_frame(frame_, frame_size, HEADER_SIZE, it, end);
+					if(!len) {
+						break;
+					}
+
+					block_data_t copy[sizeof(frame_)];
+					memcpy(copy, frame_, len);
+					size_type damaged_len = len;
+					seed = seed * 1103515245UL + 12345UL;
+					switch((seed >> 16) % 3) {
+						case 0: // truncate
+							damaged_len = HEADER_SIZE + (seed >> 8) % (len - HEADER_SIZE);
+							break;
+						case 1: // flip a byte
+							copy[HEADER_SIZE + (seed >> 8) % (len - HEADER_SIZE)] ^= 1 << ((seed >> 4) % 8);
+							break;
+						default: // noise
+							for(size_type i = HEADER_SIZE; i < len; i++) {
+								seed = seed * 1103515245UL + 12345UL;
+								copy[i] = seed >> 16;
+							}
+							break;
+					}
+
+					bool end_of_stream;
+					if(damaged.read_frame<BenchmarkTuple>(copy, damaged_len, HEADER_SIZE,
+							delegate1<void, BenchmarkTuple&>::from_method<ShdtBenchmark, &ShdtBenchmark::on_damaged_tuple>(this),
+							end_of_stream) == Shdt::npos) {
+						rejected++;
+					}
+
+					decoded_ = 0;
+					decoder.read_frame<BenchmarkTuple>(frame_, len, HEADER_SIZE,
+							delegate1<void, BenchmarkTuple&>::from_method<ShdtBenchmark, &ShdtBenchmark::on_damaged_tuple>(this), done);
+					frames++;
+				}
+			}
+			debug_->debug("shdt_benchmark;corrupt;%d;%d;rejected %d;;;%d",
+					(int)frame_size, (int)frames, (int)rejected, (int)errors_);
+		}
+
+		size_type encode_frame(Shdt& encoder, size_type frame_size, bool frames, BenchmarkIterator& it, const BenchmarkIterator& end) {
+			if(frames) {
+				return encoder.write_frame(frame_, frame_size, HEADER_SIZE, it, end);
+			}
+			return encoder.fill_buffer(frame_, frame_size, it, end);
+		}
+
+		size_type encode_frame(Baseline& encoder, size_type frame_size, bool, BenchmarkIterator& it, const BenchmarkIterator& end) {
+			return encoder.fill_buffer(frame_, frame_size, it, end);
+		}
+
+		void decode_frame(Shdt& decoder, size_type len, bool& done) {
+			if(decoder.read_frame<BenchmarkTuple>(frame_, len, HEADER_SIZE,
+					delegate1<void, BenchmarkTuple&>::from_method<ShdtBenchmark, &ShdtBenchmark::on_tuple>(this), done) == Shdt::npos) {
+				errors_++;
+				done = true;
+			}
+		}
+
+		void decode_frame(Baseline&, size_type, bool& done) {
+			done = true;
+		}
+
+		void on_damaged_tuple(BenchmarkTuple& t) {
+			for(size_type j = 0; j < 3; j++) {
+				if(!t.get(j)) {
+					errors_++;
+				}
+			}
+		}
+
+		void on_tuple(BenchmarkTuple& t) {
+			if(decoded_ >= TUPLES) {
+				errors_++;
+				return;
+			}
+			for(size_type j = 0; j < 3; j++) {
+				if(strcmp((char*)t.get(j), (char*)strings_[decoded_][j]) != 0) {
+					errors_++;
+				}
+			}
+			decoded_++;
+		}
+
+	private:
+		block_data_t strings_[TUPLES][3][STRING_LENGTH];
+		BenchmarkTuple document_[TUPLES];
+		block_data_t frame_[116];
+		size_type decoded_;
+		size_type errors_;
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, ShdtBenchmark> shdt_benchmark;
+
+Allocator allocator_;
+
+Allocator& get_allocator() { return allocator_; }
+
+void application_main(Os::AppMainParameter& value) {
+	shdt_benchmark.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
@@ -0,0 +1,80 @@
+/**
+ * Simulation Throughput Benchmark Application
+ * Runs Echo neighbor discovery on every node of an in-process simulated
+ * world. After REPORT_TIME seconds every node adds its number of
+ * bidirectional neighbors to a global sum which node 1 prints; the
+ * simulator itself prints event counts and events per second at the end.
+ *
+ *   make sim
+ *   ./out/sim/sim_benchmark count=2000 width=400 height=400 range=30 \
+ *      jitter=200 time=40 threads=4
+ */
+#include "external_interface/external_interface_testing.h"
+#include "algorithms/neighbor_discovery/echo.h"
+
+typedef wiselib::OSMODEL Os;
+
+#define REPORT_TIME 30
+
+typedef wiselib::Echo<Os, Os::Radio, Os::Timer, Os::Debug> nb_t;
+
+class SimBenchmark
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      radio_ = &wiselib::FacetProvider<Os, Os::Radio>::get_facet( value );
+      timer_ = &wiselib::FacetProvider<Os, Os::Timer>::get_facet( value );
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      clock_ = &wiselib::FacetProvider<Os, Os::Clock>::get_facet( value );
+      rand_ = &wiselib::FacetProvider<Os, Os::Rand>::get_facet( value );
+
+      radio_->enable_radio();
+      neighbor_discovery_.init( *radio_, *clock_, *timer_, *debug_, 1000, 9000 );
+
+      // do not start all nodes in the same millisecond
+      timer_->set_timer<SimBenchmark, &SimBenchmark::start>( (*rand_)( 1000 ), this, 0 );
+      timer_->set_timer<SimBenchmark, &SimBenchmark::report>( REPORT_TIME * 1000, this, 0 );
+      if ( radio_->id() == 1 )
+         timer_->set_timer<SimBenchmark, &SimBenchmark::summary>( REPORT_TIME * 1000 + 500, this, 0 );
+   }
+   // --------------------------------------------------------------------
+   void start( void* )
+   {
+      neighbor_discovery_.enable();
+   }
+   // --------------------------------------------------------------------
+   void report( void* )
+   {
+      __sync_fetch_and_add( &nodes_, 1 );
+      __sync_fetch_and_add( &neighbors_, neighbor_discovery_.bidi_nb_size() );
+   }
+   // --------------------------------------------------------------------
+   void summary( void* )
+   {
+      debug_->debug( "sim_benchmark;nodes;bidi_neighbors;avg_degree" );
+      debug_->debug( "sim_benchmark;%d;%d;%d.%02d", (int)nodes_, (int)neighbors_,
+         (int)( nodes_ ? neighbors_ / nodes_ : 0 ),
+         (int)( nodes_ ? neighbors_ * 100 / nodes_ % 100 : 0 ) );
+   }
+
+private:
+   static volatile uint32_t nodes_, neighbors_;
+
+   nb_t neighbor_discovery_;
+   Os::Radio::self_pointer_t radio_;
+   Os::Timer::self_pointer_t timer_;
+   Os::Debug::self_pointer_t debug_;
+   Os::Clock::self_pointer_t clock_;
+   Os::Rand::self_pointer_t rand_;
+};
+
+volatile uint32_t SimBenchmark::nodes_ = 0;
+volatile uint32_t SimBenchmark::neighbors_ = 0;
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, SimBenchmark> sim_benchmark;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   sim_benchmark.init( value );
+}
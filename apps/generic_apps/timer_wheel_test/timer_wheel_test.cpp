@@ -0,0 +1,166 @@
+/**
+ * Timer Wheel Test Application
+ * Drives a TimerWheel of 2 levels of 4 slots (16 ticks) by a fake timer
+ * that fires one tick at a time. Adds a timer on level 0, one that
+ * cascades from level 1 and some beyond the wheel, which are parked and
+ * moved on. Cancels one parked timer right away and another one after it
+ * has been moved several times, and reschedules a parked timer into
+ * level 0.
+ *
+ * Checks the tick each timer fires in, that cancelled timers never fire,
+ * that the wheel stops its timer once nothing is pending, that handles of
+ * fired timers do not reach the timer reusing their entry, and that a full
+ * pool refuses more timers.
+ *
+ * Prints "timer_wheel_test;ok" or the steps that failed.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "algorithms/timer/timer_wheel.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+typedef Os::size_t size_type;
+
+/**
+ * Timer that holds one pending callback and only calls it from fire().
+ */
+class FakeTimer {
+	public:
+		typedef FakeTimer self_type;
+		typedef self_type* self_pointer_t;
+		typedef ::uint32_t millis_t;
+		typedef delegate1<void, void*> timer_delegate_t;
+
+		FakeTimer() : armed_(false) {
+		}
+
+		template<typename T, void (T::*TMethod)(void*)>
+		int set_timer(millis_t, T* obj, void* userdata) {
+			callback_ = timer_delegate_t::template from_method<T, TMethod>(obj);
+			userdata_ = userdata;
+			armed_ = true;
+			return Os::SUCCESS;
+		}
+
+		/// Calls the pending callback, false if there is none.
+		bool fire() {
+			if(!armed_) { return false; }
+			armed_ = false;
+			callback_(userdata_);
+			return true;
+		}
+
+		bool armed() { return armed_; }
+
+	private:
+		timer_delegate_t callback_;
+		void *userdata_;
+		bool armed_;
+};
+
+#define MAX_TIMERS 8
+#define TICK 10
+
+typedef TimerWheel<Os, FakeTimer, MAX_TIMERS, TICK, 2, 2> Wheel;
+
+enum { A, B, C, D, E, F, G, TIMERS };
+
+/// Tick each timer is expected to fire in, 0 for never.
+static const Wheel::tick_t expected[TIMERS] = { 3, 10, 50, 0, 5, 0, 0 };
+
+class TimerWheelTest {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet(value);
+			failed_ = 0;
+			for(size_type i = 0; i < TIMERS; i++) {
+				fired_[i] = 0;
+				timers_[i] = i;
+			}
+
+			wheel_.init(timer_);
+			add(A, 3 * TICK);
+			add(B, 10 * TICK);
+			add(C, 50 * TICK);
+			add(D, 40 * TICK);
+			add(E, 20 * TICK);
+			add(F, 60 * TICK);
+			check("add", wheel_.size() == 6 && timer_.armed());
+
+			check("cancel parked", wheel_.cancel(handles_[D]) == Os::SUCCESS && !wheel_.pending(handles_[D]) &&
+					wheel_.cancel(handles_[D]) != Os::SUCCESS);
+			check("reschedule parked", wheel_.reschedule(handles_[E], 5 * TICK) == Os::SUCCESS);
+
+			while(timer_.fire()) {
+				if(wheel_.now() == 30) {
+					check("cancel moved", wheel_.pending(handles_[F]) &&
+							wheel_.cancel(handles_[F]) == Os::SUCCESS && !wheel_.pending(handles_[F]));
+				}
+				if(wheel_.now() > 100) { break; }
+			}
+
+			for(size_type i = 0; i < TIMERS; i++) {
+				if(fired_[i] != expected[i]) {
+					debug_->debug("timer_wheel_test;failed;timer %d fired in tick %d, expected %d",
+							(int)i, (int)fired_[i], (int)expected[i]);
+					failed_++;
+				}
+			}
+			check("stopped", wheel_.size() == 0 && !timer_.armed() && wheel_.now() == 50);
+
+			add(G, TICK);
+			check("stale handle", wheel_.pending(handles_[G]) && !wheel_.pending(handles_[A]) &&
+					wheel_.cancel(handles_[A]) != Os::SUCCESS && wheel_.reschedule(handles_[A], TICK) != Os::SUCCESS &&
+					wheel_.pending(handles_[G]) && wheel_.cancel(handles_[G]) == Os::SUCCESS);
+			check("no handle", !wheel_.pending(Wheel::NO_TIMER) && !wheel_.pending(MAX_TIMERS + 1));
+
+			for(size_type i = 0; i < MAX_TIMERS; i++) {
+				add(G, TICK);
+			}
+			check("full", wheel_.add_timer<TimerWheelTest, &TimerWheelTest::expire>(TICK, this, &timers_[G]) == Wheel::NO_TIMER &&
+					wheel_.set_timer<TimerWheelTest, &TimerWheelTest::expire>(TICK, this, &timers_[G]) != Os::SUCCESS &&
+					wheel_.size() == MAX_TIMERS);
+
+			if(!failed_) {
+				debug_->debug("timer_wheel_test;ok");
+			}
+		}
+
+		void expire(void* userdata) {
+			size_type i = *(size_type*)userdata;
+			fired_[i] = fired_[i] ? (Wheel::tick_t)-1 : wheel_.now();
+		}
+
+	private:
+		void add(size_type i, Wheel::millis_t millis) {
+			handles_[i] = wheel_.add_timer<TimerWheelTest, &TimerWheelTest::expire>(millis, this, &timers_[i]);
+			if(handles_[i] == Wheel::NO_TIMER) {
+				check("add_timer", false);
+			}
+		}
+
+		void check(const char* step, bool ok) {
+			if(!ok) {
+				debug_->debug("timer_wheel_test;failed;%s", step);
+				failed_++;
+			}
+		}
+
+		FakeTimer timer_;
+		Wheel wheel_;
+		Wheel::timer_id_t handles_[TIMERS];
+		Wheel::tick_t fired_[TIMERS];
+		size_type timers_[TIMERS];
+		size_type failed_;
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, TimerWheelTest> timer_wheel_test;
+
+void application_main(Os::AppMainParameter& value) {
+	timer_wheel_test.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
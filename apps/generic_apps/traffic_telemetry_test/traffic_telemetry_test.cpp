@@ -0,0 +1,303 @@
+/**
+ * Traffic Telemetry Test Application
+ * Stacks a TrafficTelemetryRadioModel on a fake radio that records the
+ * frames it is handed and delivers frames on demand, once with
+ * ExtendedData and once without. Sends and receives a few frames of
+ * several types and neighbors, more than the tables hold, and checks the
+ * counters per type, per neighbor and in total, the size and
+ * interarrival histograms, and that the link metric the fake radio
+ * delivers reaches an extended receiver registered on the telemetry
+ * radio.
+ *
+ *   make pc
+ *
+ * Prints "traffic_telemetry_test;ok" or the steps that failed.
+ */
+#include "external_interface/external_interface_testing.h"
+#include "util/metrics/traffic_telemetry_radio.h"
+
+typedef wiselib::OSMODEL Os;
+typedef Os::block_data_t block_data_t;
+
+/**
+ * Radio that remembers the last frame sent and hands frames given to
+ * deliver() to its receivers, with ExtendedData if Base_P has them.
+ */
+template<typename Base_P>
+class FakeRadio : public Base_P
+{
+public:
+   typedef FakeRadio<Base_P> self_type;
+   typedef self_type* self_pointer_t;
+   typedef typename Base_P::node_id_t node_id_t;
+   typedef typename Base_P::size_t size_t;
+   typedef typename Base_P::block_data_t block_data_t;
+   typedef uint8_t message_id_t;
+
+   enum { BROADCAST_ADDRESS = 0xffff, NULL_NODE_ID = 0 };
+   enum { MAX_MESSAGE_LENGTH = 128 };
+
+   FakeRadio() : frames_( 0 ), to_( NULL_NODE_ID ), len_( 0 ), data_( 0 ) {}
+
+   int enable_radio() { return Os::SUCCESS; }
+   int disable_radio() { return Os::SUCCESS; }
+   node_id_t id() { return 1; }
+
+   int send( node_id_t to, size_t len, block_data_t *data )
+   {
+      frames_++;
+      to_ = to;
+      len_ = len;
+      data_ = data;
+      return Os::SUCCESS;
+   }
+
+   void deliver( node_id_t from, size_t len, block_data_t *data )
+   {
+      this->notify_receivers( from, len, data );
+   }
+
+   template<typename ExtendedData>
+   void deliver( node_id_t from, size_t len, block_data_t *data, const ExtendedData& ex )
+   {
+      this->notify_receivers( from, len, data, ex );
+   }
+
+   int frames() { return frames_; }
+   node_id_t to() { return to_; }
+   size_t len() { return len_; }
+   block_data_t* data() { return data_; }
+
+private:
+   int frames_;
+   node_id_t to_;
+   size_t len_;
+   block_data_t *data_;
+};
+
+/**
+ * Clock that only moves by advance().
+ */
+class FakeClock
+{
+public:
+   typedef uint32_t time_t;
+   typedef FakeClock* self_pointer_t;
+
+   FakeClock() : ms_( 0 ) {}
+
+   time_t time() { return ms_; }
+   uint32_t seconds( time_t t ) { return t / 1000; }
+   uint32_t milliseconds( time_t t ) { return t % 1000; }
+   void advance( uint32_t ms ) { ms_ += ms; }
+
+private:
+   uint32_t ms_;
+};
+
+typedef wiselib::BaseExtendedData<Os> ExtendedData;
+typedef FakeRadio<wiselib::ExtendedRadioBase<Os, uint16_t, size_t, block_data_t,
+   RADIO_BASE_MAX_RECEIVERS, ExtendedData> > extended_radio_t;
+typedef FakeRadio<wiselib::RadioBase<Os, uint16_t, size_t, block_data_t> > plain_radio_t;
+
+/// two types and two neighbors, so the third of each is counted as other
+typedef wiselib::TrafficTelemetryRadioModel<Os, extended_radio_t, FakeClock, Os::Debug,
+   wiselib::NullFrameDump<Os>, 2, 2> telemetry_t;
+typedef wiselib::TrafficTelemetryRadioModel<Os, plain_radio_t, FakeClock, Os::Debug> plain_telemetry_t;
+typedef telemetry_t::Snapshot Snapshot;
+typedef telemetry_t::node_id_t node_id_t;
+
+enum { LINK_METRIC = 1234 };
+
+class TrafficTelemetryTest
+{
+public:
+   void init( Os::AppMainParameter& value )
+   {
+      debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet( value );
+      failed_ = 0;
+      plain_ = 0;
+      extended_ = 0;
+      metric_ = 0;
+
+      counters();
+      extended_data();
+      plain_radio();
+
+      if ( !failed_ )
+         debug_->debug( "traffic_telemetry_test;ok" );
+   }
+   // --------------------------------------------------------------------
+   void receive( node_id_t, size_t, block_data_t* )
+   {
+      plain_++;
+   }
+   // --------------------------------------------------------------------
+   void receive_extended( node_id_t, size_t, block_data_t*, const ExtendedData& ex )
+   {
+      extended_++;
+      metric_ = ex.link_metric();
+   }
+
+private:
+   /** Frames: tx type 7 of 10 bytes to 2 by send(), type 7 of 3 bytes to
+    *  3 in place, type 9 of 100 bytes to 2; rx type 7 of 5 bytes from 2,
+    *  10 ms later type 9 of 20 bytes from 2, then type 11 of 40 bytes
+    *  from 4.
+    */
+   void counters()
+   {
+      extended_radio_t radio;
+      FakeClock clock;
+      telemetry_t telemetry;
+      telemetry.init( radio, clock, *debug_ );
+
+      telemetry.send( 2, 10, frame( 7 ) );
+      check( "send passed on", radio.frames() == 1 && radio.to() == 2 && radio.len() == 10 && radio.data() == buffer_ );
+      telemetry.send_in_place( 3, 3, frame( 7 ) );
+      telemetry.send( 2, 100, frame( 9 ) );
+      check( "send_in_place passed on", radio.frames() == 3 );
+
+      radio.deliver( 2, 5, frame( 7 ), ex_data() );
+      clock.advance( 10 );
+      radio.deliver( 2, 20, frame( 9 ), ex_data() );
+      radio.deliver( 4, 40, frame( 11 ), ex_data() );
+
+      const Snapshot& s = telemetry.stats();
+      check( "total", equal( s.total, 3, 113, 3, 65 ) );
+
+      const telemetry_t::TypeEntry *t7 = type( s, 7 ), *t9 = type( s, 9 );
+      check( "type 7", t7 && equal( t7->counters, 2, 13, 1, 5 ) );
+      check( "type 9", t9 && equal( t9->counters, 1, 100, 1, 20 ) );
+      check( "other types", !type( s, 11 ) && equal( s.other_types, 0, 0, 1, 40 ) );
+
+      const telemetry_t::NeighborEntry *n2 = neighbor( s, 2 ), *n3 = neighbor( s, 3 );
+      check( "neighbor 2", n2 && equal( n2->counters, 2, 110, 2, 25 ) && n2->last_rx == 10 );
+      check( "neighbor 3", n3 && equal( n3->counters, 1, 3, 0, 0 ) );
+      check( "other neighbors", !neighbor( s, 4 ) && equal( s.other_neighbors, 0, 0, 1, 40 ) );
+
+      // 3 in [2, 4), 10 in [8, 16), 100 in [64, 128)
+      check( "tx sizes", histogram( s.tx_size, 2, 4, 7 ) );
+      // 5 in [4, 8), 20 in [16, 32), 40 in [32, 64)
+      check( "rx sizes", histogram( s.rx_size, 3, 5, 6 ) );
+      check( "interarrival", s.rx_interarrival[4] == 1 && total( s.rx_interarrival ) == 1 );
+      check( "bin floors", telemetry_t::bin_floor( 0 ) == 0 && telemetry_t::bin_floor( 4 ) == 8 );
+
+      Snapshot copy;
+      telemetry.snapshot( copy );
+      telemetry.reset();
+      check( "snapshot", equal( copy.total, 3, 113, 3, 65 ) && copy.tx_size[7] == 1 );
+      check( "reset", equal( telemetry.stats().total, 0, 0, 0, 0 ) && !type( telemetry.stats(), 7 ) &&
+         total( telemetry.stats().rx_size ) == 0 );
+   }
+   // --------------------------------------------------------------------
+   /** Both kinds of receivers on the telemetry radio get the frame, the
+    *  extended one with the link metric of the radio below.
+    */
+   void extended_data()
+   {
+      extended_radio_t radio;
+      FakeClock clock;
+      telemetry_t telemetry;
+      telemetry.init( radio, clock, *debug_ );
+      telemetry.reg_recv_callback<TrafficTelemetryTest, &TrafficTelemetryTest::receive>( this );
+      telemetry.reg_recv_callback<TrafficTelemetryTest, &TrafficTelemetryTest::receive_extended>( this );
+
+      plain_ = extended_ = metric_ = 0;
+      radio.deliver( 2, 5, frame( 7 ), ex_data() );
+      check( "extended data", plain_ == 1 && extended_ == 1 && metric_ == LINK_METRIC &&
+         telemetry.stats().total.rx_packets == 1 );
+   }
+   // --------------------------------------------------------------------
+   /** A radio without ExtendedData feeds plain receivers and the counters.
+    */
+   void plain_radio()
+   {
+      plain_radio_t radio;
+      FakeClock clock;
+      plain_telemetry_t telemetry;
+      telemetry.init( radio, clock, *debug_ );
+      telemetry.reg_recv_callback<TrafficTelemetryTest, &TrafficTelemetryTest::receive>( this );
+
+      plain_ = extended_ = 0;
+      telemetry.send( 2, 10, frame( 7 ) );
+      radio.deliver( 2, 5, frame( 7 ) );
+      check( "plain radio", radio.frames() == 1 && plain_ == 1 && extended_ == 0 &&
+         equal( telemetry.stats().total, 1, 10, 1, 5 ) );
+   }
+   // --------------------------------------------------------------------
+   block_data_t* frame( uint8_t message_id )
+   {
+      memset( buffer_, 0, sizeof( buffer_ ) );
+      buffer_[0] = message_id;
+      return buffer_;
+   }
+   // --------------------------------------------------------------------
+   static ExtendedData ex_data()
+   {
+      ExtendedData ex;
+      ex.set_link_metric( LINK_METRIC );
+      return ex;
+   }
+   // --------------------------------------------------------------------
+   static const telemetry_t::TypeEntry* type( const Snapshot& s, uint8_t message_id )
+   {
+      for ( int i = 0; i < 2; ++i )
+         if ( s.types[i].used && s.types[i].message_id == message_id )
+            return &s.types[i];
+      return 0;
+   }
+   // --------------------------------------------------------------------
+   static const telemetry_t::NeighborEntry* neighbor( const Snapshot& s, node_id_t node )
+   {
+      for ( int i = 0; i < 2; ++i )
+         if ( s.neighbors[i].used && s.neighbors[i].node == node )
+            return &s.neighbors[i];
+      return 0;
+   }
+   // --------------------------------------------------------------------
+   static bool equal( const wiselib::TrafficCounters& c, uint32_t tx_packets, uint32_t tx_bytes,
+      uint32_t rx_packets, uint32_t rx_bytes )
+   {
+      return c.tx_packets == tx_packets && c.tx_bytes == tx_bytes &&
+         c.rx_packets == rx_packets && c.rx_bytes == rx_bytes;
+   }
+   // --------------------------------------------------------------------
+   /** Bins a, b and c hold one value each, all others none.
+    */
+   static bool histogram( const uint32_t *h, int a, int b, int c )
+   {
+      return h[a] == 1 && h[b] == 1 && h[c] == 1 && total( h ) == 3;
+   }
+   // --------------------------------------------------------------------
+   static uint32_t total( const uint32_t *h )
+   {
+      uint32_t r = 0;
+      for ( int i = 0; i < 12; ++i )
+         r += h[i];
+      return r;
+   }
+   // --------------------------------------------------------------------
+   void check( const char *step, bool ok )
+   {
+      if ( !ok )
+      {
+         debug_->debug( "traffic_telemetry_test;FAILED;%s", step );
+         failed_++;
+      }
+   }
+   // --------------------------------------------------------------------
+   block_data_t buffer_[128];
+   int failed_;
+   int plain_;
+   int extended_;
+   uint16_t metric_;
+   Os::Debug::self_pointer_t debug_;
+};
+// --------------------------------------------------------------------------
+wiselib::WiselibApplication<Os, TrafficTelemetryTest> traffic_telemetry_test;
+// --------------------------------------------------------------------------
+void application_main( Os::AppMainParameter& value )
+{
+   traffic_telemetry_test.init( value );
+}
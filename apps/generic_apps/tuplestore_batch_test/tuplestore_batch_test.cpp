@@ -0,0 +1,220 @@
+/**
+ * TupleStore Batch Test Application
+ * Inserts a batch of TUPLES tuples, most of them duplicates, into a
+ * TupleStore with insert_batch(). The batch spans more than one chunk and
+ * the chunk is larger than 256 tuples. Then it inserts the batch once more,
+ * erases by pattern with erase_matching() and finally erases everything.
+ *
+ * After every step the number of stored tuples is compared against a
+ * brute force count. The references the store holds in the dictionary
+ * are compared against the keys found in the container. Erased values
+ * must have left the dictionary.
+ *
+ * Prints "tuplestore_batch_test;ok" or the steps that failed.
+ */
+#define TUPLESTORE_BATCH_SIZE 300
+
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#include "util/allocators/malloc_free_allocator.h"
+typedef MallocFreeAllocator<Os> Allocator;
+Allocator& get_allocator();
+
+#include <util/meta.h>
+#include <util/pstl/list_dynamic.h>
+#include <util/pstl/unique_container.h>
+#include <util/tuple_store/tuplestore.h>
+#include <util/tuple_store/prescilla_dictionary.h>
+#include "../inqp_test/tuple.h"
+
+#define TUPLES 700
+#define MAX_KEYS 64
+#define STRING_LENGTH 8
+
+/**
+ * PrescillaDictionary that keeps its own count of the references taken
+ * with insert() and dropped with erase().
+ */
+class CountingDictionary : public PrescillaDictionary<Os> {
+	public:
+		typedef PrescillaDictionary<Os> Base;
+
+		CountingDictionary() : keys_(0), errors_(0) {
+		}
+
+		key_type insert(value_type v) {
+			key_type k = Base::insert(v);
+			if(k != NULL_KEY) {
+				size_type i = index(k);
+				if(i == keys_) {
+					if(keys_ == MAX_KEYS) { errors_++; return k; }
+					key_[keys_] = k;
+					references_[keys_++] = 0;
+				}
+				references_[i]++;
+			}
+			return k;
+		}
+
+		void erase(key_type k) {
+			size_type i = index(k);
+			if(i == keys_ || references_[i] == 0) { errors_++; }
+			else { references_[i]--; }
+			Base::erase(k);
+		}
+
+		/// References currently held for k.
+		size_type references(key_type k) {
+			size_type i = index(k);
+			return (i == keys_) ? 0 : references_[i];
+		}
+
+		size_type keys() { return keys_; }
+		key_type key(size_type i) { return key_[i]; }
+
+		/// erase() calls for keys without references.
+		size_type errors() { return errors_; }
+
+	private:
+		size_type index(key_type k) {
+			size_type i = 0;
+			while(i < keys_ && !(key_[i] == k && references_[i])) { i++; }
+			if(i < keys_) { return i; }
+			// a key may be handed out again after its entry was freed
+			for(i = 0; i < keys_ && key_[i] != k; i++) { }
+			return i;
+		}
+
+		key_type key_[MAX_KEYS];
+		size_type references_[MAX_KEYS];
+		size_type keys_;
+		size_type errors_;
+};
+
+typedef Tuple<Os> TupleT;
+typedef wiselib::list_dynamic<Os, TupleT> TupleList;
+typedef wiselib::UniqueContainer<TupleList> TupleContainer;
+typedef wiselib::TupleStore<Os, TupleContainer, CountingDictionary, Os::Debug, BIN(111), &TupleT::compare> TS;
+
+class TupleStoreBatchTest {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &wiselib::FacetProvider<Os, Os::Debug>::get_facet(value);
+			failed_ = 0;
+
+			dictionary_.init(debug_);
+			ts_.init(&dictionary_, &container_, debug_);
+
+			for(size_type j = 0; j < TUPLES; j++) {
+				snprintf((char*)strings_[j][0], STRING_LENGTH, "s%d", (int)((j * 7) % 13));
+				snprintf((char*)strings_[j][1], STRING_LENGTH, "p%d", (int)((j * 3) % 5));
+				snprintf((char*)strings_[j][2], STRING_LENGTH, "o%d", (int)((j * j) % 11));
+				for(size_type i = 0; i < 3; i++) {
+					batch_[j].set(i, strings_[j][i]);
+				}
+			}
+
+			size_type distinct = count(0);
+			size_type added = ts_.insert_batch(batch_, TUPLES);
+			check("insert", added == distinct && ts_.size() == distinct);
+
+			added = ts_.insert_batch(batch_, TUPLES);
+			check("insert again", added == 0 && ts_.size() == distinct);
+
+			TupleT query;
+			query.set(1, (block_data_t*)"p1");
+			size_type erased = ts_.erase_matching(&query, BIN(10));
+			check("erase p1", erased == count((block_data_t*)"p1") &&
+					ts_.size() == distinct - erased &&
+					dictionary_.find((block_data_t*)"p1") == CountingDictionary::NULL_KEY);
+
+			erased = ts_.erase_matching();
+			check("erase all", erased == distinct - count((block_data_t*)"p1") && ts_.size() == 0);
+			for(size_type k = 0; k < dictionary_.keys(); k++) {
+				if(dictionary_.references(dictionary_.key(k))) {
+					check("dictionary empty", false);
+					break;
+				}
+			}
+
+			if(!failed_) {
+				debug_->debug("tuplestore_batch_test;ok");
+			}
+		}
+
+	private:
+		/**
+		 * Number of distinct tuples in the batch, only those with
+		 * predicate p if given.
+		 */
+		size_type count(block_data_t* p) {
+			size_type r = 0;
+			for(size_type j = 0; j < TUPLES; j++) {
+				if(p && strcmp((char*)strings_[j][1], (char*)p) != 0) { continue; }
+				size_type k = 0;
+				for( ; k < j; k++) {
+					if(strcmp((char*)strings_[j][0], (char*)strings_[k][0]) == 0 &&
+							strcmp((char*)strings_[j][1], (char*)strings_[k][1]) == 0 &&
+							strcmp((char*)strings_[j][2], (char*)strings_[k][2]) == 0) {
+						break;
+					}
+				}
+				if(k == j) { r++; }
+			}
+			return r;
+		}
+
+		/**
+		 * Reports step as failed unless ok holds and every dictionary
+		 * reference is held by exactly one column of a stored tuple.
+		 */
+		void check(const char* step, bool ok) {
+			size_type held = 0;
+			for(size_type k = 0; k < dictionary_.keys(); k++) {
+				CountingDictionary::key_type key = dictionary_.key(k);
+				size_type used = 0;
+				for(TupleContainer::iterator it = container_.begin(); it != container_.end(); ++it) {
+					for(size_type i = 0; i < 3; i++) {
+						if(TS::to_key(it->get(i)) == key) { used++; }
+					}
+				}
+				if(used != dictionary_.references(key)) { ok = false; }
+				held += dictionary_.references(key);
+			}
+			if(held != 3 * ts_.size() || dictionary_.errors()) { ok = false; }
+
+			if(!ok) {
+				debug_->debug("tuplestore_batch_test;failed;%s;tuples=%d;references=%d;errors=%d",
+						step, (int)ts_.size(), (int)held, (int)dictionary_.errors());
+				failed_++;
+			}
+		}
+
+		block_data_t strings_[TUPLES][3][STRING_LENGTH];
+		TupleT batch_[TUPLES];
+
+		CountingDictionary dictionary_;
+		TupleContainer container_;
+		TS ts_;
+		size_type failed_;
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, TupleStoreBatchTest> tuplestore_batch_test;
+
+Allocator allocator_;
+
+Allocator& get_allocator() { return allocator_; }
+
+void application_main(Os::AppMainParameter& value) {
+	tuplestore_batch_test.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
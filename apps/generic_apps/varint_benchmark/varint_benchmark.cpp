@@ -0,0 +1,182 @@
+/**
+ * Varint Codec Benchmark Application
+ * Encodes VALUES 32 bit IDs of five distributions (below 128, below
+ * 16384, uniform length of 1 to 14 bits, i.e. one and two byte varints
+ * in random order, uniform 32 bit, uniform length of 1 to 32 bits) and
+ * decodes them again with VarInt over a
+ * pointer buffer, VarIntCodec::decode() per value and
+ * VarIntCodec::decode_array(); then round trips signed 64 bit values
+ * through ZigZag. Prints ns per value and million values per second of
+ * the fastest of ROUNDS rounds for each decoder plus the number of values
+ * that did not round trip.
+ *
+ *   make pc
+ *   make pc ADD_CXXFLAGS=-mssse3      (SIMD bulk decode)
+ */
+#include "external_interface/external_interface_testing.h"
+
+using namespace wiselib;
+
+typedef OSMODEL Os;
+
+#include "util/protobuf/varint.h"
+#include "util/protobuf/zigzag.h"
+#include "util/protobuf/varint_codec.h"
+
+#include <ctime>
+
+typedef Os::block_data_t block_data_t;
+typedef Os::size_t size_type;
+
+#define VALUES 1000000
+#define ROUNDS 20
+
+typedef protobuf::VarInt<Os, block_data_t*, uint32_t> VarInt32;
+typedef protobuf::ZigZag<Os, block_data_t*, int64_t> ZigZag64;
+typedef protobuf::VarIntCodec<Os> Codec;
+
+class VarIntBenchmark {
+	public:
+		void init(Os::AppMainParameter& value) {
+			debug_ = &FacetProvider<Os, Os::Debug>::get_facet(value);
+			values_ = new uint32_t[VALUES];
+			decoded_ = new uint32_t[VALUES];
+			buffer_ = new block_data_t[VALUES * Codec::MAX_BYTES];
+
+			debug_->debug("varint_benchmark;distribution;decoder;bytes_per_value;ns_per_value;mvalues_per_s;errors");
+			run("small", 0x7f);
+			run("medium", 0x3fff);
+			run("short", 0, 18);
+			run("large", 0xffffffff);
+			run("mixed", 0, 0);
+			zigzag();
+
+			delete[] values_;
+			delete[] decoded_;
+			delete[] buffer_;
+		}
+
+		/**
+		 * Values below max + 1, or with max 0 of 1 to 32 - min_shift
+		 * significant bits.
+		 */
+		void run(const char *name, uint32_t max, uint32_t min_shift = 0) {
+			uint32_t x = 12345;
+			for(size_type i = 0; i < VALUES; i++) {
+				x = x * 1103515245 + 12345;
+				values_[i] = (x ^ (x >> 13) * 2654435761u);
+				values_[i] = max ? values_[i] & max : values_[i] >> (min_shift + (x >> 27) % (32 - min_shift));
+			}
+			size_type len = Codec::encode_array(values_, VALUES, buffer_);
+
+			std::clock_t best = 0;
+			for(int r = 0; r < ROUNDS; r++) {
+				std::clock_t t0 = std::clock();
+				block_data_t *p = buffer_, *end = buffer_ + len;
+				for(size_type i = 0; i < VALUES; i++) {
+					VarInt32::read(p, end, decoded_[i]);
+				}
+				best = fastest(best, r, t0);
+			}
+			report(name, "varint", len, best, count_errors());
+
+			for(int r = 0; r < ROUNDS; r++) {
+				std::clock_t t0 = std::clock();
+				const block_data_t *p = buffer_, *end = buffer_ + len;
+				for(size_type i = 0; i < VALUES; i++) {
+					uint64_t v = 0;
+					p += Codec::decode(p, end, v);
+					decoded_[i] = (uint32_t)v;
+				}
+				best = fastest(best, r, t0);
+			}
+			report(name, "codec", len, best, count_errors());
+
+			for(int r = 0; r < ROUNDS; r++) {
+				std::clock_t t0 = std::clock();
+				Codec::decode_array(buffer_, buffer_ + len, decoded_, VALUES);
+				best = fastest(best, r, t0);
+			}
+			report(name, "codec_array", len, best, count_errors());
+		}
+
+		/**
+		 * Time since t0 if round r is the first one or faster than best,
+		 * else best.
+		 */
+		static std::clock_t fastest(std::clock_t best, int r, std::clock_t t0) {
+			std::clock_t t = std::clock() - t0;
+			return (r == 0 || t < best) ? t : best;
+		}
+
+		size_type count_errors() {
+			size_type errors = 0;
+			for(size_type i = 0; i < VALUES; i++) {
+				if(decoded_[i] != values_[i]) { errors++; }
+				decoded_[i] = 0;
+			}
+			return errors;
+		}
+
+		/**
+		 * Prints one row, t being the time of the fastest round.
+		 */
+		void report(const char *name, const char *decoder, size_type len, std::clock_t t, size_type errors) {
+			double ns = (double)t * 1.0e9 / CLOCKS_PER_SEC / (double)VALUES;
+			debug_->debug("varint_benchmark;%s;%s;%d.%02d;%d.%02d;%d;%d", name, decoder,
+					(int)(len / VALUES), (int)(len * 100 / VALUES % 100),
+					(int)ns, (int)(ns * 100) % 100, (int)(ns > 0 ? 1000.0 / ns : 0), (int)errors);
+		}
+
+		void zigzag() {
+			size_type errors = 0;
+			int64_t samples[] = { 0, -1, 1, -64, 64, -2147483647LL - 1, 2147483647LL,
+				-9223372036854775807LL - 1, 9223372036854775807LL };
+			block_data_t *p = buffer_, *end = buffer_ + VALUES * Codec::MAX_BYTES;
+			uint64_t x = 1;
+			for(size_type i = 0; i < VALUES; i++) {
+				x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+				int64_t v = i < sizeof(samples) / sizeof(samples[0]) ? samples[i] : (int64_t)x >> (i % 64);
+				ZigZag64::write(p, end, v);
+			}
+			size_type len = p - buffer_;
+			p = buffer_;
+			x = 1;
+			for(size_type i = 0; i < VALUES; i++) {
+				x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+				int64_t v = i < sizeof(samples) / sizeof(samples[0]) ? samples[i] : (int64_t)x >> (i % 64), r;
+				if(!ZigZag64::read(p, end, r) || r != v) { errors++; }
+			}
+
+			// decoding alone, the sum keeps the loop from being dropped
+			std::clock_t best = 0;
+			int64_t sum = 0;
+			for(int r = 0; r < ROUNDS; r++) {
+				std::clock_t t0 = std::clock();
+				p = buffer_;
+				for(size_type i = 0; i < VALUES; i++) {
+					int64_t v;
+					ZigZag64::read(p, end, v);
+					sum += v;
+				}
+				best = fastest(best, r, t0);
+			}
+			if(sum == 1) { errors++; }
+			report("zigzag64", "varint", len, best, errors);
+		}
+
+	private:
+		uint32_t *values_;
+		uint32_t *decoded_;
+		block_data_t *buffer_;
+
+		Os::Debug::self_pointer_t debug_;
+};
+
+wiselib::WiselibApplication<Os, VarIntBenchmark> varint_benchmark;
+
+void application_main(Os::AppMainParameter& value) {
+	varint_benchmark.init(value);
+}
+
+/* vim: set ts=4 sw=4 tw=78 noexpandtab foldmethod=marker foldenable :*/
@@ -34,6 +34,7 @@
 
 // ---------------- Base Classes --------------------------------------------
 #define RADIO_BASE_MAX_RECEIVERS 10
+#define RADIO_BASE_MAX_BATCH_RECEIVERS 2
 #define UART_BASE_MAX_RECEIVERS 10
 #define STATE_CALLBACK_BASE_MAX_RECEIVERS 10
 #define SENSOR_CALLBACK_BASE_MAX_RECEIVERS 10
@@ -21,8 +21,13 @@
 
 #include "util/delegates/delegate.hpp"
 #include "util/pstl/vector_static.h"
+#include "util/base_classes/receiver_dispatch_table.h"
 #include "config.h"
 
+#ifndef RADIO_BASE_MAX_BATCH_RECEIVERS
+#define RADIO_BASE_MAX_BATCH_RECEIVERS 2
+#endif
+
 namespace wiselib
 {
 
@@ -32,6 +37,12 @@ namespace wiselib
     *
     *  Basic radio class that provides helpful methods like registration of
     *  callbacks.
+    *
+    *  Receivers may register for all frames or only for those whose first
+    *  byte, the message id of nearly every protocol, has a given value;
+    *  see ReceiverDispatchTable. Batch receivers get several frames per
+    *  call from notify_receivers( frames, count ), e.g. everything a driver
+    *  drained from its receive queue, and a batch of one for single frames.
     */
    template<typename OsModel_P,
             typename NodeId_P,
@@ -49,25 +60,61 @@ namespace wiselib
 
       typedef delegate3<void, node_id_t, size_t, block_data_t*> radio_delegate_t;
 
-      typedef vector_static<OsModel, radio_delegate_t, MAX_RECEIVERS> CallbackVector;
-      typedef typename CallbackVector::iterator CallbackVectorIterator;
+      /** One received frame of a batch.
+       */
+      struct Frame
+      {
+         node_id_t from;
+         size_t len;
+         block_data_t *data;
+      };
+      typedef delegate2<void, const Frame*, size_t> batch_delegate_t;
+
+      typedef ReceiverDispatchTable<MAX_RECEIVERS> DispatchTable;
       // --------------------------------------------------------------------
       enum ReturnValues
       {
          SUCCESS = OsModel::SUCCESS
       };
       // --------------------------------------------------------------------
+      enum MessageIds
+      {
+         ANY_MESSAGE_ID = DispatchTable::ANY_MESSAGE_ID ///< Receiver gets every frame
+      };
+      // --------------------------------------------------------------------
       template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*)>
       int reg_recv_callback( T *obj_pnt )
       {
-         if ( callbacks_.empty() )
-            callbacks_.assign( MAX_RECEIVERS, radio_delegate_t() );
+         return reg_recv_callback<T, TMethod>( obj_pnt, ANY_MESSAGE_ID );
+      }
+      // --------------------------------------------------------------------
+      /** Registers a receiver for the frames starting with message_id only.
+       */
+      template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*)>
+      int reg_recv_callback( T *obj_pnt, int message_id )
+      {
+         int idx = table_.insert( message_id );
+         if ( idx >= 0 )
+            callbacks_[idx] = radio_delegate_t::template from_method<T, TMethod>( obj_pnt );
 
-         for ( unsigned int i = 0; i < callbacks_.size(); ++i )
+         return idx;
+      }
+      // --------------------------------------------------------------------
+      int unreg_recv_callback( int idx )
+      {
+         callbacks_[idx] = radio_delegate_t();
+         table_.remove( idx );
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      template<class T, void (T::*TMethod)(const Frame*, size_t)>
+      int reg_recv_batch_callback( T *obj_pnt )
+      {
+         for ( int i = 0; i < RADIO_BASE_MAX_BATCH_RECEIVERS; ++i )
          {
-            if ( callbacks_.at(i) == radio_delegate_t() )
+            if ( !batch_callbacks_[i] )
             {
-               callbacks_.at(i) = radio_delegate_t::template from_method<T, TMethod>( obj_pnt );
+               batch_callbacks_[i] = batch_delegate_t::template from_method<T, TMethod>( obj_pnt );
                return i;
             }
          }
@@ -75,27 +122,62 @@ namespace wiselib
          return -1;
       }
       // --------------------------------------------------------------------
-      int unreg_recv_callback( int idx )
+      int unreg_recv_batch_callback( int idx )
       {
-         callbacks_.at(idx) = radio_delegate_t();
+         batch_callbacks_[idx] = batch_delegate_t();
          return SUCCESS;
       }
       // --------------------------------------------------------------------
       void notify_receivers( node_id_t from, size_t len, block_data_t *data )
       {
-         for ( CallbackVectorIterator
-                  it = callbacks_.begin();
-                  it != callbacks_.end();
-                  ++it )
+         Frame frame;
+         frame.from = from;
+         frame.len = len;
+         frame.data = data;
+         notify_receivers( &frame, 1 );
+      }
+      // --------------------------------------------------------------------
+      /** Hands count frames one by one to the receivers registered for
+       *  them and in one call to every batch receiver.
+       */
+      void notify_receivers( const Frame *frames, size_t count )
+      {
+         table_.lock();
+         for ( size_t k = 0; k < count; ++k )
          {
-            if ( *it != radio_delegate_t() )
-               (*it)( from, len, data );
+            Delivery delivery( callbacks_, frames[k] );
+            table_.dispatch( frames[k].len ? frames[k].data[0] : -1, delivery );
+         }
+         table_.unlock();
+
+         for ( int i = 0; i < RADIO_BASE_MAX_BATCH_RECEIVERS; ++i )
+         {
+            if ( batch_callbacks_[i] && count > 0 )
+               batch_callbacks_[i]( frames, count );
          }
       }
 
    private:
-      CallbackVector callbacks_;
+      struct Delivery
+      {
+         Delivery( radio_delegate_t *cbs, const Frame& f )
+            : callbacks( cbs ), frame( f )
+         {}
+
+         void operator()( uint8_t slot )
+         {
+            // a receiver may have unregistered another one meanwhile
+            if ( callbacks[slot] )
+               callbacks[slot]( frame.from, frame.len, frame.data );
+         }
 
+         radio_delegate_t *callbacks;
+         const Frame& frame;
+      };
+      // --------------------------------------------------------------------
+      radio_delegate_t callbacks_[MAX_RECEIVERS];
+      batch_delegate_t batch_callbacks_[RADIO_BASE_MAX_BATCH_RECEIVERS];
+      DispatchTable table_;
    };
 
 }
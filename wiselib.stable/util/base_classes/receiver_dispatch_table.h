@@ -0,0 +1,149 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __UTIL_BASECLASSES_RECEIVER_DISPATCH_TABLE_H__
+#define __UTIL_BASECLASSES_RECEIVER_DISPATCH_TABLE_H__
+
+namespace wiselib
+{
+
+   /** \brief Compacted receiver table of the radio base classes.
+    *
+    *  Maps MAX_RECEIVERS registration slots to the message id (first byte
+    *  of a frame) each receiver wants, or ANY_MESSAGE_ID. The used slots
+    *  are kept in dispatch order: untyped receivers first, then the typed
+    *  ones by ascending message id, so a frame visits no empty slot and
+    *  no receiver of a different message id.
+    *
+    *  While frames are delivered (between lock() and unlock()) the order
+    *  is not rebuilt; the owner checks its delegate before each call, so
+    *  receivers removed from a callback are skipped.
+    */
+   template<int MAX_RECEIVERS>
+   class ReceiverDispatchTable
+   {
+   public:
+      enum MessageIds
+      {
+         ANY_MESSAGE_ID = -1, ///< Receiver gets every frame
+         FREE_SLOT = -2
+      };
+      // --------------------------------------------------------------------
+      ReceiverDispatchTable()
+         : size_( 0 ), any_size_( 0 ), locked_( 0 ), dirty_( false )
+      {
+         for ( int i = 0; i < MAX_RECEIVERS; ++i )
+            message_ids_[i] = FREE_SLOT;
+      }
+      // --------------------------------------------------------------------
+      /** \return registration slot, -1 if the table is full
+       */
+      int insert( int message_id )
+      {
+         for ( int i = 0; i < MAX_RECEIVERS; ++i )
+         {
+            if ( message_ids_[i] == FREE_SLOT )
+            {
+               message_ids_[i] = message_id;
+               update();
+               return i;
+            }
+         }
+
+         return -1;
+      }
+      // --------------------------------------------------------------------
+      void remove( int slot )
+      {
+         message_ids_[slot] = FREE_SLOT;
+         update();
+      }
+      // --------------------------------------------------------------------
+      void lock()
+      { ++locked_; }
+      // --------------------------------------------------------------------
+      void unlock()
+      {
+         if ( --locked_ == 0 && dirty_ )
+            update();
+      }
+      // --------------------------------------------------------------------
+      /** Calls deliver( slot ) for every receiver of a frame starting with
+       *  message_id (-1 for an empty frame).
+       */
+      template<class Deliver_P>
+      void dispatch( int message_id, Deliver_P& deliver )
+      {
+         uint8_t i = 0;
+         for ( ; i < any_size_; ++i )
+            deliver( order_[i] );
+         if ( message_id < 0 )
+            return;
+
+         for ( ; i < size_; ++i )
+         {
+            int id = message_ids_[order_[i]];
+            if ( id > message_id )
+               break;
+            if ( id == message_id )
+               deliver( order_[i] );
+         }
+      }
+
+   private:
+      void update()
+      {
+         if ( locked_ )
+         {
+            dirty_ = true;
+            return;
+         }
+         dirty_ = false;
+
+         size_ = 0;
+         for ( int i = 0; i < MAX_RECEIVERS; ++i )
+         {
+            if ( message_ids_[i] == ANY_MESSAGE_ID )
+               order_[size_++] = i;
+         }
+         any_size_ = size_;
+         for ( int i = 0; i < MAX_RECEIVERS; ++i )
+         {
+            if ( message_ids_[i] < 0 )
+               continue;
+            // insertion sort, the table is short and rarely changes
+            uint8_t k = size_++;
+            while ( k > any_size_ && message_ids_[order_[k - 1]] > message_ids_[i] )
+            {
+               order_[k] = order_[k - 1];
+               --k;
+            }
+            order_[k] = i;
+         }
+      }
+      // --------------------------------------------------------------------
+      int16_t message_ids_[MAX_RECEIVERS];
+      uint8_t order_[MAX_RECEIVERS];
+      uint8_t size_;
+      uint8_t any_size_;
+      uint8_t locked_;
+      bool dirty_;
+   };
+
+}
+#endif
@@ -24,6 +24,49 @@
 namespace wiselib
 {
 
+   /** Copies Size_P bytes from source to target in reversed order. Four and
+    *  eight byte values are reversed as whole words with the byte swap
+    *  builtins of GCC where available.
+    */
+   template <int Size_P>
+   struct ByteSwap
+   {
+      template <typename BlockData_P>
+      static inline void copy( BlockData_P *target, const BlockData_P *source )
+      {
+         for ( unsigned int i = 0; i < Size_P; i++ )
+            target[Size_P - 1 - i] = source[i];
+      }
+   };
+#if defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 3 ) )
+   // -----------------------------------------------------------------------
+   template <>
+   struct ByteSwap<4>
+   {
+      template <typename BlockData_P>
+      static inline void copy( BlockData_P *target, const BlockData_P *source )
+      {
+         uint32_t word;
+         __builtin_memcpy( &word, source, 4 );
+         word = __builtin_bswap32( word );
+         __builtin_memcpy( target, &word, 4 );
+      }
+   };
+   // -----------------------------------------------------------------------
+   template <>
+   struct ByteSwap<8>
+   {
+      template <typename BlockData_P>
+      static inline void copy( BlockData_P *target, const BlockData_P *source )
+      {
+         uint64_t word;
+         __builtin_memcpy( &word, source, 8 );
+         word = __builtin_bswap64( word );
+         __builtin_memcpy( target, &word, 8 );
+      }
+   };
+#endif
+   // -----------------------------------------------------------------------
    /** Following implementation assumes "Little Endian". A specialization for
     *  "Big Endian" is also available.
     */
@@ -41,16 +84,14 @@ namespace wiselib
       // --------------------------------------------------------------------
       static inline size_t write( BlockData *target, Type& value )
       {
-         for ( unsigned int i = 0; i < sizeof(Type); i++ )
-            target[sizeof(Type) - 1 - i] = *((BlockData*)&value + i);
+         ByteSwap<sizeof(Type)>::copy( target, (BlockData*)&value );
          return sizeof(Type);
       }
       // --------------------------------------------------------------------
       static Type read( BlockData *target )
       {
          Type value;
-         for ( unsigned int i = 0; i < sizeof(Type); i++ )
-            *((BlockData*)&value + i) = target[sizeof(Type) - 1 - i];
+         ByteSwap<sizeof(Type)>::copy( (BlockData*)&value, target );
          return value;
       }
 
@@ -95,7 +95,7 @@ namespace wiselib
 			
 			//Version is fix 6
 			uint8_t version = 6;
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + VERSION_BYTE, version, VERSION_BIT, VERSION_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, VERSION_BIT, VERSION_LEN>( buffer_ + VERSION_BYTE, version );
 		
 			//Without IPv6 extension headers
 			TRANSPORT_POS = PAYLOAD_POS;
@@ -128,13 +128,13 @@ namespace wiselib
 		void set_traffic_class( uint8_t traffic_class )
 		{
 			//Traffic Class
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + TRAFFIC_CLASS_BYTE, traffic_class, TRAFFIC_CLASS_BIT, TRAFFIC_CLASS_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, TRAFFIC_CLASS_BIT, TRAFFIC_CLASS_LEN>( buffer_ + TRAFFIC_CLASS_BYTE, traffic_class );
 		}
 		
 		void set_flow_label( uint32_t flow_label )
 		{
 			//Flow Label
-			bitwise_write<OsModel, block_data_t, uint32_t>( buffer_ + FLOW_LABEL_BYTE, flow_label, FLOW_LABEL_BIT, FLOW_LABEL_LEN );
+			bitwise_write<OsModel, block_data_t, uint32_t, FLOW_LABEL_BIT, FLOW_LABEL_LEN>( buffer_ + FLOW_LABEL_BYTE, flow_label );
 		}
 		
 		//IMPORTANT NOTE: If there are extension headers, the layer must set the size of the
@@ -144,13 +144,13 @@ namespace wiselib
 			//Add the size of the extension headers
 			length += TRANSPORT_POS - PAYLOAD_POS;
 			//Length
-			bitwise_write<OsModel, block_data_t, uint16_t>( buffer_ + LENGTH_BYTE, length, LENGTH_BIT, LENGTH_LEN );
+			bitwise_write<OsModel, block_data_t, uint16_t, LENGTH_BIT, LENGTH_LEN>( buffer_ + LENGTH_BYTE, length );
 		}
 		
 		void set_real_length( uint16_t length )
 		{
 			//Length
-			bitwise_write<OsModel, block_data_t, uint16_t>( buffer_ + LENGTH_BYTE, length, LENGTH_BIT, LENGTH_LEN );
+			bitwise_write<OsModel, block_data_t, uint16_t, LENGTH_BIT, LENGTH_LEN>( buffer_ + LENGTH_BYTE, length );
 		}
 		
 		//This function only stores the next-header value and it will be placed by the IPv6 layer
@@ -163,13 +163,13 @@ namespace wiselib
 		void set_real_next_header( uint8_t next_header )
 		{
 			//Next Header
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + NEXT_HEADER_BYTE, next_header, NEXT_HEADER_BIT, NEXT_HEADER_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, NEXT_HEADER_BIT, NEXT_HEADER_LEN>( buffer_ + NEXT_HEADER_BYTE, next_header );
 		}
 		
 		void set_hop_limit( uint8_t hop_limit )
 		{
 			//Hop limit
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + HOP_LIMIT_BYTE, hop_limit, HOP_LIMIT_BIT, HOP_LIMIT_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, HOP_LIMIT_BIT, HOP_LIMIT_LEN>( buffer_ + HOP_LIMIT_BYTE, hop_limit );
 		}
 		
 		void set_source_address( node_id_t& source )
@@ -214,29 +214,29 @@ namespace wiselib
 		///@{
 		inline uint8_t version()
 		{
-			return bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + VERSION_BYTE, VERSION_BIT, VERSION_LEN );
+			return bitwise_read<OsModel, block_data_t, uint8_t, VERSION_BIT, VERSION_LEN>( buffer_ + VERSION_BYTE );
 		}
 		
 		inline uint8_t traffic_class()
 		{
-			return bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + TRAFFIC_CLASS_BYTE, TRAFFIC_CLASS_BIT, TRAFFIC_CLASS_LEN );
+			return bitwise_read<OsModel, block_data_t, uint8_t, TRAFFIC_CLASS_BIT, TRAFFIC_CLASS_LEN>( buffer_ + TRAFFIC_CLASS_BYTE );
 		}
 		
 		inline uint32_t flow_label()
 		{
-			return bitwise_read<OsModel, block_data_t, uint32_t>( buffer_ + FLOW_LABEL_BYTE, FLOW_LABEL_BIT, FLOW_LABEL_LEN );
+			return bitwise_read<OsModel, block_data_t, uint32_t, FLOW_LABEL_BIT, FLOW_LABEL_LEN>( buffer_ + FLOW_LABEL_BYTE );
 		}
 		
 		inline uint16_t transport_length()
 		{
-			uint16_t len = bitwise_read<OsModel, block_data_t, uint16_t>( buffer_ + LENGTH_BYTE, LENGTH_BIT, LENGTH_LEN );
+			uint16_t len = bitwise_read<OsModel, block_data_t, uint16_t, LENGTH_BIT, LENGTH_LEN>( buffer_ + LENGTH_BYTE );
 			//Correction: deduct with the length of the extension headers
 			return len - (TRANSPORT_POS - PAYLOAD_POS);
 		}
 		
 		inline uint16_t real_length()
 		{
-			return bitwise_read<OsModel, block_data_t, uint16_t>( buffer_ + LENGTH_BYTE, LENGTH_BIT, LENGTH_LEN );
+			return bitwise_read<OsModel, block_data_t, uint16_t, LENGTH_BIT, LENGTH_LEN>( buffer_ + LENGTH_BYTE );
 		}
 		
 		//NOTE This function returns the used transport layer's value!
@@ -277,12 +277,12 @@ namespace wiselib
 		
 		inline uint8_t real_next_header()
 		{
-			return bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + NEXT_HEADER_BYTE, NEXT_HEADER_BIT, NEXT_HEADER_LEN );
+			return bitwise_read<OsModel, block_data_t, uint8_t, NEXT_HEADER_BIT, NEXT_HEADER_LEN>( buffer_ + NEXT_HEADER_BYTE );
 		}
 		
 		inline uint8_t hop_limit()
 		{
-			return bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + HOP_LIMIT_BYTE, HOP_LIMIT_BIT, HOP_LIMIT_LEN );
+			return bitwise_read<OsModel, block_data_t, uint8_t, HOP_LIMIT_BIT, HOP_LIMIT_LEN>( buffer_ + HOP_LIMIT_BYTE );
 		}
 		
 		inline void source_address(node_id_t& address)
@@ -1047,7 +1047,7 @@ namespace wiselib
 	//------------------------------------------------------------------------------------------------------------
 	//		MESH UNDER HEADER PROCESSING
 	//------------------------------------------------------------------------------------------------------------
-		if( 2 != bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + MESH_DISP_BYTE, MESH_DISP_BIT, MESH_DISP_LEN ) )
+		if( 2 != bitwise_read<OsModel, block_data_t, uint8_t, MESH_DISP_BIT, MESH_DISP_LEN>( buffer_ + ACTUAL_SHIFT + MESH_DISP_BYTE ) )
 		{
 			#ifdef LoWPAN_LAYER_DEBUG
 			debug().debug(" LoWPAN layer: Dropped packet without mesh header in mesh under mode %x %x %x ", buffer_[0], buffer_[1], buffer_[2]);
@@ -1063,14 +1063,14 @@ namespace wiselib
 			ACTUAL_SHIFT++;
 			
 			//EXTRA hopsleft byte exists or not
-			if( 0xF == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN ))
+			if( 0xF == bitwise_read<OsModel, block_data_t, uint8_t, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE ))
 				ACTUAL_SHIFT++;
 			
 			uint8_t padding_size = 0;
 			uint8_t address_size = 0;
 			
 			//Determinate sizes of mesh addresses
-			if ( 0 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_V_BYTE, MESH_V_BIT, MESH_V_LEN ))
+			if ( 0 == bitwise_read<OsModel, block_data_t, uint8_t, MESH_V_BIT, MESH_V_LEN>( buffer_ + MESH_SHIFT + MESH_V_BYTE ))
 			{
 				address_size = 2;
 			}
@@ -1168,14 +1168,14 @@ namespace wiselib
 	
 		//Discover FRAG and IPHC headers
 		uint8_t fragment_offset = 0;
-		uint8_t frag_disp = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + FRAG_DISP_BYTE, FRAG_DISP_BIT, FRAG_DISP_LEN );
+		uint8_t frag_disp = bitwise_read<OsModel, block_data_t, uint8_t, FRAG_DISP_BIT, FRAG_DISP_LEN>( buffer_ + ACTUAL_SHIFT + FRAG_DISP_BYTE );
 		uint16_t datagram_size = 0;
 		
 		if( (0x18 == frag_disp) || (0x1C == frag_disp) )
 		{	
 			FRAG_SHIFT = ACTUAL_SHIFT;
-			uint16_t d_tag = bitwise_read<OsModel, block_data_t, uint16_t>( buffer_ + FRAG_SHIFT + FRAG_TAG_BYTE, FRAG_TAG_BIT, FRAG_TAG_LEN );
-			datagram_size = bitwise_read<OsModel, block_data_t, uint16_t>( buffer_ + FRAG_SHIFT + FRAG_SIZE_BYTE, FRAG_SIZE_BIT, FRAG_SIZE_LEN );
+			uint16_t d_tag = bitwise_read<OsModel, block_data_t, uint16_t, FRAG_TAG_BIT, FRAG_TAG_LEN>( buffer_ + FRAG_SHIFT + FRAG_TAG_BYTE );
+			datagram_size = bitwise_read<OsModel, block_data_t, uint16_t, FRAG_SIZE_BIT, FRAG_SIZE_LEN>( buffer_ + FRAG_SHIFT + FRAG_SIZE_BYTE );
 			
 			//Frag header for the first fragment
 			if(0x18 == frag_disp) 
@@ -1184,7 +1184,7 @@ namespace wiselib
 			else
 			{
 				ACTUAL_SHIFT += 5;
-				fragment_offset = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + FRAG_SHIFT + FRAG_OFFSET_BYTE, FRAG_OFFSET_BIT, FRAG_OFFSET_LEN );
+				fragment_offset = bitwise_read<OsModel, block_data_t, uint8_t, FRAG_OFFSET_BIT, FRAG_OFFSET_LEN>( buffer_ + FRAG_SHIFT + FRAG_OFFSET_BYTE );
 			}
 			
 			//debug().debug( "LoWPAN layer: RECEIVED!!! valid:%i, old tag:%i new tag:%i, old sender: %x offset: %x ", reassembling_mgr_.valid, reassembling_mgr_.datagram_tag, d_tag, reassembling_mgr_.frag_sender, fragment_offset );
@@ -1225,7 +1225,7 @@ namespace wiselib
 	//------------------------------------------------------------------------------------------------------------
 	//		IPHC & NHC HEADER PROCESSING
 	//------------------------------------------------------------------------------------------------------------
-		if( (fragment_offset == 0) && ( 0x03 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + IPHC_DISP_BYTE, IPHC_DISP_BIT, IPHC_DISP_LEN ) ))
+		if( (fragment_offset == 0) && ( 0x03 == bitwise_read<OsModel, block_data_t, uint8_t, IPHC_DISP_BIT, IPHC_DISP_LEN>( buffer_ + ACTUAL_SHIFT + IPHC_DISP_BYTE ) ))
 		{
 			
 			uint16_t NEXT_HEADER_SHIFT = 0;
@@ -1256,7 +1256,7 @@ namespace wiselib
 			//Next header is compressed with NHC
 			if( reassembling_mgr_.ip_packet->real_next_header() == reassembling_mgr_.ip_packet->REAL_NH_NOT_SET )
 			{
-				if( 30 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + NHC_DISP_BYTE, NHC_DISP_BIT, NHC_DISP_LEN ) )
+				if( 30 == bitwise_read<OsModel, block_data_t, uint8_t, NHC_DISP_BIT, NHC_DISP_LEN>( buffer_ + ACTUAL_SHIFT + NHC_DISP_BYTE ) )
 				{
 					is_udp = true;
 					reassembling_mgr_.ip_packet->set_real_next_header( UDP );
@@ -1426,19 +1426,19 @@ namespace wiselib
 		//	Set Dispatch ( 10 )
 		//------------------------------------------------------------------------------------
 		uint8_t mode = 2;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_DISP_BYTE, mode, MESH_DISP_BIT, MESH_DISP_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, MESH_DISP_BIT, MESH_DISP_LEN>( buffer_ + MESH_SHIFT + MESH_DISP_BYTE, mode );
 		
 		//------------------------------------------------------------------------------------
 		//	Set HopsLeft (extra hopsleft byte if required)
 		//------------------------------------------------------------------------------------
 		//If value is short just set it
 		if( hopsleft < 0xF )
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, hopsleft, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, hopsleft );
 		//extra byte required, indicate it with 1111 in the HopsLft field
 		else
 		{
 			mode = 0xF;
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, mode, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, mode );
 		 
 			//Set extra hopleft byte
 			buffer_[ACTUAL_SHIFT++] = hopsleft;
@@ -1483,8 +1483,8 @@ namespace wiselib
 			ACTUAL_SHIFT += 16;
 		}
 		//Set the V and F bits in the header
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_V_BYTE, mode, MESH_V_BIT, MESH_V_LEN );
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_F_BYTE, mode, MESH_F_BIT, MESH_F_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, MESH_V_BIT, MESH_V_LEN>( buffer_ + MESH_SHIFT + MESH_V_BYTE, mode );
+		bitwise_write<OsModel, block_data_t, uint8_t, MESH_F_BIT, MESH_F_LEN>( buffer_ + MESH_SHIFT + MESH_F_BYTE, mode );
 		//------------------------------------------------------------------------------------
 		//	Set V & F & initialize addresses END
 		//------------------------------------------------------------------------------------
@@ -1502,7 +1502,7 @@ namespace wiselib
 	LoWPAN<OsModel_P, Radio_P, Debug_P, Timer_P, Uart_Radio_P>::
 	decrement_hopsleft()
 	{
-		uint8_t hopsleft = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN );
+		uint8_t hopsleft = bitwise_read<OsModel, block_data_t, uint8_t, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE );
 		
 		//Short hopsleft format
 		if( hopsleft < 0x0F )
@@ -1510,7 +1510,7 @@ namespace wiselib
 			if ( hopsleft == 1 )
 				return ERR_UNSPEC;
 			hopsleft = hopsleft - 1;
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, hopsleft, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, MESH_HOPSLEFT_BIT, MESH_HOPSLEFT_LEN>( buffer_ + MESH_SHIFT + MESH_HOPSLEFT_BYTE, hopsleft );
 		}
 		//Long hopsleft format
 		else
@@ -1578,17 +1578,17 @@ namespace wiselib
 		ACTUAL_SHIFT += header_size;
 
 		//Set Dispatch
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + FRAG_SHIFT + FRAG_DISP_BYTE, mode, FRAG_DISP_BIT, FRAG_DISP_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, FRAG_DISP_BIT, FRAG_DISP_LEN>( buffer_ + FRAG_SHIFT + FRAG_DISP_BYTE, mode );
 		
 		//Set datagram size
-		bitwise_write<OsModel, block_data_t, uint16_t>( buffer_ + FRAG_SHIFT + FRAG_SIZE_BYTE, size, FRAG_SIZE_BIT, FRAG_SIZE_LEN );
+		bitwise_write<OsModel, block_data_t, uint16_t, FRAG_SIZE_BIT, FRAG_SIZE_LEN>( buffer_ + FRAG_SHIFT + FRAG_SIZE_BYTE, size );
 		
 		//Set datagram tag
-		bitwise_write<OsModel, block_data_t, uint16_t>( buffer_ + FRAG_SHIFT + FRAG_TAG_BYTE, tag, FRAG_TAG_BIT, FRAG_TAG_LEN );
+		bitwise_write<OsModel, block_data_t, uint16_t, FRAG_TAG_BIT, FRAG_TAG_LEN>( buffer_ + FRAG_SHIFT + FRAG_TAG_BYTE, tag );
 		
 		if( header_size == 5)
 			//Set datagram offset if it is a long version
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + FRAG_SHIFT + FRAG_OFFSET_BYTE, offset, FRAG_OFFSET_BIT, FRAG_OFFSET_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, FRAG_OFFSET_BIT, FRAG_OFFSET_LEN>( buffer_ + FRAG_SHIFT + FRAG_OFFSET_BYTE, offset );
 	}
 
 //-----------------------------------------------------------------------
@@ -1612,7 +1612,7 @@ namespace wiselib
 		//	Set Dispatch ( 011 )
 		//------------------------------------------------------------------------------------
 		uint8_t mode = 3;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DISP_BYTE, mode, IPHC_DISP_BIT, IPHC_DISP_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_DISP_BIT, IPHC_DISP_LEN>( buffer_ + IPHC_SHIFT + IPHC_DISP_BYTE, mode );
 		
 		
 		//------------------------------------------------------------------------------------
@@ -1639,10 +1639,10 @@ namespace wiselib
 			{
 				mode = 1;
 				uint8_t ecn = (0x03 & ((ip_packet->traffic_class()) >> 6 ));
-				bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_ECN_BYTE, ecn, TRAFLO_01_ECN_BIT, TRAFLO_01_ECN_LEN );
+				bitwise_write<OsModel, block_data_t, uint8_t, TRAFLO_01_ECN_BIT, TRAFLO_01_ECN_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_ECN_BYTE, ecn );
 				//Flow label
 				uint32_t flow_label = ip_packet->flow_label();
-				bitwise_write<OsModel, block_data_t, uint32_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_FLO_BYTE, flow_label, TRAFLO_01_FLO_BIT, TRAFLO_01_FLO_LEN );
+				bitwise_write<OsModel, block_data_t, uint32_t, TRAFLO_01_FLO_BIT, TRAFLO_01_FLO_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_FLO_BYTE, flow_label );
 				ACTUAL_SHIFT += 3;
 			}
 			//USE TF = 00, both in-line
@@ -1651,15 +1651,15 @@ namespace wiselib
 				mode = 0;
 				//Traffic class (ECN & DSCP)
 				uint8_t traffic_class = ip_packet->traffic_class();
-				bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_TRA_BYTE, traffic_class, TRAFLO_00_TRA_BIT, TRAFLO_00_TRA_LEN );
+				bitwise_write<OsModel, block_data_t, uint8_t, TRAFLO_00_TRA_BIT, TRAFLO_00_TRA_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_TRA_BYTE, traffic_class );
 				//Flow label
 				uint32_t flow_label = ip_packet->flow_label();
-				bitwise_write<OsModel, block_data_t, uint32_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_FLO_BYTE, flow_label, TRAFLO_00_FLO_BIT, TRAFLO_00_FLO_LEN );
+				bitwise_write<OsModel, block_data_t, uint32_t, TRAFLO_00_FLO_BIT, TRAFLO_00_FLO_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_FLO_BYTE, flow_label );
 				ACTUAL_SHIFT += 4;
 			}
 		}
 		//SET TF bits in the IPHC header
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_TF_BYTE, mode, IPHC_TF_BIT, IPHC_TF_LEN );	
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_TF_BIT, IPHC_TF_LEN>( buffer_ + IPHC_SHIFT + IPHC_TF_BYTE, mode );	
 		//------------------------------------------------------------------------------------
 		//	SET TRAFFIC CLASS & FLOW LABEL	END
 		//------------------------------------------------------------------------------------
@@ -1683,7 +1683,7 @@ namespace wiselib
 			mode = 1;
 		}
 		//Set NH bit in the IPHC header
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_NH_BYTE, mode, IPHC_NH_BIT, IPHC_NH_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_NH_BIT, IPHC_NH_LEN>( buffer_ + IPHC_SHIFT + IPHC_NH_BYTE, mode );
 		//------------------------------------------------------------------------------------
 		//	SET NEXT HEADER		END
 		//------------------------------------------------------------------------------------
@@ -1708,7 +1708,7 @@ namespace wiselib
 				break;
 		}
 		//Set the HLIM bits in the IPHC header
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_HLIM_BYTE, mode, IPHC_HLIM_BIT, IPHC_HLIM_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_HLIM_BIT, IPHC_HLIM_LEN>( buffer_ + IPHC_SHIFT + IPHC_HLIM_BYTE, mode );
 		//------------------------------------------------------------------------------------
 		//	SET Hop LIMit		END
 		//------------------------------------------------------------------------------------
@@ -1785,10 +1785,10 @@ namespace wiselib
 			}
 			
 			//Set the DAC bit
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, AC_mode, IPHC_DAC_BIT, IPHC_DAC_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_DAC_BIT, IPHC_DAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, AC_mode );
 			
 			//Set the DAM bits
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, AM_mode, IPHC_DAM_BIT, IPHC_DAM_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_DAM_BIT, IPHC_DAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, AM_mode );
 			
 		}
 		else
@@ -1798,10 +1798,10 @@ namespace wiselib
 		}
 		
 		//Set the M bit
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_M_BYTE, M_mode, IPHC_M_BIT, IPHC_M_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_M_BIT, IPHC_M_LEN>( buffer_ + IPHC_SHIFT + IPHC_M_BYTE, M_mode );
 		
 		//Set the CID bit
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE, CID_mode, IPHC_CID_BIT, IPHC_CID_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, IPHC_CID_BIT, IPHC_CID_LEN>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE, CID_mode );
 		
 		//Set the CID byte is required!
 		if( CID_mode == 1 )
@@ -1842,7 +1842,7 @@ namespace wiselib
 		//	Set Dispatch ( 1110 )
 		//------------------------------------------------------------------------------------
 		uint8_t mode = 14;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + ACT_EH_SHIFT + EH_NHC_DISP_BYTE, mode, EH_NHC_DISP_BIT, EH_NHC_DISP_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, EH_NHC_DISP_BIT, EH_NHC_DISP_LEN>( buffer_ + ACT_EH_SHIFT + EH_NHC_DISP_BYTE, mode );
 		
 		//------------------------------------------------------------------------------------
 		//	Set EID
@@ -1852,7 +1852,7 @@ namespace wiselib
 		if( actual_NH_value == EH_HOHO )
 		{
 			mode = EID_EH_HOHO;
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + ACT_EH_SHIFT + EH_NHC_EID_BYTE, mode, EH_NHC_EID_BIT, EH_NHC_EID_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, EH_NHC_EID_BIT, EH_NHC_EID_LEN>( buffer_ + ACT_EH_SHIFT + EH_NHC_EID_BYTE, mode );
 		}
 		else
 		{
@@ -1871,7 +1871,7 @@ namespace wiselib
 		//NH elided for NHC comprassable headers
 		else
 			mode = 1;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + ACT_EH_SHIFT + EH_NHC_NH_BYTE, mode, EH_NHC_NH_BIT, EH_NHC_NH_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, EH_NHC_NH_BIT, EH_NHC_NH_LEN>( buffer_ + ACT_EH_SHIFT + EH_NHC_NH_BYTE, mode );
 		
 		//------------------------------------------------------------------------------------
 		//	Set the length for the EH
@@ -1914,7 +1914,7 @@ namespace wiselib
 		//	Set Dispatch ( 11110 )
 		//------------------------------------------------------------------------------------
 		uint8_t mode = 30;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + NHC_SHIFT + NHC_DISP_BYTE, mode, NHC_DISP_BIT, NHC_DISP_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, NHC_DISP_BIT, NHC_DISP_LEN>( buffer_ + NHC_SHIFT + NHC_DISP_BYTE, mode );
 		
 		//------------------------------------------------------------------------------------
 		//	SET CHECKSUM
@@ -1922,7 +1922,7 @@ namespace wiselib
 		
 		//NOTE CHECKSUM is not elided by default
 		uint8_t C_mode = 0;
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + NHC_SHIFT + NHC_C_BYTE, C_mode, NHC_C_BIT, NHC_C_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, NHC_C_BIT, NHC_C_LEN>( buffer_ + NHC_SHIFT + NHC_C_BYTE, C_mode );
 				
 		//------------------------------------------------------------------------------------
 		//	SET CHECKSUM		END
@@ -1970,7 +1970,7 @@ namespace wiselib
 		}
 		
 		//Set the P bits
-		bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + NHC_SHIFT + NHC_P_BYTE, mode, NHC_P_BIT, NHC_P_LEN );
+		bitwise_write<OsModel, block_data_t, uint8_t, NHC_P_BIT, NHC_P_LEN>( buffer_ + NHC_SHIFT + NHC_P_BYTE, mode );
 		
 		//------------------------------------------------------------------------------------
 		//	SET PORTS		END
@@ -2006,28 +2006,28 @@ namespace wiselib
 		// Read the CID value and increment the shift if there is a CID byte after the IPHC header
 		//--------------------------------------
 		
-			if( 1 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE, IPHC_CID_BIT, IPHC_CID_LEN ) )
+			if( 1 == bitwise_read<OsModel, block_data_t, uint8_t, IPHC_CID_BIT, IPHC_CID_LEN>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE ) )
 				ACTUAL_SHIFT++;
 		
 		//------------------------------------
 		// TRAFIC CLASS & FLOW LABEL
 		//------------------------------------
 		
-			uint8_t mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_TF_BYTE, IPHC_TF_BIT, IPHC_TF_LEN );
+			uint8_t mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_TF_BIT, IPHC_TF_LEN>( buffer_ + IPHC_SHIFT + IPHC_TF_BYTE );
 		
 			switch(mode) {
 			case 0:
 				//Traffic class (ECN & DSCP)
-				packet->set_traffic_class(bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_TRA_BYTE, TRAFLO_00_TRA_BIT, TRAFLO_00_TRA_LEN ));
+				packet->set_traffic_class(bitwise_read<OsModel, block_data_t, uint8_t, TRAFLO_00_TRA_BIT, TRAFLO_00_TRA_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_TRA_BYTE ));
 				//Flow label
-				packet->set_flow_label(bitwise_read<OsModel, block_data_t, uint32_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_FLO_BYTE, TRAFLO_00_FLO_BIT, TRAFLO_00_FLO_LEN ));
+				packet->set_flow_label(bitwise_read<OsModel, block_data_t, uint32_t, TRAFLO_00_FLO_BIT, TRAFLO_00_FLO_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_00_FLO_BYTE ));
 				ACTUAL_SHIFT += 4;
 				break;
 			case 1:
 				//ECN from Traffic class
-				packet->set_traffic_class((bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_ECN_BYTE, TRAFLO_01_ECN_BIT, TRAFLO_01_ECN_LEN )) << 6);
+				packet->set_traffic_class((bitwise_read<OsModel, block_data_t, uint8_t, TRAFLO_01_ECN_BIT, TRAFLO_01_ECN_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_ECN_BYTE )) << 6);
 				//Flow Label
-				packet->set_flow_label(bitwise_read<OsModel, block_data_t, uint32_t>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_FLO_BYTE, TRAFLO_01_FLO_BIT, TRAFLO_01_FLO_LEN ));
+				packet->set_flow_label(bitwise_read<OsModel, block_data_t, uint32_t, TRAFLO_01_FLO_BIT, TRAFLO_01_FLO_LEN>( buffer_ + ACTUAL_SHIFT + TRAFLO_01_FLO_BYTE ));
 				ACTUAL_SHIFT += 3;
 				break;				
 			case 2:
@@ -2041,7 +2041,7 @@ namespace wiselib
 		//------------------------------------
 		// NEXT HEADER
 		//------------------------------------
-			if( 0 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_NH_BYTE, IPHC_NH_BIT, IPHC_NH_LEN ) )
+			if( 0 == bitwise_read<OsModel, block_data_t, uint8_t, IPHC_NH_BIT, IPHC_NH_LEN>( buffer_ + IPHC_SHIFT + IPHC_NH_BYTE ) )
 				packet->set_real_next_header( buffer_[ACTUAL_SHIFT++] );
 			//Removed because of EH support
 			//else
@@ -2049,7 +2049,7 @@ namespace wiselib
 		//------------------------------------
 		// HOP LIMIT
 		//------------------------------------
-			mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_HLIM_BYTE, IPHC_HLIM_BIT, IPHC_HLIM_LEN );
+			mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_HLIM_BIT, IPHC_HLIM_LEN>( buffer_ + IPHC_SHIFT + IPHC_HLIM_BYTE );
 			switch(mode){
 				case 0:
 					packet->set_hop_limit( buffer_[ACTUAL_SHIFT++] );
@@ -2079,7 +2079,7 @@ namespace wiselib
 		//------------------------------------
 		
 			//Multicast or not
-			if( 0 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_M_BYTE, IPHC_M_BIT, IPHC_M_LEN ))
+			if( 0 == bitwise_read<OsModel, block_data_t, uint8_t, IPHC_M_BIT, IPHC_M_LEN>( buffer_ + IPHC_SHIFT + IPHC_M_BYTE ))
 			{
 				node_id_t my_address = radio_->id();
 				if( get_unicast_address( &my_address , false, address) != SUCCESS )
@@ -2089,9 +2089,9 @@ namespace wiselib
 			}
 			else
 			{
-				if( 0 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, IPHC_DAC_BIT, IPHC_DAC_LEN ))
+				if( 0 == bitwise_read<OsModel, block_data_t, uint8_t, IPHC_DAC_BIT, IPHC_DAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE ))
 				{
-					uint8_t AM_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, IPHC_DAM_BIT, IPHC_DAM_LEN );
+					uint8_t AM_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_DAM_BIT, IPHC_DAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE );
 					
 					//In-line
 					if( AM_mode == 0 )
@@ -2151,7 +2151,7 @@ namespace wiselib
 		uint8_t EH_start_shift = NEXT_HEADER_SHIFT;
 		
 		//Read the initial byte
-		uint8_t EID_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + EH_NHC_EID_BYTE, EH_NHC_EID_BIT, EH_NHC_EID_LEN );
+		uint8_t EID_mode = bitwise_read<OsModel, block_data_t, uint8_t, EH_NHC_EID_BIT, EH_NHC_EID_LEN>( buffer_ + ACTUAL_SHIFT + EH_NHC_EID_BYTE );
 		
 		//if this is the first EH, set the NH value to the IP header
 		if( packet->real_next_header() == packet->REAL_NH_NOT_SET )
@@ -2160,7 +2160,7 @@ namespace wiselib
 				packet->set_real_next_header( EH_HOHO );
 		}
 		
-		uint8_t NH_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + EH_NHC_NH_BYTE, EH_NHC_NH_BIT, EH_NHC_NH_LEN );
+		uint8_t NH_mode = bitwise_read<OsModel, block_data_t, uint8_t, EH_NHC_NH_BIT, EH_NHC_NH_LEN>( buffer_ + ACTUAL_SHIFT + EH_NHC_NH_BYTE );
 		ACTUAL_SHIFT++;
 		
 		//Read the next header byte if it is not NHC
@@ -2189,7 +2189,7 @@ namespace wiselib
 		
 		if( NH_mode == 1 )
 		{
-			if( 30 == bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + ACTUAL_SHIFT + NHC_DISP_BYTE, NHC_DISP_BIT, NHC_DISP_LEN ))
+			if( 30 == bitwise_read<OsModel, block_data_t, uint8_t, NHC_DISP_BIT, NHC_DISP_LEN>( buffer_ + ACTUAL_SHIFT + NHC_DISP_BYTE ))
 			{
 				is_udp = 1;
 				//Set the NH field in the IP packet's actual EH header
@@ -2222,7 +2222,7 @@ namespace wiselib
 			ACTUAL_SHIFT++;
 			
 			//Get the P bits
-			uint8_t P_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + NHC_SHIFT + NHC_P_BYTE, NHC_P_BIT, NHC_P_LEN );
+			uint8_t P_mode = bitwise_read<OsModel, block_data_t, uint8_t, NHC_P_BIT, NHC_P_LEN>( buffer_ + NHC_SHIFT + NHC_P_BYTE );
 			uint16_t port;
 			switch( P_mode ){
 				case 0:
@@ -2264,7 +2264,7 @@ namespace wiselib
 		//------------------------------------
 		//Checksum
 		//------------------------------------
-		uint8_t C_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + NHC_SHIFT + NHC_C_BYTE, NHC_C_BIT, NHC_C_LEN );
+		uint8_t C_mode = bitwise_read<OsModel, block_data_t, uint8_t, NHC_C_BIT, NHC_C_LEN>( buffer_ + NHC_SHIFT + NHC_C_BYTE );
 		//Checksum in-line
 		if( C_mode == 0 )
 		{
@@ -2442,18 +2442,18 @@ namespace wiselib
 		if( source )
 		{
 			//Set the SAC bit
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_SAC_BYTE, AC_mode, IPHC_SAC_BIT, IPHC_SAC_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_SAC_BIT, IPHC_SAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_SAC_BYTE, AC_mode );
 		
 			//Set the SAM bits
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_SAM_BYTE, AM_mode, IPHC_SAM_BIT, IPHC_SAM_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_SAM_BIT, IPHC_SAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_SAM_BYTE, AM_mode );
 		}
 		else
 		{
 			//Set the DAC bit
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, AC_mode, IPHC_DAC_BIT, IPHC_DAC_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_DAC_BIT, IPHC_DAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, AC_mode );
 		
 			//Set the DAM bits
-			bitwise_write<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, AM_mode, IPHC_DAM_BIT, IPHC_DAM_LEN );
+			bitwise_write<OsModel, block_data_t, uint8_t, IPHC_DAM_BIT, IPHC_DAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, AM_mode );
 		}
 		
 	}
@@ -2471,18 +2471,18 @@ namespace wiselib
 	{
 		uint8_t AM_mode;
 		uint8_t AC_mode;
-		uint8_t CID_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE, IPHC_CID_BIT, IPHC_CID_LEN );
+		uint8_t CID_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_CID_BIT, IPHC_CID_LEN>( buffer_ + IPHC_SHIFT + IPHC_CID_BYTE );
 		
 		//Read AM bits
 		if( source )
 		{
-			AM_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_SAM_BYTE, IPHC_SAM_BIT, IPHC_SAM_LEN );
-			AC_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_SAC_BYTE, IPHC_SAC_BIT, IPHC_SAC_LEN );
+			AM_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_SAM_BIT, IPHC_SAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_SAM_BYTE );
+			AC_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_SAC_BIT, IPHC_SAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_SAC_BYTE );
 		}	
 		else
 		{
-			AM_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE, IPHC_DAM_BIT, IPHC_DAM_LEN );
-			AC_mode = bitwise_read<OsModel, block_data_t, uint8_t>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE, IPHC_DAC_BIT, IPHC_DAC_LEN );
+			AM_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_DAM_BIT, IPHC_DAM_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAM_BYTE );
+			AC_mode = bitwise_read<OsModel, block_data_t, uint8_t, IPHC_DAC_BIT, IPHC_DAC_LEN>( buffer_ + IPHC_SHIFT + IPHC_DAC_BYTE );
 		}	
 		
 		
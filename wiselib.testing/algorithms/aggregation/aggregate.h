@@ -46,6 +46,10 @@ namespace wiselib {
         typedef AggregateValue_P value_t;
         typedef aggregate_base<OsModel,AggregateValue_P> self_t;
 
+        enum {
+            MAX_SIZE = sizeof(AggregateValue_P)
+        };
+
         aggregate_base() {
         	value = 0xFFFFFFFF;
 //                timeStampMillis = 0;
@@ -32,11 +32,17 @@
 #include "util/delegates/delegate.hpp"
 #include "util/pstl/vector_static.h"
 #include "util/pstl/pair.h"
+#include "util/meta.h"
 #include "aggregate.h"
 #include "aggregationmsg.h"
 
 #define DEBUG_AGGREGATION
 
+// Number of aggregates (own value and children) a node buffers per round.
+#ifndef AGGREGATION_MAX_PENDING
+#define AGGREGATION_MAX_PENDING 10
+#endif
+
 namespace wiselib {
 
     template<typename OsModel_P, typename Radio_P,typename Debug_P,
@@ -58,6 +64,9 @@ namespace wiselib {
 
         typedef AggregateMsg<OsModel,Radio> msg_t;
 
+        // Every aggregate must fit into a single message.
+        static_assert((int)Aggregate_t::MAX_SIZE <= (int)msg_t::MAX_PAYLOAD_SIZE);
+
         typedef typename Radio::node_id_t node_id_t;
         typedef typename Radio::size_t size_t;
         typedef typename Radio::block_data_t block_data_t;
@@ -72,7 +81,7 @@ namespace wiselib {
         TxPower power;
 
         // Vector containing the aggregates that the node is going to combine.
-        typedef wiselib::vector_static<OsModel, Aggregate_t, 10> aggregates_vector_t;
+        typedef wiselib::vector_static<OsModel, Aggregate_t, AGGREGATION_MAX_PENDING> aggregates_vector_t;
 
         // Iterators for the aggregates_vector_t
         typedef typename aggregates_vector_t::iterator iterator_t;
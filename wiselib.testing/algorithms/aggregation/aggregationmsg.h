@@ -60,6 +60,10 @@ namespace wiselib {
                            // (the payload starts at +1)
         };
 
+        enum {
+         MAX_PAYLOAD_SIZE = Radio::MAX_MESSAGE_LENGTH - PAYLOAD_POS - 1
+        };
+
         enum aggregation_level {
          IN_CLUSTER  = 0,
          IN_TREE = 1
@@ -0,0 +1,134 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef COUNT_MIN_AGGREGATE_H
+#define	COUNT_MIN_AGGREGATE_H
+
+#include "util/serialization/serialization.h"
+#include "sketch_hash.h"
+
+namespace wiselib {
+
+    /**
+     * Count-Min sketch aggregate: DEPTH_P rows of WIDTH_P counters, each
+     * row indexed by its own hash of the value. frequency() returns the
+     * smallest of the DEPTH_P counters of a value, which overestimates the
+     * true frequency by at most 2 * count() / WIDTH_P with probability
+     * 1 - 2^-DEPTH_P. Combining adds the counters, so any value can be
+     * queried at the sink, not only the ones that were frequent.
+     */
+    template
+    <typename OsModel_P, typename AggregateValue_P, int DEPTH_P = 2, int WIDTH_P = 24>
+    class count_min_aggregate {
+    public:
+        typedef OsModel_P OsModel;
+        typedef typename OsModel::block_data_t block_data_t;
+        typedef typename OsModel::size_t size_t;
+
+        typedef AggregateValue_P value_t;
+        typedef uint16_t count_t;
+        typedef count_min_aggregate<OsModel, AggregateValue_P, DEPTH_P, WIDTH_P> self_t;
+
+        enum {
+            DEPTH = DEPTH_P,
+            WIDTH = WIDTH_P,
+            MAX_SIZE = DEPTH_P * WIDTH_P * sizeof(count_t)
+        };
+
+        count_min_aggregate() {
+            clear();
+        }
+
+        count_min_aggregate(block_data_t * buffer) {
+            for (int i = 0; i < DEPTH * WIDTH; i++) {
+                counters_[i] = read<OsModel, block_data_t, count_t>(buffer);
+                buffer += sizeof(count_t);
+            }
+        }
+
+        void clear() {
+            for (int i = 0; i < DEPTH * WIDTH; i++) {
+                counters_[i] = 0;
+            }
+        }
+
+        /**
+         * Adds a local reading.
+         */
+        void put(value_t v) {
+            for (int d = 0; d < DEPTH; d++) {
+                count_t &c = counters_[d * WIDTH + sketch_hash((uint32_t) v, d + 1) % WIDTH];
+                if (c < 0xffff) c++;
+            }
+        }
+
+        /**
+         * Estimated (over-) frequency of v.
+         */
+        count_t frequency(value_t v) {
+            count_t r = 0xffff;
+            for (int d = 0; d < DEPTH; d++) {
+                count_t c = counters_[d * WIDTH + sketch_hash((uint32_t) v, d + 1) % WIDTH];
+                if (c < r) r = c;
+            }
+            return r;
+        }
+
+        /**
+         * Number of summarized readings.
+         */
+        uint32_t count() {
+            uint32_t n = 0;
+            for (int i = 0; i < WIDTH; i++) {
+                n += counters_[i];
+            }
+            return n;
+        }
+
+        uint32_t get() {
+            return count();
+        }
+
+        self_t combine(self_t &rhs) {
+            self_t result(*this);
+            for (int i = 0; i < DEPTH * WIDTH; i++) {
+                uint32_t c = (uint32_t) result.counters_[i] + rhs.counters_[i];
+                result.counters_[i] = c > 0xffff ? 0xffff : c;
+            }
+            return result;
+        }
+
+        void writeTo(uint8_t *buffer) {
+            for (int i = 0; i < DEPTH * WIDTH; i++) {
+                write<OsModel, block_data_t, count_t>(buffer, counters_[i]);
+                buffer += sizeof(count_t);
+            }
+        }
+
+        size_t size() {
+            return DEPTH * WIDTH * sizeof(count_t);
+        }
+
+    private:
+        count_t counters_[DEPTH_P * WIDTH_P];
+    };
+
+}
+
+#endif
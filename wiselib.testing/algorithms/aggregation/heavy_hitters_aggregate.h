@@ -0,0 +1,225 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef HEAVY_HITTERS_AGGREGATE_H
+#define	HEAVY_HITTERS_AGGREGATE_H
+
+#include "util/serialization/serialization.h"
+
+namespace wiselib {
+
+    /**
+     * Heavy hitters aggregate (SpaceSaving / Misra-Gries summary with
+     * COUNTERS_P counters). Every value occurring in more than
+     * 1 / (COUNTERS_P + 1) of all readings is guaranteed to be kept, and
+     * its count is underestimated by at most count() / (COUNTERS_P + 1).
+     *
+     * Combining adds the counters of both summaries and, if more than
+     * COUNTERS_P values remain, subtracts the (COUNTERS_P + 1)-th largest
+     * count from all of them, which keeps the error bound of the merged
+     * summary ("mergeable summaries").
+     */
+    template
+    <typename OsModel_P, typename AggregateValue_P, int COUNTERS_P = 16>
+    class heavy_hitters_aggregate {
+    public:
+        typedef OsModel_P OsModel;
+        typedef typename OsModel::block_data_t block_data_t;
+        typedef typename OsModel::size_t size_t;
+
+        typedef AggregateValue_P value_t;
+        typedef uint16_t count_t;
+        typedef heavy_hitters_aggregate<OsModel, AggregateValue_P, COUNTERS_P> self_t;
+
+        enum {
+            COUNTERS = COUNTERS_P,
+            MAX_SIZE = 1 + sizeof(uint32_t) + COUNTERS_P * (sizeof(AggregateValue_P) + sizeof(count_t))
+        };
+
+        heavy_hitters_aggregate() {
+            clear();
+        }
+
+        heavy_hitters_aggregate(block_data_t * buffer) {
+            clear();
+            used_ = *buffer++;
+            if (used_ > COUNTERS) used_ = 0;
+            total_ = read<OsModel, block_data_t, uint32_t>(buffer);
+            buffer += sizeof(uint32_t);
+            for (int i = 0; i < used_; i++) {
+                values_[i] = read<OsModel, block_data_t, value_t>(buffer);
+                buffer += sizeof(value_t);
+                counts_[i] = read<OsModel, block_data_t, count_t>(buffer);
+                buffer += sizeof(count_t);
+            }
+        }
+
+        void clear() {
+            used_ = 0;
+            total_ = 0;
+        }
+
+        /**
+         * Adds a local reading.
+         */
+        void put(value_t v) {
+            total_++;
+            for (int i = 0; i < used_; i++) {
+                if (values_[i] == v) {
+                    if (counts_[i] < 0xffff) counts_[i]++;
+                    return;
+                }
+            }
+            if (used_ < COUNTERS) {
+                values_[used_] = v;
+                counts_[used_] = 1;
+                used_++;
+                return;
+            }
+            decrement(1);
+        }
+
+        /**
+         * Number of summarized readings.
+         */
+        uint32_t count() {
+            return total_;
+        }
+
+        /**
+         * Lower bound of the frequency of v.
+         */
+        count_t frequency(value_t v) {
+            for (int i = 0; i < used_; i++) {
+                if (values_[i] == v) return counts_[i];
+            }
+            return 0;
+        }
+
+        /**
+         * Number of kept values; value(i) / frequency of value(i) for
+         * i < size() list the candidate heavy hitters.
+         */
+        uint8_t counters() {
+            return used_;
+        }
+
+        value_t value(uint8_t i) {
+            return values_[i];
+        }
+
+        /**
+         * Most frequent value.
+         */
+        value_t get() {
+            int best = -1;
+            for (int i = 0; i < used_; i++) {
+                if (best < 0 || counts_[i] > counts_[best]) best = i;
+            }
+            return best < 0 ? value_t() : values_[best];
+        }
+
+        self_t combine(self_t &rhs) {
+            value_t values[2 * COUNTERS];
+            uint32_t counts[2 * COUNTERS];
+            int n = 0;
+            for (int i = 0; i < used_; i++, n++) {
+                values[n] = values_[i];
+                counts[n] = counts_[i];
+            }
+            for (int i = 0; i < rhs.used_; i++) {
+                int j = 0;
+                for (; j < used_ && values[j] != rhs.values_[i]; j++);
+                if (j < used_) {
+                    counts[j] += rhs.counts_[i];
+                } else {
+                    values[n] = rhs.values_[i];
+                    counts[n++] = rhs.counts_[i];
+                }
+            }
+
+            // subtract the (COUNTERS + 1)-th largest count
+            uint32_t cut = 0;
+            if (n > COUNTERS) {
+                uint32_t sorted[2 * COUNTERS];
+                for (int i = 0; i < n; i++) {
+                    int j = i;
+                    for (; j > 0 && counts[i] > sorted[j - 1]; j--) {
+                        sorted[j] = sorted[j - 1];
+                    }
+                    sorted[j] = counts[i];
+                }
+                cut = sorted[COUNTERS];
+            }
+
+            self_t result;
+            result.total_ = total_ + rhs.total_;
+            for (int i = 0; i < n && result.used_ < COUNTERS; i++) {
+                if (counts[i] > cut) {
+                    uint32_t c = counts[i] - cut;
+                    result.values_[result.used_] = values[i];
+                    result.counts_[result.used_] = c > 0xffff ? 0xffff : c;
+                    result.used_++;
+                }
+            }
+            return result;
+        }
+
+        void writeTo(uint8_t *buffer) {
+            *buffer++ = used_;
+            write<OsModel, block_data_t, uint32_t>(buffer, total_);
+            buffer += sizeof(uint32_t);
+            for (int i = 0; i < used_; i++) {
+                write<OsModel, block_data_t, value_t>(buffer, values_[i]);
+                buffer += sizeof(value_t);
+                write<OsModel, block_data_t, count_t>(buffer, counts_[i]);
+                buffer += sizeof(count_t);
+            }
+        }
+
+        size_t size() {
+            return 1 + sizeof(uint32_t) + used_ * (sizeof(value_t) + sizeof(count_t));
+        }
+
+    private:
+        /**
+         * Misra-Gries step: a new value found no free counter, decrement
+         * all counters and drop the ones reaching zero.
+         */
+        void decrement(count_t by) {
+            int j = 0;
+            for (int i = 0; i < used_; i++) {
+                if (counts_[i] > by) {
+                    values_[j] = values_[i];
+                    counts_[j] = counts_[i] - by;
+                    j++;
+                }
+            }
+            used_ = j;
+        }
+
+        value_t values_[COUNTERS];
+        count_t counts_[COUNTERS];
+        uint32_t total_;
+        uint8_t used_;
+    };
+
+}
+
+#endif
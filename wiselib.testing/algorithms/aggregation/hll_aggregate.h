@@ -0,0 +1,138 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef HLL_AGGREGATE_H
+#define	HLL_AGGREGATE_H
+
+#include "util/serialization/serialization.h"
+#include "sketch_hash.h"
+#include <math.h>
+
+namespace wiselib {
+
+    /**
+     * Distinct count aggregate (HyperLogLog). Every value is hashed, the
+     * first PRECISION_P bits select one of 2^PRECISION_P registers which
+     * keeps the longest run of leading zeros seen in the rest of the hash.
+     * Combining takes the register wise maximum, so duplicates, e.g. a
+     * reading forwarded on two paths, are not counted twice and the
+     * message size does not depend on the number of nodes.
+     *
+     * The standard error is about 1.04 / sqrt(2^PRECISION_P), i.e. 13% for
+     * the default of 64 registers (64 bytes on the air).
+     */
+    template
+    <typename OsModel_P, typename AggregateValue_P, int PRECISION_P = 6>
+    class hll_aggregate {
+    public:
+        typedef OsModel_P OsModel;
+        typedef typename OsModel::block_data_t block_data_t;
+        typedef typename OsModel::size_t size_t;
+
+        typedef AggregateValue_P value_t;
+        typedef hll_aggregate<OsModel, AggregateValue_P, PRECISION_P> self_t;
+
+        enum {
+            REGISTERS = 1 << PRECISION_P,
+            MAX_SIZE = REGISTERS
+        };
+
+        hll_aggregate() {
+            clear();
+        }
+
+        hll_aggregate(block_data_t * buffer) {
+            for (int i = 0; i < REGISTERS; i++) {
+                registers_[i] = buffer[i];
+            }
+        }
+
+        void clear() {
+            for (int i = 0; i < REGISTERS; i++) {
+                registers_[i] = 0;
+            }
+        }
+
+        /**
+         * Adds a local reading (or any other item to count).
+         */
+        void put(value_t v) {
+            uint32_t h = sketch_hash((uint32_t) v);
+            uint32_t idx = h >> (32 - PRECISION_P);
+            uint32_t rest = (h << PRECISION_P) | (1UL << (PRECISION_P - 1));
+            uint8_t rank = 1;
+            while (!(rest & 0x80000000UL)) {
+                rank++;
+                rest <<= 1;
+            }
+            if (rank > registers_[idx]) {
+                registers_[idx] = rank;
+            }
+        }
+
+        /**
+         * Estimated number of distinct values.
+         */
+        uint32_t get() {
+            double sum = 0;
+            int zeros = 0;
+            for (int i = 0; i < REGISTERS; i++) {
+                sum += 1.0 / (double) (1UL << registers_[i]);
+                if (registers_[i] == 0) zeros++;
+            }
+
+            double m = REGISTERS;
+            double alpha = (REGISTERS == 16) ? 0.673 : (REGISTERS == 32) ? 0.697 :
+                    (REGISTERS == 64) ? 0.709 : 0.7213 / (1.0 + 1.079 / m);
+            double estimate = alpha * m * m / sum;
+
+            // small range correction (linear counting)
+            if (estimate <= 2.5 * m && zeros) {
+                estimate = m * log(m / zeros);
+            }
+            return (uint32_t) (estimate + 0.5);
+        }
+
+        self_t combine(self_t &rhs) {
+            self_t result(*this);
+            for (int i = 0; i < REGISTERS; i++) {
+                if (rhs.registers_[i] > result.registers_[i]) {
+                    result.registers_[i] = rhs.registers_[i];
+                }
+            }
+            return result;
+        }
+
+        void writeTo(uint8_t *buffer) {
+            for (int i = 0; i < REGISTERS; i++) {
+                buffer[i] = registers_[i];
+            }
+        }
+
+        size_t size() {
+            return REGISTERS;
+        }
+
+    private:
+        uint8_t registers_[REGISTERS];
+    };
+
+}
+
+#endif
@@ -0,0 +1,282 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef QUANTILE_AGGREGATE_H
+#define	QUANTILE_AGGREGATE_H
+
+#include "util/serialization/serialization.h"
+
+namespace wiselib {
+
+    /**
+     * Quantile aggregate (a fixed size KLL sketch). Readings are kept in
+     * levels; an item at level h stands for 2^h readings. When the sketch
+     * is full, a level is sorted and every other item is promoted to the
+     * next level, which halves the number of items at the cost of a small,
+     * bounded rank error. Combining concatenates the levels and compacts
+     * again, so medians and percentiles are computed in-network while
+     * every message carries at most CAPACITY_P values.
+     *
+     * On the air: number of levels, one item count per level and the
+     * values, i.e. at most MAX_SIZE = 1 + MAX_LEVELS + CAPACITY_P *
+     * sizeof(value_t) bytes. The default of 24 values keeps that within
+     * the aggregate payload of 116 byte radios for 32 bit values; the rank
+     * error then reaches 20 to 30 percent after 10^4 to 10^5 readings.
+     * Radios with larger messages can afford a larger CAPACITY_P (40
+     * values roughly halve the error), Aggregation refuses sketches that
+     * do not fit.
+     */
+    template
+    <typename OsModel_P, typename AggregateValue_P, int CAPACITY_P = 24>
+    class quantile_aggregate {
+    public:
+        typedef OsModel_P OsModel;
+        typedef typename OsModel::block_data_t block_data_t;
+        typedef typename OsModel::size_t size_t;
+
+        typedef AggregateValue_P value_t;
+        typedef quantile_aggregate<OsModel, AggregateValue_P, CAPACITY_P> self_t;
+
+        enum {
+            CAPACITY = CAPACITY_P,
+            MAX_LEVELS = 16,
+            MAX_SIZE = 1 + MAX_LEVELS + CAPACITY_P * sizeof(AggregateValue_P)
+        };
+
+        quantile_aggregate() {
+            clear();
+        }
+
+        quantile_aggregate(block_data_t * buffer) {
+            clear();
+            uint8_t levels = *buffer++;
+            if (levels > MAX_LEVELS) return;
+
+            uint8_t counts[MAX_LEVELS];
+            int total = 0;
+            for (int h = 0; h < levels; h++) {
+                counts[h] = *buffer++;
+                total += counts[h];
+            }
+            if (total > CAPACITY) return;
+
+            levels_ = levels;
+            for (int h = 0; h < levels; h++) {
+                start_[h + 1] = start_[h] + counts[h];
+            }
+            for (int i = 0; i < total; i++) {
+                items_[i] = read<OsModel, block_data_t, value_t>(buffer);
+                buffer += sizeof(value_t);
+            }
+        }
+
+        void clear() {
+            levels_ = 1;
+            compactions_ = 0;
+            for (int h = 0; h <= MAX_LEVELS; h++) {
+                start_[h] = 0;
+            }
+        }
+
+        /**
+         * Adds a local reading.
+         */
+        void put(value_t v) {
+            insert(0, v);
+        }
+
+        /**
+         * Number of readings summarized (exact).
+         */
+        uint32_t count() {
+            uint32_t n = 0;
+            for (int h = 0; h < levels_; h++) {
+                n += (uint32_t) (start_[h + 1] - start_[h]) << h;
+            }
+            return n;
+        }
+
+        /**
+         * Approximate q-quantile of all summarized readings, given as
+         * numerator / denominator, e.g. quantile(95, 100).
+         */
+        value_t quantile(uint32_t numerator, uint32_t denominator) {
+            int n = start_[levels_];
+            if (n == 0) return value_t();
+
+            // sort a copy of all items with their weights
+            value_t values[CAPACITY];
+            uint8_t weights[CAPACITY];
+            for (int h = 0, i = 0; h < levels_; h++) {
+                for (; i < start_[h + 1]; i++) {
+                    int j = i;
+                    for (; j > 0 && items_[i] < values[j - 1]; j--) {
+                        values[j] = values[j - 1];
+                        weights[j] = weights[j - 1];
+                    }
+                    values[j] = items_[i];
+                    weights[j] = h;
+                }
+            }
+
+            uint32_t rank = (uint32_t) (((uint64_t) count() * numerator) / denominator);
+            uint32_t seen = 0;
+            for (int i = 0; i < n; i++) {
+                seen += 1UL << weights[i];
+                if (seen > rank) return values[i];
+            }
+            return values[n - 1];
+        }
+
+        /**
+         * Approximate median.
+         */
+        value_t get() {
+            return quantile(1, 2);
+        }
+
+        self_t combine(self_t &rhs) {
+            self_t result(*this);
+            for (int h = 0; h < rhs.levels_; h++) {
+                for (int i = rhs.start_[h]; i < rhs.start_[h + 1]; i++) {
+                    result.insert(h, rhs.items_[i]);
+                }
+            }
+            return result;
+        }
+
+        void writeTo(uint8_t *buffer) {
+            *buffer++ = levels_;
+            for (int h = 0; h < levels_; h++) {
+                *buffer++ = start_[h + 1] - start_[h];
+            }
+            for (int i = 0; i < start_[levels_]; i++) {
+                write<OsModel, block_data_t, value_t>(buffer, items_[i]);
+                buffer += sizeof(value_t);
+            }
+        }
+
+        size_t size() {
+            return 1 + levels_ + start_[levels_] * sizeof(value_t);
+        }
+
+    private:
+        void insert(int level, value_t v) {
+            if (start_[levels_] == CAPACITY) {
+                compact();
+                if (start_[levels_] == CAPACITY) return;
+            }
+            while (level >= levels_) {
+                start_[levels_ + 1] = start_[levels_];
+                levels_++;
+            }
+
+            // make room at the end of the level
+            int pos = start_[level + 1];
+            for (int i = start_[levels_]; i > pos; i--) {
+                items_[i] = items_[i - 1];
+            }
+            items_[pos] = v;
+            for (int h = level + 1; h <= levels_; h++) {
+                start_[h]++;
+            }
+        }
+
+        /**
+         * Capacity of level h, shrinking by 2/3 per level below the top.
+         */
+        int level_capacity(int h) {
+            int c = CAPACITY / 3;
+            for (int d = levels_ - 1 - h; d > 0 && c > 2; d--) {
+                c = c * 2 / 3;
+            }
+            return c < 2 ? 2 : c;
+        }
+
+        /**
+         * Halves the lowest level that exceeds its capacity (or the
+         * lowest level holding at least two items).
+         */
+        void compact() {
+            int level = -1;
+            for (int h = 0; h < levels_ && level < 0; h++) {
+                if (start_[h + 1] - start_[h] > level_capacity(h)) level = h;
+            }
+            for (int h = 0; h < levels_ && level < 0; h++) {
+                if (start_[h + 1] - start_[h] >= 2) level = h;
+            }
+            if (level < 0 || level + 1 >= MAX_LEVELS) return;
+
+            if (level + 1 == levels_) {
+                start_[levels_ + 1] = start_[levels_];
+                levels_++;
+            }
+
+            // sort the level
+            int begin = start_[level], end = start_[level + 1];
+            for (int i = begin + 1; i < end; i++) {
+                value_t v = items_[i];
+                int j = i;
+                for (; j > begin && v < items_[j - 1]; j--) {
+                    items_[j] = items_[j - 1];
+                }
+                items_[j] = v;
+            }
+
+            // an odd item stays, of the rest every other one is promoted
+            int pairs = (end - begin) / 2;
+            int offset = compactions_++ & 1;
+            value_t promoted[CAPACITY / 2];
+            for (int i = 0; i < pairs; i++) {
+                promoted[i] = items_[begin + 2 * i + offset];
+            }
+            int keep = (end - begin) - 2 * pairs;
+            if (keep) {
+                items_[begin] = items_[end - 1];
+            }
+
+            // items of the next level move up to close the gap, the
+            // promoted ones are appended to the next level
+            int removed = 2 * pairs;
+            int next_end = start_[level + 2];
+            for (int i = begin + keep; i < next_end - removed; i++) {
+                items_[i] = items_[i + removed];
+            }
+            for (int i = 0; i < pairs; i++) {
+                items_[next_end - removed + i] = promoted[i];
+            }
+            for (int i = next_end - removed + pairs; i < start_[levels_] - pairs; i++) {
+                items_[i] = items_[i + pairs];
+            }
+            start_[level + 1] -= removed;
+            start_[level + 2] -= pairs;
+            for (int h = level + 3; h <= levels_; h++) {
+                start_[h] -= pairs;
+            }
+        }
+
+        value_t items_[CAPACITY];
+        uint8_t start_[MAX_LEVELS + 1];
+        uint8_t levels_;
+        uint8_t compactions_;
+    };
+
+}
+
+#endif
@@ -0,0 +1,43 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef SKETCH_HASH_H
+#define	SKETCH_HASH_H
+
+namespace wiselib {
+
+    /**
+     * 32 bit integer hash (murmur3 finalizer) used by the sketch aggregates.
+     * Different seeds give independent hash functions, and all nodes
+     * compute the same hash for the same value, which is what makes the
+     * sketches mergeable.
+     */
+    inline uint32_t sketch_hash(uint32_t x, uint32_t seed = 0) {
+        x ^= (seed + 1) * 0x9e3779b9UL;
+        x ^= x >> 16;
+        x *= 0x85ebca6bUL;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35UL;
+        x ^= x >> 16;
+        return x;
+    }
+
+}
+
+#endif
@@ -546,10 +546,7 @@ class AES
 			//call KeyExpansion on the user defined key
 			KeyExpansion(key);
 		}
-		else
-		{
-			os().debug("Wrong key length!!!!!!!!!!!!@@@@@@@@@@@@@@@@@@@@@@********************");
-		}
+		//other key lengths are not supported, the cipher stays unkeyed
 	}
 
 } //end of namespace wiselib
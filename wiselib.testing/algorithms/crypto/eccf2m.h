@@ -827,6 +827,18 @@ public:
 				return a;
 			}
 
+			//generate a sensor nodes private key from rand, e.g. a CtrDrbg
+			template<typename Rand_P>
+			static inline uint8_t * gen_private_key(uint8_t * a, Rand_P& rand)
+			{
+				for (uint8_t i = NUMWORDS/2; i < NUMWORDS; i++)
+				{
+					a[i] = (uint8_t) rand();
+				}
+				b_mod(a, params.r, NUMWORDS/2);
+				return a;
+			}
+
 			//generate a sensor nodes public key
 			static inline Point * gen_public_key(uint8_t * a,Point * P0)
 			{
@@ -296,6 +296,42 @@ public:
 		}
 	}
 
+	//generate a private key uniformly in [1, r-1] from rand, e.g. a CtrDrbg
+	template<typename Rand_P>
+	void gen_private_key(NN_DIGIT *PrivateKey, Rand_P& rand)
+	{
+		NN_UINT order_digit_len, order_bit_len;
+		bool done = FALSE;
+		uint8_t ri;
+		NN_DIGIT digit_mask;
+
+		order_bit_len = pmp.Bits(param.r, NUMWORDS);
+		order_digit_len = pmp.Digits(param.r, NUMWORDS);
+
+		while(!done)
+		{
+			for (ri=0; ri<order_digit_len; ri++)
+			{
+				PrivateKey[ri] = (NN_DIGIT)rand();
+			}
+
+			for (ri=order_digit_len; ri<NUMWORDS; ri++)
+			{
+				PrivateKey[ri] = 0;
+			}
+
+			if (order_bit_len % NN_DIGIT_BITS != 0)
+			{
+				digit_mask = MAX_NN_DIGIT >> (NN_DIGIT_BITS - order_bit_len % NN_DIGIT_BITS);
+				PrivateKey[order_digit_len - 1] = PrivateKey[order_digit_len - 1] & digit_mask;
+			}
+
+			//reject instead of reducing, so every key is equally likely
+			if (pmp.Cmp(PrivateKey, param.r, NUMWORDS) < 0 && pmp.Zero(PrivateKey, NUMWORDS) != 1)
+				done = TRUE;
+		}
+	}
+
 	//generate public key by multiplying private key with base point G
 	// PublicKey = PrivateKey * params.G
 	void gen_public_key(Point *PublicKey, NN_DIGIT *PrivateKey)
@@ -0,0 +1,227 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __ALGORITHMS_GRAPH_CSR_GRAPH_H__
+#define __ALGORITHMS_GRAPH_CSR_GRAPH_H__
+
+namespace wiselib
+{
+
+   /** \brief Immutable graph in compressed sparse row (CSR) layout.
+    *  \ingroup graph_concept
+    *
+    *  The graph is built once from an edge list with build(). Afterwards
+    *  the out-neighbors of vertex v are the contiguous entries
+    *  [edges_begin(v), edges_end(v)) of one target and one weight array,
+    *  so traversals (see CsrGraphAlgorithms) touch memory sequentially
+    *  instead of following links.
+    *
+    *  Vertices are numbered 0 .. num_vertices() - 1; mapping them to node
+    *  ids is left to the caller. Storage is fixed at compile time with at
+    *  most MAX_VERTICES_P vertices and MAX_EDGES_P directed edges (an
+    *  undirected edge counts twice).
+    */
+   template<typename OsModel_P,
+            int MAX_VERTICES_P,
+            int MAX_EDGES_P,
+            typename Vertex_P = uint16_t,
+            typename Weight_P = uint16_t>
+   class CsrGraph
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Vertex_P vertex_t;
+      typedef Weight_P weight_t;
+      typedef uint32_t edge_t;
+
+      typedef CsrGraph<OsModel, MAX_VERTICES_P, MAX_EDGES_P, Vertex_P, Weight_P> self_type;
+
+      enum ErrorCodes
+      {
+         SUCCESS = OsModel::SUCCESS,
+         ERR_NOMEM = OsModel::ERR_NOMEM,
+         ERR_UNSPEC = OsModel::ERR_UNSPEC
+      };
+
+      enum
+      {
+         MAX_VERTICES = MAX_VERTICES_P,
+         MAX_EDGES = MAX_EDGES_P
+      };
+
+      /** Entry of the edge list handed to build().
+       */
+      struct Edge
+      {
+         vertex_t source;
+         vertex_t target;
+         weight_t weight;
+      };
+      // --------------------------------------------------------------------
+      CsrGraph()
+         : vertices_( 0 )
+      { offsets_[0] = 0; }
+      // --------------------------------------------------------------------
+      /** Replaces the graph by \a vertices vertices and the \a count edges
+       *  in \a edges. With \a undirected set, every edge is stored in both
+       *  directions. Neighbors of each vertex are sorted by target.
+       *
+       *  Returns ERR_NOMEM if vertices or edges exceed the capacity and
+       *  ERR_UNSPEC if an edge refers to a vertex >= \a vertices; the graph
+       *  is empty afterwards in both cases.
+       */
+      int build( const Edge *edges, edge_t count, vertex_t vertices, bool undirected = true )
+      {
+         vertices_ = 0;
+         offsets_[0] = 0;
+
+         edge_t total = undirected ? 2 * count : count;
+         if ( vertices > MAX_VERTICES || total > (edge_t)MAX_EDGES )
+            return ERR_NOMEM;
+         for ( edge_t i = 0; i < count; i++ )
+            if ( edges[i].source >= vertices || edges[i].target >= vertices )
+               return ERR_UNSPEC;
+
+         // count degrees, offsets_[v + 1] holds the degree of v
+         for ( edge_t v = 0; v <= (edge_t)vertices; v++ )
+            offsets_[v] = 0;
+         for ( edge_t i = 0; i < count; i++ )
+         {
+            offsets_[edges[i].source + 1]++;
+            if ( undirected )
+               offsets_[edges[i].target + 1]++;
+         }
+         for ( vertex_t v = 0; v < vertices; v++ )
+            offsets_[v + 1] += offsets_[v];
+
+         // scatter, using offsets_[v] as insert cursor of v
+         for ( edge_t i = 0; i < count; i++ )
+         {
+            place( edges[i].source, edges[i].target, edges[i].weight );
+            if ( undirected )
+               place( edges[i].target, edges[i].source, edges[i].weight );
+         }
+         // the cursors now point to the start of the next row
+         for ( vertex_t v = vertices; v > 0; v-- )
+            offsets_[v] = offsets_[v - 1];
+         offsets_[0] = 0;
+
+         vertices_ = vertices;
+         for ( vertex_t v = 0; v < vertices_; v++ )
+            sort_row( v );
+
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      void clear()
+      {
+         vertices_ = 0;
+         offsets_[0] = 0;
+      }
+      // --------------------------------------------------------------------
+      vertex_t num_vertices() const
+      { return vertices_; }
+      // --------------------------------------------------------------------
+      edge_t num_edges() const
+      { return offsets_[vertices_]; }
+      // --------------------------------------------------------------------
+      edge_t degree( vertex_t v ) const
+      { return offsets_[v + 1] - offsets_[v]; }
+      // --------------------------------------------------------------------
+      /** Index of the first out-edge of \a v.
+       */
+      edge_t edges_begin( vertex_t v ) const
+      { return offsets_[v]; }
+      // --------------------------------------------------------------------
+      /** One past the index of the last out-edge of \a v.
+       */
+      edge_t edges_end( vertex_t v ) const
+      { return offsets_[v + 1]; }
+      // --------------------------------------------------------------------
+      vertex_t target( edge_t e ) const
+      { return targets_[e]; }
+      // --------------------------------------------------------------------
+      weight_t weight( edge_t e ) const
+      { return weights_[e]; }
+      // --------------------------------------------------------------------
+      /** Out-neighbors of \a v as contiguous array of degree(v) entries.
+       */
+      const vertex_t* neighbors( vertex_t v ) const
+      { return targets_ + offsets_[v]; }
+      // --------------------------------------------------------------------
+      /** Weights of the out-edges of \a v, parallel to neighbors(v).
+       */
+      const weight_t* weights( vertex_t v ) const
+      { return weights_ + offsets_[v]; }
+      // --------------------------------------------------------------------
+      /** Returns the index of edge (\a u, \a v), or num_edges() if there is
+       *  none. Binary search in the sorted row of \a u.
+       */
+      edge_t find_edge( vertex_t u, vertex_t v ) const
+      {
+         edge_t lo = offsets_[u], hi = offsets_[u + 1];
+         while ( lo < hi )
+         {
+            edge_t mid = lo + ( hi - lo ) / 2;
+            if ( targets_[mid] < v )
+               lo = mid + 1;
+            else
+               hi = mid;
+         }
+         if ( lo < offsets_[u + 1] && targets_[lo] == v )
+            return lo;
+         return num_edges();
+      }
+
+   private:
+      void place( vertex_t source, vertex_t target, weight_t weight )
+      {
+         edge_t e = offsets_[source]++;
+         targets_[e] = target;
+         weights_[e] = weight;
+      }
+      // --------------------------------------------------------------------
+      /** Insertion sort, rows are short for radio topologies.
+       */
+      void sort_row( vertex_t v )
+      {
+         edge_t begin = offsets_[v], end = offsets_[v + 1];
+         for ( edge_t i = begin + 1; i < end; i++ )
+         {
+            vertex_t t = targets_[i];
+            weight_t w = weights_[i];
+            edge_t j = i;
+            for ( ; j > begin && t < targets_[j - 1]; j-- )
+            {
+               targets_[j] = targets_[j - 1];
+               weights_[j] = weights_[j - 1];
+            }
+            targets_[j] = t;
+            weights_[j] = w;
+         }
+      }
+
+      vertex_t vertices_;
+      edge_t offsets_[MAX_VERTICES_P + 1];
+      vertex_t targets_[MAX_EDGES_P];
+      weight_t weights_[MAX_EDGES_P];
+   };
+
+}
+
+#endif
@@ -0,0 +1,313 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __ALGORITHMS_GRAPH_CSR_GRAPH_ALGORITHMS_H__
+#define __ALGORITHMS_GRAPH_CSR_GRAPH_ALGORITHMS_H__
+
+#include "algorithms/graph/csr_graph.h"
+
+namespace wiselib
+{
+
+   /** \brief Traversal algorithms over a CsrGraph.
+    *  \ingroup graph_algorithm
+    *
+    *  Breadth first search, Dijkstra, Prim's minimum spanning tree and
+    *  connected components. All of them scan the contiguous neighbor rows
+    *  of the graph and keep their working set (queue, heap, union-find
+    *  forest) in arrays of this object, sized for Graph_P::MAX_VERTICES,
+    *  so they neither allocate nor chase pointers. Results are written to
+    *  caller supplied arrays of graph.num_vertices() entries; vertices
+    *  that are not reached get distance INFINITE_DISTANCE and parent
+    *  NO_VERTEX.
+    *
+    *  The object is meant to be reused: on a node for its local topology,
+    *  or on a gateway as one static instance for a whole network graph.
+    */
+   template<typename OsModel_P,
+            typename Graph_P,
+            typename Distance_P = uint32_t>
+   class CsrGraphAlgorithms
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Graph_P Graph;
+      typedef Distance_P distance_t;
+
+      typedef typename Graph::vertex_t vertex_t;
+      typedef typename Graph::edge_t edge_t;
+      typedef typename Graph::weight_t weight_t;
+
+      static const vertex_t NO_VERTEX = (vertex_t)-1;
+      static const distance_t INFINITE_DISTANCE = (distance_t)-1;
+      // --------------------------------------------------------------------
+      /** Hop distances from \a source. Returns the number of reached
+       *  vertices (including \a source).
+       */
+      vertex_t bfs( const Graph& g, vertex_t source, distance_t *distance,
+                    vertex_t *parent = 0 )
+      {
+         vertex_t n = g.num_vertices();
+         for ( vertex_t v = 0; v < n; v++ )
+         {
+            distance[v] = INFINITE_DISTANCE;
+            if ( parent )
+               parent[v] = NO_VERTEX;
+         }
+         if ( source >= n )
+            return 0;
+
+         vertex_t head = 0, tail = 0;
+         queue_[tail++] = source;
+         distance[source] = 0;
+         while ( head < tail )
+         {
+            vertex_t u = queue_[head++];
+            distance_t d = distance[u] + 1;
+            const vertex_t *it = g.neighbors( u );
+            const vertex_t *end = it + g.degree( u );
+            for ( ; it != end; ++it )
+            {
+               if ( distance[*it] != INFINITE_DISTANCE )
+                  continue;
+               distance[*it] = d;
+               if ( parent )
+                  parent[*it] = u;
+               queue_[tail++] = *it;
+            }
+         }
+         return tail;
+      }
+      // --------------------------------------------------------------------
+      /** Shortest path distances from \a source over the edge weights
+       *  (binary heap with decrease-key). Returns the number of reached
+       *  vertices.
+       */
+      vertex_t dijkstra( const Graph& g, vertex_t source, distance_t *distance,
+                         vertex_t *parent = 0 )
+      {
+         vertex_t n = g.num_vertices();
+         init_heap( n );
+         for ( vertex_t v = 0; v < n; v++ )
+         {
+            distance[v] = INFINITE_DISTANCE;
+            if ( parent )
+               parent[v] = NO_VERTEX;
+         }
+         if ( source >= n )
+            return 0;
+
+         vertex_t reached = 0;
+         distance[source] = 0;
+         heap_update( source, distance );
+         while ( heap_size_ )
+         {
+            vertex_t u = heap_pop( distance );
+            reached++;
+            edge_t end = g.edges_end( u );
+            for ( edge_t e = g.edges_begin( u ); e != end; e++ )
+            {
+               vertex_t v = g.target( e );
+               distance_t d = distance[u] + g.weight( e );
+               if ( d < distance[v] && heap_pos_[v] != DONE )
+               {
+                  distance[v] = d;
+                  if ( parent )
+                     parent[v] = u;
+                  heap_update( v, distance );
+               }
+            }
+         }
+         return reached;
+      }
+      // --------------------------------------------------------------------
+      /** Minimum spanning forest of an undirected graph (Prim, started
+       *  once per component). \a parent receives the tree edges, roots
+       *  have parent NO_VERTEX; \a key (if given) the weight of the edge
+       *  to the parent. Returns the total weight.
+       */
+      distance_t minimum_spanning_tree( const Graph& g, vertex_t *parent,
+                                        distance_t *key = 0 )
+      {
+         vertex_t n = g.num_vertices();
+         distance_t *k = key ? key : key_;
+         init_heap( n );
+         for ( vertex_t v = 0; v < n; v++ )
+         {
+            k[v] = INFINITE_DISTANCE;
+            parent[v] = NO_VERTEX;
+         }
+
+         distance_t total = 0;
+         for ( vertex_t root = 0; root < n; root++ )
+         {
+            if ( heap_pos_[root] == DONE )
+               continue;
+            k[root] = 0;
+            heap_update( root, k );
+            while ( heap_size_ )
+            {
+               vertex_t u = heap_pop( k );
+               total += k[u];
+               edge_t end = g.edges_end( u );
+               for ( edge_t e = g.edges_begin( u ); e != end; e++ )
+               {
+                  vertex_t v = g.target( e );
+                  if ( heap_pos_[v] != DONE && g.weight( e ) < k[v] )
+                  {
+                     k[v] = g.weight( e );
+                     parent[v] = u;
+                     heap_update( v, k );
+                  }
+               }
+            }
+         }
+         return total;
+      }
+      // --------------------------------------------------------------------
+      /** Labels the (weakly) connected components with 0 .. count - 1 in
+       *  order of their smallest vertex. Returns the number of components.
+       */
+      vertex_t connected_components( const Graph& g, vertex_t *component )
+      {
+         vertex_t n = g.num_vertices();
+         for ( vertex_t v = 0; v < n; v++ )
+            forest_[v] = v;
+         for ( vertex_t u = 0; u < n; u++ )
+         {
+            const vertex_t *it = g.neighbors( u );
+            const vertex_t *end = it + g.degree( u );
+            for ( ; it != end; ++it )
+               unite( u, *it );
+         }
+
+         vertex_t count = 0;
+         for ( vertex_t v = 0; v < n; v++ )
+         {
+            vertex_t r = find( v );
+            if ( r == v )
+               component[v] = count++;
+            else
+               component[v] = component[r];
+         }
+         return count;
+      }
+
+   private:
+      enum { MAX_VERTICES = Graph::MAX_VERTICES };
+
+      /** heap_pos_ marks for vertices not (or no longer) in the heap.
+       */
+      enum { UNSEEN = MAX_VERTICES, DONE = MAX_VERTICES + 1 };
+      // --------------------------------------------------------------------
+      void init_heap( vertex_t n )
+      {
+         heap_size_ = 0;
+         for ( vertex_t v = 0; v < n; v++ )
+            heap_pos_[v] = UNSEEN;
+      }
+      // --------------------------------------------------------------------
+      /** Inserts \a v or moves it up after its key decreased.
+       */
+      void heap_update( vertex_t v, const distance_t *key )
+      {
+         uint32_t i = heap_pos_[v];
+         if ( i == UNSEEN )
+            i = heap_size_++;
+         while ( i > 0 )
+         {
+            uint32_t p = ( i - 1 ) / 2;
+            if ( key[heap_[p]] <= key[v] )
+               break;
+            heap_[i] = heap_[p];
+            heap_pos_[heap_[i]] = i;
+            i = p;
+         }
+         heap_[i] = v;
+         heap_pos_[v] = i;
+      }
+      // --------------------------------------------------------------------
+      vertex_t heap_pop( const distance_t *key )
+      {
+         vertex_t top = heap_[0];
+         heap_pos_[top] = DONE;
+         vertex_t v = heap_[--heap_size_];
+         if ( heap_size_ == 0 )
+            return top;
+
+         uint32_t i = 0;
+         for ( ;; )
+         {
+            uint32_t c = 2 * i + 1;
+            if ( c >= heap_size_ )
+               break;
+            if ( c + 1 < heap_size_ && key[heap_[c + 1]] < key[heap_[c]] )
+               c++;
+            if ( key[v] <= key[heap_[c]] )
+               break;
+            heap_[i] = heap_[c];
+            heap_pos_[heap_[i]] = i;
+            i = c;
+         }
+         heap_[i] = v;
+         heap_pos_[v] = i;
+         return top;
+      }
+      // --------------------------------------------------------------------
+      vertex_t find( vertex_t v )
+      {
+         while ( forest_[v] != v )
+         {
+            forest_[v] = forest_[forest_[v]];
+            v = forest_[v];
+         }
+         return v;
+      }
+      // --------------------------------------------------------------------
+      /** The smaller root becomes the representative, which keeps the
+       *  component numbering independent of the edge order.
+       */
+      void unite( vertex_t a, vertex_t b )
+      {
+         a = find( a );
+         b = find( b );
+         if ( a < b )
+            forest_[b] = a;
+         else if ( b < a )
+            forest_[a] = b;
+      }
+
+      vertex_t queue_[MAX_VERTICES];
+      vertex_t heap_[MAX_VERTICES];
+      uint32_t heap_pos_[MAX_VERTICES];
+      uint32_t heap_size_;
+      distance_t key_[MAX_VERTICES];
+      vertex_t forest_[MAX_VERTICES];
+   };
+   // -----------------------------------------------------------------------
+   template<typename OsModel_P, typename Graph_P, typename Distance_P>
+   const typename Graph_P::vertex_t
+   CsrGraphAlgorithms<OsModel_P, Graph_P, Distance_P>::NO_VERTEX;
+   // -----------------------------------------------------------------------
+   template<typename OsModel_P, typename Graph_P, typename Distance_P>
+   const Distance_P
+   CsrGraphAlgorithms<OsModel_P, Graph_P, Distance_P>::INFINITE_DISTANCE;
+
+}
+
+#endif
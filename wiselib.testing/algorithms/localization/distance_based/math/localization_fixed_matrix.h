@@ -0,0 +1,193 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __ALGORITHMS_LOCALIZATION_DISTANCE_BASED_MATH_FIXED_MATRIX_H
+#define __ALGORITHMS_LOCALIZATION_DISTANCE_BASED_MATH_FIXED_MATRIX_H
+
+#include <math.h>
+
+namespace wiselib
+{
+
+   /** Matrix with dimensions known at compile time, the storage of
+    *  LeastSquares. Elements are stored in row major order inside the
+    *  object, so it lives on the stack.
+    *
+    *  In contrast to SimpleMatrix, which reserves room for
+    *  LOCALIZATION_SIMPLE_MATRIX_MAX_VECSIZE elements, a FixedMatrix only
+    *  occupies ROWS_P * COLS_P elements.
+    */
+   template<typename OsModel_P,
+            typename Arithmatic_P,
+            int ROWS_P,
+            int COLS_P>
+   class FixedMatrix
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Arithmatic_P Arithmatic;
+
+      enum
+      {
+         ROWS = ROWS_P,
+         COLS = COLS_P
+      };
+      // --------------------------------------------------------------------
+      /** Matrix with all elements set to \a value.
+       */
+      explicit FixedMatrix( Arithmatic value = 0 )
+      {
+         for ( int i = 0; i < ROWS * COLS; i++ )
+            data_[i] = value;
+      }
+      // --------------------------------------------------------------------
+      inline Arithmatic& operator()( int row, int col )
+      { return data_[row * COLS + col]; }
+      // --------------------------------------------------------------------
+      inline const Arithmatic& operator()( int row, int col ) const
+      { return data_[row * COLS + col]; }
+
+   private:
+      Arithmatic data_[ROWS_P * COLS_P];
+   };
+   // ----------------------------------------------------------------------
+   // ----------------------------------------------------------------------
+   // ----------------------------------------------------------------------
+   /** Linear least squares \f$\min \|Ax - b\|\f$ for an arbitrary number
+    *  of equations with UNKNOWNS_P unknowns.
+    *
+    *  Equations are added one by one and immediately folded into the upper
+    *  triangular factor \f$R\f$ of a QR decomposition of \f$A\f$ by Givens
+    *  rotations, together with \f$Q^Tb\f$. Memory does not depend on the
+    *  number of equations, and solving does not square the condition
+    *  number of \f$A\f$ as the normal equations \f$(A^TA)^{-1}A^Tb\f$ do.
+    */
+   template<typename OsModel_P,
+            typename Arithmatic_P,
+            int UNKNOWNS_P>
+   class LeastSquares
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Arithmatic_P Arithmatic;
+      typedef FixedMatrix<OsModel, Arithmatic, UNKNOWNS_P, UNKNOWNS_P> Matrix;
+      typedef FixedMatrix<OsModel, Arithmatic, UNKNOWNS_P, 1> Vector;
+
+      enum
+      {
+         UNKNOWNS = UNKNOWNS_P
+      };
+      // --------------------------------------------------------------------
+      LeastSquares()
+      { clear(); }
+      // --------------------------------------------------------------------
+      void clear()
+      {
+         r_ = Matrix();
+         qtb_ = Vector();
+         residual_ = 0;
+         equations_ = 0;
+      }
+      // --------------------------------------------------------------------
+      /** Adds the equation \f$\sum_j a_j x_j = b\f$. \a a holds UNKNOWNS
+       *  coefficients, weights have to be applied by the caller.
+       */
+      void add_equation( const Arithmatic *a, Arithmatic b )
+      {
+         Arithmatic row[UNKNOWNS];
+         for ( int j = 0; j < UNKNOWNS; j++ )
+            row[j] = a[j];
+
+         for ( int i = 0; i < UNKNOWNS; i++ )
+         {
+            if ( row[i] == 0 )
+               continue;
+
+            Arithmatic h = sqrt( r_(i,i) * r_(i,i) + row[i] * row[i] );
+            Arithmatic c = r_(i,i) / h, s = row[i] / h;
+            r_(i,i) = h;
+
+            for ( int j = i + 1; j < UNKNOWNS; j++ )
+            {
+               Arithmatic t = r_(i,j);
+               r_(i,j) = c * t + s * row[j];
+               row[j] = c * row[j] - s * t;
+            }
+            Arithmatic t = qtb_(i,0);
+            qtb_(i,0) = c * t + s * b;
+            b = c * b - s * t;
+         }
+
+         residual_ += b * b;
+         equations_++;
+      }
+      // --------------------------------------------------------------------
+      /** Back substitution \f$Rx = Q^Tb\f$.
+       *
+       *  \result \c false if the system has less equations than unknowns
+       *    or \f$R\f$ is singular.
+       */
+      bool solve( Vector& x ) const
+      {
+         if ( equations_ < UNKNOWNS )
+            return false;
+
+         for ( int i = UNKNOWNS - 1; i >= 0; i-- )
+         {
+            if ( r_(i,i) == 0 )
+               return false;
+
+            Arithmatic s = qtb_(i,0);
+            for ( int j = i + 1; j < UNKNOWNS; j++ )
+               s -= r_(i,j) * x(j,0);
+            x(i,0) = s / r_(i,i);
+         }
+         return true;
+      }
+      // --------------------------------------------------------------------
+      /** Determinant of the normal matrix \f$A^TA = R^TR\f$, computed from
+       *  the diagonal of \f$R\f$.
+       */
+      Arithmatic normal_det( void ) const
+      {
+         Arithmatic d = 1;
+         for ( int i = 0; i < UNKNOWNS; i++ )
+            d *= r_(i,i) * r_(i,i);
+         return d;
+      }
+      // --------------------------------------------------------------------
+      /** Squared norm of the residual \f$\|Ax - b\|^2\f$ of the solution.
+       */
+      Arithmatic residual( void ) const
+      { return residual_; }
+      // --------------------------------------------------------------------
+      int equations( void ) const
+      { return equations_; }
+      // --------------------------------------------------------------------
+      const Matrix& r( void ) const
+      { return r_; }
+
+   private:
+      Matrix r_;
+      Vector qtb_;
+      Arithmatic residual_;
+      int equations_;
+   };
+
+}// namespace wiselib
+#endif
@@ -20,7 +20,7 @@
 #define __ALGORITHMS_LOCALIZATION_DISTANCE_BASED_MATH_TRIANGULATION_H
 
 #include "algorithms/localization/distance_based/math/vec.h"
-#include "algorithms/localization/distance_based/math/localization_simple_matrix.h"
+#include "algorithms/localization/distance_based/math/localization_fixed_matrix.h"
 #include "algorithms/localization/distance_based/neighborhood/localization_neighborhood.h"
 #include "algorithms/localization/distance_based/util/localization_defutils.h"
 #include "util/pstl/algorithm.h"
@@ -58,7 +58,8 @@ namespace wiselib
    bool est_pos_min_max( const NeighborInfoList&, Vec<Arithmatic_P>& );
    /** Position estimation with distance to anchors and their positions.
     *  This method uses lateration for position estimation. Main idea is
-    *  to solve a system of equations, using here a least squares approach.
+    *  to solve a system of equations, using here a least squares approach
+    *  (QR decomposition, see LeastSquares).
     *
     *  Cause of different requirements, there is a chance to use standard
     *  or weighted least squares approach.
@@ -196,142 +197,61 @@ namespace wiselib
          const LaterationType& lat_type,
          bool use_pos )
    {
-
-
       typedef typename NeighborInfoList::iterator NeighborInfoListIterator;
-
+      typedef LeastSquares<OsModel_P, Arithmatic_P, 2> Solver;
 
       int nbr_size = neighbors.size();
       if ( nbr_size < 3 ) return false;
 
-
-
-      typedef SimpleMatrix<OsModel_P, Arithmatic_P> Matrix;
-      Matrix m_a;
-      Matrix m_b;
-      Matrix m_x;
-
-
-
       NeighborInfoListIterator it = neighbors.begin();
 
-
-
-
+      // Linearize by subtracting the equation of a reference point, either
+      // the given position or the first neighbor.
       Arithmatic_P x_1, y_1, d_1;
       if ( use_pos )
       {
-         m_a = Matrix( nbr_size, 2 );
-         m_b = Matrix( nbr_size, 1 );
          x_1 = pos.x();
          y_1 = pos.y();
          d_1 = 0;
       }
       else
       {
-         m_a = Matrix( nbr_size - 1, 2 );
-         m_b = Matrix( nbr_size - 1, 1 );
          x_1 = (*it)->pos().x();
          y_1 = (*it)->pos().y();
          d_1 = (*it)->distance();
          ++it;
       }
 
-     /* if(isense::JennicOs::jennic_os->id()==0x9999)
-                  	  isense::JennicOs::jennic_os->debug("befgin it %f %f %f",x_1,y_1,d_1);*/
-
-      int row = 0;
+      Solver solver;
       for ( ; it != neighbors.end(); ++it )
       {
          Arithmatic_P confidence = (*it)->confidence();
-
-             /*  if(isense::JennicOs::jennic_os->id()==0x9999)
-             	  isense::JennicOs::jennic_os->debug("it %f %f %f %f",(*it)->pos().x(),(*it)->pos().y(),(*it)->distance(),(*it)->confidence());*/
-
          if ( lat_type == lat_anchors ) confidence = 1;
 
+         Arithmatic_P a[2];
+         a[0] = 2 * ( (*it)->pos().x() - x_1 ) * confidence;
+         a[1] = 2 * ( (*it)->pos().y() - y_1 ) * confidence;
 
-         m_a(row,0) = 2 * ( (*it)->pos().x() - x_1 ) * confidence;
-         m_a(row,1) = 2 * ( (*it)->pos().y() - y_1 ) * confidence;
-
-       m_b(row,0) =
+         Arithmatic_P b =
             ( SQR( (*it)->pos().x() ) - SQR( x_1 )
                + SQR( (*it)->pos().y() ) - SQR( y_1 )
                + SQR( d_1 )
                - SQR( (*it)->distance() ) )
             * confidence;
-//    std::cout << "distanz von Knoten"<<  <<"gesch�tzt: " << (*
-/*     m_b(row,0) = 
-          ( SQR( (*it)->pos().x() -  x_1 )
-               + SQR( (*it)->pos().y() - y_1 )
-               + SQR( d_1 )
-               - SQR( (*it)->distance() ) ) *  0.5;
-*/         row++;
-      }
-
-
-//
-//     if (
-//    		  (( m_a.transposed() * m_a ).det() < 0.0001 )&&
-//    		  (( m_a.transposed() * m_a ).det() > -0.0001 )
-//    	){
-//    	  /*if(isense::JennicOs::jennic_os->id()==0x9999)
-//    		  isense::JennicOs::jennic_os->debug("before second transport");*/
-//    	  return false;
-//      }else
-//      {
-//    	 /* if(isense::JennicOs::jennic_os->id()==0x9999)
-//    	     		  isense::JennicOs::jennic_os->debug("det %f",( m_a.transposed() * m_a ).det());*/
-//    	 // return true;
-//      }
-
-
-
-Matrix tmp = m_a.transposed();
-tmp*=m_a;
-
-Arithmatic_P det = tmp.det();
-
-
-
-
-if( (det < 0.0001 )&&(det > -0.0001 ))
-{
-	return false;
-}
-
-
-
-
-m_x = tmp.inverse();
-
-
-
-tmp = m_a.transposed();
-
-
-
-
-
-
-tmp*=m_b;
-
-
-
-
-m_x*=tmp;
-
 
+         solver.add_equation( a, b );
+      }
 
-     // solve Ax = b
- /*     m_x = ( m_a.transposed() * m_a ).inverse()
-         * ( m_a.transposed() * m_b );*/
+      // (nearly) collinear neighbors
+      Arithmatic_P det = solver.normal_det();
+      if ( ( det < 0.0001 ) && ( det > -0.0001 ) )
+         return false;
 
-/*      if(isense::JennicOs::jennic_os->id()==0x9999)
-    	  isense::JennicOs::jennic_os->debug("after second transport");
-      return true;*/
+      typename Solver::Vector x;
+      if ( !solver.solve( x ) )
+         return false;
 
-      pos = Vec<Arithmatic_P>( m_x(0,0), m_x(1,0));
+      pos = Vec<Arithmatic_P>( x(0,0), x(1,0) );
 
       return true;
    }
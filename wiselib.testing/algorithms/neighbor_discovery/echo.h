@@ -34,6 +34,7 @@
 #include "pgb_payloads_ids.h"
 
 #include "echomsg.h"
+#include "echo_neighbor_table.h"
 
 /*
  * DEBUG MESSAGES TEMPLATE
@@ -44,7 +45,23 @@
 //#define DEBUG_ECHO_EXTRA
 //#define DEBUG_PIGGYBACKING
 #define MAX_PG_PAYLOAD 48
+
+/**
+ * Default capacity of the neighbor table, can be overridden per instance
+ * through the MaxNodes_P template parameter.
+ */
+#ifndef ECHO_MAX_NODES
 #define ECHO_MAX_NODES 20
+#endif
+
+/**
+ * Number of slots of the timer wheel that schedules the beacon timeout
+ * checks. One slot corresponds to one beacon period; timeouts longer than
+ * the wheel are re-armed when their slot comes up.
+ */
+#ifndef ECHO_WHEEL_SLOTS
+#define ECHO_WHEEL_SLOTS 32
+#endif
 
 /**
  *	If enabled, beacons that are below certain LQI thresholds
@@ -77,12 +94,16 @@ namespace wiselib {
     *  \ingroup basic_algorithm_concept
     *  \ingroup neighbourhood_discovery_algorithm
     *
+    *  Neighbors are kept in an EchoNeighborTable of MaxNodes_P entries,
+    *  so looking up the sender of a beacon does not depend on the size of
+    *  the neighborhood, and beacon timeouts are driven by a timer wheel
+    *  instead of scanning all neighbors every beacon period.
     */
    template<typename OsModel_P, typename Radio_P, typename Timer_P,
-   typename Debug_P>
+   typename Debug_P, int MaxNodes_P = ECHO_MAX_NODES>
    class Echo {
    public:
-      typedef Echo<OsModel_P, Radio_P, Timer_P, Debug_P> self_type;
+      typedef Echo<OsModel_P, Radio_P, Timer_P, Debug_P, MaxNodes_P> self_type;
       typedef self_type* self_pointer_t;
 
       // Type definitions
@@ -102,7 +123,7 @@ namespace wiselib {
       typedef typename Radio::ExtendedData ExData;
 
       typedef EchoMsg<OsModel, Radio> EchoMsg_t;
-      typedef Echo<OsModel_P, Radio_P, Timer_P, Debug_P> self_t;
+      typedef Echo<OsModel_P, Radio_P, Timer_P, Debug_P, MaxNodes_P> self_t;
 
       typedef delegate4<void, uint8_t, node_id_t, uint8_t, uint8_t*>
       event_notifier_delegate_t;
@@ -165,10 +186,10 @@ namespace wiselib {
       typedef struct neighbor_entry neighbor_entry_t;
 
       /**
-       * Type of the Vector Containing information for all nodes in the Neighborhood.
+       * Type of the Table Containing information for all nodes in the Neighborhood.
        */
-      typedef wiselib::vector_static<OsModel, neighbor_entry_t, ECHO_MAX_NODES>
-      node_info_vector_t;
+      typedef wiselib::EchoNeighborTable<OsModel, neighbor_entry_t, node_id_t,
+      MaxNodes_P, ECHO_WHEEL_SLOTS> node_info_vector_t;
       typedef typename node_info_vector_t::iterator iterator_t;
 
       /**
@@ -298,6 +319,8 @@ namespace wiselib {
       void init_echo() {
          neighborhood.clear();
          node_stability = 0;
+         assoc_sum_ = 0;
+         assoc_count_ = 0;
       }
       ;
 
@@ -390,19 +413,13 @@ namespace wiselib {
       }
 
       bool is_neighbor(node_id_t id) {
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->stable && it->id == id)
-               return true;
-         }
-         return false;
+         iterator_t it = neighborhood.find(id);
+         return it != neighborhood.end() && it->stable;
       }
 
       bool is_neighbor_bidi(node_id_t id) {
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->bidi && it->id == id)
-               return true;
-         }
-         return false;
+         iterator_t it = neighborhood.find(id);
+         return it != neighborhood.end() && it->bidi;
       }
 
       uint8_t nb_size(void) {
@@ -436,57 +453,48 @@ namespace wiselib {
       }
 
       uint8_t get_link_assoc(node_id_t neighbor_id) {
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->id == neighbor_id) {
-               return it->beacons_in_row;
-            }
+         iterator_t it = neighborhood.find(neighbor_id);
+         if (it != neighborhood.end()) {
+            return it->beacons_in_row;
          }
          return 0;
       }
 
       uint8_t get_ilink_assoc(node_id_t neighbor_id) {
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->id == neighbor_id) {
-               return it->inverse_link_assoc;
-            }
+         iterator_t it = neighborhood.find(neighbor_id);
+         if (it != neighborhood.end()) {
+            return it->inverse_link_assoc;
          }
          return 0;
       }
 
       uint8_t get_nb_stability(node_id_t id) {
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->id == id) {
-               return it->stability;
-            }
+         iterator_t it = neighborhood.find(id);
+         if (it != neighborhood.end()) {
+            return it->stability;
          }
          return 0;
       }
 
       uint8_t get_nb_receive_stability(node_id_t id) {
          uint8_t stability = 0;
-         for (iterator_t it = neighborhood.begin(); it != neighborhood.end(); ++it) {
-            if (it->id == id) {
-               uint32_t millis = (uint32_t) clock().milliseconds(
-                       clock().time()) + clock().seconds(clock().time())
-                       * 1000 - (uint32_t) clock().milliseconds(
-                       it->first_beacon) - (uint32_t) clock().seconds(
-                       it->first_beacon) * 1000;
-               uint32_t beacons_send = (millis / beacon_period) + 1;
+         iterator_t it = neighborhood.find(id);
+         if (it != neighborhood.end()) {
+            uint32_t millis = to_millis(clock().time())
+                    - to_millis(it->first_beacon);
+            uint32_t beacons_send = (millis / beacon_period) + 1;
 
 #ifdef DEBUG_ECHO
-               if (beacons_send < it->total_beacons)
-                  debug().debug("WARNING beacons_send %d total_beacons %d\n", beacons_send, it->total_beacons);
+            if (beacons_send < it->total_beacons)
+               debug().debug("WARNING beacons_send %d total_beacons %d\n", beacons_send, it->total_beacons);
 #endif
 
-               stability = (it->total_beacons * 100) / beacons_send;
+            stability = (it->total_beacons * 100) / beacons_send;
 #ifdef DEBUG_ECHO
-               if (stability > 100) {
-                  debug().debug("stability of %x is %d\n", it->id, stability);
-               }
-#endif
-
-               break;
+            if (stability > 100) {
+               debug().debug("stability of %x is %d\n", it->id, stability);
             }
+#endif
          }
 
          return stability;
@@ -718,164 +726,155 @@ namespace wiselib {
             received_beacon(from);
 #endif
 
-            for (iterator_t
-               it = neighborhood.begin();
-                    it != neighborhood.end();
-                    ++it) {
-
-               bool contains_my_id = false;
-               if (!it->active) {
-                  continue;
-               }
+            iterator_t it = neighborhood.find(from);
+            if (it == neighborhood.end() || !it->active) {
+               return;
+            }
 
-               if (it->id == from) {
+            bool contains_my_id = false;
 
-                  uint8_t nb_size_bytes = recvmsg->nb_list_size();
-                  uint8_t bytes_read = 0;
+            uint8_t nb_size_bytes = recvmsg->nb_list_size();
+            uint8_t bytes_read = 0;
 
 
-                  while (nb_size_bytes != bytes_read) {
+            while (nb_size_bytes != bytes_read) {
 
-                     node_id_t neighbor_id = read<OsModel, block_data_t, node_id_t> (
-                             recvmsg->payload() + bytes_read);
-                     bytes_read += sizeof (node_id_t);
-                     //						debug().debug( "Debug::echo::receive %d got beacon from %d bytes_read= %d \n", radio().id(), from, bytes_read);
+               node_id_t neighbor_id = read<OsModel, block_data_t, node_id_t> (
+                       recvmsg->payload() + bytes_read);
+               bytes_read += sizeof (node_id_t);
+               //						debug().debug( "Debug::echo::receive %d got beacon from %d bytes_read= %d \n", radio().id(), from, bytes_read);
 
-                     /*						if (radio().id()==4 && from==9) {
-                                                                      debug().debug( "Debug::echo::receive %d got beacon from %d bytes_read= %d \n", radio().id(), from, bytes_read);
-                                                                      debug().debug("TEST2: id: %d stability: %d size of list of neighbors: %d\n",read<OsModel, block_data_t, node_id_t> (
-                                                                                    recvmsg->payload()),read<OsModel, block_data_t, uint8_t> (
-                                                                                                  recvmsg->payload() + sizeof(node_id_t))
-                                                                                                  ,recvmsg->nb_list_size());
-                                                               }*/
+               /*						if (radio().id()==4 && from==9) {
+                                                                debug().debug( "Debug::echo::receive %d got beacon from %d bytes_read= %d \n", radio().id(), from, bytes_read);
+                                                                debug().debug("TEST2: id: %d stability: %d size of list of neighbors: %d\n",read<OsModel, block_data_t, node_id_t> (
+                                                                              recvmsg->payload()),read<OsModel, block_data_t, uint8_t> (
+                                                                                            recvmsg->payload() + sizeof(node_id_t))
+                                                                                            ,recvmsg->nb_list_size());
+                                                         }*/
 
-                     if (neighbor_id == radio().id()) {
+               if (neighbor_id == radio().id()) {
 #ifndef ENABLE_STABILITY_THRESHOLDS
-                        contains_my_id = true;
+                  contains_my_id = true;
 #endif
-                        //							debug().debug( "Debug::echo::NO %d got beacon from %d size= %d \n", radio().id(), bytes_read, nb_size_bytes);
+                  //							debug().debug( "Debug::echo::NO %d got beacon from %d size= %d \n", radio().id(), bytes_read, nb_size_bytes);
 
 #ifdef CALCULATE_INVERSE_STABILITY
-                        it->inverse_link_assoc
-                                = read<OsModel, block_data_t, uint8_t> (
-                                recvmsg->payload() + bytes_read);
-                        //							debug().debug( "Debug::echo::XXXXXX %d from %d it->inverse_link_assoc %d\n",
-                        //									radio().id(), from, it->inverse_link_assoc);
+                  set_inverse_link_assoc(*it,
+                          read<OsModel, block_data_t, uint8_t> (
+                          recvmsg->payload() + bytes_read));
+                  //							debug().debug( "Debug::echo::XXXXXX %d from %d it->inverse_link_assoc %d\n",
+                  //									radio().id(), from, it->inverse_link_assoc);
 
 
-                        bytes_read += sizeof (uint8_t);
+                  bytes_read += sizeof (uint8_t);
 #endif
 #ifndef ENABLE_STABILITY_THRESHOLDS
-                        break;
+                  break;
 #endif
-                     }
+               }
 #ifdef ENABLE_STABILITY_THRESHOLDS
-                     else if (neighbor_id == from) {
-
-
-                        it->stability = read<OsModel, block_data_t, uint16_t > (recvmsg->payload() + bytes_read);
-                        //							debug().debug( "Debug::echo::received_beacon::%d  stability %d threshold %d\n", radio().id(), it->stability, max_stability_threshold);
-                        /*
-                        if (radio().id()==4&& from==9)
-                        debug().debug( "Debug::echo::XXXXXX %d from %d stability %d iLinkAssoc %d linkAssoc %d\n",
-                                      radio().id(), bytes_read, nb_size_bytes , get_ilink_assoc(from), it->inverse_link_assoc);*/
-
-                        bytes_read += sizeof (uint16_t);
-                        if (
-                                //((6 * node_stability > 5 * it->stability)
-                                //&& ( 4 * node_stability < 5 * it->stability))
-                                //&&
-                                (it->stability > max_stability_threshold) &&
-                                (node_stability > max_stability_threshold)
-                                ) {
-                           contains_my_id = true;
-                        }
-
-                        /*							if (radio().id()==4 && from==9) {
-                                                                         debug().debug( "Debug::echo::YES %d got beacon from %d size= %d \n", radio().id(), bytes_read, nb_size_bytes);
-                        //							exit(1);
-                                                                         }*/
-                     }
+               else if (neighbor_id == from) {
+
+
+                  it->stability = read<OsModel, block_data_t, uint16_t > (recvmsg->payload() + bytes_read);
+                  //							debug().debug( "Debug::echo::received_beacon::%d  stability %d threshold %d\n", radio().id(), it->stability, max_stability_threshold);
+                  /*
+                  if (radio().id()==4&& from==9)
+                  debug().debug( "Debug::echo::XXXXXX %d from %d stability %d iLinkAssoc %d linkAssoc %d\n",
+                                radio().id(), bytes_read, nb_size_bytes , get_ilink_assoc(from), it->inverse_link_assoc);*/
+
+                  bytes_read += sizeof (uint16_t);
+                  if (
+                          //((6 * node_stability > 5 * it->stability)
+                          //&& ( 4 * node_stability < 5 * it->stability))
+                          //&&
+                          (it->stability > max_stability_threshold) &&
+                          (node_stability > max_stability_threshold)
+                          ) {
+                     contains_my_id = true;
+                  }
+
+                  /*							if (radio().id()==4 && from==9) {
+                                                                   debug().debug( "Debug::echo::YES %d got beacon from %d size= %d \n", radio().id(), bytes_read, nb_size_bytes);
+                  //							exit(1);
+                                                                   }*/
+               }
 #endif
 #ifdef CALCULATE_INVERSE_STABILITY
-                     else {
-                        bytes_read += sizeof (uint8_t);
-                     }
+               else {
+                  bytes_read += sizeof (uint8_t);
+               }
 #endif
-                  }
+            }
 
-                  if (!it->stable) {
-                     continue;
-                  }
+            if (!it->stable) {
+               return;
+            }
 #ifdef DEBUG_ECHO
 #ifdef ISENSE
-                  debug().debug("Debug::echo NODE %x has bidirectional communication with %x", radio().id(), from);
+            debug().debug("Debug::echo NODE %x has bidirectional communication with %x", radio().id(), from);
 #else
 #endif
-                  debug().debug("Debug::echo NODE %d has bidirectional communication with %d\n", radio().id(), from);
+            debug().debug("Debug::echo NODE %d has bidirectional communication with %d\n", radio().id(), from);
 #endif
 
-                  if (contains_my_id) {
-                     if (!it->bidi) {
-                        it->bidi = true;
-                        notify_listeners(NEW_NB_BIDI, from, 0, 0);
-                     }
+            if (contains_my_id) {
+               if (!it->bidi) {
+                  it->bidi = true;
+                  notify_listeners(NEW_NB_BIDI, from, 0, 0);
+               }
 
-                  } else {
-                     if (it->bidi) {
-                        it->bidi = false;
-                        notify_listeners(LOST_NB_BIDI, from, 0, 0);
-                     }
-                  }
+            } else {
+               if (it->bidi) {
+                  it->bidi = false;
+                  notify_listeners(LOST_NB_BIDI, from, 0, 0);
+               }
+            }
 
-                  uint8_t * alg_pl = recvmsg->payload()
-                          + recvmsg->nb_list_size();
-                  for (int i = 0; i < recvmsg->get_pg_payloads_num(); i++) {
+            uint8_t * alg_pl = recvmsg->payload()
+                    + recvmsg->nb_list_size();
+            for (int i = 0; i < recvmsg->get_pg_payloads_num(); i++) {
 
 #ifdef DEBUG_PIGGYBACKING
-                     debug().debug("Debug::echo NODE %d: new payload from %d with alg_id %d and size %d ",
-                             radio().id(), from, *alg_pl, *(alg_pl + 1));
+               debug().debug("Debug::echo NODE %d: new payload from %d with alg_id %d and size %d ",
+                       radio().id(), from, *alg_pl, *(alg_pl + 1));
 
-                     debug().debug(" [");
-                     for (uint8_t j = 1; j <= *(alg_pl + 1); j++) {
-                        debug().debug("%d ", *(alg_pl + j + 1));
-                     }
-                     debug().debug("]\n");
+               debug().debug(" [");
+               for (uint8_t j = 1; j <= *(alg_pl + 1); j++) {
+                  debug().debug("%d ", *(alg_pl + j + 1));
+               }
+               debug().debug("]\n");
 #endif
 
-                     for (reg_alg_iterator_t it = registered_apps.begin(); it
-                             != registered_apps.end(); it++) {
-
-                        if ((it->alg_id == *alg_pl)
-                                && (it->event_notifier_callback != 0)) {
-                           if ((it->events_flag & (uint8_t) NEW_PAYLOAD)
-                                   == (uint8_t) NEW_PAYLOAD) {
-                              it->event_notifier_callback(NEW_PAYLOAD,
-                                      from, *(alg_pl + 1), alg_pl + 2);
-                           } else if (((it->events_flag
-                                   & (uint8_t) NEW_PAYLOAD_BIDI)
-                                   == (uint8_t) NEW_PAYLOAD_BIDI)
-                                   && is_neighbor_bidi(from)) {
-                              it->event_notifier_callback(
-                                      NEW_PAYLOAD_BIDI, from, *(alg_pl
-                                      + 1), alg_pl + 2);
-                           }
-                        }
+               for (reg_alg_iterator_t it = registered_apps.begin(); it
+                       != registered_apps.end(); it++) {
+
+                  if ((it->alg_id == *alg_pl)
+                          && (it->event_notifier_callback != 0)) {
+                     if ((it->events_flag & (uint8_t) NEW_PAYLOAD)
+                             == (uint8_t) NEW_PAYLOAD) {
+                        it->event_notifier_callback(NEW_PAYLOAD,
+                                from, *(alg_pl + 1), alg_pl + 2);
+                     } else if (((it->events_flag
+                             & (uint8_t) NEW_PAYLOAD_BIDI)
+                             == (uint8_t) NEW_PAYLOAD_BIDI)
+                             && is_neighbor_bidi(from)) {
+                        it->event_notifier_callback(
+                                NEW_PAYLOAD_BIDI, from, *(alg_pl
+                                + 1), alg_pl + 2);
                      }
+                  }
+               }
 
-                     alg_pl += *(alg_pl + 1) + 2;
+               alg_pl += *(alg_pl + 1) + 2;
 
 #ifdef DEBUG_ECHO
 #ifdef ISENSE
-                     debug().debug("Debug::echo NODE %x has bidirectional communication with %x", radio().id(), from);
+               debug().debug("Debug::echo NODE %x has bidirectional communication with %x", radio().id(), from);
 #else
-                     debug().debug("Debug::echo NODE %d has bidirectional communication with %d\n", radio().id(), from);
+               debug().debug("Debug::echo NODE %d has bidirectional communication with %d\n", radio().id(), from);
 #endif
 #endif
-                  }
-                  break;
-               }
-
             }
          }
 
@@ -921,20 +920,17 @@ namespace wiselib {
 #endif
          // known is true if node from was contacted before
          bool known = false;
-         iterator_t it = neighborhood.begin();
-         // iterate nearby nodes to see if from is known
-         for (; it != neighborhood.end(); ++it) {
-            // if known
-            if (it->id == from) {
+         // look up from in the neighbor table
+         iterator_t it = neighborhood.find(from);
+         if (it != neighborhood.end()) {
 
-               //				debug().debug( "Debug::echo::received_beacon::%d new neighbor %d  stability %d iLinkAssoc %d linkAssoc %d\n",
-               //						radio().id(), from, get_nb_stability(from) , get_ilink_assoc(from), get_link_assoc(from));
+            //				debug().debug( "Debug::echo::received_beacon::%d new neighbor %d  stability %d iLinkAssoc %d linkAssoc %d\n",
+            //						radio().id(), from, get_nb_stability(from) , get_ilink_assoc(from), get_link_assoc(from));
 
-               it->total_beacons++;
+            it->total_beacons++;
 
-               if (!it->active) {
-                  break;
-               }
+            // if known and still active
+            if (it->active) {
 
 #ifdef ENABLE_LQI_THRESHOLDS
 #ifndef SHAWN
@@ -950,7 +946,7 @@ namespace wiselib {
                it->last_echo = clock().time();
                // increase the beacons received so far by one
                if (it->beacons_in_row != 255) {
-                  it->beacons_in_row++;
+                  set_link_assoc(*it, it->beacons_in_row + 1);
                }
 #ifndef SHAWN				
                it->last_lqi = ex.link_metric();
@@ -989,7 +985,7 @@ namespace wiselib {
 #endif
                }
 #endif
-               break;
+               schedule_timeout_check(it);
             }
          }
 
@@ -1003,7 +999,8 @@ namespace wiselib {
             }
 #endif
 #endif
-            if (neighborhood.size() < neighborhood.max_size()) {
+            if (it != neighborhood.end()
+                    || neighborhood.size() < neighborhood.max_size()) {
 
                if (it == neighborhood.end()) {
                   // create a new struct entry for the vector
@@ -1012,7 +1009,7 @@ namespace wiselib {
                   new_nb_entry.first_beacon = clock().time();
                   new_nb_entry.last_echo = clock().time();
                   //                    new_nb_entry.timeout = new_nb_entry.last_echo + timeout_period;
-                  new_nb_entry.beacons_in_row = 1;
+                  new_nb_entry.beacons_in_row = 0;
                   new_nb_entry.stability = 0;
                   new_nb_entry.inverse_link_assoc = 0;
                   new_nb_entry.total_beacons = 1;
@@ -1021,16 +1018,17 @@ namespace wiselib {
                   new_nb_entry.bidi = false;
 
                   //                    a.uptime = ((double)a.time_known-(double)a.beacons_missed)/(double)a.time_known;
-                  //add the struct to the vector
-                  neighborhood.push_back(new_nb_entry);
+                  //add the struct to the table
+                  it = neighborhood.insert(new_nb_entry);
                } else {
                   it->active = true;
                   it->last_echo = clock().time();
-                  it->beacons_in_row = 1;
                   it->stable = false;
                   it->bidi = false;
                   it->total_beacons++;
                }
+               set_link_assoc(*it, 1);
+               schedule_timeout_check(it);
 
                //debug().debug("Added new neighbor %d %d\n",radio().id(),from);
 
@@ -1113,30 +1111,32 @@ namespace wiselib {
       }
 
       /*
-       * Search the list of the nearby nodes
-       * for nodes that have missed too many
-       * beacons and remove them from the neighborhood
+       * Advance the timeout wheel by one beacon period and check
+       * the nodes whose deadline has come up: reset the link assoc
+       * of nodes that missed a beacon and remove the nodes that
+       * missed too many beacons from the neighborhood
        */
       void cleanup_nearby() {
 
-         uint32_t current_millisec = (uint32_t) clock().milliseconds(
-                 clock().time()) + clock().seconds(clock().time()) * 1000;
+         uint32_t current_millisec = to_millis(clock().time());
 
          if (clock().seconds(clock().time()) == 10) {
             notify_listeners(NB_READY, 0, 0, 0);
 
          }
-         // iterate the nearby_nodes vector for the missing nodes
+
+         neighborhood.tick();
+
+         // check the nodes scheduled for this beacon period
          for (iterator_t
-            it = neighborhood.begin();
+            it = neighborhood.pop_expired();
                  it != neighborhood.end();
-                 ++it) {
+                 it = neighborhood.pop_expired()) {
 
             if (!it->active)
                continue;
 
-            uint32_t last_echo_millisec = clock().seconds(it->last_echo) * 1000
-                    + (uint32_t) clock().milliseconds(it->last_echo);
+            uint32_t last_echo_millisec = to_millis(it->last_echo);
 
             //               debug().debug( "Debug::echo NODE %d cleanup %d %d\n",
             //                       radio().id(),
@@ -1144,7 +1144,7 @@ namespace wiselib {
             //                       current_millisec );
 
             if ((last_echo_millisec + beacon_period + 40) < current_millisec) {
-               it->beacons_in_row = 0;
+               set_link_assoc(*it, 0);
             }
             //TODO: Add a delta to last_echo_millisec
             // if last echo was too long before
@@ -1152,8 +1152,6 @@ namespace wiselib {
                     < current_millisec) {
 
                // remove the node from the neighborhood
-               //                    remove_from_neighborhood(it);
-               //                    neighborhood.erase(it);
                if (it->stable) {
                   //					debug().debug( "::timout NODE %x dropped from neighbors %x", it->id, radio().id(),it->stability);
                   notify_listeners(DROPPED_NB, it->id, 0, 0);
@@ -1161,7 +1159,7 @@ namespace wiselib {
                it->active = false;
                it->stable = false;
                it->bidi = false;
-               it->beacons_in_row = 0;
+               set_link_assoc(*it, 0);
                it->stability = 0;
 
 #ifdef DEBUG_ECHO
@@ -1171,60 +1169,19 @@ namespace wiselib {
                debug().debug("Debug::echo NODE %d droped from neighbors %d\n", radio().id(), it->id);
 #endif
 #endif
-               cleanup_nearby();
-               break;
-            }
-            /*
-            #ifdef ENABLE_STABILITY_THRESHOLDSX
-                                 else if (( it->stability < min_stability_threshold) && (it->stable)) {
-            //				debug().debug( "Debug::echo NODE %d dpd %d \n", radio().id(), it->id);
-
-            //				debug().debug( "::ss NODE %x dropped from neighbors %x", it->id, radio().id(),it->stability);
-                                        notify_listeners(DROPPED_NB, it->id, 0, 0);
-            //                                it->beacons_in_row = 0;
-                                        it->active = false;
-                                        it->stable = false;
-                                        it->bidi = false;
-                                        cleanup_nearby();
-                                        break;
-                                 }
-            #endif
-             */
-         }
-
-         /**
-          * Calculate the sum of all the link assoc's
-          */
-         uint16_t new_node_stability = 0;
-         uint16_t nodes_counted = 0;
-         for (iterator_t
-            it = neighborhood.begin();
-                 it != neighborhood.end();
-                 ++it) {
-#ifdef CALCULATE_INVERSE_STABILITY
-            if (it->inverse_link_assoc > 0) {
-               new_node_stability += it->inverse_link_assoc;
-               nodes_counted++;
+               continue;
             }
-            /*else if (it->inverse_link_assoc > 1) {
-                nodes_counted++;
-            }*/
 
-            //			debug().debug( "Debug::echo %d Adding [%d] with iAssoc %d\n", radio().id(), it->id, it->inverse_link_assoc);
-#else
-            if (it->beacons_in_row > 0) {
-               new_node_stability += it->beacons_in_row;
-               nodes_counted++;
-            }
-            //			debug().debug( "Debug::echo %d Adding [%d] with Assoc %d\n", radio().id(), it->id, it->beacons_in_row);
-#endif
+            schedule_timeout_check(it);
          }
 
          /**
-          * Calculate the sum of all the link assoc's
+          * Average of all the non zero link assoc's, the sum is kept
+          * up to date by set_link_assoc() and set_inverse_link_assoc()
           */
-         if (nodes_counted != 0) {
-            new_node_stability = new_node_stability / nodes_counted;
+         uint16_t new_node_stability = 0;
+         if (assoc_count_ != 0) {
+            new_node_stability = (uint16_t) (assoc_sum_ / assoc_count_);
          }
 
          /**
@@ -1299,11 +1256,34 @@ namespace wiselib {
        */
       void add_list_to_beacon(EchoMsg_t * msg) {
 
+         // leave room for the piggybacked payloads, in dense
+         // neighborhoods the list is truncated instead of overflowing
+         // the beacon
+         size_t reserved = 0;
+         for (reg_alg_iterator_t ait = registered_apps.begin(); ait
+                 != registered_apps.end(); ++ait) {
+            if (ait->size != 0) {
+               reserved += ait->size + 2;
+            }
+         }
+#ifdef ENABLE_STABILITY_THRESHOLDS
+         reserved += sizeof (node_id_t) + sizeof (uint16_t);
+#endif
+#ifdef CALCULATE_INVERSE_STABILITY
+         const size_t entry_size = sizeof (node_id_t) + sizeof (uint8_t);
+#else
+         const size_t entry_size = sizeof (node_id_t);
+#endif
+
          // add only the stable neighbor nodes to the array
          for (iterator_t
             it = neighborhood.begin();
                  it != neighborhood.end();
                  ++it) {
+            if (msg->buffer_size() + entry_size + reserved
+                    > (size_t) Radio::MAX_MESSAGE_LENGTH) {
+               break;
+            }
 #ifdef CALCULATE_INVERSE_STABILITY
             if (it->active) {
                msg->add_nb_entry(it->id);
@@ -1342,6 +1322,65 @@ namespace wiselib {
          //
       }
 
+      /**
+       * Converts a clock time to milliseconds.
+       */
+      uint32_t to_millis(time_t t) {
+         return (uint32_t) clock().seconds(t) * 1000
+                 + (uint32_t) clock().milliseconds(t);
+      }
+
+      /**
+       * Puts the neighbor on the timeout wheel at its next deadline: the
+       * missed beacon check while it has beacons in a row, the drop
+       * check otherwise. Deadlines that are not reached yet when the slot
+       * comes up are simply re-scheduled by cleanup_nearby().
+       */
+      void schedule_timeout_check(iterator_t it) {
+         uint32_t now = to_millis(clock().time());
+         uint32_t deadline = to_millis(it->last_echo);
+         if (it->beacons_in_row > 0) {
+            deadline += beacon_period + 40;
+         } else {
+            deadline += timeout_period;
+         }
+
+         uint32_t ticks = 1;
+         if (deadline > now) {
+            ticks = (deadline - now) / beacon_period + 1;
+         }
+         neighborhood.schedule(it, ticks);
+      }
+
+      /**
+       * Keeps the running sum of the link assoc's up to date, so the node
+       * stability does not need a pass over the whole neighborhood.
+       */
+      void account_assoc(uint8_t old_value, uint8_t new_value) {
+         if (old_value > 0) {
+            assoc_sum_ -= old_value;
+            assoc_count_--;
+         }
+         if (new_value > 0) {
+            assoc_sum_ += new_value;
+            assoc_count_++;
+         }
+      }
+
+      void set_link_assoc(neighbor_entry_t& entry, uint8_t value) {
+#ifndef CALCULATE_INVERSE_STABILITY
+         account_assoc(entry.beacons_in_row, value);
+#endif
+         entry.beacons_in_row = value;
+      }
+
+      void set_inverse_link_assoc(neighbor_entry_t& entry, uint8_t value) {
+#ifdef CALCULATE_INVERSE_STABILITY
+         account_assoc(entry.inverse_link_assoc, value);
+#endif
+         entry.inverse_link_assoc = value;
+      }
+
       enum NODE_ECHO_STATUS {
          SEARCHING = 1, WAITING = 0
       };
@@ -1356,6 +1395,11 @@ namespace wiselib {
       uint8_t status_;
       uint16_t node_stability;
       uint16_t node_stability_prv;
+      /**
+       * Sum and number of the non zero link assoc's of the neighborhood.
+       */
+      uint32_t assoc_sum_;
+      uint16_t assoc_count_;
 
       /**
        * \brief The timeout for dropping a stable neighbor.
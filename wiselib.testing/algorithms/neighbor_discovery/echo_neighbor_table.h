@@ -0,0 +1,210 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+/*
+ * File:   echo_neighbor_table.h
+ *
+ * Neighbor storage for Echo: entries live in a contiguous vector (so the
+ * neighborhood can still be iterated as before), an open addressing index
+ * maps node ids to vector positions and a timer wheel orders the entries
+ * by their next timeout check.
+ */
+
+#ifndef ECHO_NEIGHBOR_TABLE_H
+#define ECHO_NEIGHBOR_TABLE_H
+
+#include "util/pstl/vector_static.h"
+
+namespace wiselib {
+
+   /**
+    * \brief Fixed capacity, node id indexed neighbor table with an
+    * attached timer wheel.
+    *
+    * Entries are never moved once inserted, so iterators stay valid until
+    * clear() is called. Entry_P must provide a public member \c id of type
+    * NodeId_P.
+    *
+    * The timer wheel has WHEEL_SLOTS buckets, each holding an intrusive
+    * doubly linked list of entry indices. schedule() puts an entry into the
+    * bucket \a ticks steps ahead of the current one (delays longer than the
+    * wheel are clamped, the owner is expected to re-check and re-schedule),
+    * tick() advances the wheel by one bucket and pop_expired() hands out the
+    * entries of the current bucket one by one.
+    */
+   template<typename OsModel_P,
+            typename Entry_P,
+            typename NodeId_P,
+            int MAX_NODES,
+            int WHEEL_SLOTS = 32>
+   class EchoNeighborTable
+      : public vector_static<OsModel_P, Entry_P, MAX_NODES>
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Entry_P value_type;
+      typedef NodeId_P node_id_t;
+
+      typedef vector_static<OsModel, value_type, MAX_NODES> vector_type;
+      typedef typename vector_type::iterator iterator;
+      typedef typename vector_type::size_type size_type;
+
+      typedef uint16_t index_t;
+
+      enum
+      {
+         NO_INDEX = 0xffff,
+         INDEX_SIZE = 2 * MAX_NODES
+      };
+      // --------------------------------------------------------------------
+      EchoNeighborTable()
+      { clear(); }
+      // --------------------------------------------------------------------
+      void clear()
+      {
+         vector_type::clear();
+         for ( int i = 0; i < INDEX_SIZE; ++i )
+            index_[i] = NO_INDEX;
+         for ( int i = 0; i < WHEEL_SLOTS; ++i )
+            wheel_[i] = NO_INDEX;
+         current_slot_ = 0;
+      }
+      // --------------------------------------------------------------------
+      /** Returns the entry of node \a id or end() if the node is unknown.
+       */
+      iterator find( node_id_t id )
+      {
+         for ( size_type h = hash( id ); index_[h] != NO_INDEX; h = next( h ) )
+         {
+            if ( (*this)[index_[h]].id == id )
+               return this->begin() + index_[h];
+         }
+         return this->end();
+      }
+      // --------------------------------------------------------------------
+      /** Appends \a entry to the table. The caller has to make sure the id
+       *  is not present yet. Returns end() if the table is full.
+       */
+      iterator insert( const value_type& entry )
+      {
+         if ( this->size() == this->max_size() )
+            return this->end();
+
+         index_t pos = (index_t)this->size();
+         vector_type::push_back( entry );
+
+         size_type h = hash( entry.id );
+         while ( index_[h] != NO_INDEX )
+            h = next( h );
+         index_[h] = pos;
+
+         wheel_next_[pos] = NO_INDEX;
+         wheel_prev_[pos] = NO_INDEX;
+         wheel_slot_[pos] = NO_INDEX;
+
+         return this->begin() + pos;
+      }
+      // --------------------------------------------------------------------
+      ///@name Timer Wheel
+      ///@{
+      /** (Re-)schedules \a it to expire \a ticks wheel steps from now.
+       */
+      void schedule( iterator it, uint32_t ticks )
+      {
+         index_t pos = position( it );
+         unlink( pos );
+
+         if ( ticks == 0 )
+            ticks = 1;
+         if ( ticks >= (uint32_t)WHEEL_SLOTS )
+            ticks = WHEEL_SLOTS - 1;
+
+         index_t slot = (index_t)((current_slot_ + ticks) % WHEEL_SLOTS);
+         wheel_prev_[pos] = NO_INDEX;
+         wheel_next_[pos] = wheel_[slot];
+         if ( wheel_[slot] != NO_INDEX )
+            wheel_prev_[wheel_[slot]] = pos;
+         wheel_[slot] = pos;
+         wheel_slot_[pos] = slot;
+      }
+      // --------------------------------------------------------------------
+      void unschedule( iterator it )
+      { unlink( position( it ) ); }
+      // --------------------------------------------------------------------
+      /** Advances the wheel by one step.
+       */
+      void tick()
+      { current_slot_ = (index_t)((current_slot_ + 1) % WHEEL_SLOTS); }
+      // --------------------------------------------------------------------
+      /** Removes and returns one entry of the current wheel slot, end() if
+       *  the slot is empty.
+       */
+      iterator pop_expired()
+      {
+         index_t pos = wheel_[current_slot_];
+         if ( pos == NO_INDEX )
+            return this->end();
+
+         unlink( pos );
+         return this->begin() + pos;
+      }
+      ///@}
+
+   private:
+      // --------------------------------------------------------------------
+      size_type hash( node_id_t id ) const
+      { return (size_type)( id % INDEX_SIZE ); }
+      // --------------------------------------------------------------------
+      size_type next( size_type h ) const
+      { return h + 1 == INDEX_SIZE ? 0 : h + 1; }
+      // --------------------------------------------------------------------
+      index_t position( iterator it )
+      { return (index_t)( it - this->begin() ); }
+      // --------------------------------------------------------------------
+      void unlink( index_t pos )
+      {
+         index_t slot = wheel_slot_[pos];
+         if ( slot == NO_INDEX )
+            return;
+
+         if ( wheel_prev_[pos] != NO_INDEX )
+            wheel_next_[wheel_prev_[pos]] = wheel_next_[pos];
+         else
+            wheel_[slot] = wheel_next_[pos];
+
+         if ( wheel_next_[pos] != NO_INDEX )
+            wheel_prev_[wheel_next_[pos]] = wheel_prev_[pos];
+
+         wheel_next_[pos] = NO_INDEX;
+         wheel_prev_[pos] = NO_INDEX;
+         wheel_slot_[pos] = NO_INDEX;
+      }
+
+      index_t index_[INDEX_SIZE];
+
+      index_t wheel_[WHEEL_SLOTS];
+      index_t wheel_next_[MAX_NODES];
+      index_t wheel_prev_[MAX_NODES];
+      index_t wheel_slot_[MAX_NODES];
+      index_t current_slot_;
+   };
+
+}
+
+#endif	/* ECHO_NEIGHBOR_TABLE_H */
@@ -110,7 +110,7 @@ typedef Os::TxRadio Radio;
 typedef Radio::node_id_t node_id_t;
 typedef Radio::block_data_t block_data_t;
 #ifdef USE_FLOODING
-typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 64 > FloodingStaticMap;
+typedef wiselib::StaticArrayRoutingTable<Os, Os::Radio, 64, wiselib::SequenceWindow<Os> > FloodingStaticMap;
 typedef wiselib::FloodingAlgorithm<Os, FloodingStaticMap, Os::Radio, Os::Debug> flooding_algorithm_t;
 #endif
 typedef wiselib::ResourceController<wiselib::StaticString> resource_t;
@@ -0,0 +1,181 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef CTR_DRBG_H
+#define CTR_DRBG_H
+
+#include <string.h>
+#include "algorithms/crypto/aes.h"
+
+namespace wiselib {
+	
+	/**
+	 * @brief Cryptographically secure generator, AES-128 CTR_DRBG
+	 * (NIST SP 800-90A, without derivation function).
+	 * 
+	 * Meant for key material such as ECC private keys, not for protocol
+	 * jitter: use Kiss, Xoshiro256StarStar or Philox4x32 there. The output
+	 * is only as unpredictable as the entropy passed to seed() and
+	 * reseed() (e.g. radio noise, /dev/urandom on PC); srand() exists for
+	 * the Rand concept but 32 bit of seed are no secret.
+	 * 
+	 * After every request the key is replaced by fresh generator output,
+	 * so a later compromise of the state does not reveal earlier output.
+	 * operator() draws from a buffered request of BUFFER_SIZE bytes.
+	 * 
+	 * @ingroup rand_concept
+	 * 
+	 * @tparam OsModel_P
+	 */
+	template<
+		typename OsModel_P
+	>
+	class CtrDrbg {
+		
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::block_data_t block_data_t;
+			typedef typename OsModel::size_t size_type;
+			typedef ::uint32_t rand_t;
+			typedef ::uint32_t value_t;
+			typedef CtrDrbg<OsModel> self_type;
+			typedef self_type* self_pointer_t;
+			
+			enum { RANDOM_MAX = (value_t)(-1) };
+			enum { BLOCK_SIZE = 16, SEED_SIZE = 32, BUFFER_SIZE = 64 };
+			
+			CtrDrbg() {
+				memset(key_, 0, sizeof(key_));
+				memset(v_, 0, sizeof(v_));
+				cipher_.key_setup(key_, 128);
+				buffered_ = 0;
+			}
+			
+			void srand(value_t seed) {
+				block_data_t material[sizeof(value_t)];
+				memcpy(material, &seed, sizeof(value_t));
+				this->seed(material, sizeof(value_t));
+			}
+			
+			/**
+			 * Instantiates the generator from len bytes of entropy.
+			 */
+			void seed(const block_data_t* material, size_type len) {
+				memset(key_, 0, sizeof(key_));
+				memset(v_, 0, sizeof(v_));
+				cipher_.key_setup(key_, 128);
+				reseed(material, len);
+			}
+			
+			/**
+			 * Mixes len more bytes of entropy into the state.
+			 */
+			void reseed(const block_data_t* material, size_type len) {
+				block_data_t chunk[SEED_SIZE];
+				do {
+					size_type k = len < SEED_SIZE ? len : (size_type)SEED_SIZE;
+					memset(chunk, 0, SEED_SIZE);
+					memcpy(chunk, material, k);
+					update(chunk);
+					material += k;
+					len -= k;
+				} while(len > 0);
+				memset(chunk, 0, SEED_SIZE);
+				buffered_ = 0;
+			}
+			
+			value_t operator()() {
+				if(buffered_ < sizeof(value_t)) {
+					fill(buffer_, BUFFER_SIZE);
+					buffered_ = BUFFER_SIZE;
+				}
+				value_t r;
+				buffered_ -= sizeof(value_t);
+				memcpy(&r, buffer_ + buffered_, sizeof(value_t));
+				memset(buffer_ + buffered_, 0, sizeof(value_t));
+				return r;
+			}
+			
+			/**
+			 * @return uniform value in [0, max), 0 for max 0
+			 */
+			value_t operator()(value_t max) {
+				if(max == 0) { return 0; }
+				value_t threshold = (value_t)(-max) % max;
+				value_t r;
+				do {
+					r = (*this)();
+				} while(r < threshold);
+				return r % max;
+			}
+			
+			/**
+			 * Writes n random bytes to buffer as one request.
+			 */
+			void fill(block_data_t* buffer, size_type n) {
+				block_data_t block[BLOCK_SIZE];
+				while(n > 0) {
+					increment();
+					cipher_.encrypt(v_, block);
+					size_type k = n < BLOCK_SIZE ? n : (size_type)BLOCK_SIZE;
+					memcpy(buffer, block, k);
+					buffer += k;
+					n -= k;
+				}
+				memset(block, 0, BLOCK_SIZE);
+				
+				block_data_t zero[SEED_SIZE];
+				memset(zero, 0, SEED_SIZE);
+				update(zero);
+			}
+			
+		private:
+			void increment() {
+				for(int i = BLOCK_SIZE - 1; i >= 0 && ++v_[i] == 0; i--) {
+				}
+			}
+			
+			/**
+			 * CTR_DRBG_Update: key and counter become the next two output
+			 * blocks xor provided.
+			 */
+			void update(const block_data_t* provided) {
+				block_data_t temp[SEED_SIZE];
+				increment();
+				cipher_.encrypt(v_, temp);
+				increment();
+				cipher_.encrypt(v_, temp + BLOCK_SIZE);
+				for(int i = 0; i < SEED_SIZE; i++) {
+					temp[i] ^= provided[i];
+				}
+				memcpy(key_, temp, BLOCK_SIZE);
+				memcpy(v_, temp + BLOCK_SIZE, BLOCK_SIZE);
+				memset(temp, 0, SEED_SIZE);
+				cipher_.key_setup(key_, 128);
+			}
+			
+			AES<OsModel> cipher_;
+			block_data_t key_[BLOCK_SIZE];
+			block_data_t v_[BLOCK_SIZE];
+			block_data_t buffer_[BUFFER_SIZE];
+			size_type buffered_;
+	}; // CtrDrbg
+}
+
+#endif // CTR_DRBG_H
@@ -0,0 +1,170 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <string.h>
+
+namespace wiselib {
+	
+	/**
+	 * @brief Philox4x32-10 counter-based generator (Salmon et al.).
+	 * 
+	 * Every output block is a keyed bijection of a 128 bit counter: the
+	 * key is the global seed, the upper 64 counter bits are the stream
+	 * (e.g. the node id) and the lower 64 bits the position in it. Streams
+	 * are therefore disjoint by construction and any position can be
+	 * reached in O(1) via set_position(), which makes a simulation
+	 * reproducible per node regardless of the order nodes draw values in.
+	 * 
+	 * @ingroup rand_concept
+	 * 
+	 * @tparam OsModel_P
+	 */
+	template<
+		typename OsModel_P
+	>
+	class Philox4x32 {
+		
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::block_data_t block_data_t;
+			typedef typename OsModel::size_t size_type;
+			typedef ::uint32_t rand_t;
+			typedef ::uint32_t value_t;
+			typedef Philox4x32<OsModel> self_type;
+			typedef self_type* self_pointer_t;
+			
+			enum { RANDOM_MAX = (value_t)(-1) };
+			
+			Philox4x32() {
+				seed(0, 0);
+			}
+			
+			void srand(value_t seed) {
+				this->seed(seed, 0);
+			}
+			
+			void seed(::uint64_t global_seed, ::uint64_t stream) {
+				key_[0] = (::uint32_t)global_seed;
+				key_[1] = (::uint32_t)(global_seed >> 32);
+				stream_ = stream;
+				set_position(0);
+			}
+			
+			/**
+			 * Continues the stream at its position-th 32 bit value.
+			 */
+			void set_position(::uint64_t position) {
+				block_ = position / 4;
+				generate(block_++, out_);
+				index_ = (::uint8_t)(position % 4);
+			}
+			
+			value_t operator()() {
+				if(index_ == 4) {
+					generate(block_++, out_);
+					index_ = 0;
+				}
+				return out_[index_++];
+			}
+			
+			/**
+			 * @return uniform value in [0, max), 0 for max 0
+			 */
+			value_t operator()(value_t max) {
+				::uint64_t m = (::uint64_t)(*this)() * max;
+				value_t l = (value_t)m;
+				if(l < max) {
+					value_t threshold = (value_t)(-max) % max;
+					while(l < threshold) {
+						m = (::uint64_t)(*this)() * max;
+						l = (value_t)m;
+					}
+				}
+				return (value_t)(m >> 32);
+			}
+			
+			/**
+			 * Writes n random bytes to buffer. Whole blocks go straight into
+			 * the buffer; the values handed out are the same as those of
+			 * repeated operator() calls.
+			 */
+			void fill(block_data_t* buffer, size_type n) {
+				while(n > 0 && index_ != 4) {
+					take(buffer, n, out_[index_++]);
+				}
+				while(n >= 16) {
+					::uint32_t r[4];
+					generate(block_++, r);
+					memcpy(buffer, r, 16);
+					buffer += 16;
+					n -= 16;
+				}
+				if(n > 0) {
+					generate(block_++, out_);
+					index_ = 0;
+					while(n > 0) {
+						take(buffer, n, out_[index_++]);
+					}
+				}
+			}
+			
+		private:
+			enum {
+				M0 = 0xd2511f53UL, M1 = 0xcd9e8d57UL,
+				W0 = 0x9e3779b9UL, W1 = 0xbb67ae85UL
+			};
+			
+			static void take(block_data_t*& buffer, size_type& n, ::uint32_t v) {
+				size_type k = n < 4 ? n : 4;
+				memcpy(buffer, &v, k);
+				buffer += k;
+				n -= k;
+			}
+			
+			void generate(::uint64_t block, ::uint32_t* out) {
+				::uint32_t c0 = (::uint32_t)block, c1 = (::uint32_t)(block >> 32);
+				::uint32_t c2 = (::uint32_t)stream_, c3 = (::uint32_t)(stream_ >> 32);
+				::uint32_t k0 = key_[0], k1 = key_[1];
+				for(int round = 0; round < 10; round++) {
+					::uint64_t p0 = (::uint64_t)M0 * c0;
+					::uint64_t p1 = (::uint64_t)M1 * c2;
+					::uint32_t n0 = (::uint32_t)(p1 >> 32) ^ c1 ^ k0;
+					::uint32_t n2 = (::uint32_t)(p0 >> 32) ^ c3 ^ k1;
+					c1 = (::uint32_t)p1;
+					c3 = (::uint32_t)p0;
+					c0 = n0;
+					c2 = n2;
+					k0 += W0;
+					k1 += W1;
+				}
+				out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+			}
+			
+			::uint32_t key_[2];
+			::uint64_t stream_;
+			::uint64_t block_;
+			::uint32_t out_[4];
+			::uint8_t index_;
+	}; // Philox4x32
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,193 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef XOSHIRO256_H
+#define XOSHIRO256_H
+
+#include <string.h>
+
+namespace wiselib {
+	
+	/**
+	 * @brief xoshiro256** generator (Blackman, Vigna).
+	 * 
+	 * Drop-in replacement for Kiss with a 2^256 - 1 period. Besides the
+	 * 32 bit values of the Rand concept it hands out whole 64 bit words
+	 * (next64()) and fills buffers in bulk, so callers that need many
+	 * random bytes pay one call per 8 of them.
+	 * 
+	 * seed(global_seed, stream) derives the state of stream (e.g. the
+	 * node id) from one global seed via splitmix64, so a simulation run is
+	 * reproducible from a single number. Streams seeded that way are
+	 * statistically independent; where provably disjoint sequences are
+	 * needed, seed once and jump() 2^128 steps per stream, or use Philox.
+	 * 
+	 * @ingroup rand_concept
+	 * 
+	 * @tparam OsModel_P
+	 */
+	template<
+		typename OsModel_P
+	>
+	class Xoshiro256StarStar {
+		
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::block_data_t block_data_t;
+			typedef typename OsModel::size_t size_type;
+			typedef ::uint32_t rand_t;
+			typedef ::uint32_t value_t;
+			typedef Xoshiro256StarStar<OsModel> self_type;
+			typedef self_type* self_pointer_t;
+			
+			enum { RANDOM_MAX = (value_t)(-1) };
+			
+			Xoshiro256StarStar() {
+				seed(0, 0);
+			}
+			
+			void srand(value_t seed) {
+				this->seed(seed, 0);
+			}
+			
+			/**
+			 * Sets the state to the one of stream derived from global_seed.
+			 */
+			void seed(::uint64_t global_seed, ::uint64_t stream) {
+				::uint64_t x = global_seed;
+				::uint64_t salt = splitmix64(x) ^ stream;
+				x = salt;
+				for(int i = 0; i < 4; i++) {
+					s_[i] = splitmix64(x);
+				}
+				have_low_ = false;
+			}
+			
+			value_t operator()() {
+				// both halves of a 64 bit output are of full quality
+				if(have_low_) {
+					have_low_ = false;
+					return low_;
+				}
+				::uint64_t r = next64();
+				low_ = (value_t)r;
+				have_low_ = true;
+				return (value_t)(r >> 32);
+			}
+			
+			/**
+			 * @return uniform value in [0, max), 0 for max 0
+			 */
+			value_t operator()(value_t max) {
+				// Lemire's multiply-shift reduction, rejection makes it unbiased
+				::uint64_t m = (::uint64_t)(*this)() * max;
+				value_t l = (value_t)m;
+				if(l < max) {
+					value_t threshold = (value_t)(-max) % max;
+					while(l < threshold) {
+						m = (::uint64_t)(*this)() * max;
+						l = (value_t)m;
+					}
+				}
+				return (value_t)(m >> 32);
+			}
+			
+			::uint64_t next64() {
+				::uint64_t result = rotl(s_[1] * 5, 7) * 9;
+				::uint64_t t = s_[1] << 17;
+				
+				s_[2] ^= s_[0];
+				s_[3] ^= s_[1];
+				s_[1] ^= s_[2];
+				s_[0] ^= s_[3];
+				s_[2] ^= t;
+				s_[3] = rotl(s_[3], 45);
+				
+				return result;
+			}
+			
+			/**
+			 * Writes n random bytes to buffer.
+			 */
+			void fill(block_data_t* buffer, size_type n) {
+				// keep the state in registers for the whole run
+				::uint64_t s0 = s_[0], s1 = s_[1], s2 = s_[2], s3 = s_[3];
+				while(n > 0) {
+					::uint64_t r = rotl(s1 * 5, 7) * 9;
+					::uint64_t t = s1 << 17;
+					s2 ^= s0;
+					s3 ^= s1;
+					s1 ^= s2;
+					s0 ^= s3;
+					s2 ^= t;
+					s3 = rotl(s3, 45);
+					
+					size_type k = n < 8 ? n : 8;
+					memcpy(buffer, &r, k);
+					buffer += k;
+					n -= k;
+				}
+				s_[0] = s0; s_[1] = s1; s_[2] = s2; s_[3] = s3;
+			}
+			
+			/**
+			 * Advances the state by 2^128 steps, which gives 2^128
+			 * non-overlapping subsequences of 2^128 values each.
+			 */
+			void jump() {
+				static const ::uint64_t JUMP[] = {
+					0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+					0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+				};
+				::uint64_t t[4] = { 0, 0, 0, 0 };
+				for(int i = 0; i < 4; i++) {
+					for(int b = 0; b < 64; b++) {
+						if(JUMP[i] & ((::uint64_t)1 << b)) {
+							for(int j = 0; j < 4; j++) {
+								t[j] ^= s_[j];
+							}
+						}
+						next64();
+					}
+				}
+				for(int j = 0; j < 4; j++) {
+					s_[j] = t[j];
+				}
+				have_low_ = false;
+			}
+			
+		private:
+			static ::uint64_t rotl(::uint64_t x, int k) {
+				return (x << k) | (x >> (64 - k));
+			}
+			
+			static ::uint64_t splitmix64(::uint64_t& x) {
+				::uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				return z ^ (z >> 31);
+			}
+			
+			::uint64_t s_[4];
+			value_t low_;
+			bool have_low_;
+	}; // Xoshiro256StarStar
+}
+
+#endif // XOSHIRO256_H
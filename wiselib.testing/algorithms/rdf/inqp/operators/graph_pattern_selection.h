@@ -52,79 +52,126 @@ namespace wiselib {
 			typedef typename Base::Query Query;
 			typedef GraphPatternSelection<OsModel_P, Processor_P> self_type;
 			typedef typename RowT::Value Value;
+			typedef typename Processor::Dictionary::key_type key_type;
 			
 			enum { MAX_STRING_LENGTH = 256 };
 			
 			void init(GraphPatternSelectionDescription<OsModel, Processor> *gpsd, Query *query) {
 				Base::init(reinterpret_cast<OperatorDescription<OsModel, Processor>* >(gpsd), query);
 				
+				affected_mask_ = 0;
 				for(size_type i = 0; i < 3; i++) {
 					affected_[i] = gpsd->affects(i);
 					if(affected_[i]) {
 						values_[i] = gpsd->value(i);
+						affected_mask_ |= (1 << i);
 					}
 				}
+				row_ = 0;
 			}
 			
+			/**
+			 * Scans the whole tuple store on its own, see
+			 * INQPQueryProcessor::execute() for the shared scan.
+			 */
 			void execute(TupleStoreT& ts) {
 				//DBG("GPS execute");
 				typedef typename TupleStoreT::TupleContainer Container;
 				typedef typename Container::iterator Citer;
 				
-				RowT *row = RowT::create(this->projection_info().columns()); //TupleStoreT::COLUMNS);
-				
+				begin_scan();
 				for(Citer iter = ts.container().begin(); iter != ts.container().end(); ++iter) {
-					bool match = true;
-					size_type row_idx = 0;
+					key_type keys[TupleStoreT::COLUMNS];
+					Value values[TupleStoreT::COLUMNS];
 					for(size_type i = 0; i < TupleStoreT::COLUMNS; i++) {
-						typename Processor::Value v = this->translator().translate(TupleStoreT::to_key(iter->get(i)));
-						
-						if(affected_[i]) {
-							if(values_[i] != v) {
-								match = false;
-								break;
-							}
-						}
-						
-						switch(this->projection_info().type(i)) {
-							case ProjectionInfoBase::IGNORE:
-								//DBG("col %d ignore", i);
-								break;
-							case ProjectionInfoBase::INTEGER: {
-								//DBG("col %d INT", i);
-								block_data_t *s = this->dictionary().get_value(TupleStoreT::to_key(iter->get(i)));
-								long l = atol((char*)s);
-								(*row)[row_idx++] = *reinterpret_cast<Value*>(&l);
-								this->dictionary().free_value(s);
-								break;
-							}
-							case ProjectionInfoBase::FLOAT: {
-								//DBG("col %d FLOAT", i);
-								block_data_t *s = this->dictionary().get_value(TupleStoreT::to_key(iter->get(i)));
-								float f = atof((char*)s);
-								(*row)[row_idx++] = *reinterpret_cast<Value*>(&f);
-								this->dictionary().free_value(s);
-								break;
-							}
-							case ProjectionInfoBase::STRING:
-								//DBG("col %d STRING", i);
-								(*row)[row_idx++] = v;
-								this->reverse_translator().offer(TupleStoreT::to_key(iter->get(i)), v);
-								break;
+						keys[i] = TupleStoreT::to_key(iter->get(i));
+						if(affected_mask_ & (1 << i)) {
+							values[i] = this->translator().translate(keys[i]);
 						}
 					}
-					if(match) {
-						this->parent().push(*row);
+					if(matches(values)) {
+						push_tuple(keys, values, affected_mask_);
 					}
 				}
-				
-				row->destroy();
+				end_scan();
+			}
+			
+			/**
+			 * Columns the selection compares, bit i for column i.
+			 */
+			::uint8_t affected_columns() { return affected_mask_; }
+			
+			/**
+			 * Whether a tuple matches, given the translated values of (at
+			 * least) the affected columns. Only reads the selection, so
+			 * it may run concurrently for different selections.
+			 */
+			bool matches(const Value *values) const {
+				for(size_type i = 0; i < 3; i++) {
+					if(affected_[i] && values_[i] != values[i]) {
+						return false;
+					}
+				}
+				return true;
+			}
+			
+			void begin_scan() {
+				row_ = RowT::create(this->projection_info().columns()); //TupleStoreT::COLUMNS);
+			}
+			
+			/**
+			 * Projects a matching tuple and pushes it to the parent.
+			 * values[i] is the translation of keys[i] if bit i of
+			 * translated is set, otherwise it is translated here when
+			 * needed.
+			 */
+			void push_tuple(const key_type *keys, const Value *values, ::uint8_t translated) {
+				RowT &row = *row_;
+				size_type row_idx = 0;
+				for(size_type i = 0; i < TupleStoreT::COLUMNS; i++) {
+					switch(this->projection_info().type(i)) {
+						case ProjectionInfoBase::IGNORE:
+							//DBG("col %d ignore", i);
+							break;
+						case ProjectionInfoBase::INTEGER: {
+							//DBG("col %d INT", i);
+							block_data_t *s = this->dictionary().get_value(keys[i]);
+							long l = atol((char*)s);
+							row[row_idx++] = *reinterpret_cast<Value*>(&l);
+							this->dictionary().free_value(s);
+							break;
+						}
+						case ProjectionInfoBase::FLOAT: {
+							//DBG("col %d FLOAT", i);
+							block_data_t *s = this->dictionary().get_value(keys[i]);
+							float f = atof((char*)s);
+							row[row_idx++] = *reinterpret_cast<Value*>(&f);
+							this->dictionary().free_value(s);
+							break;
+						}
+						case ProjectionInfoBase::STRING: {
+							//DBG("col %d STRING", i);
+							Value v = (translated & (1 << i)) ? values[i] : this->translator().translate(keys[i]);
+							row[row_idx++] = v;
+							this->reverse_translator().offer(keys[i], v);
+							break;
+						}
+					}
+				}
+				this->parent().push(row);
+			}
+			
+			void end_scan() {
+				row_->destroy();
+				row_ = 0;
 				this->parent().push(Base::END_OF_INPUT);
 			}
 			
 		private:
 			typename Processor::Value values_[3];
 			bool affected_[3];
+			::uint8_t affected_mask_;
+			RowT *row_;
 		
 	}; // GraphPatternSelection
 }
@@ -36,15 +36,47 @@
 #include "dictionary_translator.h"
 #include "hash_translator.h"
 #include <algorithms/hash/fnv.h>
+#include <util/inline_executor.h>
+
+/**
+ * Tuples a shared scan translates before matching them against the
+ * selections. The block is part of every query processor: a key and a
+ * value array of INQP_SCAN_BLOCK x COLUMNS entries each, plus one bit
+ * per tuple and query. Blocks only pay off when the executor spreads
+ * the matching over threads, so sensor nodes scan tuple by tuple.
+ */
+#ifndef INQP_SCAN_BLOCK
+	#ifdef PC
+		#define INQP_SCAN_BLOCK 32
+	#else
+		#define INQP_SCAN_BLOCK 1
+	#endif
+#endif
+
+/*
+ * INQP_PARALLEL_MIN_SELECTIONS: fewest selections the executor gives to
+ * one thread in a shared scan. Defaults to MAX_QUERIES / THREADS of the
+ * executor (rounded up), so a pass with a selection of every query can
+ * use all threads.
+ */
 
 namespace wiselib {
 	
 	/**
 	 * @brief
 	 * 
+	 * Graph pattern selections read the tuple store in shared scans: one
+	 * pass feeds the selections of all queries executed together, the
+	 * n-th selection (by operator id) of every query in the n-th pass, so
+	 * the selections of one query keep their order. A pass translates the
+	 * tuples once, block by block, matches the selections against the
+	 * block through the executor, which may spread them over threads (see
+	 * PCThreadPool), and pushes the matching rows to the parent operators
+	 * in the calling context.
+	 * 
 	 * @ingroup
 	 * 
-	 * @tparam 
+	 * @tparam Executor_P provides parallel_for(), e.g. InlineExecutor
 	 */
 	template<
 		typename OsModel_P,
@@ -55,7 +87,8 @@ namespace wiselib {
 		typename ReverseTranslator_P = HashTranslator<OsModel_P, Dictionary_P, Hash_P, 64>,
 		typename Value_P = ::uint32_t,
 		int MAX_QUERIES_P = 8,
-		typename Timer_P = typename OsModel_P::Timer
+		typename Timer_P = typename OsModel_P::Timer,
+		typename Executor_P = InlineExecutor<OsModel_P>
 	>
 	class INQPQueryProcessor {
 		
@@ -63,7 +96,7 @@ namespace wiselib {
 			typedef OsModel_P OsModel;
 			typedef typename OsModel::block_data_t block_data_t;
 			typedef typename OsModel::size_t size_type;
-			typedef INQPQueryProcessor<OsModel_P, TupleStore_P, Hash_P, Dictionary_P, Translator_P, ReverseTranslator_P, Value_P, MAX_QUERIES_P> self_type;
+			typedef INQPQueryProcessor<OsModel_P, TupleStore_P, Hash_P, Dictionary_P, Translator_P, ReverseTranslator_P, Value_P, MAX_QUERIES_P, Timer_P, Executor_P> self_type;
 			typedef Value_P Value;
 			typedef TupleStore_P TupleStoreT;
 			typedef Dictionary_P Dictionary;
@@ -71,11 +104,26 @@ namespace wiselib {
 			typedef ReverseTranslator_P ReverseTranslator;
 			typedef Row<OsModel, Value> RowT;
 			typedef Timer_P Timer;
+			typedef Executor_P Executor;
+			typedef typename Dictionary::key_type key_type;
 			
 			enum {
 				MAX_QUERIES = MAX_QUERIES_P
 			};
 			
+			enum {
+				SCAN_BLOCK = INQP_SCAN_BLOCK,
+				MATCH_WORDS = (SCAN_BLOCK + 31) / 32
+			};
+			
+			enum {
+			#ifdef INQP_PARALLEL_MIN_SELECTIONS
+				PARALLEL_MIN_SELECTIONS = INQP_PARALLEL_MIN_SELECTIONS
+			#else
+				PARALLEL_MIN_SELECTIONS = (MAX_QUERIES_P + Executor_P::THREADS - 1) / Executor_P::THREADS
+			#endif
+			};
+			
 			enum {
 				DICTIONARY_NULL_KEY = Dictionary::NULL_KEY
 			};
@@ -147,28 +195,48 @@ namespace wiselib {
 				assert(query->ready());
 				DBG("executing query @%d", id);
 				query->build_tree();
+				execute(&query, 1);
+			}
+			
+			/**
+			 * Executes all ready queries again, with one shared scan per
+			 * pass, e.g. periodically for standing queries.
+			 */
+			void execute_all() {
+				Query *queries[MAX_QUERIES];
+				size_type n = 0;
+				for(typename Queries::iterator iter = queries_.begin(); iter != queries_.end(); ++iter) {
+					if(iter->second->ready()) {
+						iter->second->build_tree();
+						queries[n++] = iter->second;
+					}
+				}
+				execute(queries, n);
+			}
+			
+			/**
+			 * Executes n (at most MAX_QUERIES) queries whose operator trees
+			 * are built.
+			 */
+			void execute(Query **queries, size_type n) {
+				int last[MAX_QUERIES];
+				for(size_type i = 0; i < n; i++) { last[i] = -1; }
 				
-				for(operator_id_t id = 0; id < MAX_OPERATOR_ID; id++) {
-					if(!query->operators().contains(id)) { continue; }
-					
-					BasicOperator *op = query->operators()[id];
-					
-					switch(op->type()) {
-						case BOD::GRAPH_PATTERN_SELECTION:
-							(reinterpret_cast<GPS*>(op))->execute(*tuple_store_);
-							break;
-						case BOD::SIMPLE_LOCAL_JOIN:
-							(reinterpret_cast<SLJ*>(op))->execute();
-							break;
-						case BOD::AGGREGATE:
-							(reinterpret_cast<A*>(op))->execute();
-							break;
-						case BOD::COLLECT:
-							(reinterpret_cast<C*>(op))->execute();
-							break;
-						default:
-							DBG("unexpected op type: %d", op->type());
+				while(true) {
+					size_type selections = 0;
+					for(size_type i = 0; i < n; i++) {
+						GPS *gps = next_selection(queries[i], last[i]);
+						if(gps) {
+							last[i] = gps->id();
+							scan_selections_[selections++] = gps;
+						}
 					}
+					if(!selections) { break; }
+					shared_scan(selections);
+				}
+				
+				for(size_type i = 0; i < n; i++) {
+					execute_operators(queries[i]);
 				}
 			}
 			
@@ -275,9 +343,110 @@ namespace wiselib {
 			Translator& translator() { return translator_; }
 			ReverseTranslator& reverse_translator() { return reverse_translator_; }
 			Timer& timer() { return *timer_; }
+			Executor& executor() { return executor_; }
 			
 		private:
 			
+			/**
+			 * Selection of the query with the lowest id above last.
+			 */
+			GPS* next_selection(Query *query, int last) {
+				GPS *r = 0;
+				for(typename Query::Operators::iterator iter = query->operators().begin(); iter != query->operators().end(); ++iter) {
+					BasicOperator *op = iter->second;
+					if(op->type() == BOD::GRAPH_PATTERN_SELECTION && (int)op->id() > last && (!r || op->id() < r->id())) {
+						r = reinterpret_cast<GPS*>(op);
+					}
+				}
+				return r;
+			}
+			
+			void shared_scan(size_type selections) {
+				typedef typename TupleStoreT::TupleContainer Container;
+				typedef typename Container::iterator Citer;
+				
+				::uint8_t translated = 0;
+				for(size_type i = 0; i < selections; i++) {
+					scan_selections_[i]->begin_scan();
+					translated |= scan_selections_[i]->affected_columns();
+				}
+				
+				Container &container = tuple_store_->container();
+				Citer iter = container.begin();
+				while(iter != container.end()) {
+					for(scan_size_ = 0; iter != container.end() && scan_size_ < SCAN_BLOCK; ++iter, ++scan_size_) {
+						for(size_type c = 0; c < TupleStoreT::COLUMNS; c++) {
+							scan_keys_[scan_size_][c] = TupleStoreT::to_key(iter->get(c));
+							if(translated & (1 << c)) {
+								scan_values_[scan_size_][c] = translator_.translate(scan_keys_[scan_size_][c]);
+							}
+						}
+					}
+					
+					executor_.parallel_for(selections,
+							Executor::task_t::template from_method<self_type, &self_type::match_selections>(this),
+							PARALLEL_MIN_SELECTIONS);
+					
+					for(size_type i = 0; i < selections; i++) {
+						for(size_type t = 0; t < scan_size_; t++) {
+							if(scan_matches_[i][t / 32] & ((::uint32_t)1 << (t % 32))) {
+								scan_selections_[i]->push_tuple(scan_keys_[t], scan_values_[t], translated);
+							}
+						}
+					}
+				}
+				
+				for(size_type i = 0; i < selections; i++) {
+					scan_selections_[i]->end_scan();
+				}
+			}
+			
+			/**
+			 * Task of the executor, matches the current block against
+			 * the selections [begin, end).
+			 */
+			void match_selections(size_type begin, size_type end) {
+				for(size_type i = begin; i < end; i++) {
+					GPS &gps = *scan_selections_[i];
+					for(size_type w = 0; w < MATCH_WORDS; w++) {
+						scan_matches_[i][w] = 0;
+					}
+					for(size_type t = 0; t < scan_size_; t++) {
+						if(gps.matches(scan_values_[t])) {
+							scan_matches_[i][t / 32] |= (::uint32_t)1 << (t % 32);
+						}
+					}
+				}
+			}
+			
+			/**
+			 * Runs the operators other than the selections.
+			 */
+			void execute_operators(Query *query) {
+				for(operator_id_t id = 0; id < MAX_OPERATOR_ID; id++) {
+					if(!query->operators().contains(id)) { continue; }
+					
+					BasicOperator *op = query->operators()[id];
+					
+					switch(op->type()) {
+						case BOD::GRAPH_PATTERN_SELECTION:
+							break;
+						case BOD::SIMPLE_LOCAL_JOIN:
+							(reinterpret_cast<SLJ*>(op))->execute();
+							break;
+						case BOD::AGGREGATE:
+							(reinterpret_cast<A*>(op))->execute();
+							break;
+						case BOD::COLLECT:
+							(reinterpret_cast<C*>(op))->execute();
+							break;
+						default:
+							DBG("unexpected op type: %d", op->type());
+					}
+				}
+			}
+			
+			
 			typename TupleStoreT::self_pointer_t tuple_store_;
 			typename Timer::self_pointer_t timer_;
 			row_callback_t row_callback_;
@@ -285,6 +454,13 @@ namespace wiselib {
 			Queries queries_;
 			Translator translator_;
 			ReverseTranslator reverse_translator_;
+			Executor executor_;
+			
+			GPS *scan_selections_[MAX_QUERIES];
+			::uint32_t scan_matches_[MAX_QUERIES][MATCH_WORDS];
+			key_type scan_keys_[SCAN_BLOCK][TupleStoreT::COLUMNS];
+			Value scan_values_[SCAN_BLOCK][TupleStoreT::COLUMNS];
+			size_type scan_size_;
 		
 	}; // QueryProcessor
 }
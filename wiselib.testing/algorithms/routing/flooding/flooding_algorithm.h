@@ -21,6 +21,8 @@
 
 #include "util/base_classes/routing_base.h"
 #include "flooding_message.h"
+#include "flooding_batcher.h"
+#include "sequence_window.h"
 #include <string.h>
 
 namespace wiselib
@@ -28,6 +30,14 @@ namespace wiselib
 
    /** Flooding Algorithm for the Wiselib.
     * 
+    *  Duplicates are detected with one SequenceWindow per origin, so the
+    *  mapped type of \a NodeidIntMap_P must be
+    *  SequenceWindow<OsModel, uint16_t>, e.g.
+    *  StaticArrayRoutingTable<Os, Radio, 64, SequenceWindow<Os> >.
+    *
+    *  When initialized with a timer and a jitter, own messages and
+    *  forwards are coalesced by a FloodingBatcher.
+    *
     *  \ingroup routing_concept
     *  \ingroup radio_concept
     *  \ingroup basic_algorithm_concept
@@ -36,7 +46,8 @@ namespace wiselib
    template<typename OsModel_P,
             typename NodeidIntMap_P,
             typename Radio_P = typename OsModel_P::Radio,
-            typename Debug_P = typename OsModel_P::Debug>
+            typename Debug_P = typename OsModel_P::Debug,
+            typename Timer_P = typename OsModel_P::Timer>
    class FloodingAlgorithm
       : public RoutingBase<OsModel_P, Radio_P>
    {
@@ -44,11 +55,13 @@ namespace wiselib
       typedef OsModel_P OsModel;
       typedef Radio_P Radio;
       typedef Debug_P Debug;
+      typedef Timer_P Timer;
 
       typedef NodeidIntMap_P MapType;
       typedef typename MapType::iterator MapTypeIterator;
+      typedef typename MapType::mapped_type SeqWindow;
 
-      typedef FloodingAlgorithm<OsModel, MapType, Radio, Debug> self_type;
+      typedef FloodingAlgorithm<OsModel, MapType, Radio, Debug, Timer> self_type;
       typedef self_type* self_pointer_t;
 
       typedef typename Radio::node_id_t node_id_t;
@@ -106,9 +119,26 @@ namespace wiselib
       {
          radio_ = &radio;
          debug_ = &debug;
+         batcher_.init( radio );
          return SUCCESS;
       }
 
+      /** Like init( radio, debug ), but coalesces all broadcasts issued
+       *  within \a jitter milliseconds into one frame (0 disables this).
+       */
+      int init( Radio& radio, Timer& timer, Debug& debug, typename Timer::millis_t jitter )
+      {
+         radio_ = &radio;
+         debug_ = &debug;
+         batcher_.init( radio, timer, jitter );
+         return SUCCESS;
+      }
+
+      /** Number of radio transmissions since init( radio, ... ).
+       */
+      uint32_t transmissions()
+      { return batcher_.frames(); }
+
       int init()
       {
          seq_nr_ = FLOODING_INIT_SEQ_NR;
@@ -132,7 +162,8 @@ namespace wiselib
 
       enum MessageIds
       {
-         FLOODING_MESSAGE_ID = 112
+         FLOODING_MESSAGE_ID = 112,
+         FLOODING_BATCH_MESSAGE_ID = 113
       };
 
       enum SequenceNumbers
@@ -143,7 +174,10 @@ namespace wiselib
       int callback_id_;
       uint16_t seq_nr_;
 
+      typedef FloodingBatcher<OsModel, Radio, Timer, FLOODING_BATCH_MESSAGE_ID> Batcher;
+
       MapType seq_map_;
+      Batcher batcher_;
    };
    // -----------------------------------------------------------------------
    // -----------------------------------------------------------------------
@@ -151,8 +185,9 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+            typename Debug_P,
+            typename Timer_P>
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    FloodingAlgorithm()
       : callback_id_ ( 0 ),
          seq_nr_     ( FLOODING_INIT_SEQ_NR )
@@ -161,8 +196,9 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+            typename Debug_P,
+            typename Timer_P>
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    ~FloodingAlgorithm()
    {
 #ifdef ROUTING_FLOODING_DEBUG
@@ -173,9 +209,10 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
+            typename Debug_P,
+            typename Timer_P>
    int
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    enable_radio( void )
    {
 #ifdef ROUTING_FLOODING_DEBUG
@@ -190,9 +227,10 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
+            typename Debug_P,
+            typename Timer_P>
    int
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    disable_radio( void )
    {
 #ifdef ROUTING_FLOODING_DEBUG
@@ -206,9 +244,10 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
+            typename Debug_P,
+            typename Timer_P>
    int
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    send( node_id_t destination, size_t len, block_data_t *data )
    {
 #ifdef ROUTING_FLOODING_DEBUG
@@ -222,7 +261,7 @@ namespace wiselib
       message.set_seq_nr( seq_nr_ );
       message.set_payload( len, data );
 
-      radio().send( radio().BROADCAST_ADDRESS, message.buffer_size(), (block_data_t*)&message );
+      batcher_.send( message.buffer_size(), (block_data_t*)&message );
 
       seq_nr_++;
       return SUCCESS;
@@ -231,9 +270,10 @@ namespace wiselib
    template<typename OsModel_P,
             typename RoutingTable_P,
             typename Radio_P,
-            typename Debug_P>
+            typename Debug_P,
+            typename Timer_P>
    void
-   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P>::
+   FloodingAlgorithm<OsModel_P, RoutingTable_P, Radio_P, Debug_P, Timer_P>::
    receive( node_id_t from, size_t len, block_data_t *data )
    {
 
@@ -246,6 +286,9 @@ namespace wiselib
       }
 
 
+      if ( Batcher::template unpack<self_type, &self_type::receive>( this, from, len, data ) )
+         return;
+
       message_id_t msg_id = read<OsModel, block_data_t, message_id_t>( data );
 
       if ( msg_id == FLOODING_MESSAGE_ID )
@@ -259,35 +302,34 @@ namespace wiselib
             return;
          }
 
-         // Has message already been received? If so, return.
-         // Of course, there is a simplification with the check for seq_nr
-         // just to be greater than the known one---but this can be done for
-         // simplicity reasons (code-space!!)
-         MapTypeIterator it = seq_map_.find( message->node_id() );
-         if ( it == seq_map_.end() ||
-               ( it != seq_map_.end() &&
-                  ( message->seq_nr() > it->second ||
-                  ( message->seq_nr() == FLOODING_INIT_SEQ_NR && it->second >= 2))) )
+         // Has message already been received? If so, return. A node that
+         // restarts begins again with FLOODING_INIT_SEQ_NR, which is then
+         // far behind the window of its old numbers.
+         SeqWindow &window = seq_map_[message->node_id()];
+         if ( message->seq_nr() == FLOODING_INIT_SEQ_NR && !window.empty() &&
+               (uint16_t)( window.highest() - FLOODING_INIT_SEQ_NR ) >= SeqWindow::WINDOW )
+            window.reset();
+
+         if ( window.check_and_set( message->seq_nr() ) )
          {
-            // Update sequence number, and forward the message to neighbors.
-            seq_map_[message->node_id()] = message->seq_nr();
-            radio().send( radio().BROADCAST_ADDRESS, len, data );
+            // Forward the message to neighbors.
+            batcher_.send( len, data );
 
 #ifdef ROUTING_FLOODING_DEBUG
             debug().debug( "FloodingAlgorithm: receive at %d from %d with seqnr %d (here is %d)\n",
-                           radio_->id(), message->node_id(), message->seq_nr(), seq_map_[message->node_id()] );
+                           radio_->id(), message->node_id(), message->seq_nr(), window.highest() );
 #endif
 			
             // Pass message to each registered receiver.
             if ( (message->dest_id() ==  radio().BROADCAST_ADDRESS ) ||  (message->dest_id() ==  radio().id() ) ){
-				notify_receivers( message->node_id(), message->payload_size(), message->payload() );
+				this->notify_receivers( message->node_id(), message->payload_size(), message->payload() );
 			}
          }
          else
          {
 #ifdef ROUTING_FLOODING_DEBUG
-   debug().debug( "FloodingAlgorithm ERROR: sequence number already known at %d (%d <= %d)\n",
-                     radio_->id(), message->seq_nr(), seq_map_[message->node_id()]  );
+   debug().debug( "FloodingAlgorithm ERROR: sequence number already known at %d (%d, highest %d)\n",
+                     radio_->id(), message->seq_nr(), window.highest() );
 #endif
          }
       }
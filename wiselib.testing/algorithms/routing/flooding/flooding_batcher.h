@@ -0,0 +1,203 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __FLOODING_BATCHER_H__
+#define __FLOODING_BATCHER_H__
+
+#include "algorithms/protocols/packing_radio/message_packer.h"
+#include "util/serialization/simple_types.h"
+
+namespace wiselib
+{
+
+   /** Piggybacking stage for flooding protocols.
+    *
+    *  Flooding protocols hand every broadcast (own messages as well as
+    *  forwards) to send(). With a jitter of 0 the message is broadcast
+    *  immediately. Otherwise it is held back for up to \a jitter
+    *  milliseconds, and all messages handed over in that window are
+    *  broadcast as one frame
+    *
+    *    [MESSAGE_ID_P][len_1][msg_1][len_2][msg_2]...
+    *
+    *  so a burst of small flooded payloads costs one transmission per node
+    *  instead of one per payload. A frame that would hold a single message
+    *  is sent as that message. The receiving protocol passes every radio
+    *  message to unpack(), which calls the protocol's receive method once
+    *  per contained message.
+    */
+   template<typename OsModel_P,
+            typename Radio_P,
+            typename Timer_P,
+            int MESSAGE_ID_P>
+   class FloodingBatcher
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Radio_P Radio;
+      typedef Timer_P Timer;
+
+      typedef FloodingBatcher<OsModel, Radio, Timer, MESSAGE_ID_P> self_type;
+
+      typedef typename Radio::node_id_t node_id_t;
+      typedef typename Radio::size_t size_t;
+      typedef typename Radio::block_data_t block_data_t;
+      typedef typename Radio::message_id_t message_id_t;
+      typedef typename Timer::millis_t millis_t;
+
+      typedef MessagePacker<OsModel, uint8_t> Packer;
+      typedef typename Packer::length_t length_t;
+      // --------------------------------------------------------------------
+      enum
+      {
+         SUCCESS = OsModel::SUCCESS,
+         MESSAGE_ID = MESSAGE_ID_P
+      };
+      // --------------------------------------------------------------------
+      FloodingBatcher()
+         : radio_ ( 0 ),
+            timer_ ( 0 ),
+            jitter_ ( 0 ),
+            count_ ( 0 ),
+            timer_pending_ ( false ),
+            frames_ ( 0 )
+      {}
+      // --------------------------------------------------------------------
+      /** Sends every message immediately.
+       */
+      void init( Radio& radio )
+      {
+         radio_ = &radio;
+         timer_ = 0;
+         jitter_ = 0;
+         reset();
+      }
+      // --------------------------------------------------------------------
+      /** Coalesces the messages sent within \a jitter milliseconds, 0
+       *  disables batching.
+       */
+      void init( Radio& radio, Timer& timer, millis_t jitter )
+      {
+         radio_ = &radio;
+         timer_ = &timer;
+         jitter_ = jitter;
+         reset();
+      }
+      // --------------------------------------------------------------------
+      millis_t jitter()
+      { return jitter_; }
+      // --------------------------------------------------------------------
+      /** Number of radio transmissions since init().
+       */
+      uint32_t frames()
+      { return frames_; }
+      // --------------------------------------------------------------------
+      int send( size_t len, block_data_t *data )
+      {
+         if ( !jitter_ || sizeof( message_id_t ) + sizeof( length_t ) + len > Radio::MAX_MESSAGE_LENGTH )
+         {
+            frames_++;
+            return radio_->send( Radio::BROADCAST_ADDRESS, len, data );
+         }
+
+         if ( !packer_.append( len, data ) )
+         {
+            flush();
+            packer_.append( len, data );
+         }
+         count_++;
+
+         if ( !timer_pending_ )
+         {
+            timer_pending_ = true;
+            timer_->template set_timer<self_type, &self_type::timeout>( jitter_, this, 0 );
+         }
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      /** Broadcasts all held back messages now.
+       */
+      void flush()
+      {
+         if ( count_ == 0 )
+            return;
+
+         if ( count_ == 1 )
+            radio_->send( Radio::BROADCAST_ADDRESS, packer_.size() - sizeof( length_t ),
+                          packer_.data() + sizeof( length_t ) );
+         else
+            radio_->send( Radio::BROADCAST_ADDRESS, sizeof( message_id_t ) + packer_.size(), frame_ );
+
+         frames_++;
+         count_ = 0;
+         packer_.clear();
+      }
+      // --------------------------------------------------------------------
+      /** If \a data is a batched frame, calls T::TMethod for each message
+       *  in it and returns true. Returns false for any other message.
+       */
+      template<typename T, void (T::*TMethod)( node_id_t, size_t, block_data_t* )>
+      static bool unpack( T *obj, node_id_t from, size_t len, block_data_t *data )
+      {
+         if ( len < sizeof( message_id_t ) ||
+               read<OsModel, block_data_t, message_id_t>( data ) != MESSAGE_ID )
+            return false;
+
+         size_t pos = sizeof( message_id_t );
+         while ( pos + sizeof( length_t ) <= len )
+         {
+            length_t l = read<OsModel, block_data_t, length_t>( data + pos );
+            pos += sizeof( length_t );
+            if ( pos + l > len )
+               break;
+            (obj->*TMethod)( from, l, data + pos );
+            pos += l;
+         }
+         return true;
+      }
+
+   private:
+      void reset()
+      {
+         message_id_t id = MESSAGE_ID;
+         write<OsModel, block_data_t, message_id_t>( frame_, id );
+         packer_.init( frame_ + sizeof( message_id_t ),
+                       Radio::MAX_MESSAGE_LENGTH - sizeof( message_id_t ) );
+         count_ = 0;
+         frames_ = 0;
+      }
+      // --------------------------------------------------------------------
+      void timeout( void* )
+      {
+         timer_pending_ = false;
+         flush();
+      }
+
+      typename Radio::self_pointer_t radio_;
+      typename Timer::self_pointer_t timer_;
+      millis_t jitter_;
+
+      Packer packer_;
+      block_data_t frame_[Radio::MAX_MESSAGE_LENGTH];
+      uint8_t count_;
+      bool timer_pending_;
+      uint32_t frames_;
+   };
+
+}
+#endif
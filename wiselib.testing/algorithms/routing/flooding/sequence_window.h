@@ -0,0 +1,120 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __FLOODING_SEQUENCE_WINDOW_H__
+#define __FLOODING_SEQUENCE_WINDOW_H__
+
+namespace wiselib
+{
+
+   /** Duplicate detection for the sequence numbers of one origin.
+    *
+    *  Remembers the highest sequence number seen and, as a bitmap, which of
+    *  the WINDOW numbers below it have been seen as well. Checking a number
+    *  is O(1) and, unlike a plain "greater than last" check, accepts
+    *  packets that arrive out of order and keeps working when the counter
+    *  wraps around (numbers are compared in serial number arithmetic).
+    *  Numbers older than the window are reported as duplicates.
+    *
+    *  The window is small and copyable, so it can be used as the mapped
+    *  type of a node id map (e.g. StaticArrayRoutingTable).
+    */
+   template<typename OsModel_P,
+            typename Sequence_P = uint16_t>
+   class SequenceWindow
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef Sequence_P sequence_t;
+      typedef SequenceWindow<OsModel, Sequence_P> self_type;
+      // --------------------------------------------------------------------
+      enum
+      {
+         WINDOW = 32
+      };
+      // --------------------------------------------------------------------
+      SequenceWindow()
+      { reset(); }
+      // --------------------------------------------------------------------
+      void reset()
+      {
+         highest_ = 0;
+         seen_ = 0;
+      }
+      // --------------------------------------------------------------------
+      bool empty()
+      { return seen_ == 0; }
+      // --------------------------------------------------------------------
+      /** Highest (newest) sequence number seen, undefined if empty().
+       */
+      sequence_t highest()
+      { return highest_; }
+      // --------------------------------------------------------------------
+      /** Marks \a seq as seen.
+       *
+       *  \return true if \a seq has not been seen before, false if it is a
+       *    duplicate or too old to tell.
+       */
+      bool check_and_set( sequence_t seq )
+      {
+         if ( empty() )
+         {
+            highest_ = seq;
+            seen_ = 1;
+            return true;
+         }
+
+         sequence_t ahead = (sequence_t)( seq - highest_ );
+         if ( ahead != 0 && ahead <= HALF_RANGE )
+         {
+            seen_ = ( ahead >= WINDOW ) ? 1 : ( ( seen_ << ahead ) | 1 );
+            highest_ = seq;
+            return true;
+         }
+
+         sequence_t behind = (sequence_t)( highest_ - seq );
+         if ( behind >= WINDOW )
+            return false;
+
+         uint32_t bit = (uint32_t)1 << behind;
+         if ( seen_ & bit )
+            return false;
+         seen_ |= bit;
+         return true;
+      }
+      // --------------------------------------------------------------------
+      /** \return true if \a seq is in the window and has been seen.
+       */
+      bool contains( sequence_t seq )
+      {
+         sequence_t behind = (sequence_t)( highest_ - seq );
+         return !empty() && behind < WINDOW && ( seen_ & ( (uint32_t)1 << behind ) );
+      }
+
+   private:
+      enum
+      {
+         HALF_RANGE = (sequence_t)( (sequence_t)(-1) / 2 )
+      };
+
+      sequence_t highest_;
+      uint32_t seen_;
+   };
+
+}
+#endif
@@ -26,6 +26,8 @@
 #include <util/pstl/vector_static.h>
 #include "flooding_nd_neighbor.h"
 #include <util/serialization/serialization.h>
+#include <algorithms/routing/flooding/flooding_batcher.h>
+#include <algorithms/routing/flooding/sequence_window.h>
 
 namespace wiselib {
 	
@@ -37,6 +39,11 @@ namespace wiselib {
 	 * neighborhood component. send() can be executed multiple times and will
 	 * update the tree in the process.
 	 * 
+	 * Duplicates are detected with a SequenceWindow, so messages that
+	 * arrive out of order are still delivered once and the 8 bit sequence
+	 * number may wrap around. When initialized with a timer and a jitter,
+	 * messages are coalesced by a FloodingBatcher.
+	 * 
 	 * @note This will also make the sender receive any sent message.
 	 * 
 	 * @ingroup Better_nhood_concept Radio_concept
@@ -45,7 +52,8 @@ namespace wiselib {
 	 */
 	template<
 		typename OsModel_P,
-		typename Radio_P
+		typename Radio_P,
+		typename Timer_P = typename OsModel_P::Timer
 	>
 	class FloodingNd : public RadioBase<OsModel_P, typename Radio_P::node_id_t, typename Radio_P::size_t, typename Radio_P::block_data_t> {
 		
@@ -54,12 +62,14 @@ namespace wiselib {
 			typedef typename OsModel::block_data_t block_data_t;
 			typedef typename OsModel::size_t size_type;
 			typedef Radio_P Radio;
+			typedef Timer_P Timer;
 			typedef typename Radio::node_id_t node_id_t;
 			typedef typename Radio::size_t size_t;
 			typedef typename Radio::message_id_t message_id_t;
 			typedef FloodingNdNeighbor<Radio> Neighbor;
 			typedef ::uint8_t sequence_number_t;
-			typedef FloodingNd<OsModel_P, Radio_P> self_type;
+			typedef SequenceWindow<OsModel, sequence_number_t> Window;
+			typedef FloodingNd<OsModel_P, Radio_P, Timer_P> self_type;
 			typedef self_type* self_pointer_t;
 			typedef RadioBase<OsModel_P, typename Radio_P::node_id_t, typename Radio_P::size_t, typename Radio_P::block_data_t> base_type;
 			
@@ -106,16 +116,34 @@ namespace wiselib {
 			};
 			
 			enum {
-				MESSAGE_ID_FLOODING = 201
+				MESSAGE_ID_FLOODING = 201,
+				MESSAGE_ID_FLOODING_BATCH = 203
 			};
 			
+			typedef FloodingBatcher<OsModel, Radio, Timer, MESSAGE_ID_FLOODING_BATCH> Batcher;
+			
 			void init(typename Radio::self_pointer_t radio) {
 				radio_ = radio;
 				radio_->template reg_recv_callback<self_type, &self_type::on_receive>(this);
-				sequence_number_ = 0;
+				batcher_.init(*radio_);
+				window_.reset();
 				parent_set_ = false;
 			}
 			
+			/**
+			 * Like init(radio), but coalesces all broadcasts issued within
+			 * jitter milliseconds into one frame (0 disables this).
+			 */
+			void init(typename Radio::self_pointer_t radio, typename Timer::self_pointer_t timer, typename Timer::millis_t jitter) {
+				init(radio);
+				batcher_.init(*radio_, *timer, jitter);
+			}
+			
+			/**
+			 * Number of radio transmissions since init().
+			 */
+			::uint32_t transmissions() { return batcher_.frames(); }
+			
 			void enable_radio() { radio_->enable_radio(); }
 			void disable_radio() { radio_->disable_radio(); }
 			node_id_t id() { return radio_->id(); }
@@ -130,12 +158,13 @@ namespace wiselib {
 				message_id_t m = MESSAGE_ID_FLOODING;
 				
 				wiselib::write<OsModel>(message, m);
-				sequence_number_++;
-				wiselib::write<OsModel>(message + sizeof(message_id_t), sequence_number_);
+				sequence_number_t seq = window_.empty() ? 1 : window_.highest() + 1;
+				window_.check_and_set(seq);
+				wiselib::write<OsModel>(message + sizeof(message_id_t), seq);
 				memcpy(message + sizeof(message_id_t) + sizeof(sequence_number_t), data, size);
 				
 				//on_receive(radio_->id(), size + sizeof(message_id_t) + sizeof(sequence_number_t), message);
-				radio_->send(Radio::BROADCAST_ADDRESS, size + sizeof(message_id_t) + sizeof(sequence_number_t), message);
+				batcher_.send(size + sizeof(message_id_t) + sizeof(sequence_number_t), message);
 				return SUCCESS;
 			}
 			
@@ -176,6 +205,7 @@ namespace wiselib {
 		private:
 			void on_receive(node_id_t from, size_t size, block_data_t* data) {
 				if(from == radio_->id()) { return; }
+				if(Batcher::template unpack<self_type, &self_type::on_receive>(this, from, size, data)) { return; }
 				
 				message_id_t msg_id = wiselib::read<OsModel, block_data_t, message_id_t>(data);
 				
@@ -184,14 +214,15 @@ namespace wiselib {
 				
 				if(msg_id == MESSAGE_ID_FLOODING) {
 					sequence_number_t seq = wiselib::read<OsModel, block_data_t, sequence_number_t>(d_seq);
-					if(seq > sequence_number_) { // || (sequence_number_ == MAX_SEQUENCE_NUMBER && seq != sequence_number_)) {
+					if(window_.check_and_set(seq)) {
 						base_type::notify_receivers(from,
 								size - sizeof(sequence_number_t) - sizeof(message_id_t), d_payload);
-						radio_->send(Radio::BROADCAST_ADDRESS, size, data);
-						sequence_number_ = seq;
-						parent_.set_id(from);
-						parent_.set_state(Neighbor::OUT_EDGE);
-						parent_set_ = true;
+						batcher_.send(size, data);
+						if(window_.highest() == seq) {
+							parent_.set_id(from);
+							parent_.set_state(Neighbor::OUT_EDGE);
+							parent_set_ = true;
+						}
 					}
 				}
 				else {
@@ -201,7 +232,8 @@ namespace wiselib {
 			
 			Neighbor parent_;
 			typename Radio::self_pointer_t radio_;
-			sequence_number_t sequence_number_;
+			Window window_;
+			Batcher batcher_;
 			bool parent_set_;
 		
 	}; // FloodingNd
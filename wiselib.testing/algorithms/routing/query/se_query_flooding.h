@@ -63,7 +63,7 @@ namespace wiselib {
         typedef typename Radio::node_id_t node_id_t;
         typedef typename Radio::message_id_t message_id_t;
 
-        typedef wiselib::StaticArrayRoutingTable<OsModel, Radio, 20 > FloodingStaticMap;
+        typedef wiselib::StaticArrayRoutingTable<OsModel, Radio, 20, wiselib::SequenceWindow<OsModel> > FloodingStaticMap;
         typedef wiselib::FloodingAlgorithm<OsModel, FloodingStaticMap, Radio, Debug> routing_t;
 
         typedef QueryMsg<OsModel, Radio> QueryMsg_t;
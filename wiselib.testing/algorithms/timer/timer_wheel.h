@@ -0,0 +1,303 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <util/delegates/delegate.hpp>
+
+namespace wiselib {
+	
+	/**
+	 * @brief Hierarchical timing wheel on top of any Timer facet.
+	 * 
+	 * Multiplexes up to MAX_TIMERS_P logical timers onto one timer of the
+	 * underlying OS model, which is only kept running while logical timers
+	 * are pending. Time advances in ticks of TICK_MILLIS_P milliseconds;
+	 * a timer fires in the tick its (rounded up) expiry falls into.
+	 * 
+	 * The wheel has LEVELS_P levels of 2^SLOT_BITS_P slots each. Level 0
+	 * holds timers expiring within the next 2^SLOT_BITS_P ticks, each
+	 * higher level covers a 2^SLOT_BITS_P times longer range with the same
+	 * number of slots, and its timers are moved down a level when their
+	 * slot comes up (at most LEVELS_P - 1 times per timer). Timers further
+	 * away than the whole wheel are parked in the last slot reachable and
+	 * moved on from there. Adding, cancelling and rescheduling a timer are
+	 * O(1), as all slots are doubly linked lists in a static entry pool.
+	 * 
+	 * Implements the Timer concept (set_timer()), so it can be passed to
+	 * any algorithm in place of the OS timer. add_timer() additionally
+	 * returns a handle for cancel() and reschedule(); handles of fired or
+	 * cancelled timers become invalid. A handle carries a 32 bit
+	 * generation of its pool entry, so it can only be taken for a timer
+	 * added later after that entry has been reused 2^32 times.
+	 * 
+	 * @tparam Timer_P Underlying timer facet.
+	 * @tparam MAX_TIMERS_P Number of concurrently pending timers (< 65535).
+	 * @tparam TICK_MILLIS_P Resolution in milliseconds.
+	 * @tparam SLOT_BITS_P log2 of the number of slots per level.
+	 * @tparam LEVELS_P Number of levels, SLOT_BITS_P * LEVELS_P < 32.
+	 */
+	template<
+		typename OsModel_P,
+		typename Timer_P = typename OsModel_P::Timer,
+		int MAX_TIMERS_P = 64,
+		int TICK_MILLIS_P = 10,
+		int SLOT_BITS_P = 5,
+		int LEVELS_P = 4
+	>
+	class TimerWheel {
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::size_t size_type;
+			typedef Timer_P Timer;
+			typedef typename Timer::millis_t millis_t;
+			typedef delegate1<void, void*> timer_delegate_t;
+			typedef TimerWheel<OsModel_P, Timer_P, MAX_TIMERS_P, TICK_MILLIS_P, SLOT_BITS_P, LEVELS_P> self_type;
+			typedef self_type* self_pointer_t;
+			
+			/// Handle of a pending timer, NO_TIMER is never a valid handle.
+			typedef ::uint64_t timer_id_t;
+			typedef ::uint32_t tick_t;
+			
+			enum { SUCCESS = OsModel::SUCCESS, ERR_UNSPEC = OsModel::ERR_UNSPEC };
+			
+			enum {
+				MAX_TIMERS = MAX_TIMERS_P,
+				TICK_MILLIS = TICK_MILLIS_P,
+				SLOT_BITS = SLOT_BITS_P,
+				LEVELS = LEVELS_P,
+				SLOTS = 1 << SLOT_BITS_P
+			};
+			
+			enum { NO_TIMER = 0 };
+			
+			TimerWheel() : timer_(0) {
+			}
+			
+			int init(Timer& timer) {
+				timer_ = &timer;
+				now_ = 0;
+				size_ = 0;
+				running_ = false;
+				
+				for(size_type i = 0; i < LEVELS * SLOTS; i++) {
+					slots_[i] = NONE;
+				}
+				for(size_type i = 0; i < MAX_TIMERS; i++) {
+					entries_[i].generation = 1;
+					entries_[i].slot = NONE;
+					entries_[i].next = (i + 1 < MAX_TIMERS) ? i + 1 : NONE;
+				}
+				free_ = 0;
+				return SUCCESS;
+			}
+			
+			/**
+			 * Timer concept.
+			 */
+			template<typename T, void (T::*TMethod)(void*)>
+			int set_timer(millis_t millis, T* obj, void* userdata) {
+				return add_timer<T, TMethod>(millis, obj, userdata) == NO_TIMER ? ERR_UNSPEC : SUCCESS;
+			}
+			
+			/**
+			 * Calls obj->TMethod(userdata) in millis milliseconds.
+			 * 
+			 * @return handle for cancel() and reschedule(), NO_TIMER if
+			 * all MAX_TIMERS timers are pending.
+			 */
+			template<typename T, void (T::*TMethod)(void*)>
+			timer_id_t add_timer(millis_t millis, T* obj, void* userdata) {
+				if(free_ == NONE) { return NO_TIMER; }
+				
+				index_t i = free_;
+				Entry &e = entries_[i];
+				free_ = e.next;
+				
+				e.callback = timer_delegate_t::template from_method<T, TMethod>(obj);
+				e.userdata = userdata;
+				e.expires = now_ + ticks(millis);
+				link(i);
+				size_++;
+				
+				start();
+				return ((timer_id_t)e.generation << 32) | (i + 1);
+			}
+			
+			/**
+			 * Removes the timer without calling it.
+			 */
+			int cancel(timer_id_t id) {
+				index_t i = index(id);
+				if(i == NONE) { return ERR_UNSPEC; }
+				unlink(i);
+				release(i);
+				return SUCCESS;
+			}
+			
+			/**
+			 * Lets the timer fire millis milliseconds from now instead,
+			 * the handle stays valid.
+			 */
+			int reschedule(timer_id_t id, millis_t millis) {
+				index_t i = index(id);
+				if(i == NONE) { return ERR_UNSPEC; }
+				unlink(i);
+				entries_[i].expires = now_ + ticks(millis);
+				link(i);
+				return SUCCESS;
+			}
+			
+			bool pending(timer_id_t id) { return index(id) != NONE; }
+			
+			/**
+			 * Number of pending timers.
+			 */
+			size_type size() { return size_; }
+			
+			/**
+			 * Ticks elapsed while the wheel was running.
+			 */
+			tick_t now() { return now_; }
+			
+		private:
+			typedef ::uint16_t index_t;
+			
+			enum { NONE = (index_t)(-1) };
+			enum { MASK = SLOTS - 1 };
+			
+			struct Entry {
+				timer_delegate_t callback;
+				void *userdata;
+				tick_t expires;
+				index_t next, prev;
+				/// Flat slot index (level * SLOTS + slot), NONE if free.
+				index_t slot;
+				::uint32_t generation;
+			};
+			
+			static tick_t ticks(millis_t millis) {
+				tick_t t = (millis + TICK_MILLIS - 1) / TICK_MILLIS;
+				return t ? t : 1;
+			}
+			
+			index_t index(timer_id_t id) {
+				::uint32_t n = (::uint32_t)id;
+				if(n == 0 || n > (::uint32_t)MAX_TIMERS) { return NONE; }
+				index_t i = n - 1;
+				if(entries_[i].slot == NONE || entries_[i].generation != (::uint32_t)(id >> 32)) {
+					return NONE;
+				}
+				return i;
+			}
+			
+			void link(index_t i) {
+				Entry &e = entries_[i];
+				tick_t delta = e.expires - now_;
+				tick_t t = e.expires;
+				
+				size_type level = 0;
+				while(level + 1 < LEVELS && delta >= ((tick_t)1 << (SLOT_BITS * (level + 1)))) {
+					level++;
+				}
+				if(level + 1 == LEVELS && delta >= ((tick_t)1 << (SLOT_BITS * LEVELS))) {
+					t = now_ + ((tick_t)1 << (SLOT_BITS * LEVELS)) - 1;
+				}
+				
+				index_t s = level * SLOTS + ((t >> (SLOT_BITS * level)) & MASK);
+				e.slot = s;
+				e.prev = NONE;
+				e.next = slots_[s];
+				if(e.next != NONE) { entries_[e.next].prev = i; }
+				slots_[s] = i;
+			}
+			
+			void unlink(index_t i) {
+				Entry &e = entries_[i];
+				if(e.prev != NONE) { entries_[e.prev].next = e.next; }
+				else { slots_[e.slot] = e.next; }
+				if(e.next != NONE) { entries_[e.next].prev = e.prev; }
+			}
+			
+			void release(index_t i) {
+				Entry &e = entries_[i];
+				e.slot = NONE;
+				if(++e.generation == 0) { e.generation = 1; }
+				e.next = free_;
+				free_ = i;
+				size_--;
+			}
+			
+			void start() {
+				if(!running_) {
+					running_ = true;
+					timer_->template set_timer<self_type, &self_type::tick>(TICK_MILLIS, this, 0);
+				}
+			}
+			
+			void tick(void*) {
+				now_++;
+				
+				// When a level wraps around, the next slot of the level
+				// above is due and its timers move down.
+				for(size_type level = 1; level < LEVELS; level++) {
+					if((now_ >> (SLOT_BITS * (level - 1))) & MASK) { break; }
+					cascade(level * SLOTS + ((now_ >> (SLOT_BITS * level)) & MASK));
+				}
+				
+				// Timers added by callbacks expire in a later tick, i.e.
+				// never in the slot processed here.
+				index_t s = now_ & MASK;
+				while(slots_[s] != NONE) {
+					index_t i = slots_[s];
+					unlink(i);
+					timer_delegate_t callback = entries_[i].callback;
+					void *userdata = entries_[i].userdata;
+					release(i);
+					callback(userdata);
+				}
+				
+				running_ = false;
+				if(size_) { start(); }
+			}
+			
+			void cascade(index_t s) {
+				index_t i = slots_[s];
+				slots_[s] = NONE;
+				while(i != NONE) {
+					index_t next = entries_[i].next;
+					link(i);
+					i = next;
+				}
+			}
+			
+			typename Timer::self_pointer_t timer_;
+			Entry entries_[MAX_TIMERS_P];
+			index_t slots_[LEVELS_P << SLOT_BITS_P];
+			index_t free_;
+			size_type size_;
+			tick_t now_;
+			bool running_;
+		
+	}; // TimerWheel
+}
+
+#endif // TIMER_WHEEL_H
+
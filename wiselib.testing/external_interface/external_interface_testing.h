@@ -104,6 +104,17 @@
 #include "external_interface/pc/pc_wiselib_application.h"
 #endif
 
+#ifdef SIM
+#include "external_interface/sim/sim_os.h"
+#include "external_interface/sim/sim_radio.h"
+#include "external_interface/sim/sim_timer.h"
+#include "external_interface/sim/sim_debug.h"
+#include "external_interface/sim/sim_clock.h"
+#include "external_interface/sim/sim_rand.h"
+#include "external_interface/sim/sim_facet_provider.h"
+#include "external_interface/sim/sim_wiselib_application.h"
+#endif
+
 #ifdef TRISOS
 #include "external_interface/trisos/trisos_os.h"
 #include "external_interface/trisos/trisos_radio.h"
@@ -26,12 +26,15 @@
 
 #include <iostream>
 #include <stdio.h>
+#include <string.h>
 #include <signal.h>
 #include <pthread.h>
 
 #include "util/base_classes/extended_radio_base.h"
 #include "util/base_classes/base_extended_data.h"
 #include "util/delegates/delegate.hpp"
+#include "util/pstl/mpsc_packet_queue.h"
+#include "external_interface/pc/pc_main_loop.h"
 #include "external_interface/pc/com_isense_packet.h"
 #include "com_isense_txpower.h"
 
@@ -39,6 +42,14 @@
 
 typedef uint16_t pc_node_id_t;
 
+/*
+ * Number of received packets that can be buffered between the uart read
+ * path and their delivery to the registered receivers (power of two).
+ */
+#ifndef COM_ISENSE_RADIO_RECEIVE_QUEUE_SIZE
+#define COM_ISENSE_RADIO_RECEIVE_QUEUE_SIZE 16
+#endif
+
 namespace wiselib {
 	template<
 		typename OsModel_P,
@@ -78,8 +89,12 @@ namespace wiselib {
 				MAX_MESSAGE_LENGTH = 116
 			};
 
+			typedef MpscPacketQueue<OsModel, node_id_t, ExtendedData,
+				COM_ISENSE_RADIO_RECEIVE_QUEUE_SIZE, MAX_MESSAGE_LENGTH> receive_queue_t;
+
 			ComISenseRadioModel();
 			ComISenseRadioModel(typename OsModel::Os& os);
+			~ComISenseRadioModel();
 
 			void init(ComUart& uart);
 			void init();
@@ -99,14 +114,38 @@ namespace wiselib {
 
 			void uart_receive(typename ComUart::size_t, typename ComUart::block_data_t*);
 
+			/**
+			 * Received packets are queued by the uart read path, which runs
+			 * in the SIGALRM handler, and delivered to the registered
+			 * receivers by this method. init() registers it with
+			 * PCMainLoop, so main() calls it after every signal, outside
+			 * the handler. Applications built with WISELIB_EXIT_MAIN call
+			 * it from their own loop.
+			 *
+			 * \return Number of delivered packets.
+			 */
+			size_t process_received(size_t max = receive_queue_t::SLOTS);
+
+			/// Queue statistics (dropped packets, high water mark)
+			receive_queue_t& receive_queue() { return receive_queue_; }
+
+			/// Number of bytes or frames dropped due to broken framing
+			unsigned long framing_errors() { return framing_errors_; }
+			/// Number of frames of unknown type
+			unsigned long unexpected_packets() { return unexpected_packets_; }
+
 		private:
 			enum { DLE = 0x10, STX = 0x02, ETX = 0x03 };
+			enum { MAX_HEADER_LENGTH = 16, RECEIVE_BUFFER_SIZE = 256 };
 
-			/// Shortcut for sending a single byte over uart
-			void send_uart(uint8_t);
 			int write_packet(packet_t&);
+			block_data_t* escape(block_data_t*, block_data_t*, size_t);
+
+			bool append_received(block_data_t*, size_t);
+			void interpret_uart_packet(block_data_t*, size_t);
 
-			void interpret_uart_packet();
+			void deliver_queued();
+			void deliver(node_id_t, size_t, block_data_t*, const ExtendedData&);
 
 			ComUart *uart_;
 			node_id_t id_;
@@ -116,9 +155,14 @@ namespace wiselib {
 
 			volatile bool dle_;
 			volatile bool in_packet_;
-			vector_static<OsModel, uint8_t, 256> receiving_;
+			block_data_t receiving_[RECEIVE_BUFFER_SIZE];
+			size_t receiving_size_;
+			unsigned long framing_errors_;
+			unsigned long unexpected_packets_;
 			volatile bool busy_waiting_for_power_;
 			TxPower tx_power_;
+
+			receive_queue_t receive_queue_;
 	};
 
 	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
@@ -133,6 +177,12 @@ namespace wiselib {
 		id_valid_ = false;
 	}
 
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	~ComISenseRadioModel() {
+		PCMainLoop::unreg_callback<self_type, &self_type::deliver_queued>( this );
+	}
+
 	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
 	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
 	init(ComUart& uart) {
@@ -149,7 +199,12 @@ namespace wiselib {
 
 		dle_ = false;
 		in_packet_ = false;
-		receiving_.clear();
+		receiving_size_ = 0;
+		framing_errors_ = 0;
+		unexpected_packets_ = 0;
+
+		receive_queue_.clear();
+		PCMainLoop::reg_callback<self_type, &self_type::deliver_queued>( this );
 
 		uart_->template reg_read_callback<
 			ComISenseRadioModel,
@@ -249,15 +304,23 @@ namespace wiselib {
 
 	// private:
 
-	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
-	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
-	send_uart(uint8_t byte) {
-		uart_->write(1, reinterpret_cast<char*>(&byte));
-	}
-
 	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
 	int ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
 	write_packet(packet_t& p) {
+		// Worst case every byte needs to be escaped
+		if( p.header_size() + p.data_size() > MAX_HEADER_LENGTH + MAX_MESSAGE_LENGTH )
+			return OsModel::ERR_UNSPEC;
+
+		block_data_t frame[2 * (MAX_HEADER_LENGTH + MAX_MESSAGE_LENGTH) + 4];
+		block_data_t *out = frame;
+
+		*out++ = DLE;
+		*out++ = STX;
+		out = escape(out, p.header(), p.header_size());
+		out = escape(out, p.data(), p.data_size());
+		*out++ = DLE;
+		*out++ = ETX;
+
 		// Block SIGALRM to avoid interrupting call of timer_handler.
 
 		sigset_t signal_set, old_signal_set;
@@ -267,37 +330,8 @@ namespace wiselib {
 		{
 			perror( "Failed to block SIGALRM" );
 		}
-                
-		send_uart(DLE);
-		send_uart(STX);
-
-		
-//		for(size_t i=0; i<p.header_size(); i++) {
-//			std::cout << "header[" << (int)i << "]=" << (int)p.header()[i] << "\n";
-//		}
-//		for(size_t i=0; i<p.data_size(); i++) {
-//			std::cout << "data[" << (int)i << "]=" << (int)p.data()[i] << "\n";
-//		}
-		
-
-                
-		for(size_t i=0; i<p.header_size(); i++) {
-			//DLE characters must be sent twice.
-			if( (uint8_t)p.header()[i] == DLE )
-				send_uart( DLE );
 
-			send_uart( p.header()[i] );
-		}
-		for(size_t i=0; i<p.data_size(); i++) {
-			//DLE characters must be sent twice.
-			if( (uint8_t)p.data()[i] == DLE )
-				send_uart( DLE );
-
-			send_uart( p.data()[i] );
-		}
-
-		send_uart(DLE);
-		send_uart(ETX);
+		uart_->write(out - frame, reinterpret_cast<typename ComUart::block_data_t*>(frame));
 
 		// Unblock SIGALRM.
 		if( sigismember( &old_signal_set, SIGALRM ) == 0 )
@@ -313,99 +347,138 @@ namespace wiselib {
 		return OsModel::SUCCESS;
 	}
 
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	typename ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::block_data_t* ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	escape(block_data_t* out, block_data_t* data, size_t size) {
+		for(size_t i=0; i<size; i++) {
+			//DLE characters must be sent twice.
+			if( data[i] == DLE )
+				*out++ = DLE;
+			*out++ = data[i];
+		}
+		return out;
+	}
+
+	/*
+	 * Frames are unescaped in place, i.e. the uart's read buffer is
+	 * overwritten. Frames which are completely contained in data are
+	 * interpreted right from there, only frames spanning several reads
+	 * are collected in receiving_.
+	 */
 	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
 	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
 	uart_receive(
 			typename ComUart::size_t size,
 			typename ComUart::block_data_t* data
 	) {
-		//std::cout << "isense uart_receive " << size << " bytes\n";
+		block_data_t *in = reinterpret_cast<block_data_t*>(data);
+		block_data_t *end = in + size;
+
+		// unescaped part of the current frame in this buffer: [frame, out)
+		block_data_t *frame = in, *out = in;
+
+		for( ; in != end; ++in) {
+			block_data_t c = *in;
 
-		for(size_t i = 0; i<size; i++) {
-			/*std::cout << std::hex << (int)data[i] << " ";
-			if( ( data[i] >= 32 ) && ( data[i] < 127 ) )
-				std::cout << "(" << data[i] << ") ";*/
 			if( !dle_ ) {
-				if( data[i] == DLE ) {
+				if( c == DLE ) {
 					dle_ = true;
+				} else if( in_packet_ ) {
+					*out++ = c;
 				} else {
-					if( in_packet_ ) {
-						receiving_.push_back( data[i] );
-					} else {
-						std::cout << "Found data outside of packet-frame." << std::endl;
-					}
+					// data outside of packet frame
+					framing_errors_++;
 				}
-			} else {
-				dle_ = false;
-				if( data[i] == DLE ) {
-					if( in_packet_ ) {
-						receiving_.push_back( DLE );
-					} else {
-						std::cout << "Found data outside of packet-frame." << std::endl;
-					}
-				} else if(data[i] == STX ) {
-					if( !in_packet_ ) {
-						if( receiving_.size() > 0 ) {
-							std::cout << "Threw away " << receiving_.size() << " bytes of data from uart:\n";
-							for( size_t j=0; j< receiving_.size(); j++ )
-								std:: cout << std::hex << (int)receiving_[j] << " ";
-							std::cout << std::endl;
-						}
-					} else {
-						std::cout << "Found DLE STX while in packet." << std::endl;
-					}
-
-					receiving_.clear();
-					in_packet_ = true;
-				} else if( data[i] == ETX ) {
-					if( in_packet_ ) {
-						interpret_uart_packet();
-					} else {
-						std::cout << "Found DLE ETX outside of packet." << std::endl;
-					}
-
-					receiving_.clear();
-					in_packet_ = false;
+				continue;
+			}
+
+			dle_ = false;
+			if( c == DLE ) {
+				if( in_packet_ ) {
+					*out++ = DLE;
 				} else {
-					std::cout << "Found unsupported byte after DLE." << std::endl;
+					framing_errors_++;
+				}
+			} else if( c == STX ) {
+				if( in_packet_ ) {
+					// DLE STX while in packet, throw away what we have
+					framing_errors_++;
 				}
+				receiving_size_ = 0;
+				in_packet_ = true;
+				frame = out = in + 1;
+			} else if( c == ETX ) {
+				if( !in_packet_ ) {
+					framing_errors_++;
+				} else if( receiving_size_ == 0 ) {
+					interpret_uart_packet(frame, out - frame);
+				} else if( append_received(frame, out - frame) ) {
+					interpret_uart_packet(receiving_, receiving_size_);
+				}
+				receiving_size_ = 0;
+				in_packet_ = false;
+			} else {
+				// unsupported byte after DLE
+				framing_errors_++;
 			}
 		}
+
+		// Keep the beginning of a frame that continues in the next read
+		if( in_packet_ ) {
+			append_received(frame, out - frame);
+		}
 	}
 
 	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
-	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
-	interpret_uart_packet() {
-		//std::cout << "interpreting packet of size " << receiving_.size() << "\n";
+	bool ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	append_received(block_data_t* data, size_t size) {
+		if( receiving_size_ + size > sizeof(receiving_) ) {
+			framing_errors_++;
+			receiving_size_ = 0;
+			in_packet_ = false;
+			return false;
+		}
+		memcpy(receiving_ + receiving_size_, data, size);
+		receiving_size_ += size;
+		return true;
+	}
 
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	interpret_uart_packet(block_data_t* packet, size_t size) {
 		node_id_t sender;
 
-		if(receiving_[0] == packet_t::MESSAGE_TYPE_CUSTOM_OUT) {
-			switch(receiving_[1]) {
+		if( size == 0 ) {
+			framing_errors_++;
+			return;
+		}
+
+		if(packet[0] == packet_t::MESSAGE_TYPE_CUSTOM_OUT) {
+			if(size < 2)
+				return;
+			switch(packet[1]) {
 				case packet_t::SUB_RADIO_ADDRESS: {
-					//assert(receiving_.size() == 4);
-					if(receiving_.size() < 5)
+					if(size < 5)
 						return;
-					id_ = receiving_[3] << 8 | receiving_[4];
+					id_ = packet[3] << 8 | packet[4];
 					id_valid_ = true;
 					std::cout << "--- iSense node address: 0x" << std::hex << id_ << std::dec << "\n";
 				} break;
 
 				case packet_t::SUB_RADIO_IN: {
-					//assert(receiving_.size() > 4);
-					if(receiving_.size() <= 17)
+					if(size <= 17)
 						return;
-					uint16_t signal_strength = receiving_[7] << 8 | receiving_[8];
+					uint16_t signal_strength = packet[7] << 8 | packet[8];
 					ExtendedData ex;
 					ex.set_link_metric( 255 - signal_strength );
-					sender = receiving_[3] << 8 | receiving_[4];
-					this->notify_receivers( sender, receiving_.size() - 17, receiving_.data() + 17, ex );
+					sender = packet[3] << 8 | packet[4];
+					receive_queue_.push( sender, size - 17, packet + 17, ex );
 				} break;
 
 				case packet_t::SUB_TX_POWER: {
-					if( receiving_.size() != 3 )
+					if( size != 3 )
 						return;
-					tx_power_ = TxPower::from_dB( -receiving_[2] );
+					tx_power_ = TxPower::from_dB( -packet[2] );
 					busy_waiting_for_power_ = false;
 				} break;
 
@@ -413,16 +486,34 @@ namespace wiselib {
 					break;
 			} // switch
 		} // if CUSTOM_IN1
-		else if( receiving_[0] == packet_t::MESSAGE_TYPE_LOG ) {
-			std::cout << "iSense-node: ";
-			for( size_t i=2; i<receiving_.size(); i++ ) {
-				std::cout << (char)receiving_[i];
+		else if( packet[0] == packet_t::MESSAGE_TYPE_LOG ) {
+			if(size > 2) {
+				std::cout << "iSense-node: ";
+				std::cout.write(reinterpret_cast<char*>(packet + 2), size - 2);
+				std::cout << std::endl;
 			}
-			std::cout << std::endl;
 		} else {
-			std::cout << "unexpected msg type " << (char)receiving_[0] << " (" << (int)receiving_[0] << ")\n";
+			unexpected_packets_++;
 		}
 	} // interpret_uart_packet
+
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	typename ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::size_t ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	process_received(size_t max) {
+		return receive_queue_.template drain<self_type, &self_type::deliver>(this, max);
+	}
+
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	deliver_queued() {
+		process_received();
+	}
+
+	template<typename OsModel_P, typename ComUart_P, typename ExtendedData_P>
+	void ComISenseRadioModel<OsModel_P, ComUart_P, ExtendedData_P>::
+	deliver( node_id_t from, size_t len, block_data_t* data, const ExtendedData& ex ) {
+		this->notify_receivers( from, len, data, ex );
+	}
 }
 
 #endif // COM_RADIO_H
@@ -0,0 +1,498 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+// vim: set noexpandtab ts=4 sw=4:
+
+#ifndef PC_BINARY_LOG_H
+#define PC_BINARY_LOG_H
+
+#include <stdint.h>
+#include <string.h>
+#include <cstdarg>
+#include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+/**
+ * Slots of the ring buffer every logging thread gets on its first record
+ * and bytes per slot; a record that does not fit (long strings, many
+ * arguments) is cut short, a full ring drops records.
+ */
+#ifndef PC_BINARY_LOG_SLOTS
+	#define PC_BINARY_LOG_SLOTS 4096
+#endif
+
+/**
+ * Number of preallocated rings, i.e. of threads that can log during the
+ * lifetime of the process. Records of further threads are dropped.
+ */
+#ifndef PC_BINARY_LOG_THREADS
+	#define PC_BINARY_LOG_THREADS 8
+#endif
+
+#ifndef PC_BINARY_LOG_SLOT_SIZE
+	#define PC_BINARY_LOG_SLOT_SIZE 128
+#endif
+
+namespace wiselib {
+	
+	/**
+	 * Deferred formatting log.
+	 * 
+	 * log() only walks the conversions of the format string and copies the
+	 * pointer to it and the raw arguments (strings by value) into a ring
+	 * buffer of the calling thread, without locks or system calls. The
+	 * printf style formatting and the output happen in drain(), called
+	 * explicitly, periodically by the thread start_drain_thread() creates
+	 * and at exit. Format strings must outlive the drain, which string
+	 * literals do.
+	 * 
+	 * The rings are static and a thread claims its own with an atomic
+	 * increment, a record reserves its slot with compare and swap and
+	 * commits it when complete. So log() is async-signal-safe and may
+	 * interrupt itself, as it does when timer callbacks (run in the
+	 * SIGALRM handler on PC) log. drain() stops at the first reserved but
+	 * uncommitted slot of a ring and continues there the next time; it
+	 * must not be called from a signal handler.
+	 * 
+	 * init() registers the drain at exit. main() of PC applications calls
+	 * it before application_main(), the Debug facet on construction.
+	 */
+	class PCBinaryLogBase {
+		public:
+			static void log(const char* fmt, ...) {
+				va_list args;
+				va_start(args, fmt);
+				vlog(fmt, args);
+				va_end(args);
+			}
+			
+			static void vlog(const char* fmt, va_list args) {
+				Ring *ring = thread_ring();
+				if(!ring) {
+					__sync_fetch_and_add(&unowned_dropped(), 1);
+					return;
+				}
+				
+				uint32_t head;
+				do {
+					head = ring->reserved;
+					if(head - ring->tail >= PC_BINARY_LOG_SLOTS) {
+						__sync_fetch_and_add(&ring->dropped, 1);
+						return;
+					}
+				} while(!__sync_bool_compare_and_swap(&ring->reserved, head, head + 1));
+				
+				Slot &slot = ring->slots[head % PC_BINARY_LOG_SLOTS];
+				slot.fmt = fmt;
+				slot.truncated = 0;
+				uint8_t *p = slot.data;
+				uint8_t *end = slot.data + sizeof(slot.data);
+				
+				Spec spec;
+				const char *f = fmt;
+				va_list ap;
+				va_copy(ap, args);
+				while(next_spec(f, spec)) {
+					for(int i = 0; i < spec.stars; i++) {
+						put_int(p, end, slot, va_arg(ap, int));
+					}
+					switch(spec.kind) {
+						case Spec::SIGNED: put_int(p, end, slot, read_signed(spec, ap)); break;
+						case Spec::UNSIGNED: put_int(p, end, slot, (int64_t)read_unsigned(spec, ap)); break;
+						case Spec::DOUBLE: put_double(p, end, slot, spec.length == 'L' ? (double)va_arg(ap, long double) : va_arg(ap, double)); break;
+						case Spec::POINTER: put_int(p, end, slot, (int64_t)(uintptr_t)va_arg(ap, void*)); break;
+						case Spec::STRING: put_string(p, end, slot, va_arg(ap, const char*)); break;
+						case Spec::IGNORED: (void)va_arg(ap, void*); break;
+						default: break;
+					}
+				}
+				va_end(ap);
+				
+				__sync_synchronize();
+				slot.commit = head + 1;
+			}
+			
+			/**
+			 * Sets up the drain at exit and claims the ring of the calling
+			 * thread. Call it before any signal handler can log.
+			 */
+			static void init() {
+				registry();
+				thread_ring();
+			}
+			
+			/**
+			 * Formats and writes out all records logged so far, one line
+			 * per record, thread by thread. Returns the number of records.
+			 */
+			static size_t drain() {
+				Registry &r = registry();
+				size_t n = 0;
+				pthread_mutex_lock(&r.drain_lock);
+				
+				uint32_t claimed = rings_claimed();
+				if(claimed > PC_BINARY_LOG_THREADS) { claimed = PC_BINARY_LOG_THREADS; }
+				for(uint32_t i = 0; i < claimed; i++) {
+					Ring *ring = &rings()[i];
+					uint32_t t = ring->tail;
+					for( ; ; t++) {
+						Slot &slot = ring->slots[t % PC_BINARY_LOG_SLOTS];
+						if(slot.commit != t + 1) { break; }
+						__sync_synchronize();
+						format(r.out, slot);
+						n++;
+					}
+					__sync_synchronize();
+					ring->tail = t;
+					
+					uint32_t dropped = ring->dropped;
+					if(dropped != ring->dropped_reported) {
+						fprintf(r.out, "[binary log: %u records dropped]\n", dropped - ring->dropped_reported);
+						ring->dropped_reported = dropped;
+					}
+				}
+				uint32_t dropped = unowned_dropped();
+				if(dropped != r.unowned_dropped_reported) {
+					fprintf(r.out, "[binary log: %u records of threads without ring dropped]\n", dropped - r.unowned_dropped_reported);
+					r.unowned_dropped_reported = dropped;
+				}
+				fflush(r.out);
+				pthread_mutex_unlock(&r.drain_lock);
+				return n;
+			}
+			
+			static void set_output(FILE* out) {
+				registry().out = out;
+			}
+			
+			/**
+			 * Drains every period_ms milliseconds until stop_drain_thread().
+			 */
+			static bool start_drain_thread(unsigned period_ms = 100) {
+				Registry &r = registry();
+				if(r.drain_running) { return false; }
+				r.drain_period_ms = period_ms;
+				r.drain_running = true;
+				if(pthread_create(&r.drain_thread, 0, &drain_loop, 0) != 0) {
+					r.drain_running = false;
+					return false;
+				}
+				return true;
+			}
+			
+			static void stop_drain_thread() {
+				Registry &r = registry();
+				if(!r.drain_running) { return; }
+				r.drain_running = false;
+				pthread_join(r.drain_thread, 0);
+				drain();
+			}
+			
+		private:
+			struct Slot {
+				const char *fmt;
+				/// index of the record + 1 once it is complete
+				volatile uint32_t commit;
+				uint8_t truncated;
+				uint8_t data[PC_BINARY_LOG_SLOT_SIZE - sizeof(const char*) - sizeof(uint32_t) - 1];
+			};
+			
+			struct Ring {
+				volatile uint32_t reserved;
+				volatile uint32_t tail;
+				volatile uint32_t dropped;
+				uint32_t dropped_reported;
+				Slot slots[PC_BINARY_LOG_SLOTS];
+			};
+			
+			struct Registry {
+				Registry() : out(stdout), unowned_dropped_reported(0), drain_running(false), drain_period_ms(100) {
+					pthread_mutex_init(&drain_lock, 0);
+					atexit(&drain_at_exit);
+				}
+				
+				pthread_mutex_t drain_lock;
+				FILE *out;
+				uint32_t unowned_dropped_reported;
+				volatile bool drain_running;
+				unsigned drain_period_ms;
+				pthread_t drain_thread;
+			};
+			
+			struct Spec {
+				enum Kind { NONE, SIGNED, UNSIGNED, DOUBLE, POINTER, STRING, IGNORED };
+				
+				const char *begin; ///< the '%'
+				const char *mods_end; ///< end of flags, width and precision
+				int stars;
+				char length; ///< 'H' for hh, 'q' for ll, else the modifier or 0
+				char conversion;
+				Kind kind;
+			};
+			
+			static Registry& registry() {
+				static Registry r;
+				return r;
+			}
+			
+			// Plain zero initialized statics, so the first use from a
+			// signal handler does not run a constructor.
+			
+			static Ring* rings() {
+				static Ring rings_[PC_BINARY_LOG_THREADS];
+				return rings_;
+			}
+			
+			static volatile uint32_t& rings_claimed() {
+				static volatile uint32_t claimed = 0;
+				return claimed;
+			}
+			
+			static volatile uint32_t& unowned_dropped() {
+				static volatile uint32_t dropped = 0;
+				return dropped;
+			}
+			
+			/// 0 if all rings are taken
+			static Ring* thread_ring() {
+				static __thread Ring *ring = 0;
+				static __thread bool claimed = false;
+				if(!claimed) {
+					uint32_t i = __sync_fetch_and_add(&rings_claimed(), 1);
+					ring = i < PC_BINARY_LOG_THREADS ? &rings()[i] : 0;
+					claimed = true;
+				}
+				return ring;
+			}
+			
+			static void drain_at_exit() {
+				if(registry().drain_running) {
+					stop_drain_thread();
+				}
+				else {
+					drain();
+				}
+			}
+			
+			static void* drain_loop(void*) {
+				Registry &r = registry();
+				while(r.drain_running) {
+					drain();
+					usleep(r.drain_period_ms * 1000);
+				}
+				return 0;
+			}
+			
+			/**
+			 * Advances f past the next conversion and describes it in s,
+			 * returns false at the end of the format.
+			 */
+			static bool next_spec(const char*& f, Spec& s) {
+				while(*f) {
+					if(*f != '%') { f++; continue; }
+					if(f[1] == '%') { f += 2; continue; }
+					
+					s.begin = f++;
+					s.stars = 0;
+					while(*f && strchr("-+ #0'", *f)) { f++; }
+					if(*f == '*') { s.stars++; f++; }
+					else { while(*f >= '0' && *f <= '9') { f++; } }
+					if(*f == '.') {
+						f++;
+						if(*f == '*') { s.stars++; f++; }
+						else { while(*f >= '0' && *f <= '9') { f++; } }
+					}
+					s.mods_end = f;
+					s.length = 0;
+					if(*f == 'h' && f[1] == 'h') { s.length = 'H'; f += 2; }
+					else if(*f == 'l' && f[1] == 'l') { s.length = 'q'; f += 2; }
+					else if(*f && strchr("hlLqjzt", *f)) { s.length = *f++; }
+					
+					s.conversion = *f;
+					if(!*f) { s.kind = Spec::NONE; return true; }
+					f++;
+					switch(s.conversion) {
+						case 'd': case 'i': s.kind = Spec::SIGNED; break;
+						case 'o': case 'u': case 'x': case 'X': case 'c': s.kind = Spec::UNSIGNED; break;
+						case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A': s.kind = Spec::DOUBLE; break;
+						case 'p': s.kind = Spec::POINTER; break;
+						case 's': s.kind = Spec::STRING; break;
+						case 'n': s.kind = Spec::IGNORED; break;
+						default: s.kind = Spec::NONE; break;
+					}
+					return true;
+				}
+				return false;
+			}
+			
+			static int64_t read_signed(Spec& s, va_list& args) {
+				switch(s.length) {
+					case 'H': return (signed char)va_arg(args, int);
+					case 'h': return (short)va_arg(args, int);
+					case 'l': return va_arg(args, long);
+					case 'q': case 'L': return va_arg(args, long long);
+					case 'j': return va_arg(args, intmax_t);
+					case 'z': case 't': return va_arg(args, long);
+					default: return va_arg(args, int);
+				}
+			}
+			
+			static uint64_t read_unsigned(Spec& s, va_list& args) {
+				switch(s.length) {
+					case 'H': return (unsigned char)va_arg(args, unsigned);
+					case 'h': return (unsigned short)va_arg(args, unsigned);
+					case 'l': return va_arg(args, unsigned long);
+					case 'q': case 'L': return va_arg(args, unsigned long long);
+					case 'j': return va_arg(args, uintmax_t);
+					case 'z': case 't': return va_arg(args, unsigned long);
+					default: return va_arg(args, unsigned);
+				}
+			}
+			
+			static void put_int(uint8_t*& p, uint8_t* end, Slot& slot, int64_t v) {
+				if(end - p < (long)sizeof(v)) { slot.truncated = 1; p = end; return; }
+				memcpy(p, &v, sizeof(v));
+				p += sizeof(v);
+			}
+			
+			static void put_double(uint8_t*& p, uint8_t* end, Slot& slot, double v) {
+				if(end - p < (long)sizeof(v)) { slot.truncated = 1; p = end; return; }
+				memcpy(p, &v, sizeof(v));
+				p += sizeof(v);
+			}
+			
+			static void put_string(uint8_t*& p, uint8_t* end, Slot& slot, const char* s) {
+				if(p == end) { slot.truncated = 1; return; }
+				if(!s) { s = "(null)"; }
+				size_t len = strlen(s);
+				size_t room = end - p - 1;
+				if(room > 0xff) { room = 0xff; }
+				if(len > room) { len = room; slot.truncated = 1; }
+				*p++ = (uint8_t)len;
+				memcpy(p, s, len);
+				p += len;
+			}
+			
+			static void format(FILE* out, Slot& slot) {
+				const uint8_t *p = slot.data;
+				const uint8_t *end = slot.data + sizeof(slot.data);
+				const char *f = slot.fmt;
+				const char *text = f;
+				bool complete = true;
+				Spec spec;
+				
+				while(complete && next_spec(f, spec)) {
+					print_text(out, text, spec.begin);
+					text = f;
+					if(spec.kind == Spec::NONE || spec.kind == Spec::IGNORED) { continue; }
+					
+					// rebuild the conversion with stars resolved and the
+					// length modifier matching the stored value
+					char conv[64];
+					char *c = conv;
+					bool missing = false;
+					for(const char *s = spec.begin; s < spec.mods_end && c < conv + 40; s++) {
+						if(*s == '*') {
+							int64_t v = 0;
+							if(!get(p, end, &v, sizeof(v))) { missing = true; }
+							c += snprintf(c, 12, "%d", (int)v);
+						}
+						else { *c++ = *s; }
+					}
+					if(spec.conversion != 'c' && (spec.kind == Spec::SIGNED || spec.kind == Spec::UNSIGNED)) { *c++ = 'l'; *c++ = 'l'; }
+					*c++ = spec.conversion;
+					*c = '\0';
+					
+					if(spec.kind == Spec::STRING) {
+						char s[PC_BINARY_LOG_SLOT_SIZE];
+						uint8_t len = 0;
+						if(missing || !get(p, end, &len, 1) || end - p < len) { complete = false; continue; }
+						memcpy(s, p, len);
+						s[len] = '\0';
+						p += len;
+						fprintf(out, conv, s);
+						continue;
+					}
+					
+					int64_t v;
+					if(missing || !get(p, end, &v, sizeof(v))) { complete = false; continue; }
+					if(spec.conversion == 'c') { fprintf(out, conv, (int)v); }
+					else if(spec.kind == Spec::DOUBLE) {
+						double d;
+						memcpy(&d, &v, sizeof(d));
+						fprintf(out, conv, d);
+					}
+					else if(spec.kind == Spec::POINTER) { fprintf(out, conv, (void*)(uintptr_t)v); }
+					else if(spec.kind == Spec::SIGNED) { fprintf(out, conv, (long long)v); }
+					else { fprintf(out, conv, (unsigned long long)v); }
+				}
+				if(complete) { print_text(out, text, text + strlen(text)); }
+				if(slot.truncated || !complete) { fputs(" [truncated]", out); }
+				size_t n = strlen(slot.fmt);
+				if(!complete || !n || slot.fmt[n - 1] != '\n') { fputc('\n', out); }
+			}
+			
+			static bool get(const uint8_t*& p, const uint8_t* end, void* v, size_t size) {
+				if((size_t)(end - p) < size) { return false; }
+				memcpy(v, p, size);
+				p += size;
+				return true;
+			}
+			
+			/// literal text with %% unescaped
+			static void print_text(FILE* out, const char* from, const char* to) {
+				for(const char *s = from; s < to; s++) {
+					fputc(*s, out);
+					if(*s == '%' && s + 1 < to && s[1] == '%') { s++; }
+				}
+			}
+	};
+	
+	/**
+	 * Debug facet on top of PCBinaryLogBase, a drop in replacement for
+	 * PCDebug.
+	 */
+	template<typename OsModel_P>
+	class PCBinaryLog {
+		public:
+			typedef OsModel_P OsModel;
+			
+			typedef PCBinaryLog<OsModel> self_type;
+			typedef self_type* self_pointer_t;
+			
+			PCBinaryLog() {
+				PCBinaryLogBase::init();
+			}
+			
+			void debug(const char* msg, ...) {
+				va_list fmtargs;
+				va_start(fmtargs, msg);
+				PCBinaryLogBase::vlog(msg, fmtargs);
+				va_end(fmtargs);
+			}
+			
+			size_t drain() { return PCBinaryLogBase::drain(); }
+			bool start_drain_thread(unsigned period_ms = 100) { return PCBinaryLogBase::start_drain_thread(period_ms); }
+			void stop_drain_thread() { PCBinaryLogBase::stop_drain_thread(); }
+	};
+}
+
+#endif // PC_BINARY_LOG_H
@@ -0,0 +1,138 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+// vim: set noexpandtab ts=4 sw=4:
+
+#ifndef PC_MAIN_LOOP_H
+#define PC_MAIN_LOOP_H
+
+#include <signal.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "util/delegates/delegate.hpp"
+
+/*
+ * Maximum number of callbacks registered with PCMainLoop at once.
+ */
+#ifndef PC_MAIN_LOOP_CALLBACKS
+#define PC_MAIN_LOOP_CALLBACKS 8
+#endif
+
+namespace wiselib {
+	/**
+	 * Work the PC drivers defer out of signal context.
+	 *
+	 * Timers and the uart polling run in the SIGALRM handler, where only
+	 * async-signal-safe code may run. A driver that gets data there
+	 * queues it and registers a callback here; main() of the PC
+	 * application (pc_wiselib_application.h) calls run() whenever pause()
+	 * returned, i.e. after every handled signal. run() blocks SIGALRM
+	 * while calling back, so the callbacks are not interrupted by timer
+	 * callbacks and vice versa, but may e.g. allocate or print.
+	 *
+	 * Applications built with WISELIB_EXIT_MAIN have no such loop and
+	 * call run() (or the driver's own processing method) themselves.
+	 */
+	class PCMainLoop {
+		public:
+			typedef delegate0<void> callback_t;
+
+			enum { MAX_CALLBACKS = PC_MAIN_LOOP_CALLBACKS };
+
+			/**
+			 * Registering the same method of the same object again has no
+			 * effect.
+			 *
+			 * \return false if MAX_CALLBACKS are registered already
+			 */
+			template<typename T, void (T::*TMethod)()>
+			static bool reg_callback(T* obj) {
+				return reg(callback_t::from_method<T, TMethod>(obj));
+			}
+
+			template<typename T, void (T::*TMethod)()>
+			static void unreg_callback(T* obj) {
+				callback_t c = callback_t::from_method<T, TMethod>(obj);
+				callback_t *cs = callbacks();
+				for(int i = 0; i < MAX_CALLBACKS; i++) {
+					if(same(cs[i], c)) {
+						cs[i] = callback_t();
+					}
+				}
+			}
+
+			/**
+			 * Calls all registered callbacks with SIGALRM blocked.
+			 */
+			static void run() {
+				sigset_t signal_set, old_signal_set;
+				if ( ( sigemptyset( &signal_set ) == -1 ) ||
+						( sigaddset( &signal_set, SIGALRM ) == -1 ) ||
+						pthread_sigmask( SIG_BLOCK, &signal_set, &old_signal_set ) )
+				{
+					perror( "Failed to block SIGALRM" );
+				}
+
+				callback_t *cs = callbacks();
+				for(int i = 0; i < MAX_CALLBACKS; i++) {
+					if(cs[i]) {
+						cs[i]();
+					}
+				}
+
+				if( sigismember( &old_signal_set, SIGALRM ) == 0 )
+				{
+					if ( pthread_sigmask( SIG_UNBLOCK, &signal_set, 0 ) )
+					{
+						perror( "Failed to unblock SIGALRM" );
+					}
+				}
+			}
+
+		private:
+			static callback_t* callbacks() {
+				static callback_t callbacks_[MAX_CALLBACKS];
+				return callbacks_;
+			}
+
+			static bool same(const callback_t& a, const callback_t& b) {
+				return a.object_ptr == b.object_ptr && a.stub_ptr == b.stub_ptr;
+			}
+
+			static bool reg(callback_t c) {
+				callback_t *cs = callbacks();
+				int free_slot = -1;
+				for(int i = 0; i < MAX_CALLBACKS; i++) {
+					if(same(cs[i], c)) {
+						return true;
+					}
+					if(!cs[i] && free_slot < 0) {
+						free_slot = i;
+					}
+				}
+				if(free_slot < 0) {
+					return false;
+				}
+				cs[free_slot] = c;
+				return true;
+			}
+	};
+}
+
+#endif // PC_MAIN_LOOP_H
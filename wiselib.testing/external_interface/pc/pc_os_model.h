@@ -29,9 +29,28 @@
 #define _WHERESTR "...%s:%d: "
 #define _WHEREARG (&__FILE__ [ (strlen(__FILE__) < 30) ? 0 : (strlen(__FILE__) - 30)]), __LINE__
 //#define _WHEREARG __FILE__, __LINE__
-#define DBG3(...) printf(__VA_ARGS__); fflush(stdout);
+
+// Log levels; DBG_LEVEL calls below WISELIB_LOG_LEVEL compile to nothing
+#define WISELIB_LOG_DEBUG 0
+#define WISELIB_LOG_INFO 1
+#define WISELIB_LOG_WARNING 2
+#define WISELIB_LOG_ERROR 3
+#define WISELIB_LOG_NONE 4
+#ifndef WISELIB_LOG_LEVEL
+	#define WISELIB_LOG_LEVEL WISELIB_LOG_DEBUG
+#endif
+
+// With PC_BINARY_LOG the arguments are recorded and formatted later by
+// PCBinaryLogBase::drain(), which is also the Debug facet then
+#if PC_BINARY_LOG
+	#include "pc_binary_log.h"
+	#define DBG3(...) ::wiselib::PCBinaryLogBase::log(__VA_ARGS__)
+#else
+	#define DBG3(...) do { printf(__VA_ARGS__); fflush(stdout); } while(0)
+#endif
 #define DBG2(_fmt, ...) DBG3(_WHERESTR _fmt "%s\n", _WHEREARG, __VA_ARGS__)
-#define DBG(...) DBG2(__VA_ARGS__, "")
+#define DBG_LEVEL(_level, ...) do { if((_level) >= WISELIB_LOG_LEVEL) { DBG2(__VA_ARGS__, ""); } } while(0)
+#define DBG(...) DBG_LEVEL(WISELIB_LOG_DEBUG, __VA_ARGS__)
 
 #include "external_interface/default_return_values.h"
 #include "com_isense_radio.h"
@@ -41,6 +60,7 @@
 #include "pc_timer.h"
 #include "pc_com_uart.h"
 #include "util/serialization/endian.h"
+#include "util/pstl/packet_buffer_pool.h"
 
 #if USE_RAM_BLOCK_MEMORY
 #include "algorithms/block_memory/ram_block_memory.h"
@@ -66,7 +86,11 @@ namespace wiselib {
 			typedef uint8_t block_data_t;
 			
 			typedef PCClockModel<PCOsModel> Clock;
+#if PC_BINARY_LOG
+			typedef PCBinaryLog<PCOsModel> Debug;
+#else
 			typedef PCDebug<PCOsModel> Debug;
+#endif
 			
 			// Radio model can only exist when port for communication with the
 			// isense node is known so it has to be instantiated by the user
@@ -77,6 +101,7 @@ namespace wiselib {
 			typedef PCComUartModel<PCOsModel, true> ISenseUart;
 			typedef PCComUartModel<PCOsModel, false> Uart;
 			typedef ComISenseRadioModel<PCOsModel, ISenseUart> Radio;
+			typedef PacketBufferPool<PCOsModel> PacketPool;
 			
 #if USE_RAM_BLOCK_MEMORY
 			typedef RamBlockMemory<PCOsModel> BlockMemory;
@@ -0,0 +1,195 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+// vim: set noexpandtab ts=4 sw=4:
+
+#ifndef PC_THREAD_POOL_H
+#define PC_THREAD_POOL_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include <util/delegates/delegate.hpp>
+
+/**
+ * Threads of a PCThreadPool, the calling thread of parallel_for()
+ * included.
+ */
+#ifndef PC_THREAD_POOL_THREADS
+	#define PC_THREAD_POOL_THREADS 4
+#endif
+
+namespace wiselib {
+	
+	/**
+	 * Fixed set of worker threads for data parallel loops, an executor
+	 * like InlineExecutor.
+	 * 
+	 * parallel_for(n, task) splits [0, n) into one contiguous range per
+	 * thread, but none shorter than min_range, and returns when
+	 * task(begin, end) is done for all of them. The calling thread works
+	 * on the first range itself. The workers are started by the first
+	 * call that needs them and joined by the destructor; only one thread
+	 * may call parallel_for() at a time.
+	 */
+	template<
+		typename OsModel_P,
+		int THREADS_P = PC_THREAD_POOL_THREADS
+	>
+	class PCThreadPool {
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::size_t size_type;
+			typedef PCThreadPool<OsModel_P, THREADS_P> self_type;
+			typedef self_type* self_pointer_t;
+			
+			/// task(begin, end) processes the indices [begin, end).
+			typedef delegate2<void, size_type, size_type> task_t;
+			
+			enum { THREADS = THREADS_P };
+			
+			PCThreadPool() : started_(false), stopping_(false), generation_(0) {
+				pthread_mutex_init(&lock_, 0);
+				pthread_cond_init(&work_, 0);
+				pthread_cond_init(&done_, 0);
+			}
+			
+			~PCThreadPool() {
+				stop();
+				pthread_cond_destroy(&done_);
+				pthread_cond_destroy(&work_);
+				pthread_mutex_destroy(&lock_);
+			}
+			
+			void parallel_for(size_type n, task_t task, size_type min_range = 1) {
+				size_type ranges = n / (min_range ? min_range : 1);
+				if(ranges > (size_type)THREADS) { ranges = THREADS; }
+				if(ranges <= 1 || !start()) {
+					if(n) { task(0, n); }
+					return;
+				}
+				
+				pthread_mutex_lock(&lock_);
+				task_ = task;
+				n_ = n;
+				ranges_ = ranges;
+				pending_ = ranges - 1;
+				generation_++;
+				pthread_cond_broadcast(&work_);
+				pthread_mutex_unlock(&lock_);
+				
+				run_range(0);
+				
+				pthread_mutex_lock(&lock_);
+				while(pending_) { pthread_cond_wait(&done_, &lock_); }
+				pthread_mutex_unlock(&lock_);
+			}
+			
+			/**
+			 * Joins the workers, the next parallel_for() starts them
+			 * again.
+			 */
+			void stop() {
+				if(!started_) { return; }
+				pthread_mutex_lock(&lock_);
+				stopping_ = true;
+				pthread_cond_broadcast(&work_);
+				pthread_mutex_unlock(&lock_);
+				for(int i = 1; i < THREADS; i++) {
+					pthread_join(workers_[i].thread, 0);
+				}
+				stopping_ = false;
+				started_ = false;
+			}
+			
+		private:
+			struct Worker {
+				self_pointer_t pool;
+				size_type index;
+				uint32_t generation; ///< last one seen
+				pthread_t thread;
+			};
+			
+			bool start() {
+				if(started_) { return true; }
+				for(int i = 1; i < THREADS; i++) {
+					workers_[i].pool = this;
+					workers_[i].index = i;
+					workers_[i].generation = generation_;
+					if(pthread_create(&workers_[i].thread, 0, &worker_loop, &workers_[i]) != 0) {
+						pthread_mutex_lock(&lock_);
+						stopping_ = true;
+						pthread_cond_broadcast(&work_);
+						pthread_mutex_unlock(&lock_);
+						for(int j = 1; j < i; j++) {
+							pthread_join(workers_[j].thread, 0);
+						}
+						stopping_ = false;
+						return false;
+					}
+				}
+				started_ = true;
+				return true;
+			}
+			
+			void run_range(size_type i) {
+				size_type begin = (size_type)((uint64_t)n_ * i / ranges_);
+				size_type end = (size_type)((uint64_t)n_ * (i + 1) / ranges_);
+				if(begin < end) { task_(begin, end); }
+			}
+			
+			static void* worker_loop(void *p) {
+				Worker &w = *reinterpret_cast<Worker*>(p);
+				self_type &pool = *w.pool;
+				
+				pthread_mutex_lock(&pool.lock_);
+				while(true) {
+					while(pool.generation_ == w.generation && !pool.stopping_) {
+						pthread_cond_wait(&pool.work_, &pool.lock_);
+					}
+					if(pool.stopping_) { break; }
+					w.generation = pool.generation_;
+					if(w.index < pool.ranges_) {
+						pthread_mutex_unlock(&pool.lock_);
+						pool.run_range(w.index);
+						pthread_mutex_lock(&pool.lock_);
+						if(--pool.pending_ == 0) {
+							pthread_cond_signal(&pool.done_);
+						}
+					}
+				}
+				pthread_mutex_unlock(&pool.lock_);
+				return 0;
+			}
+			
+			pthread_mutex_t lock_;
+			pthread_cond_t work_;
+			pthread_cond_t done_;
+			bool started_;
+			bool stopping_;
+			uint32_t generation_;
+			task_t task_;
+			size_type n_;
+			size_type ranges_;
+			size_type pending_;
+			Worker workers_[THREADS];
+		
+	}; // PCThreadPool
+}
+
+#endif // PC_THREAD_POOL_H
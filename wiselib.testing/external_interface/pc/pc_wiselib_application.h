@@ -24,6 +24,7 @@
 
 #include "external_interface/wiselib_application.h"
 #include "external_interface/pc/pc_os_model.h"
+#include "external_interface/pc/pc_main_loop.h"
 
 namespace wiselib {
 	template<typename Application_P>
@@ -46,11 +47,15 @@ int main(int argc, const char** argv) {
 	wiselib::PCOsModel app_main_arg;
 	app_main_arg.argc = argc;
 	app_main_arg.argv = argv;
+	#if PC_BINARY_LOG
+	wiselib::PCBinaryLogBase::init();
+	#endif
 	application_main(app_main_arg);
 	
 	#if not WISELIB_EXIT_MAIN
 	while(true) {
 		pause();
+		wiselib::PCMainLoop::run();
 	}
 	#endif
 	
@@ -0,0 +1,67 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __EXTERNAL_INTERFACE_SIM_DEBUG_H__
+#define __EXTERNAL_INTERFACE_SIM_DEBUG_H__
+
+#include "external_interface/sim/sim_world.h"
+#include <cstdarg>
+#include <cstdio>
+
+namespace wiselib
+{
+
+   /** \brief Simulator implementation of \ref debug_concept "Debug Concept".
+    *
+    *  \ingroup debug_concept
+    *
+    *  Every message is written with a single call, so lines of nodes
+    *  executed by different threads do not mix.
+    */
+   template<typename OsModel_P>
+   class SimDebug
+   {
+   public:
+      typedef OsModel_P OsModel;
+
+      typedef SimDebug<OsModel> self_type;
+      typedef self_type* self_pointer_t;
+      // --------------------------------------------------------------------
+      SimDebug( SimOs& os )
+         : os_(os)
+      {}
+      // --------------------------------------------------------------------
+      void debug( const char *msg, ... )
+      {
+         va_list fmtargs;
+         char buffer[1024];
+         va_start( fmtargs, msg );
+         vsnprintf( buffer, sizeof(buffer) - 1, msg, fmtargs );
+         va_end( fmtargs );
+         printf( "%s\n", buffer );
+      }
+
+   private:
+      SimOs& os()
+      { return os_; }
+      // --------------------------------------------------------------------
+      SimOs& os_;
+   };
+}
+
+#endif
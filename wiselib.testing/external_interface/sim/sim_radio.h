@@ -0,0 +1,122 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __EXTERNAL_INTERFACE_SIM_RADIO_H__
+#define __EXTERNAL_INTERFACE_SIM_RADIO_H__
+
+#include "external_interface/sim/sim_world.h"
+#include "util/base_classes/extended_radio_base.h"
+#include "util/base_classes/base_extended_data.h"
+
+namespace wiselib
+{
+
+   /** \brief Simulator implementation of \ref radio_concept "Radio concept".
+    *  \ingroup radio_concept
+    *  \ingroup extended_radio_concept
+    *
+    *  Packets reach the neighbors of the node in the SimWorld topology
+    *  after the configured latency. The link metric handed to extended
+    *  receivers grows with the distance of the sender (0 - 255).
+    *
+    *  @tparam OsModel_P Has to implement @ref os_concept "Os concept".
+    */
+   template<typename OsModel_P>
+   class SimRadioModel
+      : public ExtendedRadioBase<OsModel_P, SimWorld::node_id_t,
+            typename OsModel_P::size_t, typename OsModel_P::block_data_t>
+   {
+   public:
+      typedef OsModel_P OsModel;
+
+      typedef SimRadioModel<OsModel> self_type;
+      typedef self_type* self_pointer_t;
+
+      typedef SimWorld::node_id_t node_id_t;
+      typedef typename OsModel::size_t size_t;
+      typedef typename OsModel::block_data_t block_data_t;
+      typedef uint8_t message_id_t;
+      typedef BaseExtendedData<OsModel> ExtendedData;
+      // --------------------------------------------------------------------
+      enum ErrorCodes
+      {
+         SUCCESS = OsModel::SUCCESS,
+         ERR_UNSPEC = OsModel::ERR_UNSPEC
+      };
+      // --------------------------------------------------------------------
+      enum SpecialNodeIds {
+         BROADCAST_ADDRESS = SimWorld::BROADCAST_ADDRESS, ///< All nodes in communication range
+         NULL_NODE_ID      = SimWorld::NULL_NODE_ID       ///< Unknown/No node id
+      };
+      // --------------------------------------------------------------------
+      enum Restrictions {
+         MAX_MESSAGE_LENGTH = SIM_MAX_MESSAGE_LENGTH ///< Maximal number of bytes in payload
+      };
+      // --------------------------------------------------------------------
+      SimRadioModel( SimOs& os )
+         : os_(os), enabled_( true )
+      {
+         os.node->receivers.push_back( SimWorld::receive_delegate_t::
+            template from_method<self_type, &self_type::receive>( this ) );
+      }
+      // --------------------------------------------------------------------
+      int send( node_id_t id, size_t len, block_data_t *data )
+      {
+         if ( !enabled_ || !os().world->send( *os().node, id, len, data ) )
+            return ERR_UNSPEC;
+
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      int enable_radio()
+      {
+         enabled_ = true;
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      int disable_radio()
+      {
+         enabled_ = false;
+         return SUCCESS;
+      }
+      // --------------------------------------------------------------------
+      node_id_t id()
+      {
+         return os().node->id;
+      }
+
+   private:
+      void receive( uint16_t from, unsigned int len, uint8_t *data, uint16_t link_metric )
+      {
+         if ( !enabled_ )
+            return;
+
+         ExtendedData ex;
+         ex.set_link_metric( link_metric );
+         this->notify_receivers( from, len, data, ex );
+      }
+      // --------------------------------------------------------------------
+      SimOs& os()
+      { return os_; }
+      // --------------------------------------------------------------------
+      SimOs& os_;
+      bool enabled_;
+   };
+}
+
+#endif
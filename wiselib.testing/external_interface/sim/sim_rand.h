@@ -0,0 +1,69 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __EXTERNAL_INTERFACE_SIM_RAND_H__
+#define __EXTERNAL_INTERFACE_SIM_RAND_H__
+
+#include "external_interface/sim/sim_world.h"
+
+namespace wiselib
+{
+   /** \brief Simulator implementation of the Rand facet.
+    *
+    *  Draws from the random number generator of the node, so simulation
+    *  runs are reproducible regardless of the number of threads.
+    */
+   template<typename OsModel_P>
+   class SimRandModel
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef SimRandModel<OsModel> self_type;
+      typedef self_type* self_pointer_t;
+
+      typedef uint32_t value_t;
+      // --------------------------------------------------------------------
+      enum { RANDOM_MAX = 0xffffffffUL };
+      // --------------------------------------------------------------------
+      SimRandModel( SimOs& os )
+         : os_(os)
+      {}
+      // --------------------------------------------------------------------
+      /** Seeding is left to SimWorld::set_seed(), ignored.
+       */
+      void srand( value_t seed )
+      {}
+      // --------------------------------------------------------------------
+      value_t operator()()
+      {
+         return os().world->random( *os().node );
+      }
+      // --------------------------------------------------------------------
+      value_t operator()(value_t max) {
+         return os().world->random( *os().node ) % max;
+      }
+   private:
+      SimOs& os()
+      { return os_; }
+      // --------------------------------------------------------------------
+      SimOs& os_;
+   };
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __EXTERNAL_INTERFACE_SIM_TIMER_H__
+#define __EXTERNAL_INTERFACE_SIM_TIMER_H__
+
+#include "external_interface/sim/sim_world.h"
+
+namespace wiselib
+{
+   /** \brief Simulator implementation of \ref timer_concept "Timer Concept".
+    *
+    *  \ingroup timer_concept
+    *
+    *  Timers fire in virtual time of the SimWorld.
+    */
+   template<typename OsModel_P>
+   class SimTimerModel
+   {
+   public:
+      typedef OsModel_P OsModel;
+
+      typedef SimTimerModel<OsModel> self_type;
+      typedef self_type* self_pointer_t;
+
+      typedef uint32_t millis_t;
+      // --------------------------------------------------------------------
+      enum ErrorCodes
+      {
+         SUCCESS = OsModel::SUCCESS,
+         ERR_UNSPEC = OsModel::ERR_UNSPEC
+      };
+      // --------------------------------------------------------------------
+      SimTimerModel( SimOs& os )
+         : os_(os)
+      {}
+      // --------------------------------------------------------------------
+      template<typename T, void (T::*TMethod)(void*)>
+      int set_timer( millis_t millis, T *obj_pnt, void *userdata )
+      {
+         os().world->set_timer( *os().node, (uint64_t)millis * 1000,
+            SimWorld::timer_delegate_t::template from_method<T, TMethod>( obj_pnt ), userdata );
+         return SUCCESS;
+      }
+
+   private:
+      SimOs& os()
+      { return os_; }
+      // --------------------------------------------------------------------
+      SimOs& os_;
+   };
+}
+
+#endif
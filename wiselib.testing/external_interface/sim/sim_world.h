@@ -0,0 +1,741 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __EXTERNAL_INTERFACE_SIM_WORLD_H__
+#define __EXTERNAL_INTERFACE_SIM_WORLD_H__
+
+#include "util/delegates/delegate.hpp"
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
+
+/*
+ * Largest payload a simulated radio transports.
+ */
+#ifndef SIM_MAX_MESSAGE_LENGTH
+#define SIM_MAX_MESSAGE_LENGTH 116
+#endif
+
+namespace wiselib
+{
+   class SimWorld;
+   struct SimNode;
+   struct SimWorker;
+   // -----------------------------------------------------------------------
+   /** Handed to every node's application_main() and to the facet
+    *  constructors, identifies the node a facet belongs to.
+    */
+   struct SimOs
+   {
+      SimWorld *world;
+      SimNode *node;
+   };
+   // -----------------------------------------------------------------------
+   struct SimPacket
+   {
+      SimPacket *next;
+      volatile int refs;
+      uint16_t from;
+      unsigned int len;
+      uint8_t data[SIM_MAX_MESSAGE_LENGTH];
+   };
+   // -----------------------------------------------------------------------
+   /** A timer expiry (\a packet is 0) or the reception of a packet at
+    *  \a node. Events are ordered by time and then by the node that caused
+    *  them and that node's event counter, which does not depend on the
+    *  number of threads.
+    */
+   struct SimEvent
+   {
+      uint64_t time;
+      uint64_t order;
+      uint32_t node;
+      uint16_t link_metric;
+      SimPacket *packet;
+      delegate1<void, void*> callback;
+      void *userdata;
+   };
+   // -----------------------------------------------------------------------
+   struct SimLink
+   {
+      uint32_t to;
+      uint16_t link_metric;
+      float distance;
+      uint32_t loss_threshold;
+   };
+   // -----------------------------------------------------------------------
+   struct SimNode
+   {
+      typedef delegate4<void, uint16_t, unsigned int, uint8_t*, uint16_t> receive_delegate_t;
+
+      uint32_t index;
+      uint16_t id;
+      double x, y;
+      /// Time of the event currently executed by this node
+      uint64_t now;
+      uint64_t serial;
+      uint64_t rand_state;
+
+      std::vector<SimLink> links;
+      std::vector<receive_delegate_t> receivers;
+
+      SimWorker *worker;
+      SimOs os;
+
+      uint32_t sent, received, lost;
+   };
+   // -----------------------------------------------------------------------
+   /** Per thread state. Events created while executing a time window are
+    *  collected in \a outbox and merged into the global queue afterwards,
+    *  events of the executing node that are still due in the current
+    *  window go to \a local.
+    */
+   struct SimWorker
+   {
+      SimWorld *world;
+      pthread_t thread;
+      SimNode *current;
+      uint64_t window_end;
+      std::vector<SimEvent> local;
+      std::vector<SimEvent> outbox;
+      SimPacket *free_packets;
+      uint64_t events;
+   };
+   // -----------------------------------------------------------------------
+   // -----------------------------------------------------------------------
+   // -----------------------------------------------------------------------
+   /** \brief Discrete event simulation of many wiselib nodes in one process.
+    *
+    *  Generalizes LocalRadio from a single node talking to itself to a
+    *  world of nodes with positions, a connectivity graph, per link latency
+    *  and a loss model. All nodes share a virtual clock in microseconds;
+    *  timers and packet receptions are events in a single queue.
+    *
+    *  Execution proceeds in windows as long as the smallest link latency
+    *  (the lookahead): no event in a window can cause an event at another
+    *  node in the same window, so the nodes of a window are independent
+    *  and are optionally executed by several threads. Events are ordered
+    *  independently of the thread count and every node draws from its own
+    *  random number generator, hence a run is reproducible for a given
+    *  seed no matter how many threads execute it. Only state owned by the
+    *  executing node may be touched from within events.
+    */
+   class SimWorld
+   {
+   public:
+      typedef uint16_t node_id_t;
+      typedef SimNode::receive_delegate_t receive_delegate_t;
+      typedef delegate1<void, void*> timer_delegate_t;
+      // --------------------------------------------------------------------
+      enum SpecialNodeIds
+      {
+         BROADCAST_ADDRESS = 0xffff,
+         NULL_NODE_ID = 0
+      };
+      // --------------------------------------------------------------------
+      enum LossModel
+      {
+         LOSS_NONE,      ///< Every packet reaches all neighbors
+         LOSS_UNIFORM,   ///< Packets are lost with probability loss()
+         LOSS_DISTANCE   ///< Probability grows with the square of the distance, loss() at range()
+      };
+      // --------------------------------------------------------------------
+      SimWorld()
+         : seed_( 1 ), range_( 0.0 ), loss_model_( LOSS_NONE ), loss_( 0.0 ),
+            latency_( 1000 ), jitter_( 0 ), threads_( 1 ), running_( false ),
+            now_( 0 )
+      {
+         workers_.resize( 1 );
+         init_worker( workers_[0] );
+      }
+      // --------------------------------------------------------------------
+      ~SimWorld()
+      {
+         stop_threads();
+         for ( size_t i = 0; i < workers_.size(); ++i )
+            free_packets( workers_[i] );
+      }
+      // --------------------------------------------------------------------
+      /** Creates \a count nodes with ids 1 ... count. Must be called
+       *  before any facet is created.
+       */
+      void set_node_count( size_t count )
+      {
+         nodes_.clear();
+         nodes_.resize( count );
+         for ( size_t i = 0; i < count; ++i )
+         {
+            SimNode &node = nodes_[i];
+            node.index = i;
+            node.id = i + 1;
+            node.x = node.y = 0.0;
+            node.now = 0;
+            node.serial = 0;
+            node.rand_state = mix( seed_ + i + 1 );
+            node.worker = &workers_[0];
+            node.os.world = this;
+            node.os.node = &node;
+            node.sent = node.received = node.lost = 0;
+         }
+      }
+      // --------------------------------------------------------------------
+      size_t node_count()
+      { return nodes_.size(); }
+      // --------------------------------------------------------------------
+      SimNode& node( size_t index )
+      { return nodes_[index]; }
+      // --------------------------------------------------------------------
+      SimOs& os( size_t index )
+      { return nodes_[index].os; }
+      // --------------------------------------------------------------------
+      /** Seed of the placement and of the node random number generators,
+       *  set before set_node_count().
+       */
+      void set_seed( uint64_t seed )
+      { seed_ = seed; }
+      // --------------------------------------------------------------------
+      /** Number of threads executing independent node events.
+       */
+      void set_threads( size_t threads )
+      {
+         stop_threads();
+         threads_ = threads ? threads : 1;
+      }
+      // --------------------------------------------------------------------
+      /** Every packet is delivered after \a latency plus up to \a jitter
+       *  microseconds. \a latency is the lookahead of the parallel
+       *  execution and has to be at least 1.
+       */
+      void set_latency( uint64_t latency, uint64_t jitter = 0 )
+      {
+         latency_ = latency ? latency : 1;
+         jitter_ = jitter;
+      }
+      // --------------------------------------------------------------------
+      void set_loss( LossModel model, double loss = 0.0 )
+      {
+         loss_model_ = model;
+         loss_ = loss;
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+            for ( size_t j = 0; j < nodes_[i].links.size(); ++j )
+               update_loss( nodes_[i].links[j] );
+      }
+      // --------------------------------------------------------------------
+      double range()
+      { return range_; }
+      // --------------------------------------------------------------------
+      double loss()
+      { return loss_; }
+      // --------------------------------------------------------------------
+      /** Scatters the nodes uniformly over the given rectangle.
+       */
+      void place_random( double width, double height )
+      {
+         uint64_t state = mix( seed_ );
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+         {
+            nodes_[i].x = width * random( state ) / 4294967296.0;
+            nodes_[i].y = height * random( state ) / 4294967296.0;
+         }
+      }
+      // --------------------------------------------------------------------
+      /** Places the nodes on a regular grid covering the given rectangle.
+       */
+      void place_grid( double width, double height )
+      {
+         if ( nodes_.empty() )
+            return;
+         size_t cols = (size_t)std::ceil( std::sqrt( nodes_.size() * width / ( height > 0.0 ? height : 1.0 ) ) );
+         if ( cols == 0 )
+            cols = 1;
+         size_t rows = ( nodes_.size() + cols - 1 ) / cols;
+         double dx = cols > 1 ? width / ( cols - 1 ) : 0.0;
+         double dy = rows > 1 ? height / ( rows - 1 ) : 0.0;
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+         {
+            nodes_[i].x = dx * ( i % cols );
+            nodes_[i].y = dy * ( i / cols );
+         }
+      }
+      // --------------------------------------------------------------------
+      /** Connects all pairs of nodes closer than \a range (unit disk
+       *  graph). Candidates are looked up in a grid of range sized cells,
+       *  so this is linear in the number of nodes for a fixed density.
+       *  The link metric grows from 0 to 255 with the distance.
+       */
+      void connect_udg( double range )
+      {
+         range_ = range;
+         clear_links();
+         if ( nodes_.empty() || range <= 0.0 )
+            return;
+
+         double min_x = nodes_[0].x, min_y = nodes_[0].y, max_x = min_x, max_y = min_y;
+         for ( size_t i = 1; i < nodes_.size(); ++i )
+         {
+            min_x = std::min( min_x, nodes_[i].x );
+            min_y = std::min( min_y, nodes_[i].y );
+            max_x = std::max( max_x, nodes_[i].x );
+            max_y = std::max( max_y, nodes_[i].y );
+         }
+         size_t cols = (size_t)( ( max_x - min_x ) / range ) + 1;
+         size_t rows = (size_t)( ( max_y - min_y ) / range ) + 1;
+
+         // bucket the nodes by cell (counting sort)
+         std::vector<uint32_t> start( cols * rows + 1, 0 ), cell( nodes_.size() ), members( nodes_.size() );
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+         {
+            cell[i] = (uint32_t)( (size_t)( ( nodes_[i].y - min_y ) / range ) * cols +
+                                  (size_t)( ( nodes_[i].x - min_x ) / range ) );
+            start[cell[i] + 1]++;
+         }
+         for ( size_t c = 0; c < cols * rows; ++c )
+            start[c + 1] += start[c];
+         std::vector<uint32_t> fill( start.begin(), start.end() - 1 );
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+            members[fill[cell[i]]++] = i;
+
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+         {
+            long cx = cell[i] % cols, cy = cell[i] / cols;
+            for ( long y = cy - 1; y <= cy + 1; ++y )
+               for ( long x = cx - 1; x <= cx + 1; ++x )
+               {
+                  if ( x < 0 || y < 0 || x >= (long)cols || y >= (long)rows )
+                     continue;
+                  size_t c = y * cols + x;
+                  for ( uint32_t k = start[c]; k < start[c + 1]; ++k )
+                  {
+                     uint32_t j = members[k];
+                     if ( j == i )
+                        continue;
+                     double d = distance( nodes_[i], nodes_[j] );
+                     if ( d <= range )
+                        add_directed_link( i, j, (uint16_t)( 255.0 * d / range ), d );
+                  }
+               }
+         }
+      }
+      // --------------------------------------------------------------------
+      /** Adds a link between the nodes with the given indices, e.g. to
+       *  build a topology that does not derive from positions.
+       */
+      void add_link( size_t a, size_t b, uint16_t link_metric = 0, bool bidirectional = true )
+      {
+         double d = distance( nodes_[a], nodes_[b] );
+         add_directed_link( a, b, link_metric, d );
+         if ( bidirectional )
+            add_directed_link( b, a, link_metric, d );
+      }
+      // --------------------------------------------------------------------
+      void clear_links()
+      {
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+            nodes_[i].links.clear();
+      }
+      // --------------------------------------------------------------------
+      /** Runs \a app_main (typically application_main) for the node with
+       *  the given index at the current virtual time.
+       */
+      void boot( size_t index, void (*app_main)( SimOs& ) )
+      {
+         SimWorker &w = workers_[0];
+         SimNode &n = nodes_[index];
+         n.now = now_;
+         n.worker = &w;
+         w.current = &n;
+         w.window_end = now_;
+         app_main( n.os );
+         w.current = 0;
+         merge_outbox( w );
+      }
+      // --------------------------------------------------------------------
+      /** Executes all events up to (and including) time \a until.
+       *  \return Number of executed events.
+       */
+      uint64_t run( uint64_t until )
+      {
+         uint64_t executed = events();
+         if ( threads_ > 1 && workers_.size() < threads_ )
+            start_threads();
+
+         while ( !queue_.empty() && queue_.front().time <= until )
+         {
+            uint64_t window_end = queue_.front().time + latency_;
+            if ( window_end > until + 1 )
+               window_end = until + 1;
+
+            batch_.clear();
+            while ( !queue_.empty() && queue_.front().time < window_end )
+            {
+               std::pop_heap( queue_.begin(), queue_.end(), later );
+               batch_.push_back( queue_.back() );
+               queue_.pop_back();
+            }
+            std::sort( batch_.begin(), batch_.end(), by_node );
+
+            segments_.clear();
+            for ( size_t i = 0; i < batch_.size(); ++i )
+               if ( i == 0 || batch_[i].node != batch_[i - 1].node )
+                  segments_.push_back( i );
+            segments_.push_back( batch_.size() );
+
+            window_end_ = window_end;
+            next_segment_ = 0;
+            if ( threads_ > 1 && segments_.size() > 2 * threads_ )
+            {
+               pthread_barrier_wait( &start_barrier_ );
+               execute_segments( workers_[0] );
+               pthread_barrier_wait( &done_barrier_ );
+            }
+            else
+               execute_segments( workers_[0] );
+
+            for ( size_t i = 0; i < workers_.size(); ++i )
+               merge_outbox( workers_[i] );
+            now_ = window_end - 1;
+         }
+
+         if ( until > now_ )
+            now_ = until;
+         return events() - executed;
+      }
+      // --------------------------------------------------------------------
+      uint64_t now()
+      { return now_; }
+      // --------------------------------------------------------------------
+      /** Number of executed events so far.
+       */
+      uint64_t events()
+      {
+         uint64_t r = 0;
+         for ( size_t i = 0; i < workers_.size(); ++i )
+            r += workers_[i].events;
+         return r;
+      }
+      // --------------------------------------------------------------------
+      bool pending()
+      { return !queue_.empty(); }
+      // --------------------------------------------------------------------
+      // Called by the facets of a node
+      // --------------------------------------------------------------------
+      void set_timer( SimNode &node, uint64_t micros, timer_delegate_t callback, void *userdata )
+      {
+         SimEvent ev;
+         ev.time = node.now + micros;
+         ev.order = next_order( node );
+         ev.node = node.index;
+         ev.link_metric = 0;
+         ev.packet = 0;
+         ev.callback = callback;
+         ev.userdata = userdata;
+         schedule( node, ev );
+      }
+      // --------------------------------------------------------------------
+      /** Transmits a packet to \a to or all neighbors of \a node.
+       *  \return false if the packet is too long.
+       */
+      bool send( SimNode &node, node_id_t to, unsigned int len, uint8_t *data )
+      {
+         if ( len > SIM_MAX_MESSAGE_LENGTH )
+            return false;
+         node.sent++;
+
+         SimPacket *packet = 0;
+         for ( size_t i = 0; i < node.links.size(); ++i )
+         {
+            SimLink &link = node.links[i];
+            if ( to != BROADCAST_ADDRESS && nodes_[link.to].id != to )
+               continue;
+            if ( link.loss_threshold && random( node.rand_state ) < link.loss_threshold )
+            {
+               node.lost++;
+               continue;
+            }
+
+            if ( !packet )
+            {
+               packet = alloc_packet( *node.worker );
+               packet->refs = 0;
+               packet->from = node.id;
+               packet->len = len;
+               memcpy( packet->data, data, len );
+            }
+            packet->refs++;
+
+            SimEvent ev;
+            ev.time = node.now + latency_;
+            if ( jitter_ )
+               ev.time += random( node.rand_state ) % ( jitter_ + 1 );
+            ev.order = next_order( node );
+            ev.node = link.to;
+            ev.link_metric = link.link_metric;
+            ev.packet = packet;
+            ev.userdata = 0;
+            schedule( node, ev );
+         }
+         return true;
+      }
+      // --------------------------------------------------------------------
+      /** Next value of the node's own random number generator.
+       */
+      uint32_t random( SimNode &node )
+      { return random( node.rand_state ); }
+
+   private:
+      static bool later( const SimEvent &a, const SimEvent &b )
+      {
+         return a.time > b.time || ( a.time == b.time && a.order > b.order );
+      }
+      // --------------------------------------------------------------------
+      static bool by_node( const SimEvent &a, const SimEvent &b )
+      {
+         if ( a.node != b.node )
+            return a.node < b.node;
+         return later( b, a );
+      }
+      // --------------------------------------------------------------------
+      static uint64_t next_order( SimNode &node )
+      { return ( (uint64_t)node.index << 40 ) | ( node.serial++ & 0xffffffffffULL ); }
+      // --------------------------------------------------------------------
+      /// splitmix64 finalizer, decorrelates the per node seeds
+      static uint64_t mix( uint64_t x )
+      {
+         x += 0x9e3779b97f4a7c15ULL;
+         x = ( x ^ ( x >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+         x = ( x ^ ( x >> 27 ) ) * 0x94d049bb133111ebULL;
+         return x ^ ( x >> 31 );
+      }
+      // --------------------------------------------------------------------
+      /// xorshift64*
+      static uint32_t random( uint64_t &state )
+      {
+         state ^= state >> 12;
+         state ^= state << 25;
+         state ^= state >> 27;
+         return (uint32_t)( ( state * 2685821657736338717ULL ) >> 32 );
+      }
+      // --------------------------------------------------------------------
+      static double distance( const SimNode &a, const SimNode &b )
+      {
+         double dx = a.x - b.x, dy = a.y - b.y;
+         return std::sqrt( dx * dx + dy * dy );
+      }
+      // --------------------------------------------------------------------
+      void add_directed_link( size_t from, size_t to, uint16_t link_metric, double d )
+      {
+         SimLink link;
+         link.to = to;
+         link.link_metric = link_metric;
+         link.distance = d;
+         update_loss( link );
+         nodes_[from].links.push_back( link );
+      }
+      // --------------------------------------------------------------------
+      void update_loss( SimLink &link )
+      {
+         double p = 0.0;
+         if ( loss_model_ == LOSS_UNIFORM )
+            p = loss_;
+         else if ( loss_model_ == LOSS_DISTANCE && range_ > 0.0 )
+            p = loss_ * ( link.distance / range_ ) * ( link.distance / range_ );
+         p = std::min( std::max( p, 0.0 ), 1.0 );
+         link.loss_threshold = (uint32_t)std::min( p * 4294967296.0, 4294967295.0 );
+      }
+      // --------------------------------------------------------------------
+      void schedule( SimNode &node, SimEvent &ev )
+      {
+         SimWorker &w = *node.worker;
+         if ( ev.node == node.index && ev.time < w.window_end && w.current == &node )
+         {
+            w.local.push_back( ev );
+            std::push_heap( w.local.begin(), w.local.end(), later );
+         }
+         else
+            w.outbox.push_back( ev );
+      }
+      // --------------------------------------------------------------------
+      void merge_outbox( SimWorker &w )
+      {
+         for ( size_t i = 0; i < w.outbox.size(); ++i )
+         {
+            queue_.push_back( w.outbox[i] );
+            std::push_heap( queue_.begin(), queue_.end(), later );
+         }
+         w.outbox.clear();
+      }
+      // --------------------------------------------------------------------
+      void execute_segments( SimWorker &w )
+      {
+         w.window_end = window_end_;
+         for ( ;; )
+         {
+            size_t s = __sync_fetch_and_add( &next_segment_, 1 );
+            if ( s + 1 >= segments_.size() )
+               break;
+
+            SimNode &node = nodes_[batch_[segments_[s]].node];
+            node.worker = &w;
+            w.current = &node;
+            w.local.assign( batch_.begin() + segments_[s], batch_.begin() + segments_[s + 1] );
+            std::make_heap( w.local.begin(), w.local.end(), later );
+
+            while ( !w.local.empty() )
+            {
+               std::pop_heap( w.local.begin(), w.local.end(), later );
+               SimEvent ev = w.local.back();
+               w.local.pop_back();
+               execute( w, node, ev );
+            }
+            w.current = 0;
+         }
+      }
+      // --------------------------------------------------------------------
+      void execute( SimWorker &w, SimNode &node, SimEvent &ev )
+      {
+         node.now = ev.time;
+         w.events++;
+
+         if ( ev.packet )
+         {
+            SimPacket *packet = ev.packet;
+            node.received++;
+            for ( size_t i = 0; i < node.receivers.size(); ++i )
+               node.receivers[i]( packet->from, packet->len, packet->data, ev.link_metric );
+            release_packet( w, packet );
+         }
+         else
+            ev.callback( ev.userdata );
+      }
+      // --------------------------------------------------------------------
+      SimPacket* alloc_packet( SimWorker &w )
+      {
+         SimPacket *p = w.free_packets;
+         if ( p )
+            w.free_packets = p->next;
+         else
+            p = new SimPacket;
+         return p;
+      }
+      // --------------------------------------------------------------------
+      void release_packet( SimWorker &w, SimPacket *p )
+      {
+         if ( __sync_sub_and_fetch( &p->refs, 1 ) == 0 )
+         {
+            p->next = w.free_packets;
+            w.free_packets = p;
+         }
+      }
+      // --------------------------------------------------------------------
+      void free_packets( SimWorker &w )
+      {
+         while ( w.free_packets )
+         {
+            SimPacket *p = w.free_packets;
+            w.free_packets = p->next;
+            delete p;
+         }
+      }
+      // --------------------------------------------------------------------
+      void init_worker( SimWorker &w )
+      {
+         w.world = this;
+         w.current = 0;
+         w.window_end = 0;
+         w.free_packets = 0;
+         w.events = 0;
+      }
+      // --------------------------------------------------------------------
+      static void* worker_main( void *arg )
+      {
+         SimWorker &w = *(SimWorker*)arg;
+         SimWorld &world = *w.world;
+         for ( ;; )
+         {
+            pthread_barrier_wait( &world.start_barrier_ );
+            if ( !world.running_ )
+               break;
+            world.execute_segments( w );
+            pthread_barrier_wait( &world.done_barrier_ );
+         }
+         return 0;
+      }
+      // --------------------------------------------------------------------
+      void start_threads()
+      {
+         // worker addresses are handed to the threads, size them first
+         workers_.resize( threads_ );
+         for ( size_t i = 1; i < threads_; ++i )
+            init_worker( workers_[i] );
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+            nodes_[i].worker = &workers_[0];
+
+         pthread_barrier_init( &start_barrier_, 0, threads_ );
+         pthread_barrier_init( &done_barrier_, 0, threads_ );
+         running_ = true;
+         for ( size_t i = 1; i < threads_; ++i )
+            pthread_create( &workers_[i].thread, 0, worker_main, &workers_[i] );
+      }
+      // --------------------------------------------------------------------
+      void stop_threads()
+      {
+         if ( !running_ )
+            return;
+         running_ = false;
+         pthread_barrier_wait( &start_barrier_ );
+         for ( size_t i = 1; i < workers_.size(); ++i )
+            pthread_join( workers_[i].thread, 0 );
+         pthread_barrier_destroy( &start_barrier_ );
+         pthread_barrier_destroy( &done_barrier_ );
+
+         // keep the statistics of the stopped workers
+         for ( size_t i = 1; i < workers_.size(); ++i )
+         {
+            workers_[0].events += workers_[i].events;
+            free_packets( workers_[i] );
+         }
+         workers_.resize( 1 );
+         for ( size_t i = 0; i < nodes_.size(); ++i )
+            nodes_[i].worker = &workers_[0];
+      }
+      // --------------------------------------------------------------------
+      std::vector<SimNode> nodes_;
+      std::vector<SimWorker> workers_;
+      std::vector<SimEvent> queue_;
+      std::vector<SimEvent> batch_;
+      std::vector<size_t> segments_;
+
+      uint64_t seed_;
+      double range_;
+      LossModel loss_model_;
+      double loss_;
+      uint64_t latency_, jitter_;
+      size_t threads_;
+
+      volatile bool running_;
+      pthread_barrier_t start_barrier_, done_barrier_;
+      volatile size_t next_segment_;
+      uint64_t window_end_;
+      uint64_t now_;
+   };
+}
+
+#endif
@@ -0,0 +1,118 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+/*
+ * Runs application_main() for every node of a simulated world and then
+ * the simulation itself. The world is configured with key=value arguments
+ * in the spirit of shawn.conf:
+ *
+ *   count=100          number of nodes
+ *   width=100          size of the deployment area
+ *   height=100
+ *   placement=random   random | grid
+ *   range=20           communication range (unit disk graph)
+ *   loss_model=none    none | uniform | distance
+ *   loss=0.0           loss probability (at range for loss_model=distance)
+ *   latency=1000       packet latency in microseconds (>= 1)
+ *   jitter=0           additional random latency in microseconds
+ *   seed=1             random seed
+ *   threads=1          threads executing independent node events
+ *   time=60            simulated seconds
+ *
+ * At the end a summary line with event and packet counters and the
+ * execution speed is printed.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#include "external_interface/sim/sim_os.h"
+
+void application_main( wiselib::SimOs& );
+
+namespace
+{
+   const char* arg( int argc, const char **argv, const char *key, const char *def )
+   {
+      size_t len = strlen( key );
+      for ( int i = 1; i < argc; ++i )
+         if ( strncmp( argv[i], key, len ) == 0 && argv[i][len] == '=' )
+            return argv[i] + len + 1;
+      return def;
+   }
+}
+
+int main( int argc, const char **argv )
+{
+   wiselib::SimWorld world;
+
+   size_t count = atoi( arg( argc, argv, "count", "100" ) );
+   double width = atof( arg( argc, argv, "width", "100" ) );
+   double height = atof( arg( argc, argv, "height", "100" ) );
+   double range = atof( arg( argc, argv, "range", "20" ) );
+   double seconds = atof( arg( argc, argv, "time", "60" ) );
+   const char *placement = arg( argc, argv, "placement", "random" );
+   const char *loss_model = arg( argc, argv, "loss_model", "none" );
+   size_t threads = atoi( arg( argc, argv, "threads", "1" ) );
+
+   world.set_seed( strtoull( arg( argc, argv, "seed", "1" ), 0, 10 ) );
+   world.set_node_count( count );
+   world.set_threads( threads );
+   world.set_latency( strtoull( arg( argc, argv, "latency", "1000" ), 0, 10 ),
+                      strtoull( arg( argc, argv, "jitter", "0" ), 0, 10 ) );
+
+   if ( strcmp( placement, "grid" ) == 0 )
+      world.place_grid( width, height );
+   else
+      world.place_random( width, height );
+   world.connect_udg( range );
+
+   double loss = atof( arg( argc, argv, "loss", "0" ) );
+   if ( strcmp( loss_model, "uniform" ) == 0 )
+      world.set_loss( wiselib::SimWorld::LOSS_UNIFORM, loss );
+   else if ( strcmp( loss_model, "distance" ) == 0 )
+      world.set_loss( wiselib::SimWorld::LOSS_DISTANCE, loss );
+
+   for ( size_t i = 0; i < count; ++i )
+      world.boot( i, application_main );
+
+   timeval start, stop;
+   gettimeofday( &start, 0 );
+   world.run( (uint64_t)( seconds * 1000000.0 ) );
+   gettimeofday( &stop, 0 );
+
+   uint64_t sent = 0, received = 0, lost = 0;
+   for ( size_t i = 0; i < count; ++i )
+   {
+      sent += world.node( i ).sent;
+      received += world.node( i ).received;
+      lost += world.node( i ).lost;
+   }
+   double wall = ( stop.tv_sec - start.tv_sec ) + ( stop.tv_usec - start.tv_usec ) / 1.0e6;
+   printf( "sim;nodes;threads;seconds;events;sent;received;lost;wall_ms;events_per_s\n" );
+   printf( "sim;%lu;%lu;%g;%llu;%llu;%llu;%llu;%d;%.0f\n",
+           (unsigned long)count, (unsigned long)threads, seconds,
+           (unsigned long long)world.events(), (unsigned long long)sent,
+           (unsigned long long)received, (unsigned long long)lost,
+           (int)( wall * 1000.0 ), wall > 0.0 ? world.events() / wall : 0.0 );
+
+   return 0;
+}
@@ -37,6 +37,15 @@ namespace wiselib
 		typedef typename Radio::size_t size_t;
 		typedef typename Radio::message_id_t message_id_t;
 		// --------------------------------------------------------------------
+		enum
+		{
+#ifdef MESSAGE_H_FLETCHER_CHECKSUM
+			HEADER_SIZE = sizeof(message_id_t) + sizeof(uint16_t) + sizeof(size_t)
+#else
+			HEADER_SIZE = sizeof(message_id_t) + sizeof(size_t)
+#endif
+		};
+		// --------------------------------------------------------------------
 		inline Message_Type()
 		{
 			set_message_id( 0 );
@@ -96,6 +105,28 @@ namespace wiselib
 			memcpy( buffer + PAYLOAD_POS, _buff, _len );
 		}
 		// --------------------------------------------------------------------
+		/**
+		 * Writes the header of a message around the _len payload bytes at
+		 * _payload into the HEADER_SIZE bytes in front of them, so the
+		 * payload does not have to be copied. Returns the message.
+		 */
+		static inline block_data_t* frame_in_place( message_id_t _id, size_t _len, block_data_t* _payload )
+		{
+			block_data_t* frame = _payload - HEADER_SIZE;
+			size_t MESSAGE_ID_POS = 0;
+			write<OsModel, block_data_t, message_id_t> ( frame + MESSAGE_ID_POS, _id );
+#ifdef MESSAGE_H_FLETCHER_CHECKSUM
+			size_t CSUM_POS = MESSAGE_ID_POS + sizeof(message_id_t);
+			size_t PAYLOAD_SIZE_POS = CSUM_POS + sizeof(uint16_t);
+			uint16_t csum = fletcher16_checksum( _payload, _len );
+			write<OsModel, block_data_t, uint16_t> ( frame + CSUM_POS, csum );
+#else
+			size_t PAYLOAD_SIZE_POS = MESSAGE_ID_POS + sizeof(message_id_t);
+#endif
+			write<OsModel, block_data_t, size_t> ( frame + PAYLOAD_SIZE_POS, _len );
+			return frame;
+		}
+		// --------------------------------------------------------------------
 		inline size_t serial_size()
 		{
 			size_t MESSAGE_ID_POS = 0;
@@ -145,7 +176,7 @@ namespace wiselib
 		}
 		// --------------------------------------------------------------------
 #ifdef MESSAGE_H_FLETCHER_CHECKSUM
-		inline uint16_t fletcher16_checksum( uint8_t const* _data, size_t _bytes )
+		static inline uint16_t fletcher16_checksum( uint8_t const* _data, size_t _bytes )
 		{
 		        uint16_t sum1 = 0xff, sum2 = 0xff;
 		        while ( _bytes )
@@ -5,6 +5,12 @@
 
 namespace wiselib
 {
+	/**
+	 * Header of one fragment on the air. The payload is not part of the
+	 * object: the sender writes the header right in front of the fragment
+	 * bytes of the message being sent, the receiver copies the bytes
+	 * following it into the reassembly slab at offset.
+	 */
 	template<	typename Os_P,
 				typename Radio_P,
 				typename Debug_P>
@@ -20,28 +26,22 @@ namespace wiselib
 		typedef typename Radio::node_id_t node_id_t;
 		typedef Fragment_Type<Os, Radio, Debug> self_t;
 		// --------------------------------------------------------------------
+		enum
+		{
+			HEADER_SIZE = 3 * sizeof(uint16_t) + 2 * sizeof(uint8_t)
+		};
+		// --------------------------------------------------------------------
 		Fragment_Type() :
 			id						( 0 ),
-			orig_id					( 0 ),
 			seq_fragment			( 0 ),
 			total_fragments			( 0 ),
-			payload_size			( 0 )
+			length					( 0 ),
+			offset					( 0 )
 		{};
 		// --------------------------------------------------------------------
 		~Fragment_Type()
 		{};
 		// --------------------------------------------------------------------
-		self_t& operator=( const self_t& _frm )
-		{
-			id = _frm.id;
-			orig_id = _frm.orig_id;
-			seq_fragment = _frm.seq_fragment;
-			payload_size = _frm.payload_size;
-			total_fragments = _frm.total_fragments;
-			memcpy( payload, _frm.payload, payload_size );
-			return *this;
-		}
-		// --------------------------------------------------------------------
 		uint16_t get_id()
 		{
 			return id;
@@ -52,94 +52,89 @@ namespace wiselib
 			id = _id;
 		}
 		// --------------------------------------------------------------------
-		message_id_t get_orig_id()
+		void set_total_fragments( uint8_t _tf )
 		{
-			return orig_id;
-		}
-		// --------------------------------------------------------------------
-		void set_orig_id( message_id_t _o_id )
-		{
-			orig_id = _o_id;
+			total_fragments = _tf;
 		}
 		// --------------------------------------------------------------------
-		void set_payload( size_t _len, block_data_t* _buff )
+		uint8_t get_total_fragments()
 		{
-			payload_size = _len;
-			memcpy( payload, _buff, _len );
+			return total_fragments;
 		}
 		// --------------------------------------------------------------------
-		block_data_t* get_payload()
+		uint8_t get_seq_fragment()
 		{
-			return payload;
+			return seq_fragment;
 		}
 		// --------------------------------------------------------------------
-		size_t get_payload_size()
+		void set_seq_fragment( uint8_t _sf )
 		{
-			return payload_size;
+			seq_fragment = _sf;
 		}
 		// --------------------------------------------------------------------
-		void set_total_fragments( size_t _tf )
+		/**
+		 * Length of the whole fragmented message.
+		 */
+		uint16_t get_length()
 		{
-			total_fragments = _tf;
+			return length;
 		}
 		// --------------------------------------------------------------------
-		size_t get_total_fragments()
+		void set_length( uint16_t _l )
 		{
-			return total_fragments;
+			length = _l;
 		}
 		// --------------------------------------------------------------------
-		size_t get_seq_fragment()
+		/**
+		 * Position of this fragment in the whole message.
+		 */
+		uint16_t get_offset()
 		{
-			return seq_fragment;
+			return offset;
 		}
 		// --------------------------------------------------------------------
-		void set_seq_fragment( size_t _sf )
+		void set_offset( uint16_t _o )
 		{
-			seq_fragment = _sf;
+			offset = _o;
 		}
 		// --------------------------------------------------------------------
 		block_data_t* serialize( block_data_t* _buff, size_t _offset = 0 )
 		{
 			size_t ID_POS = 0;
-			size_t ORIG_ID_POS = ID_POS + sizeof(uint16_t);
-			size_t SEQ_FRAGMENT_POS = ORIG_ID_POS + sizeof(message_id_t);
-			size_t TOTAL_FRAGMENTS_POS = SEQ_FRAGMENT_POS + sizeof(size_t);
-			size_t PAYLOAD_SIZE_POS = TOTAL_FRAGMENTS_POS + sizeof(size_t);
-			size_t PAYLOAD_POS = PAYLOAD_SIZE_POS + sizeof(size_t);
+			size_t SEQ_FRAGMENT_POS = ID_POS + sizeof(uint16_t);
+			size_t TOTAL_FRAGMENTS_POS = SEQ_FRAGMENT_POS + sizeof(uint8_t);
+			size_t LENGTH_POS = TOTAL_FRAGMENTS_POS + sizeof(uint8_t);
+			size_t OFFSET_POS = LENGTH_POS + sizeof(uint16_t);
 			write<Os, block_data_t, uint16_t>( _buff + ID_POS + _offset, id );
-			write<Os, block_data_t, message_id_t> ( _buff + ORIG_ID_POS + _offset, orig_id );
-			write<Os, block_data_t, size_t>( _buff + SEQ_FRAGMENT_POS + _offset, seq_fragment );
-			write<Os, block_data_t, size_t>( _buff + TOTAL_FRAGMENTS_POS + _offset, total_fragments );
-			write<Os, block_data_t, size_t>( _buff + PAYLOAD_SIZE_POS + _offset, payload_size );
-			memcpy( _buff + PAYLOAD_POS + _offset, payload, payload_size );
+			write<Os, block_data_t, uint8_t>( _buff + SEQ_FRAGMENT_POS + _offset, seq_fragment );
+			write<Os, block_data_t, uint8_t>( _buff + TOTAL_FRAGMENTS_POS + _offset, total_fragments );
+			write<Os, block_data_t, uint16_t>( _buff + LENGTH_POS + _offset, length );
+			write<Os, block_data_t, uint16_t>( _buff + OFFSET_POS + _offset, offset );
 			return _buff;
 		}
 		// --------------------------------------------------------------------
 		void de_serialize( block_data_t* _buff, size_t _offset = 0 )
 		{
 			size_t ID_POS = 0;
-			size_t ORIG_ID_POS = ID_POS + sizeof(uint16_t);
-			size_t SEQ_FRAGMENT_POS = ORIG_ID_POS + sizeof(message_id_t);
-			size_t TOTAL_FRAGMENTS_POS = SEQ_FRAGMENT_POS + sizeof(size_t);
-			size_t PAYLOAD_SIZE_POS = TOTAL_FRAGMENTS_POS + sizeof(size_t);
-			size_t PAYLOAD_POS = PAYLOAD_SIZE_POS + sizeof(size_t);
+			size_t SEQ_FRAGMENT_POS = ID_POS + sizeof(uint16_t);
+			size_t TOTAL_FRAGMENTS_POS = SEQ_FRAGMENT_POS + sizeof(uint8_t);
+			size_t LENGTH_POS = TOTAL_FRAGMENTS_POS + sizeof(uint8_t);
+			size_t OFFSET_POS = LENGTH_POS + sizeof(uint16_t);
 			id = read<Os, block_data_t, uint16_t>( _buff + ID_POS + _offset );
-			orig_id = read<Os, block_data_t, message_id_t> ( _buff + ORIG_ID_POS + _offset );
-			seq_fragment = read<Os, block_data_t, size_t>( _buff + SEQ_FRAGMENT_POS + _offset );
-			total_fragments = read<Os, block_data_t, size_t>( _buff + TOTAL_FRAGMENTS_POS + _offset );
-			payload_size = read<Os, block_data_t, size_t>( _buff + PAYLOAD_SIZE_POS + _offset );
-			memcpy( payload, _buff + PAYLOAD_POS + _offset, payload_size );
+			seq_fragment = read<Os, block_data_t, uint8_t>( _buff + SEQ_FRAGMENT_POS + _offset );
+			total_fragments = read<Os, block_data_t, uint8_t>( _buff + TOTAL_FRAGMENTS_POS + _offset );
+			length = read<Os, block_data_t, uint16_t>( _buff + LENGTH_POS + _offset );
+			offset = read<Os, block_data_t, uint16_t>( _buff + OFFSET_POS + _offset );
+		}
+		// --------------------------------------------------------------------
+		static size_t header_size()
+		{
+			return HEADER_SIZE;
 		}
 		// --------------------------------------------------------------------
 		size_t serial_size()
 		{
-			size_t ID_POS = 0;
-			size_t ORIG_ID_POS = ID_POS + sizeof(uint16_t);
-			size_t SEQ_FRAGMENT_POS = ORIG_ID_POS + sizeof(message_id_t);
-			size_t TOTAL_FRAGMENTS_POS = SEQ_FRAGMENT_POS + sizeof(size_t);
-			size_t PAYLOAD_SIZE_POS = TOTAL_FRAGMENTS_POS + sizeof(size_t);
-			size_t PAYLOAD_POS = PAYLOAD_SIZE_POS + sizeof(size_t);
-			return PAYLOAD_POS + payload_size;
+			return header_size();
 		}
 		// --------------------------------------------------------------------
 #ifdef DEBUG_FRAGMENT_H
@@ -148,26 +143,20 @@ namespace wiselib
 			_debug.debug( "-------------------------------------------------------\n");
 			_debug.debug( "Fragment : \n" );
 			_debug.debug( "id (size %i) : %d\n", sizeof(uint16_t), id );
-			_debug.debug( "orig_id (size %i) : %d\n", sizeof(message_id_t), id );
-			_debug.debug( "seq_fragment (size %i) : %d\n", sizeof(size_t), seq_fragment );
-			_debug.debug( "total_fragments (size %i) : %d\n", sizeof(size_t), total_fragments );
-			_debug.debug( "payload_size (size %i) : %d\n", sizeof(size_t), payload_size );
-			_debug.debug( "payload: \n");
-			for ( size_t i = 0; i < payload_size; i++ )
-			{
-				_debug.debug("%d", payload[i] );
-			}
+			_debug.debug( "seq_fragment (size %i) : %d\n", sizeof(uint8_t), seq_fragment );
+			_debug.debug( "total_fragments (size %i) : %d\n", sizeof(uint8_t), total_fragments );
+			_debug.debug( "length (size %i) : %d\n", sizeof(uint16_t), length );
+			_debug.debug( "offset (size %i) : %d\n", sizeof(uint16_t), offset );
 			_debug.debug( "-------------------------------------------------------\n");
 		}
 #endif
 		// --------------------------------------------------------------------
 	private:
 		uint16_t id;
-		message_id_t orig_id;
-		size_t seq_fragment;
-		size_t total_fragments;
-		block_data_t payload[Radio::MAX_MESSAGE_LENGTH];
-		size_t payload_size;
+		uint8_t seq_fragment;
+		uint8_t total_fragments;
+		uint16_t length;
+		uint16_t offset;
     };
 }
 #endif
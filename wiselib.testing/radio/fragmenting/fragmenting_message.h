@@ -7,6 +7,11 @@
 
 namespace wiselib
 {
+	/**
+	 * Reassembly state of one fragmented message, identified by source and
+	 * id. The bytes live in the slab of the FragmentingRadio at the index
+	 * of this entry; received records one bit per fragment.
+	 */
 	template<	typename Os_P,
 				typename Radio_P,
 				typename FragmentingRadio_P,
@@ -27,13 +32,14 @@ namespace wiselib
 		typedef typename FragmentingRadio::size_t size_t;
 		typedef typename Timer::millis_t millis_t;
 		typedef Fragment_Type<Os, Radio, Debug> Fragment;
-		typedef vector_static<Os, Fragment, FR_MAX_FRAGMENTS> Fragment_vector;
-		typedef typename Fragment_vector::iterator Fragment_vector_iterator;
 		typedef FragmentingMessage_Type<Os, Radio, FragmentingRadio, Timer, Debug> self_t;
 		// --------------------------------------------------------------------
 		FragmentingMessage_Type() :
 			id				( 0 ),
-			orig_id			( 0 ),
+			source			( 0 ),
+			length			( 0 ),
+			total_fragments	( 0 ),
+			received		( 0 ),
 			timestamp		( 0 ),
 			active			( 0 )
 		{};
@@ -41,34 +47,38 @@ namespace wiselib
 		~FragmentingMessage_Type()
 		{};
 		// --------------------------------------------------------------------
-		self_t& operator=( const self_t& _fm )
-		{
-			id = _fm.id;
-			orig_id = _fm.orig_id;
-			timestamp = _fm.timestamp;
-			active = _fm.active;
-			fragmenting_message = _fm.fragmenting_message;
-			return *this;
+		/**
+		 * Starts reassembly of the message the fragment _f belongs to.
+		 */
+		void init( node_id_t _source, Fragment& _f, uint32_t _timestamp )
+		{
+			id = _f.get_id();
+			source = _source;
+			length = _f.get_length();
+			total_fragments = _f.get_total_fragments();
+			received = 0;
+			timestamp = _timestamp;
+			active = 1;
 		}
 		// --------------------------------------------------------------------
-		uint16_t get_id()
+		uint8_t matches( node_id_t _source, uint16_t _id )
 		{
-			return id;
+			return active && ( id == _id ) && ( source == _source );
 		}
 		// --------------------------------------------------------------------
-		void set_id( uint16_t _id )
+		uint16_t get_id()
 		{
-			id = _id;
+			return id;
 		}
 		// --------------------------------------------------------------------
-		message_id_t get_orig_id()
+		node_id_t get_source()
 		{
-			return orig_id;
+			return source;
 		}
 		// --------------------------------------------------------------------
-		void set_orig_id( message_id_t o_id )
+		uint16_t get_length()
 		{
-			orig_id = o_id;
+			return length;
 		}
 		// --------------------------------------------------------------------
 		uint32_t get_timestamp()
@@ -96,101 +106,23 @@ namespace wiselib
 			active = 0;
 		}
 		// --------------------------------------------------------------------
-		Fragment_vector* get_fragmenting_message_ref()
-		{
-			return &fragmenting_message;
-		}
-		// --------------------------------------------------------------------
-		uint8_t check_completeness()
+		/**
+		 * Marks fragment _seq as received, returns 0 if it already was.
+		 */
+		uint8_t insert_unique( uint8_t _seq )
 		{
-			if ( fragmenting_message.size() != 0 )
+			uint32_t bit = (uint32_t)1 << _seq;
+			if ( received & bit )
 			{
-				if ( fragmenting_message.size() == fragmenting_message.at( 0 ).get_total_fragments() )
-				{
-					return 1;
-				}
-				else
-				{
-					return 2;
-				}
+				return 0;
 			}
-			return 0;
+			received |= bit;
+			return 1;
 		}
 		// --------------------------------------------------------------------
-		void insert_unique( Fragment _f )
-		{
-			if ( check_completeness() == 0 )
-			{
-				fragmenting_message.push_back( _f );
-			}
-			else if ( check_completeness() == 2 )
-			{
-				uint8_t flag = 0;
-				for ( Fragment_vector_iterator it = fragmenting_message.begin(); it != fragmenting_message.end(); ++it )
-				{
-					if ( _f.get_seq_fragment() == it->get_seq_fragment() )
-					{
-						flag = 1;
-					}
-				}
-				if ( flag == 0 )
-				{
-					fragmenting_message.push_back( _f );
-				}
-			}
-		}
-		// --------------------------------------------------------------------
-		void vectorize( block_data_t* _buff, size_t _len, size_t_normal _mr_len, size_t _offset = 0 )
-		{
-			size_t number_of_fragments = _len / _mr_len;
-			size_t_normal last_fragment_bytes = _len % _mr_len;
-			if ( last_fragment_bytes != 0 )
-			{
-				number_of_fragments = number_of_fragments + 1;
-			}
-
-			size_t i;
-			for ( i = 0; i < number_of_fragments -1; i++ )
-			{
-				Fragment f;
-				f.set_id( id );
-				f.set_orig_id( orig_id );
-				f.set_seq_fragment( i );
-				f.set_total_fragments( number_of_fragments );
-				f.set_payload( _mr_len, _buff + _offset + ( i *_mr_len ) );
-				fragmenting_message.push_back( f );
-			}
-			if ( last_fragment_bytes != 0 )
-			{
-				Fragment f;
-				f.set_id( id );
-				f.set_orig_id( orig_id );
-				f.set_seq_fragment( i );
-				f.set_total_fragments( number_of_fragments );
-				f.set_payload( last_fragment_bytes, _buff + _offset + ( i * _mr_len ) );
-				fragmenting_message.push_back( f );
-			}
-		}
-		// --------------------------------------------------------------------
-		block_data_t* de_vectorize( block_data_t* _buff, size_t _offset = 0 )
-		{
-			size_t i = 0;
-			for ( Fragment_vector_iterator it = fragmenting_message.begin(); it != fragmenting_message.end(); ++it )
-			{
-				memcpy( _buff + _offset + i, it->get_payload(), it->get_payload_size() );
-				i = it->get_payload_size() + i;
-			}
-			return _buff;
-		}
-		// --------------------------------------------------------------------
-		size_t serial_size()
+		uint8_t check_completeness()
 		{
-			size_t i = 0;
-			for ( Fragment_vector_iterator it = fragmenting_message.begin(); it != fragmenting_message.end(); ++it )
-			{
-				i = it->get_payload_size() + i;
-			}
-			return i;
+			return received == ( ( (uint32_t)2 << ( total_fragments - 1 ) ) - 1 );
 		}
 		// --------------------------------------------------------------------
 #ifdef DEBUG_FRAGMENTING_MESSAGE_H
@@ -199,22 +131,22 @@ namespace wiselib
 			_debug.debug( "-------------------------------------------------------\n");
 			_debug.debug( "FragmentingMessage : \n" );
 			_debug.debug( "id (size %i) : %d\n", sizeof(uint16_t), id );
-			_debug.debug( "orig_id (size %i) : %d\n", sizeof(message_id_t), orig_id );
+			_debug.debug( "source (size %i) : %x\n", sizeof(node_id_t), source );
+			_debug.debug( "length (size %i) : %d\n", sizeof(uint16_t), length );
+			_debug.debug( "received (size %i) : %x of %d\n", sizeof(uint32_t), received, total_fragments );
 			_debug.debug( "timestamp (size %i) : %d\n", sizeof(uint32_t), timestamp );
-			for ( Fragment_vector_iterator i = fragmenting_message.begin(); i != fragmenting_message.end(); ++i )
-			{
-				i->print( _debug, _radio.radio() );
-			}
 			_debug.debug( "-------------------------------------------------------\n");
 		}
 #endif
 		// --------------------------------------------------------------------
 	private:
 		uint16_t id;
-		message_id_t orig_id;
+		node_id_t source;
+		uint16_t length;
+		uint8_t total_fragments;
+		uint32_t received;
 		uint32_t timestamp;
 		uint8_t active;
-		Fragment_vector fragmenting_message;
     };
 }
 #endif
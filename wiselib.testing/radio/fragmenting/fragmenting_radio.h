@@ -4,6 +4,7 @@
 #include "util/pstl/vector_static.h"
 #include "util/delegates/delegate.hpp"
 #include "../../internal_interface/message/message.h"
+#include "radio/stack/radio_stack.h"
 #include "fragment.h"
 #include "fragmenting_message.h"
 #include "fragmenting_radio_source_config.h"
@@ -42,14 +43,32 @@ namespace wiselib
 		typedef vector_static<Os, event_notifier_delegate_t, FR_MAX_REGISTERED_PROTOCOLS> RegisteredCallbacks_vector;
 		typedef typename RegisteredCallbacks_vector::iterator RegisteredCallbacks_vector_iterator;
 		typedef FragmentingMessage_Type<Os, Radio, FragmentingRadio, Timer, Debug> FragmentingMessage;
-		typedef vector_static<Os, FragmentingMessage, FR_MAX_FRAGMENED_MESSAGES_BUFFERED> FragmentingMessage_vector;
-		typedef typename FragmentingMessage_vector::iterator FragmentingMessage_vector_iterator;
 		typedef typename FragmentingMessage::Fragment Fragment;
-		typedef typename FragmentingMessage::Fragment_vector Fragment_vector;
-		typedef typename FragmentingMessage::Fragment_vector_iterator Fragment_vector_iterator;
 		typedef FragmentingRadio_Type<Os, Radio, Clock, Timer, Rand, Debug> self_t;
 		typedef Message_Type<Os, FragmentingRadio, Debug> Message;
 		typedef Message_Type<Os, Radio, Debug> Message_normal;
+		typedef RadioStackTraits<Radio> LowerStack;
+		typedef self_t radio_stack_layer_t;
+		// --------------------------------------------------------------------
+		enum
+		{
+			FRAME_HEADER_SIZE = Message_normal::HEADER_SIZE + Fragment::HEADER_SIZE,
+			HEADROOM = LowerStack::HEADROOM + FRAME_HEADER_SIZE
+		};
+		enum Restrictions
+		{
+			MAX_MESSAGE_LENGTH = 1024
+		};
+		// --------------------------------------------------------------------
+		enum
+		{
+			/// Longest message FR_MAX_FRAGMENTS fragments can carry
+			MAX_FRAGMENTED_LENGTH = ( Radio::MAX_MESSAGE_LENGTH > FRAME_HEADER_SIZE ) ?
+				FR_MAX_FRAGMENTS * ( Radio::MAX_MESSAGE_LENGTH - FRAME_HEADER_SIZE ) : 0,
+			/// Bytes of each of the FR_MAX_FRAGMENED_MESSAGES_BUFFERED reassembly buffers
+			REASSEMBLY_BUFFER_SIZE = FR_REASSEMBLY_BUFFER_SIZE ? FR_REASSEMBLY_BUFFER_SIZE :
+				( MAX_FRAGMENTED_LENGTH < MAX_MESSAGE_LENGTH ? MAX_FRAGMENTED_LENGTH : MAX_MESSAGE_LENGTH )
+		};
 		// --------------------------------------------------------------------
 		FragmentingRadio_Type() :
 			status							( FR_WAITING_STATUS ),
@@ -81,172 +100,102 @@ namespace wiselib
 			radio().disable_radio();
 		};
 		// --------------------------------------------------------------------
-		void send( node_id_t _dest, size_t _len, block_data_t* _data )
+		/**
+		 * Messages longer than the radio payload are sent as fragments that
+		 * cover the serialized message _data as it is. Each frame, the
+		 * radio message and fragment headers followed by a slice of _data,
+		 * is built in a frame buffer with the headroom of the radio below;
+		 * _data is only read.
+		 */
+		int send( node_id_t _dest, size_t _len, block_data_t* _data )
 		{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-			debug().debug( "FragmentingRadio - send - Entering.\n" );
-#endif
-			if ( status == FR_ACTIVE_STATUS )
-			{
-				if ( Radio::MAX_MESSAGE_LENGTH >= _len )
-				{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-					debug().debug( "FragmentingRadio - send - Sending normal message (radio max payload lens %d vs %d vs %d).\n", MAX_MESSAGE_LENGTH, Radio::MAX_MESSAGE_LENGTH, _len );
-#endif
-					Message m;
-					m.de_serialize( _data );
-					Message_normal mn;
-					mn.set_message_id( m.get_message_id() );
-					mn.set_payload( m.get_payload_size(), m.get_payload() );
-					radio().send( _dest, mn.serial_size(), mn.serialize() );
-				}
-				else
-				{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-					debug().debug( "FragmentingRadio - send - Sending fragmenting message (radio max payload lens %d vs %d vs %d).\n", MAX_MESSAGE_LENGTH, Radio::MAX_MESSAGE_LENGTH, _len );
-#endif
-					if ( Radio::MAX_MESSAGE_LENGTH > reserved_bytes() )
-					{
-						FragmentingMessage fm;
-						Message m;
-						size_t internal_reserved_bytes = m.serial_size();
-						m.de_serialize( _data );
-						size_t pure_payload = _len - internal_reserved_bytes;
-						size_t pure_fragment_payload = Radio::MAX_MESSAGE_LENGTH - reserved_bytes();
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-						debug().debug( "FragmentingRadio - send - Sending fragmenting message - Pure payload %d, pure_fragment_payload %d, reserved_bytes %d, radio().reserved_bytes %d, internal_reserved_bytes %d,  _len %d.\n", pure_payload, pure_fragment_payload, reserved_bytes(), radio().reserved_bytes(), internal_reserved_bytes, _len );
-#endif
-						fm.set_id( ( rand()() % 0xffff ) );
-						fm.set_orig_id( m.get_message_id() );
-						fm.vectorize( _data, pure_payload, pure_fragment_payload, internal_reserved_bytes );
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-						debug().debug( "FragmentingRadio - send - Sending fragmenting message of %d fragments.\n", fm.get_fragmenting_message_ref()->size() );
-#endif
-						for ( Fragment_vector_iterator it = fm.get_fragmenting_message_ref()->begin(); it != fm.get_fragmenting_message_ref()->end(); ++it )
-						{
-							Message_normal mf;
-							mf.set_message_id( FR_MESSAGE );
-							block_data_t buff[Radio::MAX_MESSAGE_LENGTH];
-							mf.set_payload( it->serial_size(), it->serialize( buff ) );
-							radio().send( _dest, mf.serial_size(), mf.serialize() );
-						}
-					}
-					else
-					{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-						debug().debug( "FragmentingRadio - send - Message headers exceed maximum payload!\n" );
-#endif
-					}
-				}
-			}
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-			debug().debug( "FragmentingRadio - send - Exiting.\n" );
-#endif
+			return send_frames( _dest, _len, _data, false );
 		}
 		// --------------------------------------------------------------------
+		/**
+		 * send() of a message with HEADROOM writable bytes in front of it
+		 * (see RadioStackTraits). The first fragment is framed right in
+		 * those bytes instead of being copied, as is a short message if its
+		 * serialized header is that of the radio below. _data itself is
+		 * only read.
+		 */
+		int send_in_place( node_id_t _dest, size_t _len, block_data_t* _data )
+		{
+			return send_frames( _dest, _len, _data, true );
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Fragments are copied into the slab entry of their (source, id)
+		 * at their offset; the complete message is handed to the callbacks
+		 * right from the slab.
+		 */
 		void receive( node_id_t _from, size_t_normal _len, block_data_t * _msg, ExData const &_ex )
 		{
 #ifdef DEBUG_FRAGMENTING_RADIO_H
 			debug().debug( "FragmentingRadio - receive - Entering.\n"  );
 #endif
-			if ( status == FR_ACTIVE_STATUS )
+			if ( ( status != FR_ACTIVE_STATUS ) || ( _from == radio().id() ) )
+			{
+				return;
+			}
+			Message_normal* message = (Message_normal*)_msg;
+			if ( ( _len < frame_header_size() ) || ( message->serial_size() > _len ) || ( !message->compare_checksum() ) )
 			{
-				if ( _from != radio().id() )
-				{
-					Message_normal message;
-					message.de_serialize( _msg );
-					if ( !message.compare_checksum() )
-					{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-						debug().debug( "FragmentingRadio - receive - Corrupted message!\n"  );
-#endif
-						return;
-					}
-					if ( message.get_message_id() == FR_MESSAGE )
-					{
-						uint8_t flag = 0;
-						Fragment f;
-						f.de_serialize( message.get_payload() );
-						for ( FragmentingMessage_vector_iterator it = fragmenting_messages.begin(); it != fragmenting_messages.end(); ++it )
-						{
-							if ( ( it->get_id() == f.get_id() ) && ( it->get_active() == 1 ) )
-							{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-								debug().debug( "FragmentingRadio - receive - Found matching fragment vector f_id : %d, f_fn : %d.\n", f.get_id(), f.get_seq_fragment()  );
-#endif
-								it->insert_unique( f );
-								if ( it->check_completeness() == 1 )
-								{
-#ifdef DEBUG_FRAGMENTING_RADIO_H
-									debug().debug( "FragmentingRadio - receive - Found matching fragment vector - Complete!.\n"  );
-#endif
-									Message m;
-									m.set_message_id( it->get_orig_id() );
-									block_data_t buff[MAX_MESSAGE_LENGTH];
-									m.set_payload( it->serial_size(), it->de_vectorize( buff ) );
-									for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
-									{
-										(*i)( _from, m.get_payload_size(), m.serialize(), _ex);
-									}
 #ifdef DEBUG_FRAGMENTING_RADIO_H
-									debug().debug( "FragmentingRadio - receive - Exiting.\n" );
+				debug().debug( "FragmentingRadio - receive - Corrupted message!\n"  );
 #endif
-									it->set_inactive();
-									return;
-								}
-								flag = 1;
-							}
-						}
-						if ( flag == 0 )
-						{
+				return;
+			}
+			if ( message->get_message_id() != FR_MESSAGE )
+			{
 #ifdef DEBUG_FRAGMENTING_RADIO_H
-							debug().debug( "FragmentingRadio - receive - No matching fragment vector - Making new f_id : %d, f_fn : %d.\n", f.get_id(), f.get_seq_fragment()  );
+				debug().debug( "FragmentingRadio - receive - Other type of ID pushing forward as it is.\n"  );
 #endif
-							FragmentingMessage fm;
-							fm.set_id( f.get_id() );
-							fm.set_orig_id( f.get_orig_id() );
-							fm.insert_unique( f );
-							fm.set_active();
-							fm.set_timestamp( clock().seconds( clock().time() ) * 1000 + clock().milliseconds( clock().time() ) );
-							uint8_t flag2 = 0;
-							for ( FragmentingMessage_vector_iterator it = fragmenting_messages.begin(); it != fragmenting_messages.end(); ++it )
-							{
-								if ( it->get_active() == 0 )
-								{
+				Message m;
+				m.set_message_id( message->get_message_id() );
+				m.set_payload( message->get_payload_size(), message->get_payload() );
+				for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
+				{
+					(*i)( _from, m.serial_size(), m.serialize(), _ex );
+				}
+				return;
+			}
+			if ( message->get_payload_size() < Fragment::header_size() )
+			{
+				return;
+			}
+			Fragment f;
+			f.de_serialize( message->get_payload() );
+			size_t len = message->get_payload_size() - Fragment::header_size();
+			if ( ( f.get_total_fragments() == 0 ) || ( f.get_total_fragments() > FR_MAX_FRAGMENTS ) ||
+				 ( f.get_seq_fragment() >= f.get_total_fragments() ) || ( f.get_length() > REASSEMBLY_BUFFER_SIZE ) ||
+				 ( f.get_offset() + len > f.get_length() ) )
+			{
 #ifdef DEBUG_FRAGMENTING_RADIO_H
-									debug().debug( "FragmentingRadio - daemon - Replacing inactive.\n" );
+				debug().debug( "FragmentingRadio - receive - Malformed fragment!\n"  );
 #endif
-									*it = fm;
-									flag2 = 1;
-								}
-							}
-							if ( flag2 == 0 )
-							{
+				return;
+			}
+			size_t slot = find_fragmenting_message( _from, f );
+			FragmentingMessage& fm = fragmenting_messages[slot];
+			if ( ( fm.get_length() != f.get_length() ) || ( fm.insert_unique( f.get_seq_fragment() ) == 0 ) )
+			{
+				return;
+			}
+			block_data_t* buff = slab + slot * REASSEMBLY_BUFFER_SIZE;
+			memcpy( buff + f.get_offset(), message->get_payload() + Fragment::header_size(), len );
 #ifdef DEBUG_FRAGMENTING_RADIO_H
-								debug().debug( "FragmentingRadio - daemon - Inserting new.\n" );
+			debug().debug( "FragmentingRadio - receive - Fragment f_id : %d, f_fn : %d into slot %d.\n", f.get_id(), f.get_seq_fragment(), slot );
 #endif
-								fragmenting_messages.push_back( fm );
-							}
-						}
-					}
-					else
-					{
+			if ( fm.check_completeness() == 1 )
+			{
 #ifdef DEBUG_FRAGMENTING_RADIO_H
-						if ( radio().id() == 0x9710 )
-						{
-							debug().debug( "FragmentingRadio - receive - Other type of ID pushing forward as it is.\n"  );
-						}
+				debug().debug( "FragmentingRadio - receive - Complete!.\n"  );
 #endif
-						for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
-						{
-							Message_normal mn;
-							mn.de_serialize( _msg );
-							Message m;
-							m.set_message_id( mn.get_message_id() );
-							m.set_payload( mn.get_payload_size(), mn.get_payload() );
-							(*i)( _from, m.serial_size(), m.serialize(), _ex);
-						}
-					}
+				fm.set_inactive();
+				for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
+				{
+					(*i)( _from, fm.get_length(), buff, _ex );
 				}
 			}
 #ifdef DEBUG_FRAGMENTING_RADIO_H
@@ -294,7 +243,7 @@ namespace wiselib
 			if ( status == FR_ACTIVE_STATUS )
 			{
 				uint32_t current_time = clock().seconds( clock().time() ) * 1000 + clock().milliseconds( clock().time() );
-				for ( FragmentingMessage_vector_iterator it = fragmenting_messages.begin(); it != fragmenting_messages.end(); ++it )
+				for ( FragmentingMessage* it = fragmenting_messages; it != fragmenting_messages + FR_MAX_FRAGMENED_MESSAGES_BUFFERED; ++it )
 				{
 					if ( current_time < it->get_timestamp() )
 					{
@@ -318,8 +267,7 @@ namespace wiselib
         // --------------------------------------------------------------------
         size_t reserved_bytes()
         {
-        	Fragment f;
-        	return ( radio().reserved_bytes() + f.serial_size() );
+        	return ( radio().reserved_bytes() + Fragment::header_size() );
         };
 		// --------------------------------------------------------------------
 		uint8_t get_status()
@@ -401,6 +349,15 @@ namespace wiselib
 			return radio().id();
 		}
 		// --------------------------------------------------------------------
+		/**
+		 * Size of the radio message header in front of the fragment header
+		 * in every fragment frame.
+		 */
+		size_t frame_header_size()
+		{
+			return Message_normal::HEADER_SIZE;
+		}
+		// --------------------------------------------------------------------
 		enum reliable_radio_status
 		{
 			FR_ACTIVE_STATUS,
@@ -420,10 +377,6 @@ namespace wiselib
 			FR_REPLY = 24,
 			FR_UNDELIVERED = 34
 		};
-        enum Restrictions
-        {
-            MAX_MESSAGE_LENGTH = 1024
-        };
         enum SpecialNodeIds
         {
         	BROADCAST_ADDRESS = Radio::BROADCAST_ADDRESS,
@@ -433,7 +386,8 @@ namespace wiselib
 		uint32_t recv_callback_id_;
         uint8_t status;
         RegisteredCallbacks_vector callbacks;
-        FragmentingMessage_vector fragmenting_messages;
+        FragmentingMessage fragmenting_messages[FR_MAX_FRAGMENED_MESSAGES_BUFFERED];
+        block_data_t slab[FR_MAX_FRAGMENED_MESSAGES_BUFFERED * REASSEMBLY_BUFFER_SIZE];
         millis_t daemon_period;
         millis_t fragmenting_message_timeout;
         Radio * radio_;
@@ -441,6 +395,117 @@ namespace wiselib
         Timer * timer_;
         Debug * debug_;
         Rand * rand_;
+		// --------------------------------------------------------------------
+		int send_frames( node_id_t _dest, size_t _len, block_data_t* _data, bool _in_place )
+		{
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+			debug().debug( "FragmentingRadio - send - Entering.\n" );
+#endif
+			if ( status != FR_ACTIVE_STATUS )
+			{
+				return Os::ERR_UNSPEC;
+			}
+			// the message fits one frame once reframed with the header of
+			// the radio message
+			if ( (size_t)Radio::MAX_MESSAGE_LENGTH + Message::HEADER_SIZE >= (size_t)Message_normal::HEADER_SIZE + _len )
+			{
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+				debug().debug( "FragmentingRadio - send - Sending normal message (radio max payload lens %d vs %d vs %d).\n", MAX_MESSAGE_LENGTH, Radio::MAX_MESSAGE_LENGTH, _len );
+#endif
+				Message* m = (Message*)_data;
+				if ( _in_place && ( (size_t)Message::HEADER_SIZE == (size_t)Message_normal::HEADER_SIZE ) )
+				{
+					// same size fields, so _data already is the radio message;
+					// the radio below only writes into the headroom
+					return LowerStack::send( radio(), _dest, _len, _data );
+				}
+				Message_normal mn;
+				mn.set_message_id( m->get_message_id() );
+				mn.set_payload( m->get_payload_size(), m->get_payload() );
+				return radio().send( _dest, mn.serial_size(), mn.serialize() );
+			}
+			size_t header = FRAME_HEADER_SIZE;
+			if ( Radio::MAX_MESSAGE_LENGTH <= header )
+			{
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+				debug().debug( "FragmentingRadio - send - Message headers exceed maximum payload!\n" );
+#endif
+				return Os::ERR_UNSPEC;
+			}
+			size_t fragment_payload = Radio::MAX_MESSAGE_LENGTH - header;
+			size_t total = ( _len + fragment_payload - 1 ) / fragment_payload;
+			if ( ( total > FR_MAX_FRAGMENTS ) || ( _len > REASSEMBLY_BUFFER_SIZE ) )
+			{
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+				debug().debug( "FragmentingRadio - send - Message of %d bytes needs too many fragments.\n", _len );
+#endif
+				return Os::ERR_UNSPEC;
+			}
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+			debug().debug( "FragmentingRadio - send - Sending fragmenting message of %d fragments of %d bytes.\n", total, fragment_payload );
+#endif
+			Fragment f;
+			f.set_id( rand()() % 0xffff );
+			f.set_total_fragments( total );
+			f.set_length( _len );
+			block_data_t buff[LowerStack::HEADROOM + Radio::MAX_MESSAGE_LENGTH];
+			int result = Os::SUCCESS;
+			for ( size_t i = 0; i < total; i++ )
+			{
+				size_t offset = i * fragment_payload;
+				size_t len = _len - offset < fragment_payload ? _len - offset : fragment_payload;
+				block_data_t* frame;
+				if ( _in_place && ( i == 0 ) )
+				{
+					// the HEADROOM bytes granted in front of _data
+					frame = _data - header;
+				}
+				else
+				{
+					frame = buff + LowerStack::HEADROOM;
+					memcpy( frame + header, _data + offset, len );
+				}
+				f.set_seq_fragment( i );
+				f.set_offset( offset );
+				f.serialize( frame, Message_normal::HEADER_SIZE );
+				Message_normal::frame_in_place( FR_MESSAGE, Fragment::HEADER_SIZE + len, frame + Message_normal::HEADER_SIZE );
+				if ( LowerStack::send( radio(), _dest, header + len, frame ) != Os::SUCCESS )
+				{
+					result = Os::ERR_UNSPEC;
+				}
+			}
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+			debug().debug( "FragmentingRadio - send - Exiting.\n" );
+#endif
+			return result;
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Slab entry reassembling the message of fragment _f from _from. A
+		 * new message takes a free entry or, if there is none, the oldest.
+		 */
+		size_t find_fragmenting_message( node_id_t _from, Fragment& _f )
+		{
+			size_t victim = 0;
+			for ( size_t i = 0; i < FR_MAX_FRAGMENED_MESSAGES_BUFFERED; i++ )
+			{
+				if ( fragmenting_messages[i].matches( _from, _f.get_id() ) )
+				{
+					return i;
+				}
+				if ( ( fragmenting_messages[victim].get_active() == 1 ) &&
+					 ( ( fragmenting_messages[i].get_active() == 0 ) ||
+					   ( fragmenting_messages[i].get_timestamp() < fragmenting_messages[victim].get_timestamp() ) ) )
+				{
+					victim = i;
+				}
+			}
+#ifdef DEBUG_FRAGMENTING_RADIO_H
+			debug().debug( "FragmentingRadio - receive - No matching fragmenting message - Making new f_id : %d in slot %d.\n", _f.get_id(), victim );
+#endif
+			fragmenting_messages[victim].init( _from, _f, clock().seconds( clock().time() ) * 1000 + clock().milliseconds( clock().time() ) );
+			return victim;
+		}
     };
 }
 
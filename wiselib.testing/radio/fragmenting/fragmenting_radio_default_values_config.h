@@ -1,5 +1,21 @@
+#ifndef FR_MAX_REGISTERED_PROTOCOLS
 #define FR_MAX_REGISTERED_PROTOCOLS 2
+#endif
+//at most 32, one bit per fragment in the reassembly bitmap
+#ifndef FR_MAX_FRAGMENTS
 #define FR_MAX_FRAGMENTS 7
+#endif
+#ifndef FR_MAX_FRAGMENED_MESSAGES_BUFFERED
 #define FR_MAX_FRAGMENED_MESSAGES_BUFFERED 5
+#endif
+//bytes of each reassembly buffer, 0 for the longest message FR_MAX_FRAGMENTS
+//fragments carry (at most 1024)
+#ifndef FR_REASSEMBLY_BUFFER_SIZE
+#define FR_REASSEMBLY_BUFFER_SIZE 0
+#endif
+#ifndef FR_DAEMON_MILLIS
 #define FR_DAEMON_MILLIS 1000
+#endif
+#ifndef FR_FRAGMENTING_MESSAGE_TIMEOUT
 #define FR_FRAGMENTING_MESSAGE_TIMEOUT 1000
+#endif
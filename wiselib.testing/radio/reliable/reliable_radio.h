@@ -4,12 +4,38 @@
 #include "util/pstl/vector_static.h"
 #include "util/delegates/delegate.hpp"
 #include "../../internal_interface/message/message.h"
+#include "radio/stack/radio_stack.h"
 #include "reliable_radio_message.h"
+#include "reliable_radio_peer.h"
 #include "reliable_radio_source_config.h"
 #include "reliable_radio_default_values_config.h"
 
 namespace wiselib
 {
+	/**
+	 * Radio decorator that delivers unicast messages reliably.
+	 *
+	 * Every neighbor gets a selective repeat send window of RR_WINDOW_SIZE
+	 * sequence numbers. Receivers answer with a cumulative ack plus a bitmap
+	 * of the messages received after it, delayed by RR_ACK_DELAY ms so that
+	 * it can ride on a reply sent in the meantime (every data frame carries
+	 * the ack state of its sender). Only messages the bitmap does not
+	 * cover are retransmitted, each when its own deadline expires; the
+	 * timeout follows the measured round trip time of the neighbor and
+	 * doubles for the first RR_MAX_BACKOFF retransmissions only, as losses
+	 * on a radio link are rarely congestion. After max_retries
+	 * retransmissions the registered callbacks get RR_UNDELIVERED with the
+	 * original message.
+	 *
+	 * Messages are delivered once but not necessarily in order. send()
+	 * fails with RR_MESSAGE_BUFFER_FULL when the window of the destination
+	 * or the shared buffer of RR_MAX_BUFFERED_MESSAGES is full. Broadcasts
+	 * are passed through unacknowledged.
+	 *
+	 * Buffered messages keep the headroom of the radio below them, so
+	 * every (re)transmission is framed in place instead of being copied
+	 * through intermediate buffers.
+	 */
 	template<	typename Os_P,
 				typename Radio_P,
 				typename Clock_P,
@@ -38,17 +64,20 @@ namespace wiselib
 		typedef vector_static<Os, event_notifier_delegate_t, RR_MAX_REGISTERED_PROTOCOLS> RegisteredCallbacks_vector;
 		typedef typename RegisteredCallbacks_vector::iterator RegisteredCallbacks_vector_iterator;
 		typedef Message_Type<Os, Radio, Debug> Message;
-		typedef ReliableRadioMessage_Type<Os, Radio, Debug> ReliableRadioMessage;
-		typedef vector_static<Os, ReliableRadioMessage, RR_MAX_BUFFERED_MESSAGES> ReliableRadioMessage_vector;
-		typedef typename ReliableRadioMessage_vector::iterator ReliableRadioMessage_vector_iterator;
-		typedef vector_static<Os, ReliableRadioMessage, RR_MAX_BUFFERED_REPLIES> ReliableRadioReply_vector;
-		typedef typename ReliableRadioReply_vector::iterator ReliableRadioReply_vector_iterator;
+		typedef RadioStackTraits<Radio> LowerStack;
+		typedef ReliableRadioMessage_Type<Os, Radio, Debug, LowerStack::HEADROOM + Message::HEADER_SIZE> ReliableRadioMessage;
+		typedef ReliableRadioPeer_Type<Os, Radio, Debug> Peer;
 		typedef ReliableRadio_Type<Os, Radio, Clock, Timer, Rand, Debug> self_t;
 		// --------------------------------------------------------------------
 		ReliableRadio_Type() :
 			daemon_period		( RR_RESEND_DAEMON_PERIOD ),
 			max_retries			( RR_MAX_RETRIES ),
-			seq					( 0 )
+			ack_delay			( RR_ACK_DELAY ),
+			retransmissions		( 0 ),
+			wakeup				( 0 ),
+			wakeup_armed		( 0 ),
+			wakeup_generation	( 0 ),
+			ack_armed			( 0 )
 		{};
 		// --------------------------------------------------------------------
 		~ReliableRadio_Type()
@@ -62,7 +91,10 @@ namespace wiselib
 			radio().enable_radio();
 			set_status( RR_ACTIVE_STATUS );
 			recv_callback_id_ = radio().template reg_recv_callback<self_t, &self_t::receive>( this );
-			daemon();
+			//timers of a previous activation may still be pending
+			wakeup_armed = 0;
+			ack_armed = 0;
+			arm_retransmit();
 #ifdef DEBUG_RELIABLE_RADIO_H
 			debug().debug( "ReliableRadio - enable %x - Exiting.\n", radio().id() );
 #endif
@@ -75,459 +107,200 @@ namespace wiselib
 			radio().disable_radio();
 		};
 		// --------------------------------------------------------------------
-		void send( node_id_t _dest, size_t _len, block_data_t* _data )
+		int send( node_id_t _dest, size_t _len, block_data_t* _data )
 		{
-#ifdef DEBUG_RELIABLE_RADIO_H
-			//***
-			block_data_t bufffff[Radio::MAX_MESSAGE_LENGTH];
-			Message mmm;
-			mmm.de_serialize( _data );
-			//***
-			if ( ( mmm.get_message_id() == 41 ) || ( mmm.get_message_id() == 51 ) )
+			if ( status != RR_ACTIVE_STATUS )
 			{
-				debug().debug( "ReliableRadio - send %d- Entering.\n", radio().id() );
+				return Os::ERR_UNSPEC;
 			}
-#endif
-			if ( status == RR_ACTIVE_STATUS )
+			if ( _dest == BROADCAST_ADDRESS )
 			{
-				if ( _dest == BROADCAST_ADDRESS )
-				{
-					radio().send( _dest, _len, _data);
-					return;
-				}
-				ReliableRadioMessage reliable_radio_message;
-#ifdef CONFIG_RELIABLE_RADIO_H_RANOM_ID
-				reliable_radio_message.set_message_id( rand()()%0xffff );
-#else
-				reliable_radio_message.set_message_id( seq );
-				seq = seq + 1;
+				return radio().send( _dest, _len, _data );
+			}
+			Message empty;
+			if ( empty.serial_size() + ReliableRadioMessage::header_size() + _len > (size_t)Radio::MAX_MESSAGE_LENGTH )
+			{
+				return Os::ERR_UNSPEC;
+			}
+			Peer* peer = find_peer( _dest, 1 );
+			uint8_t idx = free_message();
+			if ( ( peer == NULL ) || ( peer->window_full() ) || ( idx == Peer::NO_SLOT ) )
+			{
+#ifdef DEBUG_RELIABLE_RADIO_H
+				debug().debug( "ReliableRadio - send %x - No room for message to %x.\n", radio().id(), _dest );
 #endif
-				reliable_radio_message.set_payload( _len, _data );
-				reliable_radio_message.set_destination( _dest );
-				uint8_t res = insert_reliable_radio_message( reliable_radio_message );
-				if ( res == 1 )
+				for ( RegisteredCallbacks_vector_iterator j = callbacks.begin(); j != callbacks.end(); ++j )
 				{
+					ExData ex;
 					Message message;
-					message.set_message_id( RR_MESSAGE );
-					block_data_t buff[Radio::MAX_MESSAGE_LENGTH];
-					message.set_payload( reliable_radio_message.serial_size(), reliable_radio_message.serialize( buff ) );
-					radio().send( _dest, message.serial_size(), message.serialize() );
-	#ifdef DEBUG_RELIABLE_RADIO_H
-					if ( ( mmm.get_message_id() == 41 ) || ( mmm.get_message_id() == 51 ) )
-					{
-						debug().debug( "ReliableRadio - send %d - Message was sent to %d with rand id [%d] of size %d \n", radio().id(), _dest, reliable_radio_message.get_message_id(), message.serial_size() );
-					}
-	#endif
-				}
-	#ifdef DEBUG_RELIABLE_RADIO_H
-				if ( ( mmm.get_message_id() == 41 ) || ( mmm.get_message_id() == 51 ) )
-				{
-					debug().debug( "ReliableRadio - send %d - Exiting.\n", radio().id() );
-				}
-	#endif
-				else
-				{
-					for ( RegisteredCallbacks_vector_iterator j = callbacks.begin(); j != callbacks.end(); ++j )
-					{
-						ExData ex;
-						Message message;
-						message.set_message_id( RR_MESSAGE_BUFFER_FULL );
-						message.set_payload( _len, _data );
-						(*j)( _dest, message.serial_size(), message.serialize(), ex);
-					}
+					message.set_message_id( RR_MESSAGE_BUFFER_FULL );
+					message.set_payload( _len, _data );
+					(*j)( _dest, message.serial_size(), message.serialize(), ex);
 				}
+				return Os::ERR_UNSPEC;
 			}
+			ReliableRadioMessage& rrm = reliable_radio_messages[idx];
+			rrm.set_used( 1 );
+			rrm.set_destination( _dest );
+			rrm.set_payload( _len, _data );
+			rrm.set_seq( peer->next_seq );
+			rrm.set_counter( 0 );
+			peer->slot( peer->next_seq ) = idx;
+			peer->next_seq++;
+			transmit( *peer, rrm );
+			return Os::SUCCESS;
 		}
 		// --------------------------------------------------------------------
 		void receive( node_id_t _from, size_t _len, block_data_t * _msg, ExData const &_ex )
 		{
-#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ReliableRadio - receive %x - Entering.\n", radio().id() );
-#endif
-			if ( status == RR_ACTIVE_STATUS )
+			if ( ( status != RR_ACTIVE_STATUS ) || ( _from == radio().id() ) )
+			{
+				return;
+			}
+			Message* msg = (Message*) _msg;
+			if ( ( msg->get_message_id() == RR_MESSAGE ) && ( msg->compare_checksum() ) )
 			{
-				if ( _from != radio().id() )
+				ReliableRadioMessage reliable_radio_message;
+				reliable_radio_message.de_serialize( msg->get_payload(), msg->get_payload_size() );
+				Peer* peer = find_peer( _from, 1 );
+				if ( peer == NULL )
 				{
-					Message* msg = (Message*) _msg;
-					if ( ( msg->get_message_id() == RR_MESSAGE ) && ( msg->compare_checksum() ) )
-					{
-#ifdef DEBUG_RELIABLE_RADIO_H
-						debug().debug( "ReliableRadio - receive %x - Received RR_MESSAGE.\n", radio().id() );
-#endif
-						ReliableRadioMessage reliable_radio_message;
-						reliable_radio_message.de_serialize( msg->get_payload() );
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						block_data_t* buffff = reliable_radio_message.get_payload();
-//						Message mmmmm;
-//						mmmmm.de_serialize( buffff );
-//						if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//						{
-//							debug().debug( "RR-rec %x - Rec RR_MESSAGE of [%x] from %x of size %d.\n", radio().id(), reliable_radio_message.get_message_id(), _from, _len );
-//						}
-//#endif
-						ReliableRadioMessage reliable_radio_reply;
-						reliable_radio_reply.set_message_id( reliable_radio_message.get_message_id() );
-						reliable_radio_reply.set_counter( reliable_radio_message.get_counter() );
-						block_data_t buff2[Radio::MAX_MESSAGE_LENGTH];
-						block_data_t buff1[Radio::MAX_MESSAGE_LENGTH];
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-						//**
-						//size_t olds = reliable_radio_reply.serial_size();
-						//**
-//#endif
-						//used uint32 offset to store specific ids for deep debugs
-						reliable_radio_reply.set_payload( sizeof(node_id_t)/* + sizeof(uint32_t)*/, buff1 );
-						reliable_radio_reply.set_destination( _from );
-						reliable_radio_reply.reply_destination_write();
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						//**
-//						if ( ( mmmmm.get_message_id() == 41 ) )//&& ( _len != 187 ) )
-//						{
-//							reliable_radio_reply.reply_internal_message_id_write( 41 );
-//						}
-//						else if  ( mmmmm.get_message_id() == 51 )
-//						{
-//							reliable_radio_reply.reply_internal_message_id_write( 51 );
-//						}
-						//**
-//#endif
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//						{
-//							reliable_radio_reply.reply_destination_read();
-//							debug().debug( "RR-rec %x - Send RR_REPLY of [%x] to %x vs %x with sizes[%d + %d, %d].\n", radio().id(), reliable_radio_reply.get_message_id(), _from, reliable_radio_reply.get_destination(), olds, sizeof(node_id_t) + sizeof(uint32_t), reliable_radio_reply.serial_size() );
-//						}
-//#endif
-						if ( replies_check( reliable_radio_reply.get_message_id(), _from ) == 0 )
-						{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//							if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//							{
-//								debug().debug( "ReliableRadio-receive %x - RR_MESSAGE WAS NEW of [%x] from %x, going for storing.\n", radio().id(), reliable_radio_message.get_message_id(), _from );
-//							}
-//#endif
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//
-//							if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//							{
-//								if ( res == 1 )
-//								{
-//									debug().debug( "RR-rec %x - RR_MESSAGE WAS NEW of [%x] from %x, STORED.\n", radio().id(), reliable_radio_message.get_message_id(), _from );
-//								}
-//								else
-//								{
-//									debug().debug( "RR-rec %x - RR_MESSAGE WAS NEW of [%x] from %x, NOT STORED.\n", radio().id(), reliable_radio_message.get_message_id(), _from );
-//								}
-//							}
-//#endif
-							//this loop could be included only for res 1... due to the fact that the reliable node partners might go into an endless ping pong loop (no buffer - no knowledge...)
-							uint8_t res = insert_reliable_radio_reply( reliable_radio_reply );
-							if ( res == 1 )
-							{
-								Message message;
-								message.set_message_id( RR_REPLY );
-								message.set_payload( reliable_radio_reply.serial_size(), reliable_radio_reply.serialize( buff2 ) );
-								radio().send( _from, message.serial_size(), message.serialize() );
-								for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
-								{
-									(*i)( _from, reliable_radio_message.get_payload_size(), reliable_radio_message.get_payload(), _ex);
-								}
-							}
-							else
-							{
-								//debug().debug("%x",_from);
-								//callback for buffer failure
-//								for ( ReliableRadioReply_vector_iterator i = reliable_radio_replies.begin(); i != reliable_radio_replies.end(); ++i )
-//								{
-//									debug().debug("%x:%x:[%d:%d]", radio().id(), i->get_message_id(), i->get_destination(), i->get_counter() );
-//								}
-								for ( RegisteredCallbacks_vector_iterator j = callbacks.begin(); j != callbacks.end(); ++j )
-								{
-									Message message;
-									message.set_message_id( RR_REPLY_BUFFER_FULL );
-									message.set_payload( _len, msg->get_payload() );
-									(*j)( _from, message.serial_size(), message.serialize(), _ex);
-								}
-							}
-						}
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						else
-//						{
-//							if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//							{
-//								debug().debug( "RR - rec %x - RR_MESSAGE WAS NOT!!!! NEW of [%x] from %x.\n", radio().id(), reliable_radio_message.get_message_id(), _from );
-//							}
-//						}
-//#endif
-					}
-					else if ( msg->get_message_id() == RR_REPLY )
-					{
-#ifdef DEBUG_RELIABLE_RADIO_H
-						debug().debug( "ReliableRadio - receive %x - Received RR_REPLY.\n", radio().id() );
-#endif
-						ReliableRadioMessage reliable_radio_reply;
-						reliable_radio_reply.de_serialize( msg->get_payload() );
-						reliable_radio_reply.reply_destination_read();
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						if ( ( reliable_radio_reply.reply_internal_message_id_read() == 41 ) ||  ( reliable_radio_reply.reply_internal_message_id_read() == 51 ) )
-//						{
-//							debug().debug( "RR - rec %x - Rec RR_REPLY [%x] from %x.\n", radio().id(), reliable_radio_reply.get_message_id(), _from );
-//						}
-//						uint8_t found_flag = 0;
-//#endif
-						for ( ReliableRadioMessage_vector_iterator i = reliable_radio_messages.begin(); i != reliable_radio_messages.end(); ++i )
-						{
-#ifdef DEBUG_RELIABLE_RADIO_H
-							//if ( ( reliable_radio_reply.reply_internal_message_id_read() == 41 ) ||  ( reliable_radio_reply.reply_internal_message_id_read() == 51 ) )
-							//{
-							//	debug().debug( "ReliableRadio - receive %x - Received RR_REPLY [%x] - in the loops with [%x vs %x] with deliver status [%d] from %x.\n", radio().id(),  reliable_radio_reply.get_message_id(), i->get_message_id(), reliable_radio_reply.get_message_id(), i->get_delivered(), _from );
-							//}
-#endif
-							if ( ( i->get_message_id() == reliable_radio_reply.get_message_id() ) && ( i->get_delivered() == 0 ) && ( i->get_destination() == _from ) )
-							{
-								i->set_delivered();
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//								if ( ( reliable_radio_reply.reply_internal_message_id_read() == 41 ) ||  ( reliable_radio_reply.reply_internal_message_id_read() == 51 ) )
-//								{
-//									debug().debug( "RR - rec %x - Received RR_REPLY [%x] - Exiting as delivered from %x.\n", radio().id(), i->get_message_id(), _from );
-//									found_flag = 1;
-//								}
-//#endif
-								return;
-							}
-						}
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						if ( ( found_flag == 0 ) && ( ( reliable_radio_reply.reply_internal_message_id_read() == 41 ) ||  ( reliable_radio_reply.reply_internal_message_id_read() == 51 ) ) )
-//						{
-//							debug().debug( "RR - rec %x - Received RR_REPLY [%x] - Exiting not found from %x with possible obsolete reply.\n", radio().id(),  reliable_radio_reply.get_message_id(), _from );
-//						}
-//						//debug().debug( "ReliableRadio - receive %x - Exiting from %x with possible obsolete reply.\n", radio().id(), _from );
-//#endif
-					}
+					//no state to filter duplicates with, the sender will retry
+					return;
 				}
-			}
-#ifdef DEBUG_RELIABLE_RADIO_H
-			//debug().debug( "ReliableRadio - receive %x - Exiting (from %x).\n", radio().id(), _from );
-#endif
-		}
-		// --------------------------------------------------------------------
-		void daemon( void* _user_data = NULL )
-		{
+				uint8_t flags = reliable_radio_message.get_flags();
+				if ( flags & ReliableRadioMessage::RR_FLAG_ACK )
+				{
+					process_ack( *peer, reliable_radio_message.get_ack(), reliable_radio_message.get_ack_bits() );
+				}
+				uint8_t fresh = peer->accept( reliable_radio_message.get_seq(), flags & ReliableRadioMessage::RR_FLAG_SYN, flags >> ReliableRadioMessage::RR_SYN_OFFSET_SHIFT );
+				peer->ack_pending = 1;
+				peer->last_used = now();
 #ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ReliableRadio - daemon %x - Entering.\n", radio().id() );
+				debug().debug( "ReliableRadio - receive %x - RR_MESSAGE [%d] from %x, new %d.\n", radio().id(), reliable_radio_message.get_seq(), _from, fresh );
 #endif
-			if ( status == RR_ACTIVE_STATUS )
-			{
-				for ( ReliableRadioMessage_vector_iterator i = reliable_radio_messages.begin(); i != reliable_radio_messages.end(); ++i )
+				if ( fresh )
 				{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-					block_data_t* buffff = i->get_payload();
-					Message mmmmm;
-					mmmmm.de_serialize( buffff );
-//#endif
-					if ( ( i->get_counter() < max_retries ) && ( i->get_delivered() == 0 ) )
+					for ( RegisteredCallbacks_vector_iterator i = callbacks.begin(); i != callbacks.end(); ++i )
 					{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//						{
-//							debug().debug( "RR - dae %x - RR_MESS [%x] exists with less than max retr\n", radio().id(), i->get_message_id() );
-//						}
-//#endif
-						debug().debug("RRR:%x",radio().id());
-						Message message;
-						message.set_message_id( RR_MESSAGE );
-						block_data_t buff[Radio::MAX_MESSAGE_LENGTH];
-						message.set_payload( i->serial_size(), i->serialize( buff ) );
-						if ( i->get_counter() > max_retries / 2 )
-						{
-							int old_db = radio().power().to_dB();
-							if ( old_db < -6 )
-							{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//								if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//								{
-//									debug().debug("RR - dae %x - [%x], Inc rad [%d, %d], for re-trans\n", radio().id(), i->get_message_id(), old_db, old_db + 6 );
-//								}
-//#endif
-								TxPower tp;
-								tp.set_dB( old_db + 6 );
-								radio().set_power( tp );
-							}
-							radio().send( i->get_destination(), message.serial_size(), message.serialize() );
-							i->inc_counter();
-							TxPower tp;
-							tp.set_dB( old_db );
-							radio().set_power( tp );
-						}
-						else
-						{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-///							if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//							{
-//								debug().debug( "RR - dae %x - RR_MESS [%x] exists with less than max retries - Sending again to %d [%d]\n", radio().id(),  i->get_message_id(), i->get_destination(), i->get_message_id() );
-//							}
-//#endif
-							radio().send( i->get_destination(), message.serial_size(), message.serialize() );
-							i->inc_counter();
-						}
-					}
-					else if ( ( i->get_counter() ==  max_retries ) && ( i->get_delivered() == 0 ) )
-					{
-//@
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//						if ( ( mmmmm.get_message_id() == 41 ) || ( mmmmm.get_message_id() == 51 ) )
-//						{
-//							debug().debug( "RR - dae %d - RR_MESS [%x] exists with max retries %d of [%d] with deliver status [%d] from %x - Undeliv\n", radio().id() ,  i->get_message_id(), max_retries + 1, i->get_message_id(), i->get_delivered(), i->get_destination() );
-//						}
-//#endif
-						for ( RegisteredCallbacks_vector_iterator j = callbacks.begin(); j != callbacks.end(); ++j )
-						{
-							ExData ex;
-							Message message;
-							message.set_message_id( RR_UNDELIVERED );
-							message.set_payload( i->get_payload_size(), i->get_payload() );
-							(*j)( i->get_destination(), message.serial_size(), message.serialize(), ex);
-							i->inc_counter();
-						}
+						(*i)( _from, reliable_radio_message.get_payload_size(), reliable_radio_message.get_payload(), _ex);
 					}
 				}
-				for ( ReliableRadioReply_vector_iterator i = reliable_radio_replies.begin(); i != reliable_radio_replies.end(); ++i )
+				if ( peer->ack_pending )
 				{
-#ifdef DEBUG_RELIABLE_RADIO_H
-					debug().debug( "ReliableRadio - daemon %x - Inside replies vector updating counters...\n", radio().id() );
-#endif
-					if ( i->get_counter() < max_retries  )
+					//a duplicate means our ack got lost, repeat it at once
+					if ( ( !fresh ) || ( ack_delay == 0 ) )
 					{
-						i->inc_counter();
+						send_ack( *peer );
+					}
+					else if ( !ack_armed )
+					{
+						ack_armed = 1;
+						timer().template set_timer<self_t, &self_t::flush_acks>( ack_delay, this, 0 );
 					}
 				}
-				millis_t offset = 0;
-#ifdef CONFIG_RELIABLE_RADIO_H_RANDOM_DAEMON_OFFSET
-				millis_t offset = rand()() % daemon_period;
-#endif
-				timer().template set_timer<self_t, &self_t::daemon> ( daemon_period + offset, this, 0 );
-			}
-#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ReliableRadio - daemon %x Exiting.\n", radio().id() );
-#endif
-		}
-		// --------------------------------------------------------------------
-		uint8_t insert_reliable_radio_message( ReliableRadioMessage _rrm )
-		{
-//#ifdef DEBUG_RELIABLE_RADIO_H
-//			debug().debug( "ReliableRadio - insert_reliable_radio_message %x - Entering.\n", radio().id() );
-			Message mmm;
-			mmm.de_serialize( _rrm.get_payload() );
-
-//#endif
-			if ( reliable_radio_messages.max_size() > reliable_radio_messages.size() )
-			{
-				reliable_radio_messages.push_back( _rrm );
-
-#ifdef DEBUG_RELIABLE_RADIO_H
-//				if ( mmm.get_message_id() == 41 )
-//				{
-				debug().debug( "ReliableRadio - insert_reliable_radio_message %x - Enough space to push back, Exiting with success.\n", radio().id() );
-//				}
-#endif
-				return 1;
 			}
-			for ( ReliableRadioMessage_vector_iterator i = reliable_radio_messages.begin(); i != reliable_radio_messages.end(); ++i )
+			else if ( ( msg->get_message_id() == RR_REPLY ) && ( msg->compare_checksum() ) )
 			{
-#ifdef DEBUG_RELIABLE_RADIO_H
-//				if ( mmm.get_message_id() == 41 )
-//				{
-				debug().debug( "ReliableRadio - insert_reliable_radio_message %x rr_buffer[%d vs %d] - In the loops looking.... \n", radio().id(), reliable_radio_messages.max_size(), reliable_radio_messages.size() );
-//				}
-#endif
-				if ( ( i->get_counter() > max_retries ) || ( i->get_delivered() == 1 ) )
+				Peer* peer = find_peer( _from, 0 );
+				if ( peer != NULL )
 				{
-#ifdef DEBUG_RELIABLE_RADIO_H
-//					if ( mmm.get_message_id() == 41 )
-//					{
-					debug().debug( "ReliableRadio - insert_reliable_radio_message %x - Found an obsolete entry, replacing and exiting with success.\n", radio().id() );
-//					}
-#endif
-					*i = _rrm;
-					return 1;
+					block_data_t* p = msg->get_payload();
+					uint16_t ack = read<Os, block_data_t, uint16_t>( p );
+					uint32_t ack_bits = read<Os, block_data_t, uint32_t>( p + sizeof(uint16_t) );
+					process_ack( *peer, ack, ack_bits );
 				}
 			}
-//#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ins_r_r_mes %x- Exit with fail [%x].\n", radio().id(), _rrm.get_message_id(), mmm.get_message_id()  );
-//#endif
-			return 0;
 		}
 		// --------------------------------------------------------------------
-		uint8_t insert_reliable_radio_reply( ReliableRadioMessage _rrr )
+		/**
+		 * Retransmits or gives up all messages whose deadline expired and
+		 * sets the timer for the next deadline.
+		 */
+		void retransmit( void* _user_data = NULL )
 		{
-#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ReliableRadio - insert_reliable_radio_reply %x - Entering.\n", radio().id() );
-#endif
-			if ( reliable_radio_replies.max_size() > reliable_radio_replies.size() )
+			if ( status != RR_ACTIVE_STATUS )
 			{
-				reliable_radio_replies.push_back( _rrr );
-#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ReliableRadio - insert_reliable_radio_reply %x - Enough space to push back, Exiting with success.\n", radio().id() );
-#endif
-				return 1;
+				return;
+			}
+			if ( (uint8_t)(::size_t)_user_data == wakeup_generation )
+			{
+				wakeup_armed = 0;
 			}
-			for ( ReliableRadioReply_vector_iterator i = reliable_radio_replies.begin(); i != reliable_radio_replies.end(); ++i )
+			uint32_t t = now();
+			for ( uint8_t i = 0; i < RR_MAX_BUFFERED_MESSAGES; i++ )
 			{
-				if ( i->get_counter() >= max_retries )
+				ReliableRadioMessage& rrm = reliable_radio_messages[i];
+				if ( ( !rrm.get_used() ) || ( (int32_t)( rrm.get_deadline() - t ) > 0 ) )
+				{
+					continue;
+				}
+				Peer* peer = find_peer( rrm.get_destination(), 0 );
+				if ( peer == NULL )
+				{
+					rrm.set_used( 0 );
+				}
+				else if ( rrm.get_counter() >= max_retries )
 				{
 #ifdef DEBUG_RELIABLE_RADIO_H
-					debug().debug( "ReliableRadio - insert_reliable_radio_reply %x - Found an obsolete entry, replacing and exiting with success.\n", radio().id() );
+					debug().debug( "ReliableRadio - retransmit %x - Giving up [%d] to %x.\n", radio().id(), rrm.get_seq(), rrm.get_destination() );
 #endif
-					*i = _rrr;
-					return 1;
+					rrm.set_used( 0 );
+					peer->slot( rrm.get_seq() ) = Peer::NO_SLOT;
+					peer->advance();
+					for ( RegisteredCallbacks_vector_iterator j = callbacks.begin(); j != callbacks.end(); ++j )
+					{
+						ExData ex;
+						Message message;
+						message.set_message_id( RR_UNDELIVERED );
+						message.set_payload( rrm.get_payload_size(), rrm.get_payload() );
+						(*j)( rrm.get_destination(), message.serial_size(), message.serialize(), ex);
+					}
+				}
+				else
+				{
+					rrm.inc_counter();
+					retransmissions++;
+					if ( rrm.get_counter() > max_retries / 2 )
+					{
+						int old_db = radio().power().to_dB();
+						if ( old_db < -6 )
+						{
+							TxPower tp;
+							tp.set_dB( old_db + 6 );
+							radio().set_power( tp );
+						}
+						transmit( *peer, rrm );
+						TxPower tp;
+						tp.set_dB( old_db );
+						radio().set_power( tp );
+					}
+					else
+					{
+						transmit( *peer, rrm );
+					}
 				}
 			}
-//#ifdef DEBUG_RELIABLE_RADIO_H
-			debug().debug( "ins_r_rep %x - Exit fail [%x].\n", radio().id(), _rrr.get_message_id() );
-//#endif
-			return 0;
+			arm_retransmit();
 		}
 		// --------------------------------------------------------------------
-		uint8_t replies_check( uint32_t _msg_id, node_id_t _from )
+		/**
+		 * Sends the acks that could not be piggybacked within ack_delay.
+		 */
+		void flush_acks( void* _user_data = NULL )
 		{
-			for ( ReliableRadioReply_vector_iterator i = reliable_radio_replies.begin(); i != reliable_radio_replies.end(); ++i )
+			ack_armed = 0;
+			if ( status != RR_ACTIVE_STATUS )
 			{
-#ifdef DEBUG_RELIABLE_RADIO_H
-				if ( i->reply_internal_message_id_read() == 41 )
-				{
-					debug().debug( "Replies_check - checking in loop %x - Reply with [msg_id %d, dest %x] vs inc param [msg_id %d, dest %x]\n", radio().id(), i->get_message_id(), i->get_destination(), _msg_id, _from );
-				}
-#endif
-				i->reply_destination_read();
-#ifdef DEBUG_RELIABLE_RADIO_H
-				if ( i->reply_internal_message_id_read() == 41 )
-				{
-					debug().debug( "Replies_check - checking in loop %x - Reply with [msg_id %d, dest %x] vs inc param [msg_id %d, dest %x]\n", radio().id(), i->get_message_id(), i->get_destination(), _msg_id, _from );
-				}
-#endif
-				if ( ( i->get_message_id() == _msg_id ) && ( i->get_destination() == _from ) && ( i->get_delivered() == 0 ) )
+				return;
+			}
+			for ( uint8_t i = 0; i < RR_MAX_PEERS; i++ )
+			{
+				if ( peers[i].used && peers[i].ack_pending )
 				{
-#ifdef DEBUG_RELIABLE_RADIO_H
-					debug().debug( "Replies_check - checking in loop %d - Reply with [msg_id %d, dest %x, del %d] vs inc param [msg_id %d, dest %x ]\n", radio().id(), i->get_message_id(), i->get_destination(), i->get_delivered(), _msg_id, _from );
-#endif
-					return 1;
+					send_ack( peers[i] );
 				}
 			}
-			return 0;
 		}
 		// --------------------------------------------------------------------
 		template<class T, void(T::*TMethod)( node_id_t, size_t, block_data_t*, ExData const& ) >
@@ -567,8 +340,8 @@ namespace wiselib
         // --------------------------------------------------------------------
         size_t reserved_bytes()
         {
-        	ReliableRadioMessage rrm;
-        	return radio().reserved_bytes() + rrm.serial_size();
+        	Message message;
+        	return radio().reserved_bytes() + message.serial_size() + ReliableRadioMessage::header_size();
         };
 		// --------------------------------------------------------------------
 		uint8_t get_status()
@@ -581,6 +354,10 @@ namespace wiselib
 			status = _st;
 		}
 		// --------------------------------------------------------------------
+		/**
+		 * Retransmission timeout used for a neighbor until its round trip
+		 * time has been measured.
+		 */
 		millis_t get_daemon_period()
 		{
 			return daemon_period;
@@ -601,6 +378,43 @@ namespace wiselib
 			max_retries = _mr;
 		}
 		// --------------------------------------------------------------------
+		millis_t get_ack_delay()
+		{
+			return ack_delay;
+		}
+		// --------------------------------------------------------------------
+		void set_ack_delay( millis_t _ad )
+		{
+			ack_delay = _ad;
+		}
+		// --------------------------------------------------------------------
+		uint32_t get_retransmissions()
+		{
+			return retransmissions;
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Current retransmission timeout for _dest, 0 if there is no state.
+		 */
+		uint32_t get_rto( node_id_t _dest )
+		{
+			Peer* peer = find_peer( _dest, 0 );
+			return peer ? peer->rto : 0;
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Whether send() to _dest would currently find room in its window.
+		 */
+		uint8_t can_send( node_id_t _dest )
+		{
+			Peer* peer = find_peer( _dest, 0 );
+			if ( ( peer != NULL ) && ( peer->window_full() ) )
+			{
+				return 0;
+			}
+			return free_message() != Peer::NO_SLOT;
+		}
+		// --------------------------------------------------------------------
 		void init( Radio& _radio, Timer& _timer, Debug& _debug, Clock& _clock, Rand& _rand )
 		{
 			radio_ = &_radio;
@@ -691,14 +505,187 @@ namespace wiselib
         	NULL_NODE_ID = Radio::NULL_NODE_ID
         };
 	private:
+		// --------------------------------------------------------------------
+		uint32_t now()
+		{
+			time_t t = clock().time();
+			return clock().seconds( t ) * 1000 + clock().milliseconds( t );
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Sends rrm with the current ack state for its destination and sets
+		 * its deadline from the rto of the peer, doubled per retry up to
+		 * RR_MAX_BACKOFF times.
+		 */
+		void transmit( Peer& _peer, ReliableRadioMessage& _rrm )
+		{
+			uint8_t flags = 0;
+			if ( !_peer.synced )
+			{
+				flags = ReliableRadioMessage::RR_FLAG_SYN | ( (uint16_t)( _rrm.get_seq() - _peer.send_base ) << ReliableRadioMessage::RR_SYN_OFFSET_SHIFT );
+			}
+			if ( _peer.recv_synced )
+			{
+				flags |= ReliableRadioMessage::RR_FLAG_ACK;
+				_rrm.set_ack( _peer.recv_base, _peer.recv_bits );
+				_peer.ack_pending = 0;
+			}
+			_rrm.set_flags( flags );
+			// framed in the headroom of the stored message, nothing is copied
+			block_data_t* frame = Message::frame_in_place( RR_MESSAGE, _rrm.serial_size(), _rrm.serialize_in_place() );
+			LowerStack::send( radio(), _rrm.get_destination(), Message::HEADER_SIZE + _rrm.serial_size(), frame );
+
+			uint32_t t = now();
+			uint8_t backoff = _rrm.get_counter() < RR_MAX_BACKOFF ? _rrm.get_counter() : RR_MAX_BACKOFF;
+			uint32_t timeout = _peer.rto << backoff;
+			if ( timeout > RR_MAX_RTO )
+			{
+				timeout = RR_MAX_RTO;
+			}
+			_rrm.set_sent( t );
+			_rrm.set_deadline( t + timeout );
+			_peer.last_used = t;
+			arm_retransmit( t + timeout );
+		}
+		// --------------------------------------------------------------------
+		void send_ack( Peer& _peer )
+		{
+			block_data_t buff[LowerStack::HEADROOM + Message::HEADER_SIZE + sizeof(uint16_t) + sizeof(uint32_t)];
+			block_data_t* payload = buff + LowerStack::HEADROOM + Message::HEADER_SIZE;
+			uint16_t ack = _peer.recv_base;
+			uint32_t ack_bits = _peer.recv_bits;
+			write<Os, block_data_t, uint16_t>( payload, ack );
+			write<Os, block_data_t, uint32_t>( payload + sizeof(uint16_t), ack_bits );
+			block_data_t* frame = Message::frame_in_place( RR_REPLY, sizeof(uint16_t) + sizeof(uint32_t), payload );
+			LowerStack::send( radio(), _peer.id, Message::HEADER_SIZE + sizeof(uint16_t) + sizeof(uint32_t), frame );
+			_peer.ack_pending = 0;
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Releases every message of the window covered by the ack and
+		 * updates the rtt estimate from those that were sent only once.
+		 */
+		void process_ack( Peer& _peer, uint16_t _ack, uint32_t _ack_bits )
+		{
+			if ( !_peer.ack_valid( _ack ) )
+			{
+				return;
+			}
+			_peer.synced = 1;
+			uint32_t t = now();
+			for ( uint16_t s = _peer.send_base; s != _peer.next_seq; s++ )
+			{
+				uint8_t idx = _peer.slot( s );
+				if ( ( idx == Peer::NO_SLOT ) || ( !_peer.acked( s, _ack, _ack_bits ) ) )
+				{
+					continue;
+				}
+				ReliableRadioMessage& rrm = reliable_radio_messages[idx];
+				if ( rrm.get_counter() == 0 )
+				{
+					_peer.rtt_sample( t - rrm.get_sent(), RR_MIN_RTO, RR_MAX_RTO );
+				}
+				rrm.set_used( 0 );
+				_peer.slot( s ) = Peer::NO_SLOT;
+			}
+			_peer.advance();
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Makes sure the retransmission timer fires at _deadline or earlier.
+		 * Timers cannot be cancelled, so later ones that are no longer
+		 * needed just find nothing to do; they carry an old generation.
+		 */
+		void arm_retransmit( uint32_t _deadline )
+		{
+			if ( ( status != RR_ACTIVE_STATUS ) || ( wakeup_armed && ( (int32_t)( _deadline - wakeup ) >= 0 ) ) )
+			{
+				return;
+			}
+			wakeup = _deadline;
+			wakeup_armed = 1;
+			wakeup_generation++;
+			int32_t delay = (int32_t)( _deadline - now() );
+			timer().template set_timer<self_t, &self_t::retransmit>( delay > 0 ? delay : 1, this, (void*)(::size_t)wakeup_generation );
+		}
+		// --------------------------------------------------------------------
+		void arm_retransmit()
+		{
+			for ( uint8_t i = 0; i < RR_MAX_BUFFERED_MESSAGES; i++ )
+			{
+				if ( reliable_radio_messages[i].get_used() )
+				{
+					arm_retransmit( reliable_radio_messages[i].get_deadline() );
+				}
+			}
+		}
+		// --------------------------------------------------------------------
+		uint8_t free_message()
+		{
+			for ( uint8_t i = 0; i < RR_MAX_BUFFERED_MESSAGES; i++ )
+			{
+				if ( !reliable_radio_messages[i].get_used() )
+				{
+					return i;
+				}
+			}
+			return Peer::NO_SLOT;
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * State for _id. If there is none and _create is set, a free entry
+		 * or else the least recently used idle one is (re)initialized with
+		 * a random first sequence number; NULL if all peers are busy.
+		 */
+		Peer* find_peer( node_id_t _id, uint8_t _create )
+		{
+			Peer* free_peer = NULL;
+			Peer* victim = NULL;
+			for ( uint8_t i = 0; i < RR_MAX_PEERS; i++ )
+			{
+				Peer* p = &peers[i];
+				if ( !p->used )
+				{
+					if ( free_peer == NULL )
+					{
+						free_peer = p;
+					}
+				}
+				else if ( p->id == _id )
+				{
+					return p;
+				}
+				else if ( ( p->idle() ) && ( ( victim == NULL ) || ( (int32_t)( p->last_used - victim->last_used ) < 0 ) ) )
+				{
+					victim = p;
+				}
+			}
+			if ( !_create )
+			{
+				return NULL;
+			}
+			Peer* p = free_peer ? free_peer : victim;
+			if ( p != NULL )
+			{
+				p->init( _id, (uint16_t)rand()(), daemon_period );
+				p->last_used = now();
+			}
+			return p;
+		}
+		// --------------------------------------------------------------------
 		uint32_t recv_callback_id_;
         uint8_t status;
         millis_t daemon_period;
-        RegisteredCallbacks_vector callbacks;
-        ReliableRadioMessage_vector reliable_radio_messages;
-        ReliableRadioReply_vector reliable_radio_replies;
         uint32_t max_retries;
-        uint32_t seq;
+        millis_t ack_delay;
+        uint32_t retransmissions;
+        uint32_t wakeup;
+        uint8_t wakeup_armed;
+        uint8_t wakeup_generation;
+        uint8_t ack_armed;
+        RegisteredCallbacks_vector callbacks;
+        ReliableRadioMessage reliable_radio_messages[RR_MAX_BUFFERED_MESSAGES];
+        Peer peers[RR_MAX_PEERS];
         Radio * radio_;
         Clock * clock_;
         Timer * timer_;
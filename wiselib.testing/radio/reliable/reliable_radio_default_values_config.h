@@ -1,6 +1,31 @@
-#define RR_RESEND_DAEMON_PERIOD 300
+#ifndef RR_RESEND_DAEMON_PERIOD
+#define RR_RESEND_DAEMON_PERIOD 300	//initial retransmission timeout until the first rtt sample
+#endif
+#ifndef RR_MAX_REGISTERED_PROTOCOLS
 #define RR_MAX_REGISTERED_PROTOCOLS 2
+#endif
 //#define RR_MAX_BUFFERED_MESSAGES 200 shawn setting
-#define RR_MAX_BUFFERED_MESSAGES 10 //new concept to ensure throughput only depended on one vector size
-#define RR_MAX_BUFFERED_REPLIES 30  //reply buffer has to be x[retransmission_times+1] bigger than message buffer
+#ifndef RR_MAX_BUFFERED_MESSAGES
+#define RR_MAX_BUFFERED_MESSAGES 16	//shared by the send windows of all peers
+#endif
+#ifndef RR_MAX_PEERS
+#define RR_MAX_PEERS 8				//idle peers are replaced when the table is full
+#endif
+#ifndef RR_WINDOW_SIZE
+#define RR_WINDOW_SIZE 8			//unacknowledged messages per peer, power of two and at most 32
+#endif
+#ifndef RR_MAX_RETRIES
 #define RR_MAX_RETRIES 2			//documented in evernote for now
+#endif
+#ifndef RR_MIN_RTO
+#define RR_MIN_RTO 20
+#endif
+#ifndef RR_MAX_RTO
+#define RR_MAX_RTO 4000
+#endif
+#ifndef RR_MAX_BACKOFF
+#define RR_MAX_BACKOFF 2			//the timeout doubles for at most this many retries
+#endif
+#ifndef RR_ACK_DELAY
+#define RR_ACK_DELAY 10				//ms to wait for reverse traffic to piggyback an ack on, 0 acks at once
+#endif
@@ -5,27 +5,57 @@
 
 namespace wiselib
 {
+	/**
+	 * Data frame of the ReliableRadio and, while unacknowledged, the entry
+	 * kept for its retransmission. On the air it carries the sequence
+	 * number of the payload and the acknowledgement state of the sender for
+	 * the reverse direction (piggybacked ack): all sequence numbers before
+	 * ack were received, and bit i of ack_bits is set if ack + i was.
+	 * Counter, destination and the timing fields are local only.
+	 *
+	 * HEADROOM_P bytes are kept free in front of the header, so the frame
+	 * can be completed in place by serialize_in_place() and the radio
+	 * layers below (see RadioStackTraits) on every (re)transmission.
+	 */
 	template<	typename Os_P,
 				typename Radio_P,
-				typename Debug_P>
+				typename Debug_P,
+				int HEADROOM_P = 0>
 	class ReliableRadioMessage_Type
 	{
 	public:
 		typedef Os_P Os;
 		typedef Radio_P Radio;
 		typedef Debug_P Debug;
-		//typedef typename Radio::message_id_t message_id_t;
 		typedef typename Radio::block_data_t block_data_t;
 		typedef typename Radio::node_id_t node_id_t;
 		typedef typename Radio::size_t size_t;
-		typedef ReliableRadioMessage_Type<Os, Radio, Debug> self_t;
+		typedef ReliableRadioMessage_Type<Os, Radio, Debug, HEADROOM_P> self_t;
+		// --------------------------------------------------------------------
+		enum
+		{
+			HEADER_SIZE = sizeof(uint8_t) + 2 * sizeof(uint16_t) + sizeof(uint32_t),
+			PAYLOAD_POS = HEADROOM_P + HEADER_SIZE
+		};
+		// --------------------------------------------------------------------
+		enum flags
+		{
+			RR_FLAG_SYN = 0x01,		//sender has not seen an ack of this peer yet
+			RR_FLAG_ACK = 0x02,		//ack and ack_bits are valid
+			RR_SYN_OFFSET_SHIFT = 3	//upper bits: seq minus first unacked seq for SYN
+		};
 		// --------------------------------------------------------------------
 		ReliableRadioMessage_Type() :
-			message_id				( 0 ),
+			flags					( 0 ),
+			seq						( 0 ),
+			ack						( 0 ),
+			ack_bits				( 0 ),
 			counter					( 0 ),
 			payload_size			( 0 ),
 			destination				( 0 ),
-			delivered				( 0 )
+			sent					( 0 ),
+			deadline				( 0 ),
+			used					( 0 )
 		{};
 		// --------------------------------------------------------------------
 		~ReliableRadioMessage_Type()
@@ -33,34 +63,65 @@ namespace wiselib
 		// --------------------------------------------------------------------
 		self_t& operator=( const self_t& _rrm )
 		{
-			message_id = _rrm.message_id;
+			flags = _rrm.flags;
+			seq = _rrm.seq;
+			ack = _rrm.ack;
+			ack_bits = _rrm.ack_bits;
 			counter = _rrm.counter;
 			payload_size = _rrm.payload_size;
 			destination = _rrm.destination;
-			delivered = _rrm.delivered;
-			memcpy( payload, _rrm.payload, payload_size );
+			sent = _rrm.sent;
+			deadline = _rrm.deadline;
+			used = _rrm.used;
+			memcpy( buffer + PAYLOAD_POS, _rrm.buffer + PAYLOAD_POS, payload_size );
 			return *this;
 		}
 		// --------------------------------------------------------------------
-		uint32_t get_message_id()
+		uint8_t get_flags()
+		{
+			return flags;
+		}
+		// --------------------------------------------------------------------
+		void set_flags( uint8_t _f )
+		{
+			flags = _f;
+		}
+		// --------------------------------------------------------------------
+		uint16_t get_seq()
+		{
+			return seq;
+		}
+		// --------------------------------------------------------------------
+		void set_seq( uint16_t _seq )
 		{
-			return message_id;
+			seq = _seq;
 		}
 		// --------------------------------------------------------------------
-		void set_message_id( uint32_t _msg_id )
+		uint16_t get_ack()
 		{
-			message_id = _msg_id;
+			return ack;
+		}
+		// --------------------------------------------------------------------
+		uint32_t get_ack_bits()
+		{
+			return ack_bits;
+		}
+		// --------------------------------------------------------------------
+		void set_ack( uint16_t _ack, uint32_t _ack_bits )
+		{
+			ack = _ack;
+			ack_bits = _ack_bits;
 		}
 		// --------------------------------------------------------------------
 		void set_payload( size_t _len, block_data_t* _buff )
 		{
 			payload_size = _len;
-			memcpy( payload, _buff, _len );
+			memcpy( buffer + PAYLOAD_POS, _buff, _len );
 		}
 		// --------------------------------------------------------------------
 		block_data_t* get_payload()
 		{
-			return payload;
+			return buffer + PAYLOAD_POS;
 		}
 		// --------------------------------------------------------------------
 		size_t get_payload_size()
@@ -93,71 +154,88 @@ namespace wiselib
 			counter = _c;
 		}
 		// --------------------------------------------------------------------
-		void set_delivered()
+		uint32_t get_sent()
 		{
-			delivered = 1;
+			return sent;
 		}
 		// --------------------------------------------------------------------
-		uint8_t get_delivered()
+		void set_sent( uint32_t _t )
 		{
-			return delivered;
+			sent = _t;
 		}
 		// --------------------------------------------------------------------
-		void reply_destination_write() //caution! only use for reply storage!
+		uint32_t get_deadline()
 		{
-			write<Os, block_data_t, node_id_t>( payload, destination );
+			return deadline;
 		}
 		// --------------------------------------------------------------------
-		void reply_destination_read() //caution! only use for reply storage checks!
+		void set_deadline( uint32_t _t )
 		{
-			destination = read<Os, block_data_t, node_id_t>( payload );
+			deadline = _t;
 		}
-#ifdef DEBUG_RELIABLE_RADIO_H_DEEP_DEBUGS
 		// --------------------------------------------------------------------
-		void reply_internal_message_id_write( uint32_t _m) //caution! only use for reply storage debugging!
+		uint8_t get_used()
 		{
-			write<Os, block_data_t, uint32_t>( payload + sizeof(node_id_t), _m );
+			return used;
 		}
 		// --------------------------------------------------------------------
-		uint32_t reply_internal_message_id_read() //caution! only use for reply storage checks debugging!
+		void set_used( uint8_t _u )
 		{
-			uint32_t m = read<Os, block_data_t, uint32_t>( payload + sizeof(node_id_t) );
-			return m;
+			used = _u;
 		}
-#endif
 		// --------------------------------------------------------------------
 		block_data_t* serialize( block_data_t* _buff, size_t _offset = 0 )
 		{
-			size_t MSG_ID_POS = 0;
-			size_t COUNTER_POS = MSG_ID_POS + sizeof(uint32_t);
-			size_t DATA_LEN_POS = COUNTER_POS + sizeof(uint8_t);
-			size_t DATA_POS = DATA_LEN_POS + sizeof(size_t);
-			write<Os, block_data_t, uint32_t>( _buff + MSG_ID_POS + _offset,  message_id );
-			write<Os, block_data_t, uint8_t>( _buff + COUNTER_POS + _offset, counter );
-			write<Os, block_data_t, size_t>( _buff + DATA_LEN_POS + _offset, payload_size );
-			memcpy( _buff + DATA_POS + _offset, payload, payload_size );
+			size_t FLAGS_POS = 0;
+			size_t SEQ_POS = FLAGS_POS + sizeof(uint8_t);
+			size_t ACK_POS = SEQ_POS + sizeof(uint16_t);
+			size_t ACK_BITS_POS = ACK_POS + sizeof(uint16_t);
+			size_t DATA_POS = ACK_BITS_POS + sizeof(uint32_t);
+			write<Os, block_data_t, uint8_t>( _buff + FLAGS_POS + _offset, flags );
+			write<Os, block_data_t, uint16_t>( _buff + SEQ_POS + _offset, seq );
+			write<Os, block_data_t, uint16_t>( _buff + ACK_POS + _offset, ack );
+			write<Os, block_data_t, uint32_t>( _buff + ACK_BITS_POS + _offset, ack_bits );
+			memcpy( _buff + DATA_POS + _offset, buffer + PAYLOAD_POS, payload_size );
 			return _buff;
 		}
 		// --------------------------------------------------------------------
-		void de_serialize( block_data_t* _buff, size_t _offset = 0 )
+		/**
+		 * Writes the header in front of the stored payload, returns the
+		 * frame of serial_size() bytes.
+		 */
+		block_data_t* serialize_in_place()
+		{
+			block_data_t* frame = buffer + HEADROOM_P;
+			write<Os, block_data_t, uint8_t>( frame, flags );
+			write<Os, block_data_t, uint16_t>( frame + sizeof(uint8_t), seq );
+			write<Os, block_data_t, uint16_t>( frame + sizeof(uint8_t) + sizeof(uint16_t), ack );
+			write<Os, block_data_t, uint32_t>( frame + sizeof(uint8_t) + 2 * sizeof(uint16_t), ack_bits );
+			return frame;
+		}
+		// --------------------------------------------------------------------
+		void de_serialize( block_data_t* _buff, size_t _len, size_t _offset = 0 )
+		{
+			size_t FLAGS_POS = 0;
+			size_t SEQ_POS = FLAGS_POS + sizeof(uint8_t);
+			size_t ACK_POS = SEQ_POS + sizeof(uint16_t);
+			size_t ACK_BITS_POS = ACK_POS + sizeof(uint16_t);
+			size_t DATA_POS = ACK_BITS_POS + sizeof(uint32_t);
+			flags = read<Os, block_data_t, uint8_t>( _buff + FLAGS_POS + _offset );
+			seq = read<Os, block_data_t, uint16_t>( _buff + SEQ_POS + _offset );
+			ack = read<Os, block_data_t, uint16_t>( _buff + ACK_POS + _offset );
+			ack_bits = read<Os, block_data_t, uint32_t>( _buff + ACK_BITS_POS + _offset );
+			payload_size = _len > DATA_POS ? _len - DATA_POS : 0;
+			memcpy( buffer + PAYLOAD_POS, _buff + DATA_POS + _offset, payload_size );
+		}
+		// --------------------------------------------------------------------
+		static size_t header_size()
 		{
-			size_t MSG_ID_POS = 0;
-			size_t COUNTER_POS = MSG_ID_POS + sizeof(uint32_t);
-			size_t DATA_LEN_POS = COUNTER_POS + sizeof(uint8_t);
-			size_t DATA_POS = DATA_LEN_POS + sizeof(size_t);
-			message_id = read<Os, block_data_t, uint32_t>( _buff + MSG_ID_POS + _offset );
-			counter = read<Os, block_data_t, uint8_t>( _buff + COUNTER_POS + _offset );
-			payload_size = read<Os, block_data_t, size_t>( _buff + DATA_LEN_POS + _offset );
-			memcpy( payload, _buff + DATA_POS + _offset, payload_size );
+			return HEADER_SIZE;
 		}
 		// --------------------------------------------------------------------
 		size_t serial_size()
 		{
-			size_t MSG_ID_POS = 0;
-			size_t COUNTER_POS = MSG_ID_POS + sizeof(uint32_t);
-			size_t DATA_LEN_POS = COUNTER_POS + sizeof(uint8_t);
-			size_t DATA_POS = DATA_LEN_POS + sizeof(size_t);
-			return DATA_POS + payload_size;
+			return header_size() + payload_size;
 		}
 		// --------------------------------------------------------------------
 #ifdef DEBUG_RELIABLE_RADIO_H
@@ -165,27 +243,35 @@ namespace wiselib
 		{
 			_debug.debug( "-------------------------------------------------------\n");
 			_debug.debug( "ReliableRadioMessage : \n" );
-			_debug.debug( "message_id (size %i) : %d\n", sizeof(uint32_t), message_id );
-			_debug.debug( "counter (size %i) : %d\n", sizeof(uint32_t), counter );
-			_debug.debug( "destination (size %i) : %d\n", sizeof(node_id_t), destination );
-			_debug.debug( "payload_size (size %i) : %d\n", sizeof(size_t), payload_size );
-			_debug.debug( "delivered (size %i) : %d\n", sizeof(uint8_t), delivered );
+			_debug.debug( "flags (size %i) : %d\n", sizeof(uint8_t), flags );
+			_debug.debug( "seq (size %i) : %d\n", sizeof(uint16_t), seq );
+			_debug.debug( "ack (size %i) : %d\n", sizeof(uint16_t), ack );
+			_debug.debug( "ack_bits (size %i) : %x\n", sizeof(uint32_t), ack_bits );
+			_debug.debug( "counter : %d\n", counter );
+			_debug.debug( "destination : %d\n", destination );
+			_debug.debug( "deadline : %d\n", deadline );
+			_debug.debug( "payload_size : %d\n", payload_size );
 			_debug.debug( "payload: \n");
 			for ( size_t i = 0; i < payload_size; i++ )
 			{
-				_debug.debug("%d", payload[i] );
+				_debug.debug("%d", buffer[PAYLOAD_POS + i] );
 			}
 			_debug.debug( "-------------------------------------------------------\n");
 		}
 #endif
 		// --------------------------------------------------------------------
 	private:
-		uint32_t message_id;
+		uint8_t flags;
+		uint16_t seq;
+		uint16_t ack;
+		uint32_t ack_bits;
 		uint8_t counter;
-		block_data_t payload[Radio::MAX_MESSAGE_LENGTH];
+		block_data_t buffer[PAYLOAD_POS + Radio::MAX_MESSAGE_LENGTH];
 		size_t payload_size;
 		node_id_t destination;
-		uint8_t delivered;
+		uint32_t sent;
+		uint32_t deadline;
+		uint8_t used;
     };
 }
 #endif
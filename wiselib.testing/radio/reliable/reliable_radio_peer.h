@@ -0,0 +1,214 @@
+#ifndef __RELIABLE_RADIO_PEER_H__
+#define	__RELIABLE_RADIO_PEER_H__
+
+#include "reliable_radio_source_config.h"
+#include "reliable_radio_default_values_config.h"
+
+namespace wiselib
+{
+	/**
+	 * Per neighbor state of the ReliableRadio, for both directions.
+	 *
+	 * Sending: sequence numbers [send_base, next_seq) are in flight, at most
+	 * RR_WINDOW_SIZE of them. slots maps seq % RR_WINDOW_SIZE to the index of
+	 * the buffered message, so an acknowledgement is matched in O(window)
+	 * without searching the message buffer. The retransmission timeout is
+	 * estimated from the round trip times of messages acknowledged without
+	 * retransmission (Jacobson/Karels, Karn).
+	 *
+	 * Receiving: all sequence numbers before recv_base were received, bit i
+	 * of recv_bits is set if recv_base + i was. This is what is sent back as
+	 * cumulative ack plus bitmap and what filters duplicates.
+	 */
+	template<	typename Os_P,
+				typename Radio_P,
+				typename Debug_P>
+	class ReliableRadioPeer_Type
+	{
+	public:
+		typedef Os_P Os;
+		typedef Radio_P Radio;
+		typedef Debug_P Debug;
+		typedef typename Radio::node_id_t node_id_t;
+		typedef ReliableRadioPeer_Type<Os, Radio, Debug> self_t;
+		// --------------------------------------------------------------------
+		enum
+		{
+			WINDOW = RR_WINDOW_SIZE,
+			NO_SLOT = 0xff,
+			HALF_RANGE = 0x8000
+		};
+		// --------------------------------------------------------------------
+		ReliableRadioPeer_Type() :
+			id						( Radio::NULL_NODE_ID ),
+			used					( 0 )
+		{};
+		// --------------------------------------------------------------------
+		void init( node_id_t _id, uint16_t _first_seq, uint32_t _initial_rto )
+		{
+			id = _id;
+			used = 1;
+			next_seq = _first_seq;
+			send_base = _first_seq;
+			synced = 0;
+			recv_base = 0;
+			recv_bits = 0;
+			recv_synced = 0;
+			ack_pending = 0;
+			srtt = 0;
+			rttvar = 0;
+			rto = _initial_rto;
+			for ( uint8_t i = 0; i < WINDOW; i++ )
+			{
+				slots[i] = NO_SLOT;
+			}
+		}
+		// --------------------------------------------------------------------
+		uint8_t window_full()
+		{
+			return (uint16_t)( next_seq - send_base ) >= WINDOW;
+		}
+		// --------------------------------------------------------------------
+		uint8_t idle()
+		{
+			return ( next_seq == send_base ) && !ack_pending;
+		}
+		// --------------------------------------------------------------------
+		uint8_t& slot( uint16_t _seq )
+		{
+			return slots[_seq % WINDOW];
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Moves send_base past all acknowledged or abandoned messages.
+		 */
+		void advance()
+		{
+			while ( ( send_base != next_seq ) && ( slot( send_base ) == NO_SLOT ) )
+			{
+				send_base++;
+			}
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Cumulative acks outside [send_base, next_seq] do not belong to
+		 * this session, except those up to 32 behind send_base: after a
+		 * message was given up the receiver keeps acking its sequence
+		 * number until the window moved 32 past it, and the bitmap of
+		 * such an ack still covers the window.
+		 */
+		uint8_t ack_valid( uint16_t _ack )
+		{
+			return ( (uint16_t)( _ack - send_base ) <= (uint16_t)( next_seq - send_base ) )
+				|| ( (uint16_t)( send_base - _ack ) < 32 );
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Whether the valid acknowledgement (_ack, _bits) covers _seq,
+		 * which is at or after send_base.
+		 */
+		uint8_t acked( uint16_t _seq, uint16_t _ack, uint32_t _bits )
+		{
+			uint16_t d = _seq - _ack;
+			if ( d >= HALF_RANGE )
+			{
+				return 1;
+			}
+			return ( d < 32 ) && ( _bits & ( (uint32_t)1 << d ) );
+		}
+		// --------------------------------------------------------------------
+		/**
+		 * Records reception of _seq, returns 1 if it is new. SYN frames tell
+		 * how far _seq is from the first unacknowledged message of the
+		 * sender (_offset), which starts the window on first contact. A SYN
+		 * frame far behind the window means the sender started a new
+		 * session.
+		 */
+		uint8_t accept( uint16_t _seq, uint8_t _syn, uint8_t _offset )
+		{
+			uint16_t d = _seq - recv_base;
+			if ( ( !recv_synced && _syn ) || ( _syn && ( d >= HALF_RANGE ) && ( (uint16_t)( recv_base - _seq ) > 32 ) ) )
+			{
+				recv_base = _seq - _offset;
+				recv_bits = 0;
+				recv_synced = 1;
+				d = _offset;
+			}
+			else if ( !recv_synced )
+			{
+				recv_base = _seq;
+				recv_bits = 0;
+				recv_synced = 1;
+				d = 0;
+			}
+			if ( d >= HALF_RANGE )
+			{
+				return 0;
+			}
+			if ( d >= 32 )
+			{
+				//everything that far behind was given up by the sender
+				uint16_t shift = d - 31;
+				recv_bits = shift < 32 ? recv_bits >> shift : 0;
+				recv_base += shift;
+				d = 31;
+			}
+			if ( recv_bits & ( (uint32_t)1 << d ) )
+			{
+				return 0;
+			}
+			recv_bits |= (uint32_t)1 << d;
+			while ( recv_bits & 1 )
+			{
+				recv_bits >>= 1;
+				recv_base++;
+			}
+			return 1;
+		}
+		// --------------------------------------------------------------------
+		void rtt_sample( uint32_t _r, uint32_t _min_rto, uint32_t _max_rto )
+		{
+			//srtt is scaled by 8, rttvar by 4
+			if ( srtt == 0 )
+			{
+				srtt = ( _r << 3 ) + 1;
+				rttvar = _r << 1;
+			}
+			else
+			{
+				int32_t delta = (int32_t)_r - (int32_t)( srtt >> 3 );
+				srtt = (uint32_t)( (int32_t)srtt + delta );
+				if ( delta < 0 )
+				{
+					delta = -delta;
+				}
+				rttvar = (uint32_t)( (int32_t)rttvar + delta - (int32_t)( rttvar >> 2 ) );
+			}
+			rto = ( srtt >> 3 ) + rttvar;
+			if ( rto < _min_rto )
+			{
+				rto = _min_rto;
+			}
+			if ( rto > _max_rto )
+			{
+				rto = _max_rto;
+			}
+		}
+		// --------------------------------------------------------------------
+		node_id_t id;
+		uint8_t used;
+		uint8_t synced;
+		uint8_t recv_synced;
+		uint8_t ack_pending;
+		uint16_t next_seq;
+		uint16_t send_base;
+		uint16_t recv_base;
+		uint32_t recv_bits;
+		uint32_t srtt;
+		uint32_t rttvar;
+		uint32_t rto;
+		uint32_t last_used;
+		uint8_t slots[RR_WINDOW_SIZE];
+	};
+}
+#endif
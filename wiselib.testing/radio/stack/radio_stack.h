@@ -0,0 +1,123 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __RADIO_STACK_RADIO_STACK_H__
+#define __RADIO_STACK_RADIO_STACK_H__
+
+namespace wiselib
+{
+
+   /** \brief Implementation detail of RadioStackTraits: a radio that is
+    *  no stack layer has no headroom and gets the payload by send().
+    */
+   template<typename Radio_P, bool IN_PLACE>
+   struct RadioStackLayer
+   {
+      enum { HEADROOM = 0 };
+
+      static int send( Radio_P& radio, typename Radio_P::node_id_t dest,
+            typename Radio_P::size_t len, typename Radio_P::block_data_t *data )
+      {
+         return radio.send( dest, len, data );
+      }
+   };
+   // -----------------------------------------------------------------------
+   template<typename Radio_P>
+   struct RadioStackLayer<Radio_P, true>
+   {
+      enum { HEADROOM = Radio_P::HEADROOM };
+
+      static int send( Radio_P& radio, typename Radio_P::node_id_t dest,
+            typename Radio_P::size_t len, typename Radio_P::block_data_t *data )
+      {
+         return radio.send_in_place( dest, len, data );
+      }
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Compile time view of a stack of radio decorators.
+    *
+    *  A decorator that prepends a header takes part in in-place framing by
+    *  declaring
+    *
+    *  - typedef ... radio_stack_layer_t;
+    *  - enum { HEADROOM }: its own header plus the HEADROOM of the radio
+    *    below it (RadioStackTraits<Radio>::HEADROOM), and
+    *  - int send_in_place( node_id_t, size_t, block_data_t* data ): like
+    *    send(), but the HEADROOM bytes in front of data belong to the
+    *    call, so the layer writes its header right in front of data and
+    *    passes the frame on the same way instead of copying the payload.
+    *    The payload itself is left intact.
+    *
+    *  Since every layer adds the headroom of the layer below, the type of
+    *  the top of a stack knows the headroom of the whole stack. Plain
+    *  radios count as layers without headroom that are sent to by send().
+    */
+   template<typename Radio_P>
+   class RadioStackTraits
+   {
+      struct yes { char c[2]; };
+      template<typename T> static yes test( typename T::radio_stack_layer_t* );
+      template<typename T> static char test( ... );
+
+   public:
+      enum { IN_PLACE = sizeof( test<Radio_P>( 0 ) ) == sizeof( yes ) };
+
+      typedef RadioStackLayer<Radio_P, IN_PLACE> layer_t;
+
+      enum { HEADROOM = layer_t::HEADROOM };
+      // --------------------------------------------------------------------
+      /** Sends len bytes at data, which has HEADROOM writable bytes in
+       *  front of it.
+       */
+      static int send( Radio_P& radio, typename Radio_P::node_id_t dest,
+            typename Radio_P::size_t len, typename Radio_P::block_data_t *data )
+      {
+         return layer_t::send( radio, dest, len, data );
+      }
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Send buffer of an application on top of a radio stack.
+    *
+    *  The application writes its payload to payload() and send() hands it
+    *  down the stack, every layer framing it in place.
+    */
+   template<typename Radio_P,
+            int MAX_PAYLOAD = Radio_P::MAX_MESSAGE_LENGTH>
+   class RadioStackBuffer
+   {
+   public:
+      typedef Radio_P Radio;
+      typedef RadioStackTraits<Radio> Traits;
+      typedef typename Radio::node_id_t node_id_t;
+      typedef typename Radio::size_t size_t;
+      typedef typename Radio::block_data_t block_data_t;
+
+      enum { HEADROOM = Traits::HEADROOM };
+      // --------------------------------------------------------------------
+      block_data_t* payload()
+      { return buffer_ + HEADROOM; }
+      // --------------------------------------------------------------------
+      int send( Radio& radio, node_id_t dest, size_t len )
+      { return Traits::send( radio, dest, len, payload() ); }
+
+   private:
+      block_data_t buffer_[HEADROOM + MAX_PAYLOAD];
+   };
+
+}
+#endif
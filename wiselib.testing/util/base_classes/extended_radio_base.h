@@ -32,7 +32,8 @@ namespace wiselib
     *  \ingroup routing_concept
     *
     *  Basic extended radio class that provides helpful methods like registration of
-    *  callbacks.
+    *  callbacks. Extended receivers can be restricted to one message id as
+    *  in RadioBase.
     */
    template<typename OsModel_P,
             typename NodeId_P,
@@ -52,14 +53,13 @@ namespace wiselib
       typedef Size_P size_t;
       typedef BlockData_P block_data_t;
 
+      typedef RadioBase<OsModel_P, NodeId_P, Size_P, BlockData_P, MAX_RECEIVERS> base_type;
+      typedef typename base_type::Frame Frame;
+
       typedef delegate3<void, node_id_t, size_t, block_data_t*> radio_delegate_t;
       typedef delegate4<void, node_id_t, size_t, block_data_t*, const ExtendedData&> extended_radio_delegate_t;
 
-      typedef vector_static<OsModel, radio_delegate_t, MAX_RECEIVERS> CallbackVector;
-      typedef typename CallbackVector::iterator CallbackVectorIterator;
-
-      typedef vector_static<OsModel, extended_radio_delegate_t, MAX_RECEIVERS> ExtendedCallbackVector;
-      typedef typename ExtendedCallbackVector::iterator ExtendedCallbackVectorIterator;
+      typedef ReceiverDispatchTable<MAX_RECEIVERS> DispatchTable;
 
       // --------------------------------------------------------------------
       enum ReturnValues
@@ -67,61 +67,98 @@ namespace wiselib
          SUCCESS = OsModel::SUCCESS
       };
       // --------------------------------------------------------------------
+      enum MessageIds
+      {
+         ANY_MESSAGE_ID = DispatchTable::ANY_MESSAGE_ID ///< Receiver gets every frame
+      };
+      // --------------------------------------------------------------------
       template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*)>
       int reg_recv_callback( T *obj_pnt )
       {
-    	  return RadioBase<OsModel_P, NodeId_P, Size_P, BlockData_P, MAX_RECEIVERS>::template reg_recv_callback<T, TMethod>( obj_pnt );
+    	  return base_type::template reg_recv_callback<T, TMethod>( obj_pnt );
+      }
+      // --------------------------------------------------------------------
+      template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*)>
+      int reg_recv_callback( T *obj_pnt, int message_id )
+      {
+    	  return base_type::template reg_recv_callback<T, TMethod>( obj_pnt, message_id );
       }
       // --------------------------------------------------------------------
       template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*, const ExtendedData&)>
       int reg_recv_callback( T *obj_pnt )
       {
-         if ( extended_callbacks_.empty() )
-        	 extended_callbacks_.assign( MAX_RECEIVERS, extended_radio_delegate_t() );
-
-         for ( unsigned int i = 0; i < extended_callbacks_.size(); ++i )
-         {
-            if ( extended_callbacks_.at(i) == extended_radio_delegate_t() )
-            {
-               extended_callbacks_.at(i) = extended_radio_delegate_t::template from_method<T, TMethod>( obj_pnt );
-               return MAX_RECEIVERS+i;
-            }
-         }
+         return reg_recv_callback<T, TMethod>( obj_pnt, ANY_MESSAGE_ID );
+      }
+      // --------------------------------------------------------------------
+      /** Registers an extended receiver for the frames starting with
+       *  message_id only.
+       */
+      template<class T, void (T::*TMethod)(node_id_t, size_t, block_data_t*, const ExtendedData&)>
+      int reg_recv_callback( T *obj_pnt, int message_id )
+      {
+         int idx = extended_table_.insert( message_id );
+         if ( idx < 0 )
+            return -1;
 
-         return -1;
+         extended_callbacks_[idx] = extended_radio_delegate_t::template from_method<T, TMethod>( obj_pnt );
+         return MAX_RECEIVERS+idx;
       }
       // --------------------------------------------------------------------
       int unreg_recv_callback( int idx )
       {
     	  if( idx < MAX_RECEIVERS )
-    		  return RadioBase<OsModel_P, NodeId_P, Size_P, BlockData_P, MAX_RECEIVERS>::unreg_recv_callback( idx );
-    	  else
-    		  extended_callbacks_.at( idx - MAX_RECEIVERS ) = extended_radio_delegate_t();
+    		  return base_type::unreg_recv_callback( idx );
 
+         extended_callbacks_[idx - MAX_RECEIVERS] = extended_radio_delegate_t();
+         extended_table_.remove( idx - MAX_RECEIVERS );
          return SUCCESS;
       }
       // --------------------------------------------------------------------
       void notify_receivers( node_id_t from, size_t len, block_data_t *data )
       {
-    	  RadioBase<OsModel_P, NodeId_P, Size_P, BlockData_P, MAX_RECEIVERS>::notify_receivers( from, len, data );
+    	  base_type::notify_receivers( from, len, data );
+      }
+      // --------------------------------------------------------------------
+      void notify_receivers( const Frame *frames, size_t count )
+      {
+    	  base_type::notify_receivers( frames, count );
       }
       // --------------------------------------------------------------------
       void notify_receivers( node_id_t from, size_t len, block_data_t *data, const ExtendedData& ext_data )
       {
     	 notify_receivers( from, len, data );
 
-         for ( ExtendedCallbackVectorIterator
-                  it = extended_callbacks_.begin();
-                  it != extended_callbacks_.end();
-                  ++it )
-         {
-            if ( *it != extended_radio_delegate_t() )
-               (*it)( from, len, data, ext_data );
-         }
+         Frame frame;
+         frame.from = from;
+         frame.len = len;
+         frame.data = data;
+         Delivery delivery( extended_callbacks_, frame, ext_data );
+         extended_table_.lock();
+         extended_table_.dispatch( len ? data[0] : -1, delivery );
+         extended_table_.unlock();
       }
 
    private:
-      ExtendedCallbackVector extended_callbacks_;
+      struct Delivery
+      {
+         Delivery( extended_radio_delegate_t *cbs, const Frame& f, const ExtendedData& ex )
+            : callbacks( cbs ), frame( f ), ext_data( ex )
+         {}
+
+         void operator()( uint8_t slot )
+         {
+            // a receiver may have unregistered another one meanwhile
+            if ( callbacks[slot] )
+               callbacks[slot]( frame.from, frame.len, frame.data, ext_data );
+         }
+
+         extended_radio_delegate_t *callbacks;
+         const Frame& frame;
+         const ExtendedData& ext_data;
+      };
+      // --------------------------------------------------------------------
+      extended_radio_delegate_t extended_callbacks_[MAX_RECEIVERS];
+      DispatchTable extended_table_;
    };
 
 }
@@ -3,6 +3,7 @@
 #define BROKER_H
 
 #include <util/pstl/int_dictionary.h>
+#include <util/meta.h>
 
 namespace wiselib {
 	
@@ -123,6 +124,10 @@ namespace wiselib {
 				return bitmask_ < other.bitmask_;
 			}
 			
+			bool operator==(const self_type& other) const {
+				return !(*this < other) && !(other < *this);
+			}
+			
 			static int compare(int col, ::uint8_t *a, int alen, ::uint8_t *b, int blen) {
 				if(col == COL_BITMASK) {
 					bitmask_t bm_a, bm_b;
@@ -147,6 +152,35 @@ namespace wiselib {
 	};
 	
 	
+	template<typename OsModel_P, typename Value_P> class list_dynamic;
+	template<typename OsModel_P, typename Value_P, int ListSize_P> class list_static;
+	template<typename OsModel_P, typename Value_P, int SetSize_P> class set_static;
+	template<typename OsModel_P, typename Value_P> class vector_dynamic_set;
+	template<typename Container_P> class UniqueContainer;
+	
+	/**
+	 * Whether the elements of a tuple container can be changed through
+	 * its iterators, i.e. it neither orders nor hashes them. The pstl
+	 * lists and sets are plain sequences.
+	 */
+	template<typename Container_P>
+	struct ContainerUpdatableInPlace { enum { value = false }; };
+	
+	template<typename OsModel_P, typename Value_P>
+	struct ContainerUpdatableInPlace< list_dynamic<OsModel_P, Value_P> > { enum { value = true }; };
+	
+	template<typename OsModel_P, typename Value_P, int ListSize_P>
+	struct ContainerUpdatableInPlace< list_static<OsModel_P, Value_P, ListSize_P> > { enum { value = true }; };
+	
+	template<typename OsModel_P, typename Value_P, int SetSize_P>
+	struct ContainerUpdatableInPlace< set_static<OsModel_P, Value_P, SetSize_P> > { enum { value = true }; };
+	
+	template<typename OsModel_P, typename Value_P>
+	struct ContainerUpdatableInPlace< vector_dynamic_set<OsModel_P, Value_P> > { enum { value = true }; };
+	
+	template<typename Container_P>
+	struct ContainerUpdatableInPlace< UniqueContainer<Container_P> > : public ContainerUpdatableInPlace<Container_P> { };
+	
 	/**
 	 * TupleStore_P must:
 	 * - use BrokerTuple as tupletype
@@ -179,9 +213,13 @@ namespace wiselib {
 			typedef IntDictionary<OsModel, document_name_t, 8 * sizeof(bitmask_t)> NameDictionary;
 			
 			typedef delegate1<void, document_name_t> subscription_callback_t;
-			typedef IntDictionary<OsModel, subscription_callback_t, 10> Subscriptions;
+			enum { MAX_SUBSCRIPTIONS = 10 };
+			typedef IntDictionary<OsModel, subscription_callback_t, MAX_SUBSCRIPTIONS> Subscriptions;
+			/// One bit per subscription id.
+			typedef ::uint16_t subscription_mask_t;
 			
 			enum { MASK_ALL = (bitmask_t)(-1) };
+			enum { MAX_DOCUMENTS = 8 * sizeof(bitmask_t) };
 			enum { STRINGS = Tuple::STRINGS };
 			enum { COLUMNS = Tuple::SIZE };
 			
@@ -195,19 +233,61 @@ namespace wiselib {
 			typedef typename TupleStore::iterator iterator;
 			typedef typename CompressedTupleStore::iterator compressed_iterator;
 			
+			Broker() : batch_depth_(0), pending_changes_(0) {
+				for(size_type i=0; i<MAX_DOCUMENTS; i++) {
+					document_subscribers_[i] = 0;
+				}
+			}
+			
 			void init(typename Os::Debug::self_pointer_t debug) {
 				tuple_store_.init(debug);
 			}
 			
+			/**
+			 * Subscribe to changes of the documents in \p documents
+			 * (default: all documents, including ones created later).
+			 * The callback is only invoked for documents it subscribed to.
+			 * Returns -1 if no more subscriptions can be registered.
+			 */
 			template<class T, void (T::*TMethod)(document_name_t)>
-			subscription_id_t subscribe(T *obj_pnt) {
-				return subscriptions_.insert(subscription_callback_t::template from_method<T, TMethod>(obj_pnt));
+			subscription_id_t subscribe(T *obj_pnt, bitmask_t documents = MASK_ALL) {
+				typename Subscriptions::key_type id = subscriptions_.insert(subscription_callback_t::template from_method<T, TMethod>(obj_pnt));
+				if(id == Subscriptions::NULL_KEY) { return -1; }
+				
+				for(size_type i=0; i<MAX_DOCUMENTS; i++) {
+					if(documents & id_to_bitmask(i)) {
+						document_subscribers_[i] |= (subscription_mask_t)(1 << id);
+					}
+				}
+				return id;
 			}
 			
 			void unsubscribe(subscription_id_t id) {
+				for(size_type i=0; i<MAX_DOCUMENTS; i++) {
+					document_subscribers_[i] &= (subscription_mask_t)~(1 << id);
+				}
 				subscriptions_.erase(id);
 			}
 			
+			/**
+			 * Start collecting change notifications instead of delivering
+			 * them per inserted tuple. Calls may be nested, the collected
+			 * notifications are delivered (once per changed document) by
+			 * the outermost end_changes().
+			 */
+			void begin_changes() {
+				batch_depth_++;
+			}
+			
+			void end_changes() {
+				if(batch_depth_ == 0) { return; }
+				if(--batch_depth_ == 0 && pending_changes_) {
+					bitmask_t changed = pending_changes_;
+					pending_changes_ = 0;
+					notify_subscribers(changed);
+				}
+			}
+			
 			bitmask_t create_document(document_name_t name) {
 				size_t l = strlen(name) + 1;
 				char *name_copy = get_allocator().allocate_array<char>(l) .raw();
@@ -304,23 +384,74 @@ namespace wiselib {
 			CompressedTupleStore& compressed_tuple_store() { return tuple_store_.parent_tuple_store(); }
 			
 			void document_has_changed(bitmask_t mask) {
-				document_name_t docname = get_document_name(mask);
-				for(typename Subscriptions::iterator iter = subscriptions_.begin(); iter != subscriptions_.end(); ++iter) {
-					(*iter)(docname);
+				if(batch_depth_) {
+					pending_changes_ |= mask;
+				}
+				else {
+					notify_subscribers(mask);
 				}
 			}
 			
+			/**
+			 * Remove all tuples of the given document(s). Tuples that also
+			 * belong to other documents stay with the remaining bitmask.
+			 * 
+			 * If the container neither orders nor hashes its tuples
+			 * (ContainerUpdatableInPlace) this is a single pass that
+			 * updates their bitmask in place, otherwise they are erased
+			 * and inserted again.
+			 */
 			void erase_document(bitmask_t mask) {
+				erase_document_tuples<typename CompressedTupleStore::TupleContainer>(mask);
+			}
+			
+			NameDictionary& getDictionary(){
+				return name_dictionary_;
+			}
+		private:
+			
+			template<typename TupleContainer>
+			typename enable_if_c<ContainerUpdatableInPlace<TupleContainer>::value, void>::type
+			erase_document_tuples(bitmask_t mask) {
+				typedef typename CompressedTupleStore::ContainerIterator ContainerIterator;
+				
 				compressed_iterator iter = begin_compressed_document(mask);
 				
 				while(iter != end_compressed_document(mask)) {
-					//if(!(iter->bitmask() & mask)) { continue; }
+					ContainerIterator ci = iter.container_iterator();
+					bitmask_t remaining = ci->bitmask() & ~mask;
 					
+					// does this tuple belong to other documents?
+					if(remaining) {
+						// yes -> drop the erased documents from its bitmask,
+						// unless an otherwise identical tuple already carries
+						// exactly the remaining documents (then this one is
+						// redundant and can go)
+						CompressedTuple probe = *ci;
+						probe.set_bitmask(remaining);
+						if(compressed_tuple_store().container().find(probe) == compressed_tuple_store().container().end()) {
+							ci->set_bitmask(remaining);
+							++iter;
+							continue;
+						}
+					}
+					
+					// no -> just remove it :)
+					iter = compressed_tuple_store().erase(iter);
+				}
+			}
+			
+			template<typename TupleContainer>
+			typename enable_if_c<!ContainerUpdatableInPlace<TupleContainer>::value, void>::type
+			erase_document_tuples(bitmask_t mask) {
+				compressed_iterator iter = begin_compressed_document(mask);
+				
+				while(iter != end_compressed_document(mask)) {
 					// does this tuple belong to other documents?
 					if(iter->bitmask() & ~mask) {
 						// yes -> copy tuple, remove original, re-insert with
 						// altered bitmask
-						Tuple t;
+						CompressedTuple t;
 						for(size_type i=0; i<COLUMNS; i++) {
 							t.set_deep(i, iter->get(i));
 						}
@@ -337,12 +468,26 @@ namespace wiselib {
 				}
 			}
 			
-			NameDictionary& getDictionary(){
-				return name_dictionary_;
+			/**
+			 * Invoke every subscriber of a document in \p mask once for
+			 * that document. A callback may unsubscribe (itself or
+			 * others), so each subscription is looked up again right
+			 * before it is called.
+			 */
+			void notify_subscribers(bitmask_t mask) {
+				for(size_type i=0; i<MAX_DOCUMENTS; i++) {
+					if(!(mask & id_to_bitmask(i)) || !document_subscribers_[i]) { continue; }
+					
+					document_name_t docname = name_dictionary_.get(i);
+					for(size_type s=0; s<MAX_SUBSCRIPTIONS; s++) {
+						if(document_subscribers_[i] & (subscription_mask_t)(1 << s)) {
+							subscriptions_.get(s)(docname);
+						}
+					}
+				}
 			}
-		private:
 			
-			static bitmask_t id_to_bitmask(typename NameDictionary::key_type k) { return 1 << k; }
+			static bitmask_t id_to_bitmask(typename NameDictionary::key_type k) { return (bitmask_t)1 << k; }
 			static typename NameDictionary::key_type bitmask_to_id(bitmask_t b) {
 				typename NameDictionary::key_type r = 0;
 				while(b >>= 1) { r++; }
@@ -353,6 +498,10 @@ namespace wiselib {
 			
 			NameDictionary name_dictionary_;
 			Subscriptions subscriptions_;
+			/// For each document id the subscriptions interested in it.
+			subscription_mask_t document_subscribers_[MAX_DOCUMENTS];
+			size_type batch_depth_;
+			bitmask_t pending_changes_;
 	};
 }
 
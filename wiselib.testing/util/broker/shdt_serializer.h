@@ -3,9 +3,36 @@
 #define SHDT_SERIALIZER_H
 
 #include <util/meta.h>
+#include <util/delegates/delegate.hpp>
+#include <util/serialization/serialization.h>
 
 namespace wiselib {
 	
+	/**
+	 * Streamed Header Dictionary Transfer (SHDT) serializer.
+	 *
+	 * Wire format: A stream of table ids (table_id_t). A regular table id
+	 * refers to a string in the lookup table, TUPLE_SIZE of them form a
+	 * tuple. The special id nidx introduces a command:
+	 *
+	 * nidx CMD_INSERT pos string\\0
+	 * nidx CMD_INSERT_BATCH count (pos string\\0){count}
+	 * nidx CMD_END
+	 *
+	 * The encoder emits all strings a tuple needs in a single
+	 * CMD_INSERT_BATCH command directly followed by the tuple ids, the
+	 * decoder understands both insert commands.
+	 *
+	 * Every string is hashed once per tuple, the lookup table keeps hash
+	 * fingerprint and length of each entry so slots are only compared
+	 * byte-wise when they are very likely to match.
+	 *
+	 * Received data is checked before it is executed: table ids must be
+	 * below TABLE_SIZE and refer to filled slots, a batch holds 1 to
+	 * TUPLE_SIZE strings, strings are NUL terminated within the buffer and
+	 * no tuple or command may be cut off. Malformed input is rejected as a
+	 * whole without changing the lookup table.
+	 */
 	template<
 		typename OsModel_P,
 		size_t TABLE_SIZE_P,
@@ -20,11 +47,14 @@ namespace wiselib {
 			typedef typename OsModel::size_t size_type;
 			typedef typename OsModel::block_data_t block_data_t;
 			typedef uint8_t command_t;
+			typedef uint8_t count_t;
 			typedef typename SmallUint<TABLE_SIZE + 1>::t table_id_t;
+			typedef ::uint16_t fingerprint_t;
+			typedef ::uint16_t length_t;
 			
 			enum { npos = (size_type)(-1) };
 			enum { nidx = (table_id_t)(-1) };
-			enum Commands { CMD_INSERT = 0xfe, CMD_END = 0xff };
+			enum Commands { CMD_INSERT_BATCH = 0xfd, CMD_INSERT = 0xfe, CMD_END = 0xff };
 			enum { SUCCESS = OsModel::SUCCESS, ERR_UNSPEC = OsModel::ERR_UNSPEC };
 			
 			ShdtSerializer() {
@@ -40,7 +70,7 @@ namespace wiselib {
 			 * For SHDT this means clear the lookup table,
 			 * such that subsequent fill_buffer() or read_buffer() calls
 			 * will not use any table entries created in former calls.
-			 * 
+			 *
 			 * Useful if you want to reuse the same serializer instance for an
 			 * unrelated communication in which the other side starts from
 			 * scratch.
@@ -48,20 +78,20 @@ namespace wiselib {
 			void reset() {
 				for(size_type i=0; i<TABLE_SIZE; i++) {
 					if(lookup_table_[i]) {
-						get_allocator().free(lookup_table_[i]);
+						get_allocator().free_array(lookup_table_[i]);
 					}
 				}
 				memset((void*)lookup_table_, 0, sizeof(lookup_table_));
 			}
 			
 			/**
-			 * 
+			 *
 			 * Usage:
 			 * Call this in a loop, providing the buffer position to write
 			 * into and how many bytes to write (max_size).
 			 * This will increase 'current' until it hits 'end' and return the
 			 * number of bytes written.
-			 * 
+			 *
 			 * There are 3 possible outcomes of a call to fill_buffer():
 			 * 1. return > 0, current != end.
 			 *    Some data has been written, call again with updated buffer
@@ -73,41 +103,60 @@ namespace wiselib {
 			 *    No data has been written although not all data has been read
 			 *    yet. This means the supplied buffer was too small.
 			 *    Call again with a bigger buffer (i.e. larger max_size).
-			 * 
+			 *
+			 * A tuple is either written completely (including the insert
+			 * commands it needs) or not at all, so the lookup table is never
+			 * changed for a tuple that did not fit.
+			 *
 			 * \param buffer pointer to buffer to write into
 			 * \param max_size maximum amount of bytes to write into buffer
 			 * \param begin reference to iterator over tuples, will be ++'ed
 			 * 	during operation of this method
 			 * \param end end iterator (when begin==end, this method will
 			 * exit)
-			 * 
+			 *
 			 * \return Number of bytes written.
 			 */
 			template<typename iterator>
 			size_type fill_buffer(block_data_t* buffer, size_type max_size, iterator& current, const iterator& end) {
 				block_data_t *old_buffer = buffer;
-				//size_type old_max_size = max_size;
-				table_id_t ids[TUPLE_SIZE];
-				memset(&ids, 0xff, sizeof(table_id_t)*TUPLE_SIZE);
 				
-
 				for( ; current != end; ++current) {
 					typename iterator::Tuple t = *current;
-					bool ins = insert_tuple(buffer, max_size, ids, t);
-					if(!ins) { break; }
-					
-					const size_type cmdlen = TUPLE_SIZE*sizeof(table_id_t);
-					if(max_size < cmdlen) { break; }
-					
-					for(size_type p=0; p<TUPLE_SIZE; p++) {
-						wiselib::write<OsModel, table_id_t>(buffer, ids[p]);
-						buffer += sizeof(table_id_t);
-					}
-					max_size -= cmdlen;
+					if(!write_tuple(buffer, max_size, t)) { break; }
 				}
 				return buffer - old_buffer;
 			}
 			
+			/**
+			 * Write one radio frame: Reserve header_size bytes at the
+			 * beginning of frame (to be filled by the caller), then encode as
+			 * many tuples as fit into the remaining frame_size - header_size
+			 * bytes. When the last tuple has been written and there is room
+			 * left, a CMD_END command is appended so the receiving side knows
+			 * the stream is complete.
+			 *
+			 * \return Length of the frame including the header, 0 if not
+			 * even a single tuple (or the end marker) fit.
+			 */
+			template<typename iterator>
+			size_type write_frame(block_data_t* frame, size_type frame_size, size_type header_size, iterator& current, const iterator& end) {
+				if(frame_size <= header_size) { return 0; }
+				
+				block_data_t *buffer = frame + header_size;
+				size_type max_size = frame_size - header_size;
+				
+				size_type written = fill_buffer(buffer, max_size, current, end);
+				buffer += written;
+				max_size -= written;
+				
+				if(current == end && max_size >= sizeof(table_id_t) + sizeof(command_t)) {
+					write_command(buffer, CMD_END);
+					written += sizeof(table_id_t) + sizeof(command_t);
+				}
+				return written ? header_size + written : 0;
+			}
+			
 			/**
 			 * read buffer contents into tuple, returning the number of bytes
 			 * read.
@@ -119,13 +168,291 @@ namespace wiselib {
 			 * This will use tuple.set(...) in order to return the data.
 			 * (I.e. after a call to this, tuple might hold references pointing into
 			 * the internal lookup table.)
-			 * 
+			 *
 			 * It is expected that if buffer_size is not 0, it contains at
 			 * least one complete and executable tuple command.
+			 *
+			 * \return npos if the buffer does not start with well formed
+			 * commands up to the first tuple; the lookup table is not
+			 * changed then.
 			 */
 			template<typename Tuple>
 			size_type read_buffer(Tuple& tuple, block_data_t* buffer, size_type buffer_size) {
+				if(check(buffer, buffer_size, true) == npos) { return npos; }
+				
+				bool got_tuple, got_end;
+				return read_next(tuple, buffer, buffer_size, got_tuple, got_end);
+			}
+			
+			/**
+			 * Decode a complete frame as written by write_frame(), skipping
+			 * header_size bytes and calling callback for every contained
+			 * tuple. The tuple passed to the callback references the lookup
+			 * table and is only valid during the call.
+			 *
+			 * \param end_of_stream set to true if the frame contained the
+			 * CMD_END marker.
+			 * \return Number of tuples decoded, npos if the frame is
+			 * malformed (then no tuple is decoded and the lookup table is not
+			 * changed).
+			 */
+			template<typename Tuple>
+			size_type read_frame(block_data_t* frame, size_type frame_size, size_type header_size,
+					delegate1<void, Tuple&> callback, bool& end_of_stream) {
+				end_of_stream = false;
+				if(frame_size <= header_size) { return 0; }
+				
+				block_data_t *buffer = frame + header_size;
+				size_type buffer_size = frame_size - header_size;
+				size_type tuples = 0;
+				
+				if(check(buffer, buffer_size, false) == npos) { return npos; }
+				
+				while(buffer_size) {
+					Tuple tuple;
+					bool got_tuple, got_end;
+					size_type r = read_next(tuple, buffer, buffer_size, got_tuple, got_end);
+					buffer += r;
+					buffer_size -= r;
+					
+					if(got_tuple) {
+						callback(tuple);
+						tuples++;
+					}
+					if(got_end) {
+						end_of_stream = true;
+						break;
+					}
+					if(!r) { break; }
+				}
+				return tuples;
+			}
+			
+			//bool has_data() { return current_ != end_; }
+		
+		
+		private:
+		
+			/**
+			 * Length, hash and fingerprint of a string, computed in a single
+			 * pass.
+			 */
+			struct Key {
+				::uint32_t hash;
+				length_t length;
+				
+				table_id_t slot() const { return hash % TABLE_SIZE; }
+				fingerprint_t fingerprint() const { return (fingerprint_t)(hash >> 16); }
+			};
+			
+			// {{{ Encoding
+			
+			/**
+			 * Write insert commands (if needed) and table ids for tuple.
+			 *
+			 * \return
+			 * true -> success (written everything)
+			 * false -> nothing written, buffer and lookup table unchanged
+			 */
+			template<typename Tuple>
+			bool write_tuple(block_data_t*& buffer, size_type& max_size, Tuple& tuple) {
+				table_id_t ids[TUPLE_SIZE];
+				Key keys[TUPLE_SIZE];
+				block_data_t *data[TUPLE_SIZE];
+				bool fresh[TUPLE_SIZE];
+				
+				size_type inserts = 0;
+				size_type needed = TUPLE_SIZE * sizeof(table_id_t);
+				
+				for(size_type i=0; i<TUPLE_SIZE; i++) {
+					data[i] = (block_data_t*)tuple.get(i);
+					keys[i] = make_key(data[i]);
+					fresh[i] = false;
+					
+					// same string used twice in this tuple?
+					size_type j = 0;
+					for( ; j<i; j++) {
+						if(keys[j].hash == keys[i].hash && keys[j].length == keys[i].length &&
+								memcmp(data[j], data[i], keys[i].length) == 0) {
+							break;
+						}
+					}
+					if(j < i) {
+						ids[i] = ids[j];
+						continue;
+					}
+					
+					ids[i] = lookup(data[i], keys[i], ids, i, fresh[i]);
+					if(fresh[i]) {
+						inserts++;
+						needed += sizeof(table_id_t) + keys[i].length + 1;
+					}
+				}
+				
+				if(inserts) {
+					needed += sizeof(table_id_t) + sizeof(command_t) + sizeof(count_t);
+				}
+				if(max_size < needed) { return false; }
+				
+				if(inserts) {
+					write_command(buffer, CMD_INSERT_BATCH);
+					*buffer++ = (count_t)inserts;
+					
+					for(size_type i=0; i<TUPLE_SIZE; i++) {
+						if(!fresh[i]) { continue; }
+						
+						wiselib::write<OsModel, block_data_t, table_id_t>(buffer, ids[i]);
+						buffer += sizeof(table_id_t);
+						memcpy((void*)buffer, (void*)data[i], keys[i].length + 1);
+						buffer += keys[i].length + 1;
+						
+						store(ids[i], data[i], keys[i]);
+					}
+				}
+				
+				for(size_type i=0; i<TUPLE_SIZE; i++) {
+					wiselib::write<OsModel, block_data_t, table_id_t>(buffer, ids[i]);
+					buffer += sizeof(table_id_t);
+				}
+				max_size -= needed;
+				return true;
+			}
+			
+			/**
+			 * Find the table slot for data.
+			 * A string can only live in one of the TUPLE_SIZE slots following
+			 * its hash slot (earlier positions might have been blocked by
+			 * other strings of the same tuple), so only those are probed.
+			 * The first n ids in avoid are reserved by the current tuple and
+			 * must not be overwritten.
+			 *
+			 * \param fresh set to true if data is not in the table yet and
+			 * has to be inserted at the returned slot.
+			 */
+			table_id_t lookup(block_data_t* data, const Key& key, const table_id_t* avoid, size_type n, bool& fresh) {
+				table_id_t candidate = nidx;
+				table_id_t id = key.slot();
+				
+				for(size_type offs = 0; offs < TUPLE_SIZE; offs++) {
+					bool avoided = is_avoided(id, avoid, n);
+
+					// slots reserved by this tuple might be about to be
+					// overwritten, so they can't be a match
+					if(!avoided && lookup_table_[id] && fingerprints_[id] == key.fingerprint() &&
+							lengths_[id] == key.length &&
+							memcmp(lookup_table_[id], data, key.length) == 0) {
+						fresh = false;
+						return id;
+					}
+					
+					if(!avoided && (candidate == nidx ||
+								(lookup_table_[candidate] && !lookup_table_[id]))) {
+						candidate = id;
+					}
+					
+					id = (id + 1 == TABLE_SIZE) ? 0 : id + 1;
+				}
+				
+				fresh = true;
+				return candidate;
+			}
+			
+			bool is_avoided(table_id_t id, const table_id_t* avoid, size_type n) {
+				for(size_type i=0; i<n; i++) {
+					if(avoid[i] == id) { return true; }
+				}
+				return false;
+			}
+			
+			void write_command(block_data_t*& buffer, command_t cmd) {
+				table_id_t tid = nidx;
+				wiselib::write<OsModel, block_data_t, table_id_t>(buffer, tid);
+				buffer += sizeof(table_id_t);
+				wiselib::write<OsModel, block_data_t, command_t>(buffer, cmd);
+				buffer += sizeof(command_t);
+			}
+			
+			// }}}
+			
+			// {{{ Decoding
+			
+			/**
+			 * Walk the commands in buffer like read_next() would, without
+			 * executing them, up to the first tuple (one_tuple) or the end
+			 * of the buffer or stream.
+			 *
+			 * \return Number of bytes checked, npos if they are malformed.
+			 */
+			size_type check(const block_data_t* buffer, size_type buffer_size, bool one_tuple) {
+				// slots filled by inserts of the checked range
+				::uint8_t inserted[(TABLE_SIZE + 7) / 8];
+				memset(inserted, 0, sizeof(inserted));
+				
+				const block_data_t *p = buffer;
+				const block_data_t *end = buffer + buffer_size;
+				
+				while(p != end) {
+					if((size_type)(end - p) < sizeof(table_id_t)) { return npos; }
+					table_id_t tid = wiselib::read<OsModel, block_data_t, table_id_t>((block_data_t*)p);
+					p += sizeof(table_id_t);
+					
+					if(tid == nidx) {
+						if((size_type)(end - p) < sizeof(command_t)) { return npos; }
+						command_t cmd = wiselib::read<OsModel, block_data_t, command_t>((block_data_t*)p);
+						p += sizeof(command_t);
+						
+						size_type count = 1;
+						if(cmd == CMD_INSERT_BATCH) {
+							if((size_type)(end - p) < sizeof(count_t)) { return npos; }
+							count = *p;
+							p += sizeof(count_t);
+							if(count == 0 || count > TUPLE_SIZE) { return npos; }
+						}
+						else if(cmd == CMD_END) {
+							return end - buffer;
+						}
+						else if(cmd != CMD_INSERT) {
+							return npos;
+						}
+						
+						for(size_type i=0; i<count; i++) {
+							if((size_type)(end - p) < sizeof(table_id_t)) { return npos; }
+							table_id_t pos = wiselib::read<OsModel, block_data_t, table_id_t>((block_data_t*)p);
+							p += sizeof(table_id_t);
+							if(pos >= TABLE_SIZE) { return npos; }
+							
+							const block_data_t *nul = (const block_data_t*)memchr(p, 0, end - p);
+							if(!nul || nul - p > (length_t)(-1)) { return npos; }
+							p = nul + 1;
+							inserted[pos / 8] |= 1 << (pos % 8);
+						}
+					}
+					else {
+						for(size_type i=0; ; ) {
+							if(tid >= TABLE_SIZE) { return npos; }
+							if(!lookup_table_[tid] && !(inserted[tid / 8] & (1 << (tid % 8)))) { return npos; }
+							if(++i == TUPLE_SIZE) { break; }
+							
+							if((size_type)(end - p) < sizeof(table_id_t)) { return npos; }
+							tid = wiselib::read<OsModel, block_data_t, table_id_t>((block_data_t*)p);
+							p += sizeof(table_id_t);
+						}
+						if(one_tuple) { break; }
+					}
+				}
+				return p - buffer;
+			}
+			
+			/**
+			 * Execute commands from buffer until a complete tuple has been
+			 * read, the end marker is found or the buffer is exhausted.
+			 * The commands must have passed check().
+			 */
+			template<typename Tuple>
+			size_type read_next(Tuple& tuple, block_data_t* buffer, size_type buffer_size, bool& got_tuple, bool& got_end) {
 				block_data_t *old_buffer = buffer;
+				got_tuple = false;
+				got_end = false;
 				
 				while(buffer_size) {
 					if(buffer_size < sizeof(table_id_t)) {
@@ -146,29 +473,30 @@ namespace wiselib {
 						buffer += sizeof(command_t); buffer_size -= sizeof(command_t);
 						
 						if(cmd == CMD_INSERT) { // insert command
-							table_id_t pos = wiselib::read<OsModel, block_data_t, table_id_t>(buffer);
-							buffer += sizeof(table_id_t); buffer_size -= sizeof(table_id_t);
-							size_type l = strlen((char*)buffer) + 1; //strnlen((char*)buffer, buffer_size);
-							if(lookup_table_[pos]) {
-								get_allocator().free_array(lookup_table_[pos]);
+							read_insert(buffer, buffer_size);
+						}
+						else if(cmd == CMD_INSERT_BATCH) {
+							count_t count = *buffer;
+							buffer += sizeof(count_t); buffer_size -= sizeof(count_t);
+							for(count_t i=0; i<count; i++) {
+								read_insert(buffer, buffer_size);
 							}
-							lookup_table_[pos] = get_allocator().allocate_array<block_data_t>(l) .raw();
-							memcpy((void*)lookup_table_[pos], (void*)buffer, l);
-							buffer += l; buffer_size -= l;
 						}
 						else if(cmd == CMD_END) {
 							buffer += buffer_size;
+							got_end = true;
 							break;
 						}
 					} // command mode
 					
-					else { // tuple moda
+					else { // tuple mode
 						tuple.set(0, lookup_table_[tid]);
 						for(size_type i=1; i<TUPLE_SIZE; i++) {
 							tid = wiselib::read<OsModel, block_data_t, table_id_t>(buffer);
 							buffer += sizeof(table_id_t); buffer_size -= sizeof(table_id_t);
 							tuple.set(i, lookup_table_[tid]);
 						}
+						got_tuple = true;
 						break; // we got one tuple --> exit
 					}
 				} // while buffer_size
@@ -176,124 +504,49 @@ namespace wiselib {
 				return buffer - old_buffer;
 			}
 			
-			//bool has_data() { return current_ != end_; }
-				
-				
-		private:
-			
-			/**
-			 * \return
-			 * true -> success (inserted everything)
-			 * false -> partial or no insert
-			 */
-			template<typename Tuple>
-			bool insert_tuple(block_data_t*& buffer, size_type& max_size, table_id_t* ids, Tuple tuple) {
-				//printf("tuple=(%s %s %s)\n", tuple.get(0), tuple.get(1), tuple.get(2));
+			void read_insert(block_data_t*& buffer, size_type& buffer_size) {
+				table_id_t pos = wiselib::read<OsModel, block_data_t, table_id_t>(buffer);
+				buffer += sizeof(table_id_t); buffer_size -= sizeof(table_id_t);
 				
-				ids[0] = insert_hash_avoid(tuple.get(0), nidx, nidx, buffer, max_size);
-				if(ids[0] == nidx) { return false; }
-				ids[1] = insert_hash_avoid(tuple.get(1), ids[0], nidx, buffer, max_size);
-				if(ids[1] == nidx) { return false; }
-				ids[2] = insert_hash_avoid(tuple.get(2), ids[0], ids[1], buffer, max_size);
-				if(ids[2] == nidx) { return false; }
-				
-				return true;
+				Key key = make_key(buffer);
+				store(pos, buffer, key);
+				buffer += key.length + 1; buffer_size -= key.length + 1;
 			}
 			
-			table_id_t insert_hash_avoid(block_data_t* data, table_id_t avoid1, table_id_t avoid2, block_data_t*& buffer, size_type& max_size) {
-				//printf("data=(%s)\n", data);
-				table_id_t id = hash(data);
-				table_id_t id2 = nidx;
-				for(size_type offs = 0; ; offs++) {
-					id2 = (id + offs) % TABLE_SIZE;
-					
-					if(id2 == avoid1 || id2 == avoid2) { continue; }
-					
-					block_data_t *t = lookup_table_[id2];
-					//printf("  table[%d]=%s\n", id2, (char*)t);
-					
-					// empty slot in table --> insert here!
-					if(t == 0) {
-						//printf("  --> empty\n");
-						if(insert(id2, data, buffer, max_size) == ERR_UNSPEC) { return nidx; }
-						break;
-					}
-					
-					// data already there, we're done!
-					else if(strcmp((char*)t, (char*)data) == 0) {
-						//printf("  --> already there :)\n");
-						break;
-					}
-					
-					else {
-						//printf("  --> overwrite\n");
-//						GET_OS.debug("free(2) %x", t);
-						get_allocator().free(t);
-						lookup_table_[id2] = 0;
-						
-						if(insert(id2, data, buffer, max_size) == ERR_UNSPEC) { return nidx; }
-						break;
-					}
-				} // for offs
-				
-				return id2;
-			} // insert_hash_avoid(...)
+			// }}}
 			
-			int insert(table_id_t id, block_data_t* data, block_data_t*& buffer, size_type& max_size) {
-				const size_type l = strlen((char*)data) + 1;
-				const size_type cmdlen = sizeof(table_id_t) + sizeof(command_t) + sizeof(table_id_t) + l;
-				if(max_size < cmdlen) { return ERR_UNSPEC; }
-				
-				// ----- actual command write ------
-				table_id_t tid;
-				command_t cmd;
-				
-				// id = nidx --> enter command mode
-				tid = nidx;
-				wiselib::write<OsModel, table_id_t>(buffer, tid); buffer += sizeof(table_id_t);
-				
-				// command: INSERT
-				cmd = CMD_INSERT;
-				wiselib::write<OsModel, command_t>(buffer, cmd); buffer += sizeof(command_t);
-				
-				// id
-				tid = id;
-				wiselib::write<OsModel, table_id_t>(buffer, tid); buffer += sizeof(table_id_t);
-				
-				// data
-				memcpy((void*)buffer, (void*)data, l); buffer += l;
-//
-				max_size -= cmdlen;
-
-				block_data_t* d = get_allocator().allocate_array<block_data_t>(l).raw();
-//				GET_OS.debug("aod: %x", d);
-//				block_data_t* d = (block_data_t*)isense::malloc(l);
-				memcpy((void*)d, (void*)data, l);
-//				memset(d, '@', l);
-//				GET_OS.debug("id: %u %c%c", id, (char)((int)d>>8), (char)((int)d&0xff));
-				lookup_table_[id] = d;
-				
-				return SUCCESS;
+			/**
+			 * Copy data into the table slot id, replacing its former content.
+			 */
+			void store(table_id_t id, block_data_t* data, const Key& key) {
+				if(lookup_table_[id]) {
+					get_allocator().free_array(lookup_table_[id]);
+				}
+				lookup_table_[id] = get_allocator().allocate_array<block_data_t>(key.length + 1) .raw();
+				memcpy((void*)lookup_table_[id], (void*)data, key.length + 1);
+				fingerprints_[id] = key.fingerprint();
+				lengths_[id] = key.length;
 			}
 			
-			table_id_t hash(block_data_t *s) {
-				//return (s[0] ^ s[1]) % TABLE_SIZE;
-				//return reinterpret_cast<Uint<sizeof(block_data_t*)>::t>(s) % TABLE_SIZE;
-				
-				// stolen from STL, slightly modified
-				// source: http://www.fantasy-coders.de/projects/gh/html/x435.html
-				table_id_t r = 0;
-				for(size_type i=0; s[i] /*&& i<12*/; i++) {
-					r = (5*r + s[i]) % TABLE_SIZE;
+			Key make_key(block_data_t *s) {
+				// FNV-1a
+				Key key;
+				key.hash = 2166136261UL;
+				size_type i = 0;
+				for( ; s[i]; i++) {
+					key.hash = (key.hash ^ s[i]) * 16777619UL;
 				}
-				return r % TABLE_SIZE;
+				key.length = (length_t)i;
+				return key;
 			}
 			
 			
 			//iterator current_, end_;
 			block_data_t *lookup_table_[TABLE_SIZE];
+			fingerprint_t fingerprints_[TABLE_SIZE];
+			length_t lengths_[TABLE_SIZE];
 	};
-	
+
 } // namespace wiselib
 
 #endif // SHDT_SERIALIZER_H
@@ -0,0 +1,54 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef INLINE_EXECUTOR_H
+#define INLINE_EXECUTOR_H
+
+#include <util/delegates/delegate.hpp>
+
+namespace wiselib {
+	
+	/**
+	 * Executor without threads: parallel_for() runs the whole range in the
+	 * calling context. Default for algorithms that can spread independent
+	 * work over a thread pool (see PCThreadPool) where one is available.
+	 */
+	template<
+		typename OsModel_P
+	>
+	class InlineExecutor {
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::size_t size_type;
+			typedef InlineExecutor<OsModel_P> self_type;
+			typedef self_type* self_pointer_t;
+			
+			/// task(begin, end) processes the indices [begin, end).
+			typedef delegate2<void, size_type, size_type> task_t;
+			
+			enum { THREADS = 1 };
+			
+			void parallel_for(size_type n, task_t task, size_type min_range = 1) {
+				if(n) { task(0, n); }
+			}
+		
+	}; // InlineExecutor
+}
+
+#endif // INLINE_EXECUTOR_H
@@ -0,0 +1,117 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __UTIL_METRICS_PCAP_FRAME_DUMP_H
+#define __UTIL_METRICS_PCAP_FRAME_DUMP_H
+
+#include <stdio.h>
+
+namespace wiselib {
+
+   /** \brief Frame dump of the TrafficTelemetryRadioModel that writes a
+    *  pcap file, for PC targets only.
+    *
+    *  Frames are stored with link type USER0 (147). Each starts with a
+    *  pseudo header of 9 bytes: the direction (0 received, 1 sent), then
+    *  source and destination as big endian 32 bit numbers; the radio
+    *  payload follows.
+    */
+   template<typename OsModel_P>
+   class PcapFrameDump
+   {
+   public:
+      typedef typename OsModel_P::block_data_t block_data_t;
+
+      enum { ACTIVE = 1 };
+
+      enum {
+         LINKTYPE_USER0 = 147,
+         PSEUDO_HEADER_SIZE = 9,
+         SNAPLEN = 0xffff
+      };
+      // --------------------------------------------------------------------
+      PcapFrameDump()
+         : file_ ( 0 )
+      {}
+      // --------------------------------------------------------------------
+      ~PcapFrameDump()
+      {
+         close();
+      }
+      // --------------------------------------------------------------------
+      /** Creates (truncates) the file and writes the pcap header.
+       */
+      bool open( const char* path )
+      {
+         close();
+         file_ = fopen( path, "wb" );
+         if ( !file_ )
+            return false;
+
+         uint32_t magic = 0xa1b2c3d4;
+         uint16_t version[2] = { 2, 4 };
+         int32_t zone = 0;
+         uint32_t sigfigs = 0, snaplen = SNAPLEN, network = LINKTYPE_USER0;
+         fwrite( &magic, sizeof( magic ), 1, file_ );
+         fwrite( version, sizeof( version ), 1, file_ );
+         fwrite( &zone, sizeof( zone ), 1, file_ );
+         fwrite( &sigfigs, sizeof( sigfigs ), 1, file_ );
+         fwrite( &snaplen, sizeof( snaplen ), 1, file_ );
+         fwrite( &network, sizeof( network ), 1, file_ );
+         return true;
+      }
+      // --------------------------------------------------------------------
+      void close()
+      {
+         if ( file_ )
+            fclose( file_ );
+         file_ = 0;
+      }
+      // --------------------------------------------------------------------
+      void flush()
+      {
+         if ( file_ )
+            fflush( file_ );
+      }
+      // --------------------------------------------------------------------
+      void dump( uint8_t direction, uint32_t from, uint32_t to, uint32_t sec, uint32_t usec,
+                 uint32_t len, const block_data_t* data )
+      {
+         if ( !file_ )
+            return;
+
+         uint32_t record[4] = { sec, usec, len + PSEUDO_HEADER_SIZE, len + PSEUDO_HEADER_SIZE };
+         uint8_t pseudo[PSEUDO_HEADER_SIZE] = {
+            direction,
+            (uint8_t)( from >> 24 ), (uint8_t)( from >> 16 ), (uint8_t)( from >> 8 ), (uint8_t)from,
+            (uint8_t)( to >> 24 ), (uint8_t)( to >> 16 ), (uint8_t)( to >> 8 ), (uint8_t)to };
+         fwrite( record, sizeof( record ), 1, file_ );
+         fwrite( pseudo, sizeof( pseudo ), 1, file_ );
+         fwrite( data, 1, len, file_ );
+      }
+
+   private:
+      PcapFrameDump( const PcapFrameDump& );
+      PcapFrameDump& operator=( const PcapFrameDump& );
+
+      FILE* file_;
+   };
+
+}
+
+#endif
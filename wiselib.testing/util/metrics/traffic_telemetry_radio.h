@@ -0,0 +1,421 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __UTIL_METRICS_TRAFFIC_TELEMETRY_RADIO_H
+#define __UTIL_METRICS_TRAFFIC_TELEMETRY_RADIO_H
+
+#include "util/base_classes/extended_radio_base.h"
+#include "radio/stack/radio_stack.h"
+#include "util/serialization/simple_types.h"
+
+namespace wiselib {
+
+   /** \brief Frame dump of the TrafficTelemetryRadioModel that drops all
+    *  frames.
+    */
+   template<typename OsModel_P>
+   class NullFrameDump
+   {
+   public:
+      typedef typename OsModel_P::block_data_t block_data_t;
+
+      enum { ACTIVE = 0 };
+
+      void dump( uint8_t, uint32_t, uint32_t, uint32_t, uint32_t,
+                 uint32_t, const block_data_t* )
+      {}
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Implementation detail of TrafficTelemetryRadioModel: a radio
+    *  without ExtendedData calls the plain receiver.
+    */
+   template<typename OsModel_P, typename Radio_P, bool EXTENDED>
+   struct TrafficTelemetryLowerRadio
+   {
+      typedef BaseExtendedData<OsModel_P> ExtendedData;
+
+      template<typename T>
+      static int reg_recv_callback( Radio_P& radio, T *obj )
+      {
+         return radio.template reg_recv_callback<T, &T::receive>( obj );
+      }
+   };
+   // -----------------------------------------------------------------------
+   template<typename OsModel_P, typename Radio_P>
+   struct TrafficTelemetryLowerRadio<OsModel_P, Radio_P, true>
+   {
+      typedef typename Radio_P::ExtendedData ExtendedData;
+
+      template<typename T>
+      static int reg_recv_callback( Radio_P& radio, T *obj )
+      {
+         return radio.template reg_recv_callback<T, &T::receive_extended>( obj );
+      }
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Tells whether Radio_P passes ExtendedData to its receivers,
+    *  i.e. has extended receive callbacks like ExtendedRadioBase.
+    */
+   template<typename Radio_P>
+   class TrafficTelemetryExtendedTraits
+   {
+      struct yes { char c[2]; };
+      template<typename T> static yes test( typename T::extended_radio_delegate_t* );
+      template<typename T> static char test( ... );
+
+   public:
+      enum { EXTENDED = sizeof( test<Radio_P>( 0 ) ) == sizeof( yes ) };
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Counters of one message type, one neighbor or the whole radio.
+    */
+   struct TrafficCounters
+   {
+      uint32_t tx_packets;
+      uint32_t tx_bytes;
+      uint32_t rx_packets;
+      uint32_t rx_bytes;
+   };
+   // -----------------------------------------------------------------------
+   /** \brief Implementation of \ref radio_concept "Radio Concept" that
+   *     keeps traffic statistics.
+   *  \ingroup radio_concept
+   *
+   *  Counts packets and bytes sent and received per message type (first
+   *  byte of the payload) and per neighbor in fixed tables of MAX_TYPES and
+   *  MAX_NEIGHBORS entries; keys that find no room are counted as other.
+   *  Packet sizes and the gaps between two receptions from the same
+   *  neighbor go into histograms of HISTOGRAM_BINS power of two bins: bin
+   *  i holds values below 2^i, the last one everything above. snapshot()
+   *  copies all of it at once. Every frame is also passed to the FrameDump
+   *  set with set_frame_dump(), see PcapFrameDump for PC targets.
+   *
+   *  If the radio below passes ExtendedData (such as the link metric) to
+   *  its receivers, it is handed on to the extended receivers registered
+   *  here; otherwise only plain receivers are called.
+   */
+   template<typename OsModel_P,
+            typename Radio_P,
+            typename Clock_P,
+            typename Debug_P,
+            typename FrameDump_P = NullFrameDump<OsModel_P>,
+            int MAX_TYPES = 16,
+            int MAX_NEIGHBORS = 16,
+            int HISTOGRAM_BINS = 12>
+   class TrafficTelemetryRadioModel
+      : public ExtendedRadioBase<OsModel_P, typename Radio_P::node_id_t, typename Radio_P::size_t, typename Radio_P::block_data_t,
+            RADIO_BASE_MAX_RECEIVERS,
+            typename TrafficTelemetryLowerRadio<OsModel_P, Radio_P, TrafficTelemetryExtendedTraits<Radio_P>::EXTENDED>::ExtendedData>
+   {
+      typedef TrafficTelemetryLowerRadio<OsModel_P, Radio_P, TrafficTelemetryExtendedTraits<Radio_P>::EXTENDED> LowerRadio;
+      friend struct TrafficTelemetryLowerRadio<OsModel_P, Radio_P, TrafficTelemetryExtendedTraits<Radio_P>::EXTENDED>;
+
+   public:
+      typedef OsModel_P OsModel;
+      typedef Radio_P Radio;
+      typedef Clock_P Clock;
+      typedef Debug_P Debug;
+      typedef FrameDump_P FrameDump;
+      typedef TrafficTelemetryRadioModel<OsModel, Radio, Clock, Debug, FrameDump, MAX_TYPES, MAX_NEIGHBORS, HISTOGRAM_BINS> self_type;
+      typedef self_type* self_pointer_t;
+
+      typedef typename Radio::node_id_t node_id_t;
+      typedef typename Radio::size_t size_t;
+      typedef typename Radio::block_data_t block_data_t;
+      typedef typename Radio::message_id_t message_id_t;
+      typedef typename LowerRadio::ExtendedData ExtendedData;
+      typedef RadioStackTraits<Radio> LowerStack;
+      typedef self_type radio_stack_layer_t;
+
+      typedef typename Clock::time_t time_t;
+      // --------------------------------------------------------------------
+      struct TypeEntry
+      {
+         bool used;
+         message_id_t message_id;
+         TrafficCounters counters;
+      };
+      // --------------------------------------------------------------------
+      struct NeighborEntry
+      {
+         bool used;
+         node_id_t node;
+         uint32_t last_rx;
+         TrafficCounters counters;
+      };
+      // --------------------------------------------------------------------
+      struct Snapshot
+      {
+         TrafficCounters total;
+         TrafficCounters other_types;
+         TrafficCounters other_neighbors;
+         TypeEntry types[MAX_TYPES];
+         NeighborEntry neighbors[MAX_NEIGHBORS];
+         uint32_t tx_size[HISTOGRAM_BINS];
+         uint32_t rx_size[HISTOGRAM_BINS];
+         uint32_t rx_interarrival[HISTOGRAM_BINS];   ///< milliseconds
+      };
+      // --------------------------------------------------------------------
+      enum SpecialNodeIds {
+         BROADCAST_ADDRESS = Radio::BROADCAST_ADDRESS, ///< All nodes in communication range
+         NULL_NODE_ID      = Radio::NULL_NODE_ID       ///< Unknown/No node id
+      };
+      // --------------------------------------------------------------------
+      enum Restrictions {
+         MAX_MESSAGE_LENGTH = Radio::MAX_MESSAGE_LENGTH
+      };
+      // --------------------------------------------------------------------
+      enum {
+         HEADROOM = LowerStack::HEADROOM ///< Adds no header, see RadioStackTraits
+      };
+      // --------------------------------------------------------------------
+      enum Directions {
+         DIRECTION_RX = 0,
+         DIRECTION_TX = 1
+      };
+      // --------------------------------------------------------------------
+      TrafficTelemetryRadioModel()
+         : frame_dump_ ( 0 )
+      {
+         reset();
+      }
+      // --------------------------------------------------------------------
+      int send( node_id_t id, size_t len, block_data_t *data )
+      {
+         count_tx( id, len, data );
+         return radio().send( id, len, data );
+      }
+      // --------------------------------------------------------------------
+      int send_in_place( node_id_t id, size_t len, block_data_t *data )
+      {
+         count_tx( id, len, data );
+         return LowerStack::send( radio(), id, len, data );
+      }
+      // --------------------------------------------------------------------
+      void init( Radio& radio, Clock& clock, Debug& debug )
+      {
+         radio_ = &radio;
+         clock_ = &clock;
+         debug_ = &debug;
+
+         LowerRadio::reg_recv_callback( *radio_, this );
+      }
+      // --------------------------------------------------------------------
+      void destruct()
+      {}
+      // --------------------------------------------------------------------
+      int enable_radio()
+      {
+         return radio().enable_radio();
+      }
+      // --------------------------------------------------------------------
+      int disable_radio()
+      {
+         return radio().disable_radio();
+      }
+      // --------------------------------------------------------------------
+      node_id_t id()
+      {
+         return radio().id();
+      }
+      // --------------------------------------------------------------------
+      /** Frames sent and received from now on are passed to dump, 0 stops.
+       */
+      void set_frame_dump( FrameDump* dump )
+      {
+         frame_dump_ = dump;
+      }
+      // --------------------------------------------------------------------
+      void snapshot( Snapshot& snapshot )
+      {
+         snapshot = stats_;
+      }
+      // --------------------------------------------------------------------
+      const Snapshot& stats()
+      {
+         return stats_;
+      }
+      // --------------------------------------------------------------------
+      void reset()
+      {
+         memset( &stats_, 0, sizeof( stats_ ) );
+      }
+      // --------------------------------------------------------------------
+      /** Lower bound of histogram bin i.
+       */
+      static uint32_t bin_floor( int i )
+      {
+         return i ? ( (uint32_t)1 << ( i - 1 ) ) : 0;
+      }
+      // --------------------------------------------------------------------
+      void print()
+      {
+         debug().debug( "TELEMETRY: node %d tx %d/%d rx %d/%d (packets/bytes)\n", id(),
+            stats_.total.tx_packets, stats_.total.tx_bytes,
+            stats_.total.rx_packets, stats_.total.rx_bytes );
+         for ( int i = 0; i < MAX_TYPES; ++i )
+            if ( stats_.types[i].used )
+               print_counters( "type", stats_.types[i].message_id, stats_.types[i].counters );
+         for ( int i = 0; i < MAX_NEIGHBORS; ++i )
+            if ( stats_.neighbors[i].used )
+               print_counters( "neighbor", stats_.neighbors[i].node, stats_.neighbors[i].counters );
+         for ( int i = 0; i < HISTOGRAM_BINS; ++i )
+            debug().debug( "TELEMETRY: node %d bin >=%d tx_size %d rx_size %d rx_interarrival %d\n", id(),
+               bin_floor( i ), stats_.tx_size[i], stats_.rx_size[i], stats_.rx_interarrival[i] );
+      }
+
+   private:
+      void count_tx( node_id_t id, size_t len, block_data_t *data )
+      {
+         if ( len )
+         {
+            TrafficCounters& type = type_counters( read<OsModel, block_data_t, message_id_t>( data ) );
+            type.tx_packets++;
+            type.tx_bytes += len;
+         }
+         NeighborEntry* neighbor = find_neighbor( id );
+         TrafficCounters& counters = neighbor ? neighbor->counters : stats_.other_neighbors;
+         counters.tx_packets++;
+         counters.tx_bytes += len;
+         stats_.total.tx_packets++;
+         stats_.total.tx_bytes += len;
+         stats_.tx_size[bin( len )]++;
+
+         if ( FrameDump::ACTIVE && frame_dump_ )
+         {
+            time_t t = clock().time();
+            frame_dump_->dump( DIRECTION_TX, this->id(), id, clock().seconds( t ),
+               clock().milliseconds( t ) * 1000, len, data );
+         }
+      }
+      // --------------------------------------------------------------------
+      void receive( node_id_t from, size_t len, block_data_t* data )
+      {
+         count_rx( from, len, data );
+         self_type::notify_receivers( from, len, data );
+      }
+      // --------------------------------------------------------------------
+      void receive_extended( node_id_t from, size_t len, block_data_t* data, const ExtendedData& ext_data )
+      {
+         count_rx( from, len, data );
+         self_type::notify_receivers( from, len, data, ext_data );
+      }
+      // --------------------------------------------------------------------
+      void count_rx( node_id_t from, size_t len, block_data_t* data )
+      {
+         if ( len )
+         {
+            TrafficCounters& type = type_counters( read<OsModel, block_data_t, message_id_t>( data ) );
+            type.rx_packets++;
+            type.rx_bytes += len;
+         }
+         time_t t = clock().time();
+         NeighborEntry* neighbor = find_neighbor( from );
+         if ( neighbor )
+         {
+            uint32_t now = clock().seconds( t ) * 1000 + clock().milliseconds( t );
+            if ( neighbor->counters.rx_packets )
+               stats_.rx_interarrival[bin( now - neighbor->last_rx )]++;
+            neighbor->last_rx = now;
+            neighbor->counters.rx_packets++;
+            neighbor->counters.rx_bytes += len;
+         }
+         else
+         {
+            stats_.other_neighbors.rx_packets++;
+            stats_.other_neighbors.rx_bytes += len;
+         }
+         stats_.total.rx_packets++;
+         stats_.total.rx_bytes += len;
+         stats_.rx_size[bin( len )]++;
+
+         if ( FrameDump::ACTIVE && frame_dump_ )
+            frame_dump_->dump( DIRECTION_RX, from, id(), clock().seconds( t ),
+               clock().milliseconds( t ) * 1000, len, data );
+      }
+      // --------------------------------------------------------------------
+      TrafficCounters& type_counters( message_id_t message_id )
+      {
+         for ( int i = 0, k = message_id % MAX_TYPES; i < MAX_TYPES; ++i, k = ( k + 1 ) % MAX_TYPES )
+         {
+            TypeEntry& e = stats_.types[k];
+            if ( !e.used )
+            {
+               e.used = true;
+               e.message_id = message_id;
+            }
+            if ( e.message_id == message_id )
+               return e.counters;
+         }
+         return stats_.other_types;
+      }
+      // --------------------------------------------------------------------
+      NeighborEntry* find_neighbor( node_id_t node )
+      {
+         for ( int i = 0, k = node % MAX_NEIGHBORS; i < MAX_NEIGHBORS; ++i, k = ( k + 1 ) % MAX_NEIGHBORS )
+         {
+            NeighborEntry& e = stats_.neighbors[k];
+            if ( !e.used )
+            {
+               e.used = true;
+               e.node = node;
+            }
+            if ( e.node == node )
+               return &e;
+         }
+         return 0;
+      }
+      // --------------------------------------------------------------------
+      static int bin( uint32_t value )
+      {
+         int i = 0;
+         while ( value && i < HISTOGRAM_BINS - 1 )
+         {
+            value >>= 1;
+            ++i;
+         }
+         return i;
+      }
+      // --------------------------------------------------------------------
+      void print_counters( const char* kind, uint32_t key, TrafficCounters& c )
+      {
+         debug().debug( "TELEMETRY: node %d %s %d tx %d/%d rx %d/%d\n", id(), kind, key,
+            c.tx_packets, c.tx_bytes, c.rx_packets, c.rx_bytes );
+      }
+      // --------------------------------------------------------------------
+      Radio& radio()
+      { return *radio_; }
+
+      Clock& clock()
+      { return *clock_; }
+
+      Debug& debug()
+      { return *debug_; }
+
+      typename Radio::self_pointer_t radio_;
+      typename Clock::self_pointer_t clock_;
+      typename Debug::self_pointer_t debug_;
+
+      FrameDump* frame_dump_;
+
+      Snapshot stats_;
+   };
+
+}
+
+#endif
@@ -26,6 +26,14 @@
 namespace wiselib {
    namespace protobuf {
 
+/**
+ * Unsigned integer of N bytes, the type varints are computed in.
+ */
+template<int N> struct VarIntUnsigned { typedef uint64_t type; };
+template<> struct VarIntUnsigned<1> { typedef uint8_t type; };
+template<> struct VarIntUnsigned<2> { typedef uint16_t type; };
+template<> struct VarIntUnsigned<4> { typedef uint32_t type; };
+
 /**
  * Implements the ProtobufRW Concept.
  * 
@@ -33,10 +41,10 @@ namespace wiselib {
  * must support iter++ as well es (*iter) = some_block_data_t_instance.
  * E.g. block_data_t*, vector_dynamic<..., block_data_t>::iterator.
  * 
- * \tparam Integer_P Unsigned integer type that is used on the application
- * side to represent varints. Note that this *must* be an unsigned type, else
- * you will get unexpected results.
- * (negative values are not supported yet)
+ * \tparam Integer_P Integer type that is used on the application side to
+ * represent varints, up to 64 bits. Signed values are written as the
+ * unsigned integer of the same size, so negative ones take the maximum
+ * number of bytes; use ZigZag for those.
  */
 template<
    typename OsModel_P,
@@ -49,39 +57,40 @@ class VarInt {
       typedef Buffer_P buffer_t;
       typedef typename Os::block_data_t block_data_t;
       typedef Integer_P int_t;
+      typedef typename VarIntUnsigned<sizeof(int_t)>::type uint_t;
       
       typedef Byte<Os, buffer_t> byterw_t;
       
       enum { WIRE_TYPE = 0 };
+      enum { MAX_BYTES = (sizeof(int_t) * 8 + 6) / 7 };
       
       static bool write(buffer_t& buffer, buffer_t& buffer_end, int_t v_, size_t sz=0) {
-         unsigned v = (unsigned)v_;
-         bool continuation = (v >> 7) != 0;
+         uint_t v = (uint_t)v_;
          
-         if(!byterw_t::write(buffer, buffer_end, (int_t)((v & DATA) | (continuation << 7)))) { return false; }
-         if(continuation) {
-            if(!write(buffer, buffer_end, v >> 7)) { return false; }
+         while(v > DATA) {
+            if(!byterw_t::write(buffer, buffer_end, (block_data_t)((v & DATA) | CONTINUATION))) { return false; }
+            v >>= 7;
          }
-         return true;
+         return byterw_t::write(buffer, buffer_end, (block_data_t)v);
       }
       
+      /**
+       * Fails at the end of the buffer and for varints longer than 10
+       * bytes; bits beyond the width of int_t are dropped.
+       */
       static bool read(buffer_t& buffer, buffer_t& buffer_end, int_t& out) {
-         int_t v;
+         uint_t v = 0;
          block_data_t b;
-         if(!byterw_t::read(buffer, buffer_end, b)) { return false; }
-         v = b;
-         bool continuation = (v >> 7) != 0;
-         v &= DATA;
          
-         if(continuation) {
-            int_t v2;
-            if(!read(buffer, buffer_end, v2)) { return false; }
-            out = v | (v2 << 7);
-         }
-         else {
-            out = v;
+         for(unsigned shift = 0; shift < 70; shift += 7) {
+            if(!byterw_t::read(buffer, buffer_end, b)) { return false; }
+            if(shift < sizeof(uint_t) * 8) { v |= (uint_t)(b & DATA) << shift; }
+            if(!(b & CONTINUATION)) {
+               out = (int_t)v;
+               return true;
+            }
          }
-         return true;
+         return false;
       }
          
    private:
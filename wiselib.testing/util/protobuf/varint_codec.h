@@ -0,0 +1,296 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+
+#ifndef VARINT_CODEC_H
+#define VARINT_CODEC_H
+
+#include "util/protobuf/varint.h"
+
+#if defined(__SSSE3__) && !defined(VARINT_CODEC_NO_SIMD)
+   #include <tmmintrin.h>
+   #define VARINT_CODEC_SSSE3 1
+#endif
+
+/*
+ * Number of one and two byte varints the next eight bytes must hold for
+ * decode_array() to decode them with SSSE3; shorter runs are cheaper in
+ * the scalar path.
+ */
+#ifndef VARINT_CODEC_SIMD_MIN_RUN
+   #define VARINT_CODEC_SIMD_MIN_RUN 4
+#endif
+
+namespace wiselib {
+   namespace protobuf {
+
+/**
+ * Varint encoding and decoding of 64 bit values on plain memory, for code
+ * that owns a block_data_t buffer and does not need the iterator interface
+ * of VarInt (same wire format).
+ * 
+ * decode() handles one and two byte varints (values below 16384) inline
+ * and otherwise reads the next eight bytes as one word when that many are
+ * left, finding the length from the continuation bits without a branch
+ * per byte. decode_array() decodes runs of one and two byte varints
+ * (e.g. IDs) eight bytes at a time with SSSE3 when the compiler targets
+ * it, the way masked VByte does, if at least VARINT_CODEC_SIMD_MIN_RUN of
+ * them start the window; everything else and other targets take the
+ * scalar path, for longer and longer stretches while the windows keep
+ * missing.
+ */
+template<typename OsModel_P>
+class VarIntCodec {
+   public:
+      typedef OsModel_P Os;
+      typedef typename Os::block_data_t block_data_t;
+      typedef typename Os::size_t size_type;
+      
+      enum { MAX_BYTES = 10 };
+      
+      /**
+       * Number of bytes encode() writes for v.
+       */
+      static size_type encoded_size(uint64_t v) {
+         // ceil(bits / 7) for bits in 1..64 as (bits * 9 + 64) / 64
+         return (size_type)((significant_bits(v | 1) * 9 + 64) >> 6);
+      }
+      
+      /**
+       * Writes v to out, which must have room for encoded_size(v) bytes.
+       * Returns the number of bytes written.
+       */
+      static size_type encode(uint64_t v, block_data_t* out) {
+         block_data_t *p = out;
+         while(v > DATA) {
+            *p++ = (block_data_t)((v & DATA) | CONTINUATION);
+            v >>= 7;
+         }
+         *p++ = (block_data_t)v;
+         return (size_type)(p - out);
+      }
+      
+      /**
+       * Reads one varint from [p, end). Returns the number of bytes
+       * consumed, 0 if the buffer ends before the varint or it is longer
+       * than MAX_BYTES.
+       */
+      static size_type decode(const block_data_t* p, const block_data_t* end, uint64_t& out) {
+         // values below 16384 first, they are the common case
+         if(p < end) {
+            if(!(p[0] & CONTINUATION)) {
+               out = p[0];
+               return 1;
+            }
+            if(end - p >= 2 && !(p[1] & CONTINUATION)) {
+               out = (uint64_t)(p[0] & DATA) | ((uint64_t)p[1] << 7);
+               return 2;
+            }
+         }
+         return decode_long(p, end, out);
+      }
+      
+      static size_type encode_array(const uint32_t* values, size_type n, block_data_t* out) {
+         block_data_t *p = out;
+         for(size_type i = 0; i < n; i++) {
+            p += encode(values[i], p);
+         }
+         return (size_type)(p - out);
+      }
+      
+      /**
+       * Decodes n varints from [p, end) into out. Returns the number of
+       * bytes consumed, 0 if the buffer holds fewer than n varints or one
+       * of them does not fit 32 bits.
+       */
+      static size_type decode_array(const block_data_t* p, const block_data_t* end, uint32_t* out, size_type n) {
+         const block_data_t *start = p;
+         size_type i = 0;
+#if VARINT_CODEC_SSSE3
+         // values decoded scalar after a window that did not hold enough
+         // short varints, doubled with every such window in a row
+         size_type backoff = 8;
+#endif
+         
+         while(i < n) {
+            size_type run = n - i;
+#if VARINT_CODEC_SSSE3
+            if(n - i >= 8 && end - p >= 8) {
+               __m128i bytes = _mm_loadl_epi64((const __m128i*)p);
+               const ShuffleEntry &e = shuffle_table()[_mm_movemask_epi8(bytes) & 0xff];
+               if(e.count >= VARINT_CODEC_SIMD_MIN_RUN) {
+                  __m128i x = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i*)e.shuffle));
+                  __m128i lo = _mm_and_si128(x, _mm_set1_epi16(0x007f));
+                  __m128i hi = _mm_srli_epi16(_mm_and_si128(x, _mm_set1_epi16(0x7f00)), 1);
+                  x = _mm_or_si128(lo, hi);
+                  _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(x, _mm_setzero_si128()));
+                  _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(x, _mm_setzero_si128()));
+                  i += e.count;
+                  p += e.consumed;
+                  backoff = 8;
+                  continue;
+               }
+               if(run > backoff) {
+                  run = backoff;
+               }
+               if(backoff < 256) {
+                  backoff *= 2;
+               }
+            }
+#endif
+            for(size_type stop = i + run; i < stop; i++) {
+               uint64_t v;
+               size_type len = decode(p, end, v);
+               if(!len || v > 0xffffffffULL) { return 0; }
+               out[i] = (uint32_t)v;
+               p += len;
+            }
+         }
+         return (size_type)(p - start);
+      }
+      
+   private:
+      static const uint8_t DATA = 0x7f, CONTINUATION = 0x80;
+      
+      /**
+       * decode() of varints longer than two bytes, kept apart so the
+       * short cases inline into the caller's loop. With MAX_BYTES left
+       * the bytes are read without checking the end of the buffer; the
+       * word trick above costs more than it saves once varints are
+       * longer than two bytes.
+       */
+#ifdef __GNUC__
+      __attribute__((noinline))
+#endif
+      static size_type decode_long(const block_data_t* p, const block_data_t* end, uint64_t& out) {
+         if(end - p >= MAX_BYTES) {
+            uint64_t v = p[0] & DATA;
+            if(!(p[0] & CONTINUATION)) { out = v; return 1; }
+            v |= (uint64_t)(p[1] & DATA) << 7;
+            if(!(p[1] & CONTINUATION)) { out = v; return 2; }
+            v |= (uint64_t)(p[2] & DATA) << 14;
+            if(!(p[2] & CONTINUATION)) { out = v; return 3; }
+            v |= (uint64_t)(p[3] & DATA) << 21;
+            if(!(p[3] & CONTINUATION)) { out = v; return 4; }
+            v |= (uint64_t)(p[4] & DATA) << 28;
+            if(!(p[4] & CONTINUATION)) { out = v; return 5; }
+            for(size_type i = 5; i < MAX_BYTES; i++) {
+               v |= (uint64_t)(p[i] & DATA) << (7 * i);
+               if(!(p[i] & CONTINUATION)) {
+                  out = v;
+                  return i + 1;
+               }
+            }
+            return 0;
+         }
+         
+         uint64_t v = 0;
+         for(size_type i = 0; i < MAX_BYTES && p + i < end; i++) {
+            v |= (uint64_t)(p[i] & DATA) << (7 * i);
+            if(!(p[i] & CONTINUATION)) {
+               out = v;
+               return i + 1;
+            }
+         }
+         return 0;
+      }
+      
+      static uint64_t load64(const block_data_t* p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+         uint64_t w;
+         memcpy(&w, p, sizeof(w));
+         return w;
+#else
+         return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+            ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+#endif
+      }
+      
+      /// v must not be 0
+      static unsigned trailing_zeros(uint64_t v) {
+#ifdef __GNUC__
+         return __builtin_ctzll(v);
+#else
+         unsigned n = 0;
+         while(!(v & 1)) { v >>= 1; n++; }
+         return n;
+#endif
+      }
+      
+      /// v must not be 0
+      static unsigned significant_bits(uint64_t v) {
+#ifdef __GNUC__
+         return 64 - __builtin_clzll(v);
+#else
+         unsigned n = 0;
+         while(v) { v >>= 1; n++; }
+         return n;
+#endif
+      }
+      
+#if VARINT_CODEC_SSSE3
+      /**
+       * For each pattern of continuation bits of eight bytes: how to
+       * spread the leading one and two byte varints into 16 bit lanes, how
+       * many there are and how many bytes they take. count is 0 if the
+       * first varint is longer than that.
+       */
+      struct ShuffleEntry {
+         uint8_t shuffle[16];
+         uint8_t count;
+         uint8_t consumed;
+      };
+      
+      static const ShuffleEntry* shuffle_table() {
+         static ShuffleEntry table[256];
+         static bool initialized = false;
+         if(!initialized) {
+            for(unsigned mask = 0; mask < 256; mask++) {
+               ShuffleEntry &e = table[mask];
+               unsigned pos = 0, count = 0;
+               memset(e.shuffle, 0x80, sizeof(e.shuffle));
+               while(pos < 8) {
+                  if(!(mask & (1 << pos))) {
+                     e.shuffle[2 * count] = pos;
+                     pos += 1;
+                  }
+                  else if(pos + 1 < 8 && !(mask & (1 << (pos + 1)))) {
+                     e.shuffle[2 * count] = pos;
+                     e.shuffle[2 * count + 1] = pos + 1;
+                     pos += 2;
+                  }
+                  else { break; }
+                  count++;
+               }
+               e.count = count;
+               e.consumed = pos;
+            }
+            initialized = true;
+         }
+         return table;
+      }
+#endif
+};
+
+   }
+}
+
+#endif // VARINT_CODEC_H
+// vim: set ts=3 sw=3 expandtab:
+
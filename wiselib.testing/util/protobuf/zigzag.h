@@ -0,0 +1,80 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+
+#ifndef ZIGZAG_H
+#define ZIGZAG_H
+
+#include "util/protobuf/varint.h"
+
+namespace wiselib {
+   namespace protobuf {
+
+/**
+ * Implements the ProtobufRW Concept for the sint32/sint64 encoding:
+ * signed values are mapped to unsigned ones (0, -1, 1, -2, ... to 0, 1, 2,
+ * 3, ...) so small magnitudes of either sign make short varints.
+ * 
+ * \tparam Integer_P Signed integer type that is used on the application
+ * side, up to 64 bits.
+ */
+template<
+   typename OsModel_P,
+   typename Buffer_P,
+   typename Integer_P
+>
+class ZigZag {
+   public:
+      typedef OsModel_P Os;
+      typedef Buffer_P buffer_t;
+      typedef typename Os::block_data_t block_data_t;
+      typedef Integer_P int_t;
+      typedef typename VarIntUnsigned<sizeof(int_t)>::type uint_t;
+      
+      typedef VarInt<Os, buffer_t, uint_t> varint_t;
+      
+      enum { WIRE_TYPE = 0 };
+      
+      static uint_t encode(int_t v) {
+         uint_t u = (uint_t)v << 1;
+         return v < 0 ? (uint_t)~u : u;
+      }
+      
+      static int_t decode(uint_t u) {
+         return (int_t)((u >> 1) ^ (uint_t)(0 - (u & 1)));
+      }
+      
+      static bool write(buffer_t& buffer, buffer_t& buffer_end, int_t v, size_t sz=0) {
+         return varint_t::write(buffer, buffer_end, encode(v));
+      }
+      
+      static bool read(buffer_t& buffer, buffer_t& buffer_end, int_t& out) {
+         uint_t u;
+         if(!varint_t::read(buffer, buffer_end, u)) { return false; }
+         out = decode(u);
+         return true;
+      }
+};
+
+   }
+}
+
+#endif // ZIGZAG_H
+// vim: set ts=3 sw=3 expandtab:
+
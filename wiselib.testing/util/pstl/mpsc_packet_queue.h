@@ -0,0 +1,204 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __WISELIB_INTERNAL_INTERFACE_STL_MPSC_PACKET_QUEUE_H
+#define __WISELIB_INTERNAL_INTERFACE_STL_MPSC_PACKET_QUEUE_H
+
+#include <string.h>
+
+namespace wiselib {
+
+   /** \brief Bounded lock-free multi producer / single consumer queue of
+    *  received radio packets.
+    *
+    *  Packets are copied into one of SLOTS_P fixed size buffers by push(),
+    *  which may be called concurrently from any number of threads or signal
+    *  handlers. A single consumer hands them out again with drain().
+    *  The ring follows the well known sequence number scheme: every slot
+    *  carries a sequence number telling whether it is free for the producer
+    *  of a given position or ready for the consumer, so neither side ever
+    *  blocks. Synchronization relies on the GCC __sync builtins.
+    *
+    *  \tparam SLOTS_P Number of slots, must be a power of two.
+    *  \tparam BUFFER_SIZE_P Size of each slot buffer. Longer packets are
+    *    dropped.
+    */
+   template<typename OsModel_P,
+            typename NodeId_P,
+            typename ExtendedData_P,
+            int SLOTS_P,
+            int BUFFER_SIZE_P>
+   class MpscPacketQueue
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef NodeId_P node_id_t;
+      typedef ExtendedData_P ExtendedData;
+      typedef typename OsModel::size_t size_t;
+      typedef typename OsModel::block_data_t block_data_t;
+
+      typedef unsigned long position_t;
+
+      enum
+      {
+         SLOTS = SLOTS_P,
+         BUFFER_SIZE = BUFFER_SIZE_P
+      };
+      // --------------------------------------------------------------------
+      MpscPacketQueue()
+      { clear(); }
+      // --------------------------------------------------------------------
+      /** Resets queue and counters. Must not run concurrently to push() or
+       *  drain().
+       */
+      void clear()
+      {
+         for ( int i = 0; i < SLOTS; ++i )
+            slots_[i].sequence = i;
+         head_ = 0;
+         tail_ = 0;
+         dropped_ = 0;
+         high_water_mark_ = 0;
+      }
+      // --------------------------------------------------------------------
+      /** Copies a received packet into the queue. Safe to call from any
+       *  context. Returns false (and counts a drop) if the queue is full or
+       *  the packet does not fit into a slot.
+       */
+      bool push( node_id_t from, size_t len, block_data_t *data,
+                 const ExtendedData& ex = ExtendedData() )
+      {
+         if ( len > (size_t)BUFFER_SIZE )
+         {
+            __sync_fetch_and_add( &dropped_, 1 );
+            return false;
+         }
+
+         Slot *slot;
+         position_t pos = tail_;
+         for ( ;; )
+         {
+            slot = &slots_[pos & ( SLOTS - 1 )];
+            position_t seq = slot->sequence;
+            __sync_synchronize();
+            long diff = (long)seq - (long)pos;
+
+            if ( diff == 0 )
+            {
+               if ( __sync_bool_compare_and_swap( &tail_, pos, pos + 1 ) )
+                  break;
+               pos = tail_;
+            }
+            else if ( diff < 0 )
+            {
+               __sync_fetch_and_add( &dropped_, 1 );
+               return false;
+            }
+            else
+               pos = tail_;
+         }
+
+         slot->from = from;
+         slot->len = len;
+         slot->ex = ex;
+         memcpy( slot->data, data, len );
+
+         // publish
+         __sync_synchronize();
+         slot->sequence = pos + 1;
+
+         update_high_water_mark( pos + 1 - head_ );
+         return true;
+      }
+      // --------------------------------------------------------------------
+      /** Hands up to \a max queued packets to \a obj->TMethod, in order of
+       *  arrival. Only one consumer may drain at a time. Returns the number
+       *  of delivered packets.
+       */
+      template<class T, void (T::*TMethod)( node_id_t, size_t, block_data_t*, const ExtendedData& )>
+      size_t drain( T *obj, size_t max = SLOTS )
+      {
+         size_t count = 0;
+         while ( count < max )
+         {
+            Slot *slot = &slots_[head_ & ( SLOTS - 1 )];
+            position_t seq = slot->sequence;
+            __sync_synchronize();
+            if ( seq != head_ + 1 )
+               break;
+
+            (obj->*TMethod)( slot->from, slot->len, slot->data, slot->ex );
+
+            __sync_synchronize();
+            slot->sequence = head_ + SLOTS;
+            head_++;
+            count++;
+         }
+         return count;
+      }
+      // --------------------------------------------------------------------
+      /** Number of queued packets (a snapshot, may change concurrently).
+       */
+      size_t size()
+      { return (size_t)( tail_ - head_ ); }
+      // --------------------------------------------------------------------
+      bool empty()
+      { return size() == 0; }
+      // --------------------------------------------------------------------
+      /** Number of packets dropped because the queue was full or they were
+       *  too long.
+       */
+      unsigned long dropped()
+      { return dropped_; }
+      // --------------------------------------------------------------------
+      /** Maximum number of packets that were queued at the same time.
+       */
+      size_t high_water_mark()
+      { return high_water_mark_; }
+
+   private:
+      struct Slot
+      {
+         volatile position_t sequence;
+         node_id_t from;
+         size_t len;
+         ExtendedData ex;
+         block_data_t data[BUFFER_SIZE];
+      };
+      // --------------------------------------------------------------------
+      void update_high_water_mark( position_t fill )
+      {
+         size_t mark = high_water_mark_;
+         while ( fill > mark )
+         {
+            if ( __sync_bool_compare_and_swap( &high_water_mark_, mark, (size_t)fill ) )
+               break;
+            mark = high_water_mark_;
+         }
+      }
+
+      Slot slots_[SLOTS];
+      volatile position_t head_;
+      volatile position_t tail_;
+      volatile unsigned long dropped_;
+      volatile size_t high_water_mark_;
+   };
+
+}
+
+#endif
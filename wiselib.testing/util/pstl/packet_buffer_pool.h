@@ -0,0 +1,360 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+#ifndef __WISELIB_UTIL_PSTL_PACKET_BUFFER_POOL_H
+#define __WISELIB_UTIL_PSTL_PACKET_BUFFER_POOL_H
+
+#include "util/meta.h"
+#include <string.h>
+
+#ifndef PACKET_POOL_BUFFERS
+#define PACKET_POOL_BUFFERS 8
+#endif
+
+#ifndef PACKET_POOL_BUFFER_SIZE
+#define PACKET_POOL_BUFFER_SIZE 128
+#endif
+
+#ifndef PACKET_POOL_HEADROOM
+#define PACKET_POOL_HEADROOM 32
+#endif
+
+namespace wiselib {
+
+   /** \brief Pool of fixed size packet buffers handed out as reference
+    *  counted handles.
+    *
+    *  Instead of a block_data_t array of the maximal message length on the
+    *  stack of every send path, a packet lives in one of BUFFERS_P static
+    *  buffers. Copying a Packet handle only takes another reference, so a
+    *  packet can sit in a send queue, wait for its retransmission and be
+    *  forwarded by another layer at the same time; the buffer returns to
+    *  the pool with its last handle.
+    *
+    *  The bytes of a packet are a window into its buffer: push() grows it
+    *  into the headroom in front (a lower layer prepending its header),
+    *  pull() strips a header again, put() and trim() move the tail. The
+    *  window belongs to the buffer, not to the handle, so a layer changing
+    *  a packet that is shared() should clone() it first. A packet
+    *  allocated with the RadioStackTraits<Radio>::HEADROOM of a radio
+    *  stack can be sent in place by RadioStackTraits<Radio>::send().
+    *
+    *  A buffer takes at most MAX_REFERENCES handles; copying a handle
+    *  beyond that yields an invalid one instead of wrapping the count.
+    *  An invalid handle has no bytes: data() is 0, its lengths are 0 and
+    *  push(), pull() and put() fail.
+    *
+    *  Allocation and release are O(1) via a free list. The pool is meant
+    *  for a single execution context, like the rest of the node's
+    *  networking code.
+    *
+    *  \tparam BUFFERS_P Number of buffers, at most 254.
+    *  \tparam BUFFER_SIZE_P Size of each buffer, headroom included.
+    *  \tparam HEADROOM_P Default headroom of allocate().
+    */
+   template<typename OsModel_P,
+            int BUFFERS_P = PACKET_POOL_BUFFERS,
+            int BUFFER_SIZE_P = PACKET_POOL_BUFFER_SIZE,
+            int HEADROOM_P = PACKET_POOL_HEADROOM>
+   class PacketBufferPool
+   {
+   public:
+      typedef OsModel_P OsModel;
+      typedef typename OsModel::size_t size_t;
+      typedef typename OsModel::block_data_t block_data_t;
+
+      typedef PacketBufferPool<OsModel, BUFFERS_P, BUFFER_SIZE_P, HEADROOM_P> self_type;
+      typedef self_type* self_pointer_t;
+
+      enum
+      {
+         BUFFERS = BUFFERS_P,
+         BUFFER_SIZE = BUFFER_SIZE_P,
+         HEADROOM = HEADROOM_P,
+         NO_BUFFER = 0xff,
+         MAX_REFERENCES = 0xffff
+      };
+
+      // buffer indices are uint8_t with NO_BUFFER as end of the free list
+      static_assert( BUFFERS_P < NO_BUFFER && HEADROOM_P <= BUFFER_SIZE_P );
+      // --------------------------------------------------------------------
+      struct Stats
+      {
+         uint32_t allocations;
+         uint32_t failures;         ///< allocations with the pool empty
+         uint32_t clones;
+         uint16_t in_use;
+         uint16_t high_water_mark;  ///< most buffers in use at once
+      };
+      // --------------------------------------------------------------------
+      class Packet;
+      friend class Packet;
+
+   private:
+      struct Meta
+      {
+         uint16_t offset;
+         uint16_t length;
+         uint16_t references;
+         uint8_t next;
+      };
+
+   public:
+      /** \brief Reference to a packet buffer of the pool.
+       */
+      class Packet
+      {
+      public:
+         Packet()
+            : pool_( 0 ), index_( NO_BUFFER )
+         {}
+         // -----------------------------------------------------------------
+         /** Takes another reference to the buffer of other, invalid if
+          *  the buffer already has MAX_REFERENCES.
+          */
+         Packet( const Packet& other )
+            : pool_( other.pool_ ), index_( other.index_ )
+         {
+            if ( valid() && !pool_->add_ref( index_ ) )
+               index_ = NO_BUFFER;
+         }
+         // -----------------------------------------------------------------
+         ~Packet()
+         { release(); }
+         // -----------------------------------------------------------------
+         Packet& operator=( const Packet& other )
+         {
+            if ( other.pool_ == pool_ && other.index_ == index_ )
+               return *this;
+            self_pointer_t pool = other.pool_;
+            uint8_t index = other.index_;
+            if ( other.valid() && !pool->add_ref( index ) )
+               index = NO_BUFFER;
+            release();
+            pool_ = pool;
+            index_ = index;
+            return *this;
+         }
+         // -----------------------------------------------------------------
+         /** False for a default constructed handle and a failed
+          *  allocation.
+          */
+         bool valid() const
+         { return index_ != NO_BUFFER; }
+         // -----------------------------------------------------------------
+         /** Drops this reference, the handle becomes invalid.
+          */
+         void release()
+         {
+            if ( valid() )
+            {
+               pool_->unref( index_ );
+               index_ = NO_BUFFER;
+            }
+         }
+         // -----------------------------------------------------------------
+         block_data_t* data() const
+         { return valid() ? pool_->buffers_[index_] + meta().offset : 0; }
+         // -----------------------------------------------------------------
+         size_t length() const
+         { return valid() ? meta().length : 0; }
+         // -----------------------------------------------------------------
+         size_t headroom() const
+         { return valid() ? meta().offset : 0; }
+         // -----------------------------------------------------------------
+         size_t tailroom() const
+         { return valid() ? BUFFER_SIZE - meta().offset - meta().length : 0; }
+         // -----------------------------------------------------------------
+         uint16_t references() const
+         { return valid() ? meta().references : 0; }
+         // -----------------------------------------------------------------
+         bool shared() const
+         { return references() > 1; }
+         // -----------------------------------------------------------------
+         /** Grows the packet by n bytes in front, e.g. for a header.
+          *  \return the new data(), 0 if the headroom is too small
+          */
+         block_data_t* push( size_t n )
+         {
+            if ( !valid() || n > headroom() )
+               return 0;
+            meta().offset -= n;
+            meta().length += n;
+            return data();
+         }
+         // -----------------------------------------------------------------
+         /** Strips n bytes in front, e.g. a header that was handled.
+          *  \return the new data(), 0 if the packet is shorter
+          */
+         block_data_t* pull( size_t n )
+         {
+            if ( !valid() || n > length() )
+               return 0;
+            meta().offset += n;
+            meta().length -= n;
+            return data();
+         }
+         // -----------------------------------------------------------------
+         /** Grows the packet by n bytes at its end.
+          *  \return the first of them, 0 if the tailroom is too small
+          */
+         block_data_t* put( size_t n )
+         {
+            if ( !valid() || n > tailroom() )
+               return 0;
+            block_data_t *tail = data() + length();
+            meta().length += n;
+            return tail;
+         }
+         // -----------------------------------------------------------------
+         /** Cuts the packet to len bytes.
+          */
+         void trim( size_t len )
+         {
+            if ( len < length() )
+               meta().length = len;
+         }
+
+      private:
+         friend class PacketBufferPool;
+
+         Packet( self_pointer_t pool, uint8_t index )
+            : pool_( pool ), index_( index )
+         {}
+         // -----------------------------------------------------------------
+         Meta& meta() const
+         { return pool_->meta_[index_]; }
+         // -----------------------------------------------------------------
+         self_pointer_t pool_;
+         uint8_t index_;
+      };
+      // --------------------------------------------------------------------
+      PacketBufferPool()
+      { init(); }
+      // --------------------------------------------------------------------
+      /** Constructor used by the FacetProvider of OS models that hand the
+       *  application parameter to their facets.
+       */
+      explicit PacketBufferPool( typename OsModel::AppMainParameter& )
+      { init(); }
+      // --------------------------------------------------------------------
+      /** Empty packet with headroom bytes in front.
+       *  \return invalid handle if the pool is exhausted
+       */
+      Packet allocate( size_t headroom = HEADROOM )
+      {
+         if ( free_ == NO_BUFFER || headroom > (size_t)BUFFER_SIZE )
+         {
+            stats_.failures++;
+            return Packet();
+         }
+         uint8_t index = free_;
+         free_ = meta_[index].next;
+         meta_[index].references = 1;
+         meta_[index].offset = headroom;
+         meta_[index].length = 0;
+
+         stats_.allocations++;
+         if ( ++stats_.in_use > stats_.high_water_mark )
+            stats_.high_water_mark = stats_.in_use;
+         return Packet( this, index );
+      }
+      // --------------------------------------------------------------------
+      /** Packet holding a copy of len bytes at data.
+       */
+      Packet allocate( const block_data_t *data, size_t len, size_t headroom = HEADROOM )
+      {
+         if ( headroom + len > (size_t)BUFFER_SIZE )
+         {
+            stats_.failures++;
+            return Packet();
+         }
+         Packet p = allocate( headroom );
+         if ( p.valid() )
+            memcpy( p.put( len ), data, len );
+         return p;
+      }
+      // --------------------------------------------------------------------
+      /** Private copy of p with the same headroom, to be changed while p
+       *  is shared.
+       */
+      Packet clone( const Packet& p )
+      {
+         if ( !p.valid() )
+            return Packet();
+         Packet c = allocate( p.data(), p.length(), p.headroom() );
+         if ( c.valid() )
+            stats_.clones++;
+         return c;
+      }
+      // --------------------------------------------------------------------
+      size_t available() const
+      { return BUFFERS - stats_.in_use; }
+      // --------------------------------------------------------------------
+      const Stats& stats() const
+      { return stats_; }
+      // --------------------------------------------------------------------
+      /** Clears the counters, in_use stays.
+       */
+      void reset_stats()
+      {
+         uint16_t in_use = stats_.in_use;
+         memset( &stats_, 0, sizeof( stats_ ) );
+         stats_.in_use = in_use;
+         stats_.high_water_mark = in_use;
+      }
+
+   private:
+      void init()
+      {
+         for ( int i = 0; i < BUFFERS; ++i )
+         {
+            meta_[i].references = 0;
+            meta_[i].next = i + 1 < BUFFERS ? i + 1 : NO_BUFFER;
+         }
+         free_ = BUFFERS > 0 ? 0 : NO_BUFFER;
+         memset( &stats_, 0, sizeof( stats_ ) );
+      }
+      // --------------------------------------------------------------------
+      bool add_ref( uint8_t index )
+      {
+         if ( meta_[index].references == MAX_REFERENCES )
+            return false;
+         meta_[index].references++;
+         return true;
+      }
+      // --------------------------------------------------------------------
+      void unref( uint8_t index )
+      {
+         if ( --meta_[index].references == 0 )
+         {
+            meta_[index].next = free_;
+            free_ = index;
+            stats_.in_use--;
+         }
+      }
+      // --------------------------------------------------------------------
+      block_data_t buffers_[BUFFERS][BUFFER_SIZE];
+      Meta meta_[BUFFERS];
+      uint8_t free_;
+      Stats stats_;
+   };
+
+}
+
+#endif
@@ -25,12 +25,146 @@
 #ifndef __WISELIB_UTIL_SERIALIZATION_BITWISE_SERIALIZATION_H
 #define __WISELIB_UTIL_SERIALIZATION_BITWISE_SERIALIZATION_H
 
+#include "util/serialization/serialization.h"
+
 namespace wiselib
 {
+	/** \brief Big endian word covering SPAN_P bytes of a buffer.
+	* Words of 2, 4 and 8 bytes are loaded and stored with the regular
+	* serialization (i.e. with a single byte swap on little endian hosts),
+	* other sizes are assembled byte by byte into the next larger word.
+	*/
+	template <typename OsModel_P,
+		typename BlockData_P,
+		int SPAN_P>
+	struct Bitwise_Word
+	{
+		typedef typename Bitwise_Word<OsModel_P, BlockData_P, SPAN_P + 1>::word_t word_t;
+
+		static inline word_t load( BlockData_P *target )
+		{
+			word_t word = 0;
+			for( int i = 0; i < SPAN_P; i++ )
+				word = ( word << 8 ) | target[i];
+			return word;
+		}
+
+		static inline void store( BlockData_P *target, word_t word )
+		{
+			for( int i = SPAN_P - 1; i >= 0; i-- )
+			{
+				target[i] = word & 0xFF;
+				word >>= 8;
+			}
+		}
+	};
+
+	template <typename OsModel_P,
+		typename BlockData_P>
+	struct Bitwise_Word<OsModel_P, BlockData_P, 1>
+	{
+		typedef uint8_t word_t;
+
+		static inline word_t load( BlockData_P *target )
+		{ return *target; }
+
+		static inline void store( BlockData_P *target, word_t word )
+		{ *target = word; }
+	};
+
+	template <typename OsModel_P,
+		typename BlockData_P,
+		typename Word_P>
+	struct Bitwise_SerializedWord
+	{
+		typedef Word_P word_t;
+
+		static inline word_t load( BlockData_P *target )
+		{ return wiselib::read<OsModel_P, BlockData_P, word_t>( target ); }
+
+		static inline void store( BlockData_P *target, word_t word )
+		{ wiselib::write<OsModel_P, BlockData_P, word_t>( target, word ); }
+	};
+
+	template <typename OsModel_P,
+		typename BlockData_P>
+	struct Bitwise_Word<OsModel_P, BlockData_P, 2>
+		: public Bitwise_SerializedWord<OsModel_P, BlockData_P, uint16_t>
+	{};
+
+	template <typename OsModel_P,
+		typename BlockData_P>
+	struct Bitwise_Word<OsModel_P, BlockData_P, 4>
+		: public Bitwise_SerializedWord<OsModel_P, BlockData_P, uint32_t>
+	{};
+
+	template <typename OsModel_P,
+		typename BlockData_P>
+	struct Bitwise_Word<OsModel_P, BlockData_P, 8>
+		: public Bitwise_SerializedWord<OsModel_P, BlockData_P, uint64_t>
+	{};
+
+	// -----------------------------------------------------------------------
+	/** \brief Compile time bit field layout
+	* Describes a field of WIDTH_P bits which starts OFFSET_P bits after the
+	* most significant bit of the target byte (OFFSET_P may exceed 8).
+	* WIDTH_P = 0 means the full size of Type_P, OFFSET_P % 8 + WIDTH_P must
+	* not exceed 64.
+	* Reading and writing is a single word load, shift and mask, the layout
+	* on the wire is the same as with Bitwise_Serialization.
+	*/
+	template <typename OsModel_P,
+		typename BlockData_P,
+		typename Type_P,
+		int OFFSET_P,
+		int WIDTH_P>
+	struct Bitwise_Field
+	{
+		typedef OsModel_P OsModel;
+		typedef BlockData_P BlockData;
+		typedef Type_P Type;
+
+		typedef typename OsModel::size_t size_t;
+
+		enum
+		{
+			BYTE = OFFSET_P / 8,
+			SHIFT = OFFSET_P % 8,
+			WIDTH = WIDTH_P ? WIDTH_P : sizeof( Type ) * 8,
+			SPAN = ( SHIFT + WIDTH + 7 ) / 8,
+			//Bits after the field in the last covered byte
+			TAIL = SPAN * 8 - SHIFT - WIDTH
+		};
+
+		typedef Bitwise_Word<OsModel, BlockData, SPAN> Word;
+		typedef typename Word::word_t word_t;
+		// --------------------------------------------------------------------
+		static inline word_t mask()
+		{
+			return ((word_t)~(word_t)0) >> ( sizeof( word_t ) * 8 - WIDTH );
+		}
+		// --------------------------------------------------------------------
+		static inline size_t write( BlockData *target, Type& value )
+		{
+			word_t word = Word::load( target + BYTE );
+			word &= ~(word_t)( mask() << TAIL );
+			word |= (word_t)(( (word_t)value & mask() ) << TAIL );
+			Word::store( target + BYTE, word );
+			return sizeof(Type);
+		}
+		// --------------------------------------------------------------------
+		static inline Type read( BlockData *target )
+		{
+			return (Type)(( Word::load( target + BYTE ) >> TAIL ) & mask() );
+		}
+	};
+
+	// -----------------------------------------------------------------------
 	/** \brief Bitwise Serializaton 
 	* This class was made for the IPv6 stack.
 	* The goal is to write and read content to a byte array, to/from a specified position.
 	* The position is specified as: Byte position, Bit shift, Length of the data
+	* If the position is known at compile time, prefer Bitwise_Field.
 	*/
 	template <typename OsModel_P,
 		typename BlockData_P,
@@ -42,111 +176,60 @@ namespace wiselib
 		typedef Type_P Type;
 
 		typedef typename OsModel::size_t size_t;
+
+		//Word covering the value at any bit shift (as long as the value
+		//is at most 57 bits long)
+		typedef typename Bitwise_Word<OsModel, BlockData,
+			( sizeof( Type ) < 8 ) ? sizeof( Type ) + 1 : 8>::word_t word_t;
 		// --------------------------------------------------------------------
 		static inline size_t write( BlockData *target, Type& value, uint8_t target_shift, uint8_t value_length)
 		{
-		
 			//Default size is the full size of the type
 			if( value_length == 0 )
 				value_length = sizeof( Type ) * 8;
-		
-			//Byte shift from the start
-			int position = 0;
-		
-			while( 1 )
-			{
-				//If the remaining bits are less than the space in the actual byte
-				if( value_length <= ( 8 - target_shift ))
-				{
-					//Clear the bits
-					//Set 1 to the bits upper than the value
-					BlockData mask = (0xFF << ( 8 - target_shift ));
-					//Set 1 to the bits lower than the value
-					mask |= ~(0xFF << ( 8 - target_shift - value_length ));
-					target[position] &= mask;
-					
-					target[position] |= value << ( 8 - value_length - target_shift );
-					return sizeof(Type);
-				}
-				//If there will be an overflow
-				
-				else
-				{
-					//Clear the lower bits in the byte if target_shift exists or the whole byte if not.
-					target[position] &= ~(0xFF >> target_shift);
-					
-					//remaining length
-					value_length -= ( 8 - target_shift );
-					
-					//Shift out the overflow bits
-					//1. Shift the actual highest bit to the top of the byte
-					//2. Mask (FF), the higher bits will be 0 after this, (if there is a target_shift the length will be less than 8 bit, but all the upper bits will be 0
-					target[position] |= ((value >> value_length) & 0xFF );
-					
-					//target_shift is just for the first byte
-					target_shift = 0;
-					//Byte shift
-					position++;
-				}
-			}
+
+			uint8_t span = ( target_shift + value_length + 7 ) / 8;
+			uint8_t tail = span * 8 - target_shift - value_length;
+			word_t mask = ((word_t)~(word_t)0) >> ( sizeof( word_t ) * 8 - value_length );
+
+			word_t word = load( target, span );
+			word &= ~(word_t)( mask << tail );
+			word |= (word_t)(( (word_t)value & mask ) << tail );
+			store( target, span, word );
+			return sizeof(Type);
 		}
-	
 		// --------------------------------------------------------------------
 		static Type read( BlockData *target, uint8_t target_shift, uint8_t value_length )
 		{
-			
-			Type value;
-			//memset( value, 0, sizeof( Type ));
-			//for( int i=0; i < sizeof(Type); i++)
-			value=0;
-			
 			//Default size is the full size of the type
 			if( value_length == 0 )
-			value_length = sizeof( Type ) * 8;
-			
-			//Byte shift from the start
-			int position = 0;
-			
-			while( 1 )
+				value_length = sizeof( Type ) * 8;
+
+			uint8_t span = ( target_shift + value_length + 7 ) / 8;
+			uint8_t tail = span * 8 - target_shift - value_length;
+			word_t mask = ((word_t)~(word_t)0) >> ( sizeof( word_t ) * 8 - value_length );
+
+			return (Type)(( load( target, span ) >> tail ) & mask );
+		}
+
+	private:
+		// --------------------------------------------------------------------
+		static inline word_t load( BlockData *target, uint8_t span )
+		{
+			word_t word = 0;
+			for( uint8_t i = 0; i < span; i++ )
+				word = ( word << 8 ) | target[i];
+			return word;
+		}
+		// --------------------------------------------------------------------
+		static inline void store( BlockData *target, uint8_t span, word_t word )
+		{
+			for( int i = span - 1; i >= 0; i-- )
 			{
-				//Mask for the upper bits
-				// mask: 11111111
-				BlockData mask = 0xFF;
-				for( uint8_t i = 0; i < target_shift; i++ )
-				{
-					//mask: 01111111 ...
-					mask /= 2;
-				}
-				
-				
-				//If the remaining bits are in the actual byte
-				if( value_length <= ( 8 - target_shift ))
-				{
-					//Free up space
-					value <<= ( value_length );
-					//1. Shift out the bits before the target_shift
-					//2. Shift the bits to the lowest position
-					value |= (( target[position] & (mask) ) >> ( 8 - value_length - target_shift));
-					return value;
-				}
-				//If there will be an overflow
-				else
-				{
-					//Free up space
-					value <<= ( 8 - target_shift );
-
-					value |= ( target[position] & (mask) );
-
-					//remaining length
-					value_length -= ( 8 - target_shift );
-					//target_shift is just for the first byte
-					target_shift = 0;
-					//Byte shift
-					position++;
-				}
+				target[i] = word & 0xFF;
+				word >>= 8;
 			}
 		}
-
 	};
 
 	template<typename OsModel_P,
@@ -165,5 +248,27 @@ namespace wiselib
 	{
 		return Bitwise_Serialization<OsModel_P, BlockData_P, Type_P>::write( target, value, shift, value_length );
 	}
+
+	// -----------------------------------------------------------------------
+	template<typename OsModel_P,
+		typename BlockData_P,
+		typename Type_P,
+		int SHIFT_P,
+		int LENGTH_P>
+	inline Type_P bitwise_read( BlockData_P *target )
+	{
+		return Bitwise_Field<OsModel_P, BlockData_P, Type_P, SHIFT_P, LENGTH_P>::read( target );
+	}
+
+	// -----------------------------------------------------------------------
+	template<typename OsModel_P,
+		typename BlockData_P,
+		typename Type_P,
+		int SHIFT_P,
+		int LENGTH_P>
+	inline typename OsModel_P::size_t bitwise_write( BlockData_P *target, Type_P& value )
+	{
+		return Bitwise_Field<OsModel_P, BlockData_P, Type_P, SHIFT_P, LENGTH_P>::write( target, value );
+	}
 }
 #endif
@@ -0,0 +1,744 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef ART_DICTIONARY_H
+#define ART_DICTIONARY_H
+
+#include <util/meta.h>
+#include <string.h>
+
+namespace wiselib {
+
+	/**
+	 * Dictionary for zero-terminated block_data_t-arrays (e.g. strings),
+	 * implemented as adaptive radix tree (Leis et al., "The Adaptive Radix
+	 * Tree: ARTful Indexing for Main-Memory Databases").
+	 *
+	 * Inner nodes branch on one byte and come in four sizes (4, 16, 48 and
+	 * 256 children) that grow and shrink with their fan-out. Runs of bytes
+	 * without branches are collapsed into a node prefix (path compression,
+	 * up to MAX_PREFIX bytes stored in the node, longer prefixes are
+	 * checked against a leaf), so lookups of long IRIs sharing their
+	 * first bytes touch few nodes and compare whole bytes.
+	 *
+	 * Leaves hold a reference counted copy of the value; their address is
+	 * the key. The terminating zero is part of the indexed bytes so no
+	 * value is a prefix of another one.
+	 *
+	 * Implements the same interface as PrescillaDictionary.
+	 */
+	template<
+		typename OsModel_P,
+		typename Debug_P = typename OsModel_P::Debug
+	>
+	class ArtDictionary {
+
+		public:
+			typedef OsModel_P OsModel;
+			typedef Debug_P Debug;
+			typedef ArtDictionary<OsModel, Debug> self_type;
+			typedef self_type* self_pointer_t;
+
+			typedef typename OsModel::block_data_t block_data_t;
+			typedef typename OsModel::size_t size_type;
+
+			typedef block_data_t* value_type;
+			typedef block_data_t* mapped_type;
+			typedef typename Uint<sizeof(void*)>::t key_type;
+			typedef size_type refcount_t;
+
+			enum {
+				ABSTRACT_KEYS = true
+			};
+
+			enum {
+				MAX_PREFIX = 10
+			};
+
+			static const key_type NULL_KEY;
+
+		private:
+			enum NodeType { NODE4, NODE16, NODE48, NODE256 };
+
+			struct Leaf {
+				Leaf *prev;
+				Leaf *next;
+				refcount_t refcount;
+				size_type length; // including the terminating zero
+				block_data_t data[1];
+			};
+
+			/// Inner node or tagged leaf pointer.
+			struct Node;
+			typedef Node* child_t;
+
+			struct Node {
+				::uint8_t type;
+				::uint16_t children;
+				::uint32_t prefix_length;
+				block_data_t prefix[MAX_PREFIX];
+			};
+
+			struct Node4 : public Node {
+				::uint8_t keys[4];
+				child_t child[4];
+			};
+
+			struct Node16 : public Node {
+				::uint8_t keys[16];
+				child_t child[16];
+			};
+
+			struct Node48 : public Node {
+				::uint8_t index[256]; // slot + 1, 0 = no child
+				child_t child[48];
+			};
+
+			struct Node256 : public Node {
+				child_t child[256];
+			};
+
+		public:
+			/**
+			 * Iterates over all keys (in insertion order).
+			 */
+			class iterator {
+				public:
+					iterator(Leaf *l) : leaf_(l) {
+					}
+
+					key_type operator*() { return to_key(leaf_); }
+					iterator& operator++() {
+						leaf_ = leaf_->next;
+						return *this;
+					}
+
+					bool operator==(const iterator& other) { return leaf_ == other.leaf_; }
+					bool operator!=(const iterator& other) { return leaf_ != other.leaf_; }
+
+				private:
+					Leaf *leaf_;
+			};
+
+			ArtDictionary() : root_(0), leaves_(0), size_(0) {
+			}
+
+			~ArtDictionary() {
+				destruct(root_);
+			}
+
+			int init(typename Debug::self_pointer_t debug) {
+				debug_ = debug;
+				return OsModel::SUCCESS;
+			}
+
+			/**
+			 * value will be copied into the dictionary (non-shallowly, i.e.
+			 * you may remove the original value afterwards!)
+			 */
+			key_type insert(value_type value) {
+				size_type len = strlen((char*)value) + 1;
+				return to_key(insert(&root_, value, len, 0));
+			}
+
+			key_type find(value_type value) {
+				size_type len = strlen((char*)value) + 1;
+				child_t n = root_;
+				size_type depth = 0;
+
+				while(n) {
+					if(is_leaf(n)) {
+						Leaf *l = as_leaf(n);
+						return leaf_matches(l, value, len) ? to_key(l) : NULL_KEY;
+					}
+					if(n->prefix_length) {
+						if(check_prefix(n, value, len, depth) != prefix_stored(n)) {
+							return NULL_KEY;
+						}
+						depth += n->prefix_length;
+					}
+					if(depth >= len) { return NULL_KEY; }
+					child_t *c = find_child(n, value[depth]);
+					n = c ? *c : 0;
+					depth++;
+				}
+				return NULL_KEY;
+			}
+
+			void erase(key_type k) {
+				Leaf *l = to_leaf(k);
+				if(--l->refcount > 0) {
+					return;
+				}
+				remove(&root_, l, 0);
+
+				if(l->prev) { l->prev->next = l->next; }
+				else { leaves_ = l->next; }
+				if(l->next) { l->next->prev = l->prev; }
+				get_allocator().free_array((block_data_t*)l);
+				size_--;
+			}
+
+			iterator begin_keys() { return iterator(leaves_); }
+			iterator end_keys() { return iterator(0); }
+
+			/**
+			 * The returned value is owned by the dictionary and valid
+			 * until the key is erased; free_value() is a no-op.
+			 */
+			value_type get_value(key_type k) { return to_leaf(k)->data; }
+
+			value_type get_copy(key_type k) {
+				Leaf *l = to_leaf(k);
+				block_data_t *r = get_allocator().template allocate_array<block_data_t>(l->length).raw();
+				memcpy(r, l->data, l->length);
+				return r;
+			}
+
+			void free_value(value_type v) {
+			}
+
+			/// Number of distinct values.
+			size_type size() { return size_; }
+
+		private:
+
+			// {{{ Tagged pointers
+
+			static bool is_leaf(child_t n) { return reinterpret_cast<key_type>(n) & 1; }
+			static Leaf* as_leaf(child_t n) { return reinterpret_cast<Leaf*>(reinterpret_cast<key_type>(n) & ~(key_type)1); }
+			static child_t tag(Leaf *l) { return reinterpret_cast<child_t>(reinterpret_cast<key_type>(l) | 1); }
+			static key_type to_key(Leaf *l) { return reinterpret_cast<key_type>(l); }
+			static Leaf* to_leaf(key_type k) { return reinterpret_cast<Leaf*>(k); }
+
+			// }}}
+
+			// {{{ Leaves
+
+			Leaf* make_leaf(value_type value, size_type len) {
+				block_data_t *p = get_allocator().template allocate_array<block_data_t>(
+						sizeof(Leaf) - 1 + len).raw();
+				Leaf *l = reinterpret_cast<Leaf*>(p);
+				l->refcount = 1;
+				l->length = len;
+				memcpy(l->data, value, len);
+
+				l->prev = 0;
+				l->next = leaves_;
+				if(leaves_) { leaves_->prev = l; }
+				leaves_ = l;
+				size_++;
+				return l;
+			}
+
+			static bool leaf_matches(Leaf *l, value_type value, size_type len) {
+				return l->length == len && memcmp(l->data, value, len) == 0;
+			}
+
+			/**
+			 * Some leaf below n, used to recover prefix bytes beyond
+			 * MAX_PREFIX.
+			 */
+			static Leaf* any_leaf(child_t n) {
+				while(!is_leaf(n)) {
+					switch(n->type) {
+						case NODE4: n = static_cast<Node4*>(n)->child[0]; break;
+						case NODE16: n = static_cast<Node16*>(n)->child[0]; break;
+						case NODE48: {
+							Node48 *n48 = static_cast<Node48*>(n);
+							int i = 0;
+							while(!n48->index[i]) { i++; }
+							n = n48->child[n48->index[i] - 1];
+							break;
+						}
+						default: {
+							Node256 *n256 = static_cast<Node256*>(n);
+							int i = 0;
+							while(!n256->child[i]) { i++; }
+							n = n256->child[i];
+							break;
+						}
+					}
+				}
+				return as_leaf(n);
+			}
+
+			// }}}
+
+			// {{{ Prefixes
+
+			static size_type prefix_stored(Node *n) {
+				return n->prefix_length < (::uint32_t)MAX_PREFIX ? n->prefix_length : (size_type)MAX_PREFIX;
+			}
+
+			/**
+			 * Number of stored prefix bytes of n matching value at depth.
+			 */
+			static size_type check_prefix(Node *n, value_type value, size_type len, size_type depth) {
+				size_type max = prefix_stored(n);
+				if(len - depth < max) { max = len - depth; }
+				size_type i = 0;
+				for( ; i < max && n->prefix[i] == value[depth + i]; i++) { }
+				return i;
+			}
+
+			/**
+			 * Length of the common part of the (full) prefix of n and value
+			 * at depth.
+			 */
+			static size_type prefix_mismatch(Node *n, value_type value, size_type len, size_type depth) {
+				size_type i = check_prefix(n, value, len, depth);
+				if(i < prefix_stored(n) || n->prefix_length <= (::uint32_t)MAX_PREFIX) {
+					return i;
+				}
+				Leaf *l = any_leaf(n);
+				size_type max = (l->length < len ? l->length : len) - depth;
+				if(max > n->prefix_length) { max = n->prefix_length; }
+				for( ; i < max && l->data[depth + i] == value[depth + i]; i++) { }
+				return i;
+			}
+
+			// }}}
+
+			// {{{ Node allocation
+
+			template<typename N>
+			N* make_node(NodeType type) {
+				N *n = get_allocator().template allocate<N>().raw();
+				memset(n, 0, sizeof(N));
+				n->type = type;
+				return n;
+			}
+
+			static void copy_header(Node *to, Node *from) {
+				to->children = from->children;
+				to->prefix_length = from->prefix_length;
+				memcpy(to->prefix, from->prefix, prefix_stored(from));
+			}
+
+			void destruct(child_t n) {
+				if(!n) { return; }
+				if(is_leaf(n)) {
+					get_allocator().free_array((block_data_t*)as_leaf(n));
+					return;
+				}
+				switch(n->type) {
+					case NODE4: {
+						Node4 *n4 = static_cast<Node4*>(n);
+						for(int i = 0; i < n4->children; i++) { destruct(n4->child[i]); }
+						get_allocator().free(n4);
+						break;
+					}
+					case NODE16: {
+						Node16 *n16 = static_cast<Node16*>(n);
+						for(int i = 0; i < n16->children; i++) { destruct(n16->child[i]); }
+						get_allocator().free(n16);
+						break;
+					}
+					case NODE48: {
+						Node48 *n48 = static_cast<Node48*>(n);
+						for(int i = 0; i < 256; i++) {
+							if(n48->index[i]) { destruct(n48->child[n48->index[i] - 1]); }
+						}
+						get_allocator().free(n48);
+						break;
+					}
+					default: {
+						Node256 *n256 = static_cast<Node256*>(n);
+						for(int i = 0; i < 256; i++) { destruct(n256->child[i]); }
+						get_allocator().free(n256);
+						break;
+					}
+				}
+			}
+
+			// }}}
+
+			// {{{ Children
+
+			static child_t* find_child(Node *n, ::uint8_t c) {
+				switch(n->type) {
+					case NODE4: {
+						Node4 *n4 = static_cast<Node4*>(n);
+						for(int i = 0; i < n4->children; i++) {
+							if(n4->keys[i] == c) { return &n4->child[i]; }
+						}
+						return 0;
+					}
+					case NODE16: {
+						Node16 *n16 = static_cast<Node16*>(n);
+						// keys are sorted, binary search
+						int lo = 0, hi = n16->children;
+						while(lo < hi) {
+							int mid = (lo + hi) / 2;
+							if(n16->keys[mid] < c) { lo = mid + 1; }
+							else { hi = mid; }
+						}
+						if(lo < n16->children && n16->keys[lo] == c) { return &n16->child[lo]; }
+						return 0;
+					}
+					case NODE48: {
+						Node48 *n48 = static_cast<Node48*>(n);
+						return n48->index[c] ? &n48->child[n48->index[c] - 1] : 0;
+					}
+					default: {
+						Node256 *n256 = static_cast<Node256*>(n);
+						return n256->child[c] ? &n256->child[c] : 0;
+					}
+				}
+			}
+
+			/**
+			 * Adds child under byte c to *ref, growing the node (and
+			 * replacing *ref) if it is full.
+			 */
+			void add_child(child_t *ref, ::uint8_t c, child_t child) {
+				Node *n = *ref;
+				switch(n->type) {
+					case NODE4: {
+						Node4 *n4 = static_cast<Node4*>(n);
+						if(n4->children < 4) {
+							add_child(n4, c, child);
+							return;
+						}
+						Node16 *n16 = grow(n4);
+						*ref = n16;
+						add_child(n16, c, child);
+						return;
+					}
+					case NODE16: {
+						Node16 *n16 = static_cast<Node16*>(n);
+						if(n16->children < 16) {
+							add_child(n16, c, child);
+							return;
+						}
+						Node48 *n48 = grow(n16);
+						*ref = n48;
+						add_child(n48, c, child);
+						return;
+					}
+					case NODE48: {
+						Node48 *n48 = static_cast<Node48*>(n);
+						if(n48->children < 48) {
+							add_child(n48, c, child);
+							return;
+						}
+						Node256 *n256 = grow(n48);
+						*ref = n256;
+						add_child(n256, c, child);
+						return;
+					}
+					default: {
+						add_child(static_cast<Node256*>(n), c, child);
+						return;
+					}
+				}
+			}
+
+			/**
+			 * Adds child under byte c to a Node4 or Node16 with room left,
+			 * keeping the keys sorted.
+			 */
+			template<typename N>
+			static void add_child(N *n, ::uint8_t c, child_t child) {
+				int i = n->children;
+				for( ; i > 0 && n->keys[i - 1] > c; i--) {
+					n->keys[i] = n->keys[i - 1];
+					n->child[i] = n->child[i - 1];
+				}
+				n->keys[i] = c;
+				n->child[i] = child;
+				n->children++;
+			}
+
+			static void add_child(Node48 *n48, ::uint8_t c, child_t child) {
+				int slot = 0;
+				while(n48->child[slot]) { slot++; }
+				n48->child[slot] = child;
+				n48->index[c] = slot + 1;
+				n48->children++;
+			}
+
+			static void add_child(Node256 *n256, ::uint8_t c, child_t child) {
+				n256->child[c] = child;
+				n256->children++;
+			}
+
+			/**
+			 * Replace a full node by the next larger node type holding
+			 * the same children; the old node is freed.
+			 */
+			Node16* grow(Node4 *n4) {
+				Node16 *n16 = make_node<Node16>(NODE16);
+				copy_header(n16, n4);
+				memcpy(n16->keys, n4->keys, 4);
+				memcpy(n16->child, n4->child, 4 * sizeof(child_t));
+				get_allocator().free(n4);
+				return n16;
+			}
+
+			Node48* grow(Node16 *n16) {
+				Node48 *n48 = make_node<Node48>(NODE48);
+				copy_header(n48, n16);
+				for(int i = 0; i < 16; i++) {
+					n48->index[n16->keys[i]] = i + 1;
+					n48->child[i] = n16->child[i];
+				}
+				get_allocator().free(n16);
+				return n48;
+			}
+
+			Node256* grow(Node48 *n48) {
+				Node256 *n256 = make_node<Node256>(NODE256);
+				copy_header(n256, n48);
+				for(int i = 0; i < 256; i++) {
+					if(n48->index[i]) { n256->child[i] = n48->child[n48->index[i] - 1]; }
+				}
+				get_allocator().free(n48);
+				return n256;
+			}
+
+			/**
+			 * Removes the child under byte c from *ref, shrinking the node
+			 * (and replacing *ref) when it gets sparse.
+			 */
+			void remove_child(child_t *ref, ::uint8_t c) {
+				Node *n = *ref;
+				switch(n->type) {
+					case NODE4: {
+						Node4 *n4 = static_cast<Node4*>(n);
+						int i = 0;
+						while(n4->keys[i] != c) { i++; }
+						for( ; i + 1 < n4->children; i++) {
+							n4->keys[i] = n4->keys[i + 1];
+							n4->child[i] = n4->child[i + 1];
+						}
+						n4->children--;
+						if(n4->children == 1) { collapse(ref); }
+						return;
+					}
+					case NODE16: {
+						Node16 *n16 = static_cast<Node16*>(n);
+						int i = 0;
+						while(n16->keys[i] != c) { i++; }
+						for( ; i + 1 < n16->children; i++) {
+							n16->keys[i] = n16->keys[i + 1];
+							n16->child[i] = n16->child[i + 1];
+						}
+						n16->children--;
+						if(n16->children == 3) {
+							Node4 *n4 = make_node<Node4>(NODE4);
+							copy_header(n4, n16);
+							memcpy(n4->keys, n16->keys, 3);
+							memcpy(n4->child, n16->child, 3 * sizeof(child_t));
+							*ref = n4;
+							get_allocator().free(n16);
+						}
+						return;
+					}
+					case NODE48: {
+						Node48 *n48 = static_cast<Node48*>(n);
+						n48->child[n48->index[c] - 1] = 0;
+						n48->index[c] = 0;
+						n48->children--;
+						if(n48->children == 12) {
+							Node16 *n16 = make_node<Node16>(NODE16);
+							copy_header(n16, n48);
+							int j = 0;
+							for(int i = 0; i < 256; i++) {
+								if(n48->index[i]) {
+									n16->keys[j] = i;
+									n16->child[j] = n48->child[n48->index[i] - 1];
+									j++;
+								}
+							}
+							*ref = n16;
+							get_allocator().free(n48);
+						}
+						return;
+					}
+					default: {
+						Node256 *n256 = static_cast<Node256*>(n);
+						n256->child[c] = 0;
+						n256->children--;
+						if(n256->children == 37) {
+							Node48 *n48 = make_node<Node48>(NODE48);
+							copy_header(n48, n256);
+							int j = 0;
+							for(int i = 0; i < 256; i++) {
+								if(n256->child[i]) {
+									n48->child[j] = n256->child[i];
+									n48->index[i] = j + 1;
+									j++;
+								}
+							}
+							*ref = n48;
+							get_allocator().free(n256);
+						}
+						return;
+					}
+				}
+			}
+
+			/**
+			 * Replaces a Node4 with a single child by that child, moving
+			 * the node prefix and branch byte into the child's prefix.
+			 */
+			void collapse(child_t *ref) {
+				Node4 *n4 = static_cast<Node4*>(*ref);
+				child_t child = n4->child[0];
+				if(!is_leaf(child)) {
+					size_type len = prefix_stored(n4);
+					block_data_t prefix[MAX_PREFIX];
+					memcpy(prefix, n4->prefix, len);
+					if(len < (size_type)MAX_PREFIX) {
+						prefix[len++] = n4->keys[0];
+					}
+					size_type keep = prefix_stored(child);
+					if(keep > MAX_PREFIX - len) { keep = MAX_PREFIX - len; }
+					memcpy(prefix + len, child->prefix, keep);
+
+					child->prefix_length += n4->prefix_length + 1;
+					memcpy(child->prefix, prefix, len + keep);
+				}
+				*ref = child;
+				get_allocator().free(n4);
+			}
+
+			// }}}
+
+			// {{{ Insert / remove
+
+			Leaf* insert(child_t *ref, value_type value, size_type len, size_type depth) {
+				child_t n = *ref;
+				if(!n) {
+					Leaf *l = make_leaf(value, len);
+					*ref = tag(l);
+					return l;
+				}
+
+				if(is_leaf(n)) {
+					Leaf *existing = as_leaf(n);
+					if(leaf_matches(existing, value, len)) {
+						existing->refcount++;
+						return existing;
+					}
+
+					// split the leaf into a Node4 holding the common part
+					// (both end in a zero byte and differ, so this stops
+					// before the end of either)
+					size_type i = 0;
+					while(existing->data[depth + i] == value[depth + i]) { i++; }
+
+					Node4 *n4 = make_node<Node4>(NODE4);
+					n4->prefix_length = i;
+					memcpy(n4->prefix, value + depth, i < (size_type)MAX_PREFIX ? i : (size_type)MAX_PREFIX);
+
+					Leaf *l = make_leaf(value, len);
+					*ref = n4;
+					add_child(ref, existing->data[depth + i], n);
+					add_child(ref, value[depth + i], tag(l));
+					return l;
+				}
+
+				if(n->prefix_length) {
+					size_type p = prefix_mismatch(n, value, len, depth);
+					if(p < n->prefix_length) {
+						// split the prefix
+						Node4 *n4 = make_node<Node4>(NODE4);
+						n4->prefix_length = p;
+						memcpy(n4->prefix, n->prefix, p < (size_type)MAX_PREFIX ? p : (size_type)MAX_PREFIX);
+
+						::uint8_t branch;
+						if(n->prefix_length <= (::uint32_t)MAX_PREFIX) {
+							branch = n->prefix[p];
+							n->prefix_length -= p + 1;
+							memmove(n->prefix, n->prefix + p + 1, n->prefix_length);
+						}
+						else {
+							Leaf *any = any_leaf(n);
+							branch = any->data[depth + p];
+							n->prefix_length -= p + 1;
+							memcpy(n->prefix, any->data + depth + p + 1, prefix_stored(n));
+						}
+
+						Leaf *l = make_leaf(value, len);
+						*ref = n4;
+						add_child(ref, branch, n);
+						add_child(ref, value[depth + p], tag(l));
+						return l;
+					}
+					depth += n->prefix_length;
+				}
+
+				child_t *c = find_child(n, value[depth]);
+				if(c) {
+					return insert(c, value, len, depth + 1);
+				}
+
+				Leaf *l = make_leaf(value, len);
+				add_child(ref, value[depth], tag(l));
+				return l;
+			}
+
+			/**
+			 * Unlinks leaf target from the subtree at *ref.
+			 */
+			void remove(child_t *ref, Leaf *target, size_type depth) {
+				child_t n = *ref;
+				if(!n) { return; }
+				if(is_leaf(n)) {
+					if(as_leaf(n) == target) { *ref = 0; }
+					return;
+				}
+
+				depth += n->prefix_length;
+				::uint8_t c = target->data[depth];
+				child_t *child = find_child(n, c);
+				if(!child) { return; }
+
+				if(is_leaf(*child)) {
+					if(as_leaf(*child) == target) {
+						remove_child(ref, c);
+					}
+					return;
+				}
+				remove(child, target, depth + 1);
+			}
+
+			// }}}
+
+			child_t root_;
+			Leaf *leaves_;
+			size_type size_;
+			typename Debug::self_pointer_t debug_;
+	};
+
+	template<
+		typename OsModel_P,
+		typename Debug_P
+	>
+	const typename ArtDictionary<OsModel_P, Debug_P>::key_type
+	ArtDictionary<OsModel_P, Debug_P>::NULL_KEY = 0;
+
+} // namespace wiselib
+
+#endif // ART_DICTIONARY_H
+
+/* vim: set ts=3 sw=3 tw=78 noexpandtab foldmethod=marker :*/
@@ -0,0 +1,316 @@
+/***************************************************************************
+ ** This file is part of the generic algorithm library Wiselib.           **
+ ** Copyright (C) 2008,2009 by the Wisebed (www.wisebed.eu) project.      **
+ **                                                                       **
+ ** The Wiselib is free software: you can redistribute it and/or modify   **
+ ** it under the terms of the GNU Lesser General Public License as        **
+ ** published by the Free Software Foundation, either version 3 of the    **
+ ** License, or (at your option) any later version.                       **
+ **                                                                       **
+ ** The Wiselib is distributed in the hope that it will be useful,        **
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+ ** GNU Lesser General Public License for more details.                   **
+ **                                                                       **
+ ** You should have received a copy of the GNU Lesser General Public      **
+ ** License along with the Wiselib.                                       **
+ ** If not, see <http://www.gnu.org/licenses/>.                           **
+ ***************************************************************************/
+
+#ifndef COLUMN_TUPLE_CONTAINER_H
+#define COLUMN_TUPLE_CONTAINER_H
+
+#include <string.h>
+
+namespace wiselib {
+	
+	/**
+	 * @brief Tuple container for TupleStore that keeps every column in its
+	 * own contiguous array (struct of arrays).
+	 * 
+	 * The container stores the words returned by Tuple::get(), i.e. the
+	 * dictionary keys TupleStore puts into dictionary columns. Scanning
+	 * the store (or one column with column() / find_next()) thus reads a
+	 * few dense arrays instead of following one allocated tuple per row,
+	 * and a column of keys compresses well when written to block memory.
+	 * 
+	 * Erased rows are only marked in a bitmap and reused by later
+	 * inserts, so iterators and row numbers of other tuples stay valid.
+	 * end() is a fixed past-the-end row (NO_ROW), so an end() taken
+	 * before inserting or erasing still compares equal afterwards.
+	 * insert() returns an already existing equal tuple instead of adding
+	 * it again (as UniqueContainer does), where tuples are equal iff all
+	 * column words are equal. This is only value equality if all columns
+	 * are dictionary columns, which is the intended use.
+	 * 
+	 * @tparam Tuple_P Tuple type with SIZE, get() and set().
+	 * @tparam CAPACITY_P Maximum number of tuples.
+	 */
+	template<
+		typename OsModel_P,
+		typename Tuple_P,
+		int CAPACITY_P
+	>
+	class ColumnTupleContainer {
+		
+		public:
+			typedef OsModel_P OsModel;
+			typedef typename OsModel::block_data_t block_data_t;
+			typedef typename OsModel::size_t size_type;
+			typedef Tuple_P value_type;
+			typedef ColumnTupleContainer<OsModel_P, Tuple_P, CAPACITY_P> self_type;
+			
+			/// Type of a column entry (dictionary key or pointer).
+			typedef block_data_t* word_t;
+			typedef ::uint32_t row_t;
+			
+			enum {
+				COLUMNS = value_type::SIZE,
+				CAPACITY = CAPACITY_P
+			};
+			
+			enum { NO_ROW = (row_t)(-1) };
+			
+			enum { SUCCESS = OsModel::SUCCESS, ERR_UNSPEC = OsModel::ERR_UNSPEC };
+			
+			class iterator {
+				public:
+					iterator() : container_(0), row_(0) {
+					}
+					
+					iterator(self_type* container, row_t row)
+						: container_(container), row_(row) {
+					}
+					
+					/**
+					 * Materializes the current row. The returned tuple
+					 * holds the stored words, it does not own any memory.
+					 */
+					value_type& operator*() {
+						for(size_type i = 0; i < COLUMNS; i++) {
+							current_.set(i, container_->columns_[i][row_]);
+						}
+						return current_;
+					}
+					value_type* operator->() { return &operator*(); }
+					
+					iterator& operator++() {
+						row_ = container_->next_live(row_ + 1);
+						return *this;
+					}
+					
+					bool operator==(const iterator& other) const { return row_ == other.row_; }
+					bool operator!=(const iterator& other) const { return row_ != other.row_; }
+					
+					row_t row() const { return row_; }
+					
+				private:
+					self_type *container_;
+					row_t row_;
+					value_type current_;
+			};
+			
+			ColumnTupleContainer() {
+				clear();
+			}
+			
+			void clear() {
+				memset(live_, 0, sizeof(live_));
+				size_ = 0;
+				rows_ = 0;
+			}
+			
+			size_type size() { return size_; }
+			bool empty() { return size_ == 0; }
+			
+			/**
+			 * One past the highest row ever used; live rows are < rows().
+			 */
+			row_t rows() { return rows_; }
+			
+			iterator begin() { return iterator(this, next_live(0)); }
+			iterator end() { return iterator(this, NO_ROW); }
+			
+			iterator insert(value_type& t) {
+				iterator it = find(t);
+				if(it != end()) { return it; }
+				
+				row_t row = next_free(0);
+				if(row >= (row_t)CAPACITY) {
+					return end();
+				}
+				for(size_type i = 0; i < COLUMNS; i++) {
+					columns_[i][row] = t.get(i);
+				}
+				live_[row / 32] |= bit(row);
+				if(row >= rows_) { rows_ = row + 1; }
+				size_++;
+				return iterator(this, row);
+			}
+			
+			iterator erase(iterator it) {
+				row_t row = it.row();
+				if(row >= rows_ || !is_live(row)) { return end(); }
+				
+				live_[row / 32] &= ~bit(row);
+				size_--;
+				
+				// shrink to the last live row so scans stop early
+				if(row + 1 == rows_) {
+					while(rows_ && !is_live(rows_ - 1)) { rows_--; }
+					return end();
+				}
+				return iterator(this, next_live(row + 1));
+			}
+			
+			iterator find(value_type& t) {
+				word_t first = t.get(0);
+				for(row_t row = find_next(0, first, 0); row < rows_; row = find_next(0, first, row + 1)) {
+					size_type i = 1;
+					for( ; i < COLUMNS && columns_[i][row] == t.get(i); i++) { }
+					if(i == COLUMNS) { return iterator(this, row); }
+				}
+				return end();
+			}
+			
+			/**
+			 * First live row >= from whose column col holds value,
+			 * NO_ROW if there is none. Reads only that column array
+			 * (and the tombstone bitmap).
+			 */
+			row_t find_next(size_type col, word_t value, row_t from) {
+				const word_t *c = columns_[col];
+				for(row_t row = from; row < rows_; row++) {
+					if(c[row] == value && is_live(row)) { return row; }
+				}
+				return NO_ROW;
+			}
+			
+			/**
+			 * Contiguous array of the values of column col for rows
+			 * [0, rows()). Entries of erased rows are undefined, check
+			 * is_live().
+			 */
+			const word_t* column(size_type col) { return columns_[col]; }
+			
+			bool is_live(row_t row) { return live_[row / 32] & bit(row); }
+			
+			/**
+			 * Number of blocks of the given block memory needed to
+			 * persist a full container with write_blocks().
+			 */
+			template<typename BlockMemory>
+			static size_type blocks_needed() {
+				return (CAPACITY + BlockLayout<BlockMemory>::ROWS - 1) / BlockLayout<BlockMemory>::ROWS;
+			}
+			
+			/**
+			 * Writes all live tuples to consecutive blocks starting at
+			 * address a. Each block holds a row count followed by one run
+			 * of words per column. Returns the number of written blocks.
+			 */
+			template<typename BlockMemory>
+			size_type write_blocks(BlockMemory& memory, typename BlockMemory::address_t a) {
+				enum { ROWS = BlockLayout<BlockMemory>::ROWS };
+				block_data_t buffer[BlockMemory::BLOCK_SIZE];
+				row_t selected[ROWS];
+				size_type blocks = 0;
+				
+				row_t row = next_live(0);
+				do {
+					::uint16_t n = 0;
+					for( ; n < ROWS && row < rows_; row = next_live(row + 1)) {
+						selected[n++] = row;
+					}
+					
+					memset(buffer, 0, sizeof(buffer));
+					memcpy(buffer, &n, sizeof(n));
+					block_data_t *p = buffer + sizeof(n);
+					for(size_type i = 0; i < COLUMNS; i++) {
+						for(size_type j = 0; j < n; j++) {
+							memcpy(p, &columns_[i][selected[j]], sizeof(word_t));
+							p += sizeof(word_t);
+						}
+					}
+					if(memory.write(buffer, a + blocks) != SUCCESS) { return blocks; }
+					blocks++;
+				} while(row < rows_);
+				return blocks;
+			}
+			
+			/**
+			 * Replaces the contents by the tuples of the given number of
+			 * blocks written by write_blocks(). Rows are compacted.
+			 */
+			template<typename BlockMemory>
+			int read_blocks(BlockMemory& memory, typename BlockMemory::address_t a, size_type blocks) {
+				enum { ROWS = BlockLayout<BlockMemory>::ROWS };
+				block_data_t buffer[BlockMemory::BLOCK_SIZE];
+				clear();
+				for(size_type b = 0; b < blocks; b++) {
+					if(memory.read(buffer, a + b) != SUCCESS) { return ERR_UNSPEC; }
+					::uint16_t n;
+					memcpy(&n, buffer, sizeof(n));
+					if(n > ROWS || rows_ + n > (row_t)CAPACITY) { return ERR_UNSPEC; }
+					
+					block_data_t *p = buffer + sizeof(n);
+					for(size_type i = 0; i < COLUMNS; i++) {
+						for(size_type j = 0; j < n; j++) {
+							memcpy(&columns_[i][rows_ + j], p, sizeof(word_t));
+							p += sizeof(word_t);
+						}
+					}
+					for(size_type j = 0; j < n; j++) {
+						live_[(rows_ + j) / 32] |= bit(rows_ + j);
+					}
+					rows_ += n;
+					size_ += n;
+				}
+				return SUCCESS;
+			}
+			
+		private:
+			template<typename BlockMemory>
+			struct BlockLayout {
+				enum { ROWS = (BlockMemory::BLOCK_SIZE - sizeof(::uint16_t)) / (COLUMNS * sizeof(word_t)) };
+			};
+			
+			static ::uint32_t bit(row_t row) { return (::uint32_t)1 << (row % 32); }
+			
+			/**
+			 * First live row >= row, NO_ROW if there is none. Skips
+			 * erased rows a bitmap word at a time.
+			 */
+			row_t next_live(row_t row) {
+				while(row < rows_) {
+					::uint32_t w = live_[row / 32] >> (row % 32);
+					if(w) {
+						while(!(w & 1)) { w >>= 1; row++; }
+						return row < rows_ ? row : (row_t)NO_ROW;
+					}
+					row = (row / 32 + 1) * 32;
+				}
+				return NO_ROW;
+			}
+			
+			row_t next_free(row_t row) {
+				for( ; row < (row_t)CAPACITY; row = (row / 32 + 1) * 32) {
+					::uint32_t w = ~live_[row / 32] >> (row % 32);
+					if(w) {
+						while(!(w & 1)) { w >>= 1; row++; }
+						return row;
+					}
+				}
+				return CAPACITY;
+			}
+			
+			word_t columns_[COLUMNS][CAPACITY_P];
+			::uint32_t live_[(CAPACITY_P + 31) / 32];
+			size_type size_;
+			row_t rows_;
+	}; // ColumnTupleContainer
+}
+
+#endif // COLUMN_TUPLE_CONTAINER_H
+
+/* vim: set ts=3 sw=3 tw=78 noexpandtab foldmethod=marker :*/
@@ -4,6 +4,11 @@
 
 #include <util/meta.h>
 
+#ifndef TUPLESTORE_BATCH_SIZE
+	/// Number of tuples insert_batch() and erase_matching() process at once.
+	#define TUPLESTORE_BATCH_SIZE 16
+#endif
+
 namespace wiselib {
 	
 	template<
@@ -226,7 +231,12 @@ namespace wiselib {
 								}
 							}
 							
-							t.destruct_deep();
+							// t only owns copies of the non-dictionary columns
+							for(size_type i = 0; i<COLUMNS; i++) {
+								if(!(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i)))) {
+									t.free_deep(i);
+								}
+							}
 						}
 						up_to_date_ = true;
 					}
@@ -509,6 +519,145 @@ namespace wiselib {
 				return r;
 			}
 			
+			/**
+			 * Inserts the n tuples at tuples[0..n-1], equivalent to calling
+			 * insert() for each of them.
+			 * 
+			 * The tuples are handled in chunks of TUPLESTORE_BATCH_SIZE:
+			 * all dictionary columns of a chunk are resolved with find()
+			 * first (insert() only for values not in the dictionary yet),
+			 * the chunk is sorted to drop duplicates within it, and tuples
+			 * already in the container are dropped before any dictionary
+			 * reference is taken for them. References taken for dropped
+			 * tuples are released together at the end of the chunk.
+			 * 
+			 * @return number of tuples actually added.
+			 */
+			template<typename UserTuple>
+			size_type insert_batch(UserTuple* tuples, size_type n) {
+				enum { CHUNK = TUPLESTORE_BATCH_SIZE };
+				size_type added = 0;
+				
+				for(size_type base = 0; base < n; base += CHUNK) {
+					size_type m = (n - base < (size_type)CHUNK) ? n - base : (size_type)CHUNK;
+					UserTuple *chunk = tuples + base;
+					Tuple keyed[CHUNK];
+					column_mask_t owned[CHUNK];
+					size_type order[CHUNK];
+					key_type release[CHUNK * COLUMNS];
+					size_type releases = 0;
+					
+					// resolve dictionary keys, referencing only new values
+					size_type valid = 0;
+					for(size_type j = 0; j < m; j++) {
+						owned[j] = 0;
+						bool ok = true;
+						for(size_type i = 0; i < COLUMNS; i++) {
+							if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) {
+								key_type k = dictionary_->find(chunk[j].get(i));
+								if(k == Dictionary::NULL_KEY) {
+									k = dictionary_->insert(chunk[j].get(i));
+									if(k == Dictionary::NULL_KEY) { ok = false; break; }
+									owned[j] |= (1 << i);
+								}
+								keyed[j].set(i, to_bdt(k));
+							}
+							else {
+								keyed[j].set(i, chunk[j].get(i));
+							}
+						}
+						if(ok) { order[valid++] = j; }
+						else { collect_keys(keyed[j], owned[j], release, releases); }
+					}
+					
+					sort(keyed, order, valid);
+					
+					for(size_type v = 0; v < valid; v++) {
+						size_type j = order[v];
+						if((v && compare(keyed[order[v - 1]], keyed[j]) == 0) ||
+								container_->find(keyed[j]) != container_->end()) {
+							collect_keys(keyed[j], owned[j], release, releases);
+							continue;
+						}
+						
+						Tuple tmp;
+						for(size_type i = 0; i < COLUMNS; i++) {
+							if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) {
+								if(!(owned[j] & (1 << i))) {
+									dictionary_->insert(chunk[j].get(i));
+								}
+								tmp.set(i, keyed[j].get(i));
+							}
+							else {
+								tmp.set_deep(i, chunk[j].get(i));
+							}
+						}
+						typename TupleContainer::size_type sz = container_->size();
+						container_->insert(tmp);
+						if(container_->size() == sz) {
+							// container full, give back what we took
+							collect_keys(tmp, (column_mask_t)DICTIONARY_COLUMNS, release, releases);
+							free_deep_columns(tmp, MASK_ALL);
+						}
+						else {
+							added++;
+						}
+					}
+					
+					release_keys(release, releases);
+				}
+				return added;
+			}
+			
+			/**
+			 * Erases all tuples matching query in the columns of mask (all
+			 * tuples for mask 0) in one pass over the container. The
+			 * dictionary references of the erased tuples are released in
+			 * sorted batches of TUPLESTORE_BATCH_SIZE tuples.
+			 * 
+			 * @return number of erased tuples.
+			 */
+			size_type erase_matching(Tuple* query = 0, column_mask_t mask = 0) {
+				enum { CHUNK = TUPLESTORE_BATCH_SIZE };
+				Tuple q;
+				if(mask && key_copy(q, *query, mask, dictionary_) == ERR_UNSPEC) {
+					free_deep_columns(q, mask);
+					return 0;
+				}
+				
+				key_type release[CHUNK * COLUMNS];
+				size_type releases = 0;
+				size_type erased = 0;
+				
+				ContainerIterator ci = container_->begin();
+				while(ci != container_->end()) {
+					if(!matches(*ci, q, mask)) {
+						++ci;
+						continue;
+					}
+					
+					// shallow copy, see erase()
+					Tuple t = *ci;
+					if(releases + COLUMNS > (size_type)(CHUNK * COLUMNS)) {
+						release_keys(release, releases);
+					}
+					collect_keys(t, (column_mask_t)DICTIONARY_COLUMNS, release, releases);
+					for(size_type i = 0; i < COLUMNS; i++) {
+						if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) {
+							t.set(i, 0);
+						}
+					}
+					t.destruct_deep();
+					
+					ci = container_->erase(ci);
+					erased++;
+				}
+				
+				release_keys(release, releases);
+				free_deep_columns(q, mask);
+				return erased;
+			}
+			
 			iterator begin(Tuple* query = 0, column_mask_t mask = 0) {
 				iterator r;
 				r.set_dictionary(dictionary_);
@@ -597,6 +746,94 @@ namespace wiselib {
 				return SUCCESS;
 			}
 			
+			/**
+			 * Orders tuples with dictionary columns compared by key,
+			 * other columns by Compare_P.
+			 */
+			static int compare(Tuple& a, Tuple& b) {
+				for(size_type i = 0; i < COLUMNS; i++) {
+					int c;
+					if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) {
+						key_type ka = to_key(a.get(i)), kb = to_key(b.get(i));
+						c = (ka < kb) ? -1 : (kb < ka);
+					}
+					else {
+						c = (*Compare_P)(i, a.get(i), a.length(i), b.get(i), b.length(i));
+					}
+					if(c) { return c; }
+				}
+				return 0;
+			}
+			
+			/**
+			 * Insertion sort of the index array order[0..n-1] (n is at
+			 * most TUPLESTORE_BATCH_SIZE).
+			 */
+			static void sort(Tuple* tuples, size_type* order, size_type n) {
+				for(size_type i = 1; i < n; i++) {
+					size_type x = order[i];
+					size_type j = i;
+					for( ; j && compare(tuples[order[j - 1]], tuples[x]) > 0; j--) {
+						order[j] = order[j - 1];
+					}
+					order[j] = x;
+				}
+			}
+			
+			static bool matches(Tuple& t, Tuple& query, column_mask_t mask) {
+				for(size_type i = 0; i < COLUMNS; i++) {
+					if(!(mask & (1 << i))) { continue; }
+					if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) {
+						if(t.get(i) != query.get(i)) { return false; }
+					}
+					else if((*Compare_P)(i, t.get(i), t.length(i), query.get(i), query.length(i)) != 0) {
+						return false;
+					}
+				}
+				return true;
+			}
+			
+			/**
+			 * Appends the keys of the dictionary columns of t in mask to
+			 * keys[count..].
+			 */
+			static void collect_keys(Tuple& t, column_mask_t mask, key_type* keys, size_type& count) {
+				for(size_type i = 0; i < COLUMNS; i++) {
+					if(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i)) && (mask & (1 << i))) {
+						keys[count++] = to_key(t.get(i));
+					}
+				}
+			}
+			
+			/**
+			 * Drops one dictionary reference per entry of keys[0..count-1],
+			 * in key order so references to the same entry are released
+			 * back to back.
+			 */
+			void release_keys(key_type* keys, size_type& count) {
+				for(size_type i = 1; i < count; i++) {
+					key_type x = keys[i];
+					size_type j = i;
+					for( ; j && x < keys[j - 1]; j--) { keys[j] = keys[j - 1]; }
+					keys[j] = x;
+				}
+				for(size_type i = 0; i < count; i++) {
+					dictionary_->erase(keys[i]);
+				}
+				count = 0;
+			}
+			
+			/**
+			 * Frees the deep copies in the non-dictionary columns of mask.
+			 */
+			static void free_deep_columns(Tuple& q, column_mask_t mask) {
+				for(size_type i = 0; i < COLUMNS; i++) {
+					if(!(DICTIONARY_COLUMNS && (DICTIONARY_COLUMNS & (1 << i))) && (mask & (1 << i))) {
+						q.free_deep(i);
+					}
+				}
+			}
+			
 			static typename Dictionary::key_type to_key(block_data_t* bdt) {
 				static_assert(sizeof(block_data_t*) == sizeof(typename Dictionary::key_type));
 				typename Dictionary::key_type k;
@@ -710,6 +947,54 @@ namespace wiselib {
 				return r;
 			}
 			
+			/**
+			 * Inserts the n tuples at tuples[0..n-1].
+			 * 
+			 * @return number of tuples actually added.
+			 */
+			template<typename UserTuple>
+			size_type insert_batch(UserTuple* tuples, size_type n) {
+				size_type added = 0;
+				for(size_type j = 0; j < n; j++) {
+					Tuple tmp;
+					TupleStore_detail::deep_copy<COLUMNS>(tmp, tuples[j]);
+					
+					typename TupleContainer::size_type sz = container_->size();
+					container_->insert(tmp);
+					if(container_->size() == sz) { tmp.destruct_deep(); }
+					else { added++; }
+				}
+				return added;
+			}
+			
+			/**
+			 * Erases all tuples matching query in the columns of mask (all
+			 * tuples for mask 0) in one pass over the container.
+			 * 
+			 * @return number of erased tuples.
+			 */
+			size_type erase_matching(Tuple* query = 0, column_mask_t mask = 0) {
+				size_type erased = 0;
+				ContainerIterator ci = container_->begin();
+				while(ci != container_->end()) {
+					bool match = true;
+					for(size_type i = 0; match && i < COLUMNS; i++) {
+						match = !(mask & (1 << i)) ||
+							(*Compare_P)(i, ci->get(i), ci->length(i), query->get(i), query->length(i)) == 0;
+					}
+					if(!match) {
+						++ci;
+						continue;
+					}
+					
+					Tuple t = *ci;
+					t.destruct_deep();
+					ci = container_->erase(ci);
+					erased++;
+				}
+				return erased;
+			}
+			
 			iterator begin(Tuple* query = 0, column_mask_t mask = 0) {
 				iterator r;
 				